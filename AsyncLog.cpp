@@ -0,0 +1,352 @@
+#include "AsyncLog.h"
+
+#include <time.h>
+#include <chrono>
+
+#define ASYNC_LOG_RING_MASK     (ASYNC_LOG_NB_RECORDS - 1)
+#define ASYNC_LOG_IDLE_MS       2
+#define ASYNC_LOG_STRING_NULL       -1  // LOG_ARG_STRING offsets that aren't in szText
+#define ASYNC_LOG_STRING_TRUNCATED  -2  // no room left in szText, written as "..."
+
+CAsyncLog::CAsyncLog()
+{
+    int i;
+
+    for(i = 0; i < LOG_NB_CATEGORIES; i++)
+        m_nLevels[i] = LOG_OFF;
+    m_nEnabled.store(0);
+    m_bStarted.store(false);
+    m_pFile = NULL;
+    m_pRecords = NULL;
+    m_nHead.store(0);
+    m_nTail.store(0);
+    m_nDropped.store(0);
+    m_nDroppedReported = 0;
+    m_bStop.store(false);
+}
+
+CAsyncLog::~CAsyncLog()
+{
+    m_nEnabled.store(0);
+    m_bStop.store(true);
+    if(m_Writer.joinable())
+        m_Writer.join();
+    if(m_pFile)
+        fclose(m_pFile);
+    if(m_pRecords)
+        delete [] m_pRecords;
+}
+
+CAsyncLog &CAsyncLog::disabled()
+{
+    static CAsyncLog noLog;
+    return noLog;
+}
+
+#pragma mark - configuration
+void CAsyncLog::setLevel(int nCategory, int nLevel)
+{
+    int i, j;
+    unsigned nEnabled = 0;
+
+    if(nCategory < 0 || nCategory >= LOG_NB_CATEGORIES)
+        return;
+    if(nLevel < LOG_OFF)
+        nLevel = LOG_OFF;
+    if(nLevel >= LOG_NB_LEVELS)
+        nLevel = LOG_NB_LEVELS - 1;
+    m_nLevels[nCategory] = nLevel;
+
+    for(i = 0; i < LOG_NB_CATEGORIES; i++)
+        for(j = LOG_ERROR; j <= m_nLevels[i]; j++)
+            nEnabled |= LOG_ENABLED_BIT(i, j);
+
+    if(nEnabled && !start())
+        nEnabled = 0;
+    m_nEnabled.store(nEnabled, std::memory_order_release);
+}
+
+// open the file, allocate the ring and start the writer, once
+bool CAsyncLog::start()
+{
+    size_t i;
+
+    if(m_bStarted.load())
+        return true;
+    if(this == &disabled() || m_sFilePath.empty())
+        return false;
+    m_pFile = fopen(m_sFilePath.c_str(), "w");
+    if(!m_pFile)
+        return false;
+
+    m_pRecords = new AsyncLogRecord[ASYNC_LOG_NB_RECORDS];
+    for(i = 0; i < ASYNC_LOG_NB_RECORDS; i++)
+        m_pRecords[i].nSequence.store(i, std::memory_order_relaxed);
+    m_Writer = std::thread(&CAsyncLog::writerThread, this);
+    m_bStarted.store(true, std::memory_order_release);
+    return true;
+}
+
+#pragma mark - producers
+// Bounded MPSC ring, one sequence number per slot :
+// nSequence == nPos      free for the producer reserving position nPos
+// nSequence == nPos + 1  filled, ready for the writer
+// the writer then sets it to nPos + ASYNC_LOG_NB_RECORDS, freeing it for the next lap.
+AsyncLogRecord *CAsyncLog::reserve(size_t &nPos)
+{
+    AsyncLogRecord *pRecord;
+    size_t nSequence;
+    intptr_t nDiff;
+
+    if(!m_bStarted.load(std::memory_order_acquire))
+        return NULL;
+    nPos = m_nHead.load(std::memory_order_relaxed);
+    while(true) {
+        pRecord = &m_pRecords[nPos & ASYNC_LOG_RING_MASK];
+        nSequence = pRecord->nSequence.load(std::memory_order_acquire);
+        nDiff = (intptr_t)nSequence - (intptr_t)nPos;
+        if(nDiff == 0) {
+            if(m_nHead.compare_exchange_weak(nPos, nPos + 1, std::memory_order_relaxed))
+                return pRecord;
+        }
+        else if(nDiff < 0) {
+            // the writer hasn't freed this slot yet, ring full
+            m_nDropped.fetch_add(1, std::memory_order_relaxed);
+            return NULL;
+        }
+        else
+            nPos = m_nHead.load(std::memory_order_relaxed);
+    }
+}
+
+void CAsyncLog::publish(AsyncLogRecord *pRecord, size_t nPos)
+{
+    pRecord->nSequence.store(nPos + 1, std::memory_order_release);
+}
+
+int64_t CAsyncLog::nowUs()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+void CAsyncLog::packArg(AsyncLogRecord &record, double dValue)
+{
+    if(record.nNbArgs >= ASYNC_LOG_MAX_ARGS)
+        return;
+    record.nTypes[record.nNbArgs] = LOG_ARG_DOUBLE;
+    record.Args[record.nNbArgs++].d = dValue;
+}
+
+void CAsyncLog::packArg(AsyncLogRecord &record, const char *pszValue)
+{
+    int nLen;
+    int nRoom;
+
+    if(record.nNbArgs >= ASYNC_LOG_MAX_ARGS)
+        return;
+    record.nTypes[record.nNbArgs] = LOG_ARG_STRING;
+    if(!pszValue) {
+        record.Args[record.nNbArgs++].n = ASYNC_LOG_STRING_NULL;
+        return;
+    }
+    // truncated to what's left of the record text area, the earlier strings can have filled it
+    nRoom = ASYNC_LOG_TEXT_SIZE - record.nTextLen;
+    if(nRoom <= 1) {
+        record.Args[record.nNbArgs++].n = ASYNC_LOG_STRING_TRUNCATED;
+        return;
+    }
+    nLen = (int)strnlen(pszValue, (size_t)(nRoom - 1));
+    memcpy(record.szText + record.nTextLen, pszValue, nLen);
+    record.szText[record.nTextLen + nLen] = 0;
+    record.Args[record.nNbArgs++].n = record.nTextLen;
+    record.nTextLen += nLen + 1;
+}
+
+const char *CAsyncLog::stringArg(const AsyncLogRecord &record, int nArg)
+{
+    if(record.Args[nArg].n == ASYNC_LOG_STRING_NULL)
+        return "(null)";
+    if(record.Args[nArg].n == ASYNC_LOG_STRING_TRUNCATED)
+        return "...";
+    return record.szText + record.Args[nArg].n;
+}
+
+void CAsyncLog::packArg(AsyncLogRecord &record, const void *pValue)
+{
+    if(record.nNbArgs >= ASYNC_LOG_MAX_ARGS)
+        return;
+    record.nTypes[record.nNbArgs] = LOG_ARG_POINTER;
+    record.Args[record.nNbArgs++].p = pValue;
+}
+
+#pragma mark - writer
+void CAsyncLog::flush()
+{
+    size_t nHead = m_nHead.load(std::memory_order_acquire);
+
+    if(!m_bStarted.load(std::memory_order_acquire))
+        return;
+    while(m_nTail.load(std::memory_order_acquire) < nHead)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+}
+
+void CAsyncLog::writerThread()
+{
+    while(true) {
+        if(writeRecords())
+            continue;
+        if(m_bStop.load())
+            break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(ASYNC_LOG_IDLE_MS));
+    }
+    writeRecords();
+}
+
+// write everything ready, return the number of records written
+int CAsyncLog::writeRecords()
+{
+    int nWritten = 0;
+    size_t nTail = m_nTail.load(std::memory_order_relaxed);
+    unsigned long nDropped;
+    AsyncLogRecord *pRecord;
+    char szLine[ASYNC_LOG_LINE_SIZE];
+
+    while(true) {
+        pRecord = &m_pRecords[nTail & ASYNC_LOG_RING_MASK];
+        if(pRecord->nSequence.load(std::memory_order_acquire) != nTail + 1)
+            break;
+        formatRecord(*pRecord, szLine, ASYNC_LOG_LINE_SIZE);
+        pRecord->nSequence.store(nTail + ASYNC_LOG_NB_RECORDS, std::memory_order_release);
+        nTail++;
+        m_nTail.store(nTail, std::memory_order_release);
+        if(m_pFile)
+            fputs(szLine, m_pFile);
+        nWritten++;
+    }
+
+    nDropped = m_nDropped.load(std::memory_order_relaxed);
+    if(m_pFile && nDropped != m_nDroppedReported) {
+        fprintf(m_pFile, "[async log] %lu records dropped, ring full (%lu total)\n", nDropped - m_nDroppedReported, nDropped);
+        m_nDroppedReported = nDropped;
+    }
+    if(m_pFile && nWritten)
+        fflush(m_pFile);
+    return nWritten;
+}
+
+// "[Sat Oct 18 21:04:05.123456 2026] " then the format expanded with the record arguments.
+// Each conversion is done by snprintf with the argument in the type it was packed as,
+// so the text is the same as printf would have written on the calling thread.
+void CAsyncLog::formatRecord(const AsyncLogRecord &record, char *pszLine, int nMaxLen)
+{
+    time_t nSeconds = (time_t)(record.nTimeUs / 1000000);
+    struct tm tmLocal;
+    const char *pszFmt = record.pszFormat;
+    char szSpec[32];
+    char szDate[32];
+    int nSpecLen;
+    int nArg = 0;
+    int nLen;
+    bool bInteger;
+    const char *pszConversion = "";
+
+#if defined(SB_WIN_BUILD)
+    localtime_s(&tmLocal, &nSeconds);
+#else
+    localtime_r(&nSeconds, &tmLocal);
+#endif
+    strftime(szDate, sizeof(szDate), "%a %b %d %H:%M:%S", &tmLocal);
+    nLen = snprintf(pszLine, nMaxLen, "[%s.%06d %d] ", szDate, (int)(record.nTimeUs % 1000000), tmLocal.tm_year + 1900);
+
+    while(*pszFmt && nLen < nMaxLen - 1) {
+        if(*pszFmt != '%') {
+            pszLine[nLen++] = *pszFmt++;
+            continue;
+        }
+        if(pszFmt[1] == '%') {
+            pszLine[nLen++] = '%';
+            pszFmt += 2;
+            continue;
+        }
+
+        // %[flags][width][.precision][length]conversion, the length modifier is dropped and replaced by the packed type's
+        nSpecLen = 0;
+        szSpec[nSpecLen++] = *pszFmt++;
+        while(*pszFmt && strchr("-+ #0123456789.", *pszFmt) && nSpecLen < (int)sizeof(szSpec) - 4)
+            szSpec[nSpecLen++] = *pszFmt++;
+        while(*pszFmt && strchr("hlLqjzt", *pszFmt))
+            pszFmt++;
+        if(!*pszFmt)
+            break;
+        bInteger = strchr("diouxXc", *pszFmt) != NULL;
+
+        if(nArg >= record.nNbArgs) {
+            nLen += snprintf(pszLine + nLen, nMaxLen - nLen, "%%?");
+            pszFmt++;
+            continue;
+        }
+
+        switch(record.nTypes[nArg]) {
+            case LOG_ARG_INT:
+            case LOG_ARG_UINT:
+                if(!bInteger && *pszFmt != 's' && *pszFmt != 'p') {
+                    szSpec[nSpecLen++] = *pszFmt;
+                    szSpec[nSpecLen] = 0;
+                    nLen += snprintf(pszLine + nLen, nMaxLen - nLen, szSpec, (double)(record.nTypes[nArg] == LOG_ARG_INT ? record.Args[nArg].n : (int64_t)record.Args[nArg].u));
+                    break;
+                }
+                pszConversion = bInteger ? pszFmt : "d";
+                szSpec[nSpecLen++] = *pszConversion;
+                szSpec[nSpecLen] = 0;
+                if(record.nTypes[nArg] == LOG_ARG_INT)
+                    nLen += snprintf(pszLine + nLen, nMaxLen - nLen, szSpec, (int)record.Args[nArg].n);
+                else
+                    nLen += snprintf(pszLine + nLen, nMaxLen - nLen, szSpec, (unsigned int)record.Args[nArg].u);
+                break;
+            case LOG_ARG_INT64:
+            case LOG_ARG_UINT64:
+                if(!bInteger && *pszFmt != 's' && *pszFmt != 'p') {
+                    szSpec[nSpecLen++] = *pszFmt;
+                    szSpec[nSpecLen] = 0;
+                    nLen += snprintf(pszLine + nLen, nMaxLen - nLen, szSpec, (double)(record.nTypes[nArg] == LOG_ARG_INT64 ? record.Args[nArg].n : (int64_t)record.Args[nArg].u));
+                    break;
+                }
+                pszConversion = bInteger ? pszFmt : "d";
+                if(*pszConversion == 'c') {
+                    szSpec[nSpecLen++] = 'c';
+                    szSpec[nSpecLen] = 0;
+                    nLen += snprintf(pszLine + nLen, nMaxLen - nLen, szSpec, (int)record.Args[nArg].n);
+                    break;
+                }
+                szSpec[nSpecLen++] = 'l';
+                szSpec[nSpecLen++] = 'l';
+                szSpec[nSpecLen++] = *pszConversion;
+                szSpec[nSpecLen] = 0;
+                if(record.nTypes[nArg] == LOG_ARG_INT64)
+                    nLen += snprintf(pszLine + nLen, nMaxLen - nLen, szSpec, (long long)record.Args[nArg].n);
+                else
+                    nLen += snprintf(pszLine + nLen, nMaxLen - nLen, szSpec, (unsigned long long)record.Args[nArg].u);
+                break;
+            case LOG_ARG_DOUBLE:
+                szSpec[nSpecLen++] = (bInteger || *pszFmt == 's' || *pszFmt == 'p') ? 'g' : *pszFmt;
+                szSpec[nSpecLen] = 0;
+                nLen += snprintf(pszLine + nLen, nMaxLen - nLen, szSpec, record.Args[nArg].d);
+                break;
+            case LOG_ARG_STRING:
+                szSpec[nSpecLen++] = 's';
+                szSpec[nSpecLen] = 0;
+                nLen += snprintf(pszLine + nLen, nMaxLen - nLen, szSpec, stringArg(record, nArg));
+                break;
+            case LOG_ARG_POINTER:
+                szSpec[nSpecLen++] = 'p';
+                szSpec[nSpecLen] = 0;
+                nLen += snprintf(pszLine + nLen, nMaxLen - nLen, szSpec, record.Args[nArg].p);
+                break;
+        }
+        nArg++;
+        pszFmt++;
+    }
+    if(nLen > nMaxLen - 1)
+        nLen = nMaxLen - 1;
+    pszLine[nLen] = 0;
+}
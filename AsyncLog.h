@@ -0,0 +1,144 @@
+#pragma once
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#include <string>
+#include <atomic>
+#include <thread>
+#include <type_traits>
+
+// Debug log that keeps formatting and file I/O off the calling thread.
+// log() copies the format pointer, a timestamp and the arguments into a slot of a lock-free ring
+// (multiple producers, one consumer) and returns. A background thread formats the records, adds the
+// timestamp and writes them to the file. If the ring is full the record is dropped and counted,
+// the writer reports the count in the log.
+//
+// What gets logged is chosen at runtime, a level per category. Callers test enabled() before log(),
+// with constant arguments that's one load and one bit test. Nothing is allocated, no file is created
+// and no thread runs until a category is first enabled.
+//
+// The format must be a string literal (only its pointer is kept). String arguments are copied,
+// up to ASYNC_LOG_TEXT_SIZE bytes per record. Up to ASYNC_LOG_MAX_ARGS arguments, no '*' width or precision.
+
+#define ASYNC_LOG_NB_RECORDS    2048    // power of 2
+#define ASYNC_LOG_MAX_ARGS      8
+#define ASYNC_LOG_TEXT_SIZE     192
+#define ASYNC_LOG_LINE_SIZE     2048
+
+enum AsyncLogCategory {LOG_TRANSPORT=0, LOG_CACHE, LOG_SLEW, LOG_TRACKING, LOG_UI, LOG_NB_CATEGORIES};
+// 1 = bad stuff only, 2 = full debug, 3 = raw replies too
+enum AsyncLogLevel {LOG_OFF=0, LOG_ERROR, LOG_DEBUG, LOG_VERBOSE, LOG_NB_LEVELS};
+
+// one bit per category and level, set for every level up to the category's configured one
+#define LOG_ENABLED_BIT(nCategory, nLevel)  (1u << ((nCategory) * LOG_NB_LEVELS + (nLevel)))
+
+enum AsyncLogArgType {LOG_ARG_INT=0, LOG_ARG_UINT, LOG_ARG_INT64, LOG_ARG_UINT64, LOG_ARG_DOUBLE, LOG_ARG_STRING, LOG_ARG_POINTER};
+
+typedef struct {
+    std::atomic<size_t>     nSequence;      // ring slot state, see CAsyncLog::reserve()
+    int64_t                 nTimeUs;        // system clock, microseconds since the epoch
+    const char              *pszFormat;
+    int                     nNbArgs;
+    int                     nTextLen;
+    unsigned char           nTypes[ASYNC_LOG_MAX_ARGS];    // AsyncLogArgType
+    union {
+        int64_t     n;
+        uint64_t    u;
+        double      d;
+        const void  *p;
+    }                       Args[ASYNC_LOG_MAX_ARGS];      // LOG_ARG_STRING : offset in szText, negative for NULL or no room left
+    char                    szText[ASYNC_LOG_TEXT_SIZE];
+} AsyncLogRecord;
+
+class CAsyncLog
+{
+public:
+    CAsyncLog();
+    ~CAsyncLog();
+
+    // shared, never enabled instance for code that hasn't been given a log
+    static CAsyncLog &disabled();
+
+    // Configuration, from the thread that owns the log (the X2 calls).
+    // The file is created (truncated) when a category is first enabled, and stays open after that.
+    void    setFilePath(const std::string &sPath) { m_sFilePath = sPath; }
+    void    setLevel(int nCategory, int nLevel);
+    int     level(int nCategory) const { return m_nLevels[nCategory]; }
+
+    bool    enabled(int nCategory, int nLevel) const { return (m_nEnabled.load(std::memory_order_acquire) & LOG_ENABLED_BIT(nCategory, nLevel)) != 0; }
+    bool    anyEnabled() const { return m_nEnabled.load(std::memory_order_acquire) != 0; }
+
+    // guard with enabled(), nothing is recorded before the first category is enabled
+    template <typename... Args>
+    void log(const char *pszFormat, Args... args)
+    {
+        size_t nPos;
+        AsyncLogRecord *pRecord = reserve(nPos);
+
+        if(!pRecord)
+            return;
+        pRecord->nTimeUs = nowUs();
+        pRecord->pszFormat = pszFormat;
+        pRecord->nNbArgs = 0;
+        pRecord->nTextLen = 0;
+        int nPacked[] = {0, (packArg(*pRecord, args), 0)...};
+        (void)nPacked;
+        publish(pRecord, nPos);
+    }
+
+    // wait until everything logged so far is in the file
+    void            flush();
+    // for bulk dumps (flush() first), written lines can interleave with the writer thread's
+    FILE            *file() const { return m_pFile; }
+    unsigned long   droppedCount() const { return m_nDropped.load(std::memory_order_relaxed); }
+
+private:
+    bool            start();
+    AsyncLogRecord  *reserve(size_t &nPos);
+    void            publish(AsyncLogRecord *pRecord, size_t nPos);
+    static int64_t  nowUs();
+
+    template <typename T>
+    static void packInteger(AsyncLogRecord &record, T nValue)
+    {
+        if(record.nNbArgs >= ASYNC_LOG_MAX_ARGS)
+            return;
+        if(std::is_signed<T>::value) {
+            record.nTypes[record.nNbArgs] = sizeof(T) > 4 ? LOG_ARG_INT64 : LOG_ARG_INT;
+            record.Args[record.nNbArgs++].n = (int64_t)nValue;
+        }
+        else {
+            record.nTypes[record.nNbArgs] = sizeof(T) > 4 ? LOG_ARG_UINT64 : LOG_ARG_UINT;
+            record.Args[record.nNbArgs++].u = (uint64_t)nValue;
+        }
+    }
+
+    static void packArg(AsyncLogRecord &record, int nValue)                 { packInteger(record, nValue); }
+    static void packArg(AsyncLogRecord &record, unsigned int nValue)        { packInteger(record, nValue); }
+    static void packArg(AsyncLogRecord &record, long nValue)                { packInteger(record, nValue); }
+    static void packArg(AsyncLogRecord &record, unsigned long nValue)       { packInteger(record, nValue); }
+    static void packArg(AsyncLogRecord &record, long long nValue)           { packInteger(record, nValue); }
+    static void packArg(AsyncLogRecord &record, unsigned long long nValue)  { packInteger(record, nValue); }
+    static void packArg(AsyncLogRecord &record, double dValue);
+    static void packArg(AsyncLogRecord &record, const char *pszValue);
+    static void packArg(AsyncLogRecord &record, const void *pValue);
+    static const char *stringArg(const AsyncLogRecord &record, int nArg);
+
+    void    writerThread();
+    int     writeRecords();
+    void    formatRecord(const AsyncLogRecord &record, char *pszLine, int nMaxLen);
+
+    std::string                 m_sFilePath;
+    int                         m_nLevels[LOG_NB_CATEGORIES];
+    std::atomic<unsigned>       m_nEnabled;     // LOG_ENABLED_BIT mask
+    std::atomic<bool>           m_bStarted;     // file open, ring allocated, writer running
+    FILE                        *m_pFile;
+    AsyncLogRecord              *m_pRecords;
+    std::atomic<size_t>         m_nHead;        // next slot producers reserve
+    std::atomic<size_t>         m_nTail;        // next slot the writer reads
+    std::atomic<unsigned long>  m_nDropped;
+    unsigned long               m_nDroppedReported;
+    std::atomic<bool>           m_bStop;
+    std::thread                 m_Writer;
+};
@@ -0,0 +1,240 @@
+// CAsyncLog records checked against snprintf on the calling thread, and the ring dropping records
+// when the writer is stuck. Built and run by make test.
+
+#include <stdlib.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <string>
+#include <vector>
+#include <thread>
+
+#include "TestCheck.h"
+#include "AsyncLog.h"
+
+#define RING_TEST_RECORDS   (3 * ASYNC_LOG_NB_RECORDS)
+
+static std::string tempPath(const char *pszName)
+{
+    char szPath[256];
+
+    snprintf(szPath, sizeof(szPath), "/tmp/%s.%d", pszName, (int)getpid());
+    return szPath;
+}
+
+static std::vector<std::string> splitLines(const std::string &sText)
+{
+    std::vector<std::string> lines;
+    size_t nStart = 0;
+    size_t nEnd;
+
+    while((nEnd = sText.find('\n', nStart)) != std::string::npos) {
+        lines.push_back(sText.substr(nStart, nEnd - nStart + 1));
+        nStart = nEnd + 1;
+    }
+    return lines;
+}
+
+// the line without its "[date time.us year] " prefix
+static std::string logText(const std::string &sLine)
+{
+    size_t nPos;
+
+    if(sLine.size() < 2 || sLine[0] != '[' || (nPos = sLine.find("] ")) == std::string::npos)
+        return "<no timestamp> " + sLine;
+    return sLine.substr(nPos + 2);
+}
+
+static std::string readFile(const std::string &sPath)
+{
+    std::string sText;
+    char szBuffer[4096];
+    size_t nRead;
+    FILE *pFile = fopen(sPath.c_str(), "r");
+
+    if(!pFile)
+        return sText;
+    while((nRead = fread(szBuffer, 1, sizeof(szBuffer), pFile)) > 0)
+        sText.append(szBuffer, nRead);
+    fclose(pFile);
+    return sText;
+}
+
+// logs and keeps what snprintf writes with the same arguments, to compare with the file
+class CFormatCheck
+{
+public:
+    explicit CFormatCheck(CAsyncLog &log) : m_Log(log) {}
+
+    template <typename... Args>
+    void check(const char *pszFormat, Args... args)
+    {
+        char szExpected[ASYNC_LOG_LINE_SIZE];
+
+        snprintf(szExpected, sizeof(szExpected), pszFormat, args...);
+        m_Expected.push_back(szExpected);
+        m_Log.log(pszFormat, args...);
+    }
+    void expect(const std::string &sExpected) { m_Expected.push_back(sExpected); }
+
+    const std::vector<std::string> &expected() const { return m_Expected; }
+
+private:
+    CAsyncLog                   &m_Log;
+    std::vector<std::string>    m_Expected;
+};
+
+static void testFormat()
+{
+    std::string sPath = tempPath("AsyncLogTest.log");
+    std::vector<std::string> lines;
+    std::string sLong(300, 'x');
+    std::string sText;
+    size_t i;
+    int nValue = 42;
+    void *pNull = NULL;
+
+    {
+        CAsyncLog log;
+        CFormatCheck format(log);
+
+        TEST_CHECK(!log.enabled(LOG_TRANSPORT, LOG_ERROR));
+        log.log("not started %d\n", 1);     // nothing recorded before a category is enabled
+        log.setFilePath(sPath);
+        log.setLevel(LOG_TRANSPORT, LOG_DEBUG);
+        TEST_CHECK(log.enabled(LOG_TRANSPORT, LOG_DEBUG));
+        TEST_CHECK(!log.enabled(LOG_TRANSPORT, LOG_VERBOSE));
+        TEST_CHECK(!log.enabled(LOG_SLEW, LOG_ERROR));
+
+        // what the driver logs
+        format.check("*** CiOptron::sendCommand sending : '%s'\n", ":GEP#");
+        format.check("error = %d , pszCmd : '%s'\n", -5, ":MS1#");
+        format.check("nErr: %i\n", 203);
+        format.check("Number of bytes read: %lu.  Number expected: %i\n", (unsigned long)17, 19);
+        format.check("dRaRateArcSecPerSec: %f, dDecRateArcSecPerSec %f\n", 0.0150410681, -123.456789);
+        format.check("%g %g %g %g\n", 1.0e-7, 123456789.0, 0.5, -0.0);
+        format.check("[%c] [%c]\n", 'A', '#');
+        format.check("pointer %p %p\n", (const void *)&nValue, (const void *)pNull);
+        format.check("100%% done, %d%%\n", 100);
+        format.check("%s\n", "");
+        format.check("bTrackingOn: %s, bIgnoreRate: %s\n", true ? "true" : "false", false ? "true" : "false");
+
+        // width, precision and flags
+        format.check("[%5d] [%-5d] [%05d] [%+d] [% d]\n", 42, 42, 42, 42, 42);
+        format.check("[%8.3f] [%-10.2f] [%08.3f] [%+.1f] [%.0f]\n", 3.14159, 2.5, -1.5, 0.25, 2.5);
+        format.check("[%10s] [%-10s] [%.3s]\n", "right", "left", "truncated");
+        format.check("[%x] [%X] [%o] [%#x] [%u]\n", 255u, 255u, 8u, 255u, 4000000000u);
+        format.check("[%ld] [%lu] [%lld] [%llu]\n", -1234567890123L, 1234567890123UL, -9000000000000000000LL, 18000000000000000000ULL);
+        format.check("[%.2e] [%E] [%.3g]\n", 12345.678, 0.000123, 2.0 / 3.0);
+        format.check("%d %s %f %c %lu %g %p %d\n", 1, "two", 3.0, '4', (unsigned long)5, 6.5, (const void *)&nValue, 8);
+
+        // NULL and strings past the record text area
+        format.check("null '%s'\n", (const char *)NULL);
+        log.log("long '%s'\n", sLong.c_str());
+        format.expect("long '" + sLong.substr(0, ASYNC_LOG_TEXT_SIZE - 1) + "'\n");
+        log.log("'%s' '%s' '%s'\n", sLong.substr(0, 150).c_str(), sLong.substr(0, 100).c_str(), "gone");
+        format.expect("'" + sLong.substr(0, 150) + "' '" + sLong.substr(0, ASYNC_LOG_TEXT_SIZE - 151 - 1) + "' '...'\n");
+
+        // a conversion without an argument
+        log.log("%d %d\n", 1);
+        format.expect("1 %?\n");
+
+        log.flush();
+        lines = splitLines(readFile(sPath));
+        TEST_CHECK_EQUAL(lines.size(), format.expected().size());
+        for(i = 0; i < lines.size() && i < format.expected().size(); i++) {
+            sText = logText(lines[i]);
+            if(sText != format.expected()[i]) {
+                fprintf(stderr, "record %d : \"%s\", snprintf \"%s\"\n", (int)i, sText.c_str(), format.expected()[i].c_str());
+                testFailures()++;
+            }
+        }
+        TEST_CHECK_EQUAL(log.droppedCount(), 0);
+    }
+    unlink(sPath.c_str());
+}
+
+// A FIFO nobody reads for a while : the writer blocks in fputs, the ring fills and the records
+// past it are dropped. Once the FIFO is drained every record is either in the log or counted
+// as dropped, and the drops are reported in the log.
+static void testRingFull()
+{
+    std::string sPath = tempPath("AsyncLogTest.fifo");
+    std::string sText;
+    std::string sPadding(160, '.');
+    std::vector<std::string> lines;
+    std::thread reader;
+    unsigned long nDropped = 0;
+    unsigned long nReported = 0;
+    unsigned long nReportedTotal = 0;
+    unsigned long nRecords = 0;
+    int nFd;
+    int i;
+    size_t j;
+
+    unlink(sPath.c_str());
+    if(mkfifo(sPath.c_str(), 0600)) {
+        printf("SKIP testRingFull: mkfifo failed, errno %d\n", errno);
+        return;
+    }
+    nFd = open(sPath.c_str(), O_RDONLY | O_NONBLOCK);  // so the log's fopen doesn't wait for a reader
+    if(nFd < 0) {
+        printf("SKIP testRingFull: can't open the FIFO, errno %d\n", errno);
+        unlink(sPath.c_str());
+        return;
+    }
+
+    {
+        CAsyncLog log;
+
+        log.setFilePath(sPath);
+        log.setLevel(LOG_CACHE, LOG_ERROR);
+        TEST_CHECK(log.enabled(LOG_CACHE, LOG_ERROR));
+
+        // the pipe and stdio buffers hold a few hundred of these, the ring ASYNC_LOG_NB_RECORDS
+        for(i = 0; i < RING_TEST_RECORDS; i++)
+            log.log("record %d %s\n", i, sPadding.c_str());
+        nDropped = log.droppedCount();
+        TEST_CHECK(nDropped > 0);
+        TEST_CHECK(nDropped < RING_TEST_RECORDS);
+
+        reader = std::thread([nFd, &sText] {
+            char szBuffer[65536];
+            struct pollfd pfd = {nFd, POLLIN, 0};
+            ssize_t nRead;
+
+            while(poll(&pfd, 1, 5000) > 0) {
+                nRead = read(nFd, szBuffer, sizeof(szBuffer));
+                if(nRead > 0)
+                    sText.append(szBuffer, nRead);
+                else if(nRead == 0 || errno != EAGAIN)
+                    break;      // the log closed its end
+            }
+        });
+        log.flush();
+        TEST_CHECK_EQUAL(log.droppedCount(), nDropped);
+    }
+    reader.join();
+    close(nFd);
+    unlink(sPath.c_str());
+
+    lines = splitLines(sText);
+    for(j = 0; j < lines.size(); j++) {
+        if(sscanf(lines[j].c_str(), "[async log] %lu records dropped, ring full (%lu total)", &nReported, &nReportedTotal) == 2)
+            continue;
+        if(!strncmp(logText(lines[j]).c_str(), "record ", 7))
+            nRecords++;
+    }
+    TEST_CHECK_EQUAL(nRecords + nDropped, RING_TEST_RECORDS);
+    TEST_CHECK_EQUAL(nReportedTotal, nDropped);
+}
+
+int main()
+{
+    testFormat();
+    testRingFull();
+    return testResult("AsyncLogTest");
+}
@@ -0,0 +1,185 @@
+#include "CommandStats.h"
+
+#pragma mark - CLatencyHistogram
+void CLatencyHistogram::reset()
+{
+    memset(m_nBuckets, 0, sizeof(m_nBuckets));
+    m_nCount = 0;
+    m_nMinNs = 0;
+    m_nMaxNs = 0;
+    m_nSumNs = 0;
+}
+
+int CLatencyHistogram::bucketIndex(int64_t nUs)
+{
+    int nMsb = LATENCY_SUB_BUCKET_BITS;
+    int nShift;
+
+    if(nUs < 0)
+        nUs = 0;
+    if(nUs > LATENCY_MAX_US)
+        nUs = LATENCY_MAX_US;
+    if(nUs < LATENCY_SUB_BUCKETS)
+        return (int)nUs;
+
+    while((nUs >> (nMsb + 1)) != 0)
+        nMsb++;
+    // keep the LATENCY_SUB_BUCKET_BITS-1 bits below the most significant one
+    nShift = nMsb - (LATENCY_SUB_BUCKET_BITS - 1);
+    return LATENCY_SUB_BUCKETS + (nShift - 1) * (LATENCY_SUB_BUCKETS / 2) + (int)((nUs >> nShift) - LATENCY_SUB_BUCKETS / 2);
+}
+
+int64_t CLatencyHistogram::bucketLowUs(int nIndex)
+{
+    int nShift;
+
+    if(nIndex < LATENCY_SUB_BUCKETS)
+        return nIndex;
+    nShift = (nIndex - LATENCY_SUB_BUCKETS) / (LATENCY_SUB_BUCKETS / 2) + 1;
+    return (int64_t)((nIndex - LATENCY_SUB_BUCKETS) % (LATENCY_SUB_BUCKETS / 2) + LATENCY_SUB_BUCKETS / 2) << nShift;
+}
+
+int64_t CLatencyHistogram::bucketWidthUs(int nIndex)
+{
+    if(nIndex < LATENCY_SUB_BUCKETS)
+        return 1;
+    return 1LL << ((nIndex - LATENCY_SUB_BUCKETS) / (LATENCY_SUB_BUCKETS / 2) + 1);
+}
+
+void CLatencyHistogram::record(int64_t nNs)
+{
+    m_nBuckets[bucketIndex(nNs / 1000)]++;
+    if(!m_nCount || nNs < m_nMinNs)
+        m_nMinNs = nNs;
+    if(nNs > m_nMaxNs)
+        m_nMaxNs = nNs;
+    m_nSumNs += nNs;
+    m_nCount++;
+}
+
+int64_t CLatencyHistogram::percentileNs(double dPercentile) const
+{
+    uint64_t nTarget;
+    uint64_t nSeen = 0;
+    int64_t nValueNs;
+    int i;
+
+    if(!m_nCount)
+        return 0;
+    nTarget = (uint64_t)(dPercentile / 100.0 * (double)m_nCount + 0.5);
+    if(nTarget < 1)
+        nTarget = 1;
+    if(nTarget > m_nCount)
+        nTarget = m_nCount;
+
+    for(i = 0; i < LATENCY_NB_BUCKETS; i++) {
+        nSeen += m_nBuckets[i];
+        if(nSeen >= nTarget)
+            break;
+    }
+    nValueNs = (bucketLowUs(i) * 1000) + (bucketWidthUs(i) * 1000) / 2;
+    // the exact extremes are known, don't report past them
+    if(nValueNs < m_nMinNs)
+        nValueNs = m_nMinNs;
+    if(nValueNs > m_nMaxNs)
+        nValueNs = m_nMaxNs;
+    return nValueNs;
+}
+
+#pragma mark - CCommandStats
+void CCommandStats::reset()
+{
+    int i;
+
+    for(i = 0; i < IOPTRON_NB_COMMANDS; i++) {
+        m_Commands[i].nSent = 0;
+        m_Commands[i].nTimeouts = 0;
+        m_Commands[i].nErrors = 0;
+        m_Commands[i].nBytesWritten = 0;
+        m_Commands[i].nBytesRead = 0;
+        m_Commands[i].RoundTrip.reset();
+    }
+}
+
+void CCommandStats::record(int nCmdId, int64_t nRoundTripNs, bool bTimeout, bool bError, unsigned long nBytesWritten, unsigned long nBytesRead)
+{
+    iOptronCommandCounters *pCommand;
+
+    if(nCmdId < 0 || nCmdId >= IOPTRON_NB_COMMANDS)
+        return;
+
+    pCommand = &m_Commands[nCmdId];
+    pCommand->nSent++;
+    if(bTimeout)
+        pCommand->nTimeouts++;
+    else if(bError)
+        pCommand->nErrors++;
+    pCommand->nBytesWritten += nBytesWritten;
+    pCommand->nBytesRead += nBytesRead;
+    pCommand->RoundTrip.record(nRoundTripNs);
+}
+
+void CCommandStats::dump(FILE *pFile) const
+{
+    int i;
+    const iOptronCommandCounters *pCommand;
+
+    if(!pFile)
+        return;
+
+    fprintf(pFile, "%-14s %8s %8s %8s %10s %10s %10s %10s %10s %10s %10s %10s\n",
+            "command", "sent", "timeouts", "errors", "bytes out", "bytes in", "min ms", "p50 ms", "p90 ms", "p99 ms", "p99.9 ms", "max ms");
+    for(i = 0; i < IOPTRON_NB_COMMANDS; i++) {
+        pCommand = &m_Commands[i];
+        if(!pCommand->nSent)
+            continue;
+        fprintf(pFile, "%-14s %8lu %8lu %8lu %10lu %10lu %10.3f %10.3f %10.3f %10.3f %10.3f %10.3f\n",
+                commandInfo(i).pszCmd,
+                pCommand->nSent,
+                pCommand->nTimeouts,
+                pCommand->nErrors,
+                pCommand->nBytesWritten,
+                pCommand->nBytesRead,
+                pCommand->RoundTrip.minNs() / 1.0e6,
+                pCommand->RoundTrip.percentileNs(50.0) / 1.0e6,
+                pCommand->RoundTrip.percentileNs(90.0) / 1.0e6,
+                pCommand->RoundTrip.percentileNs(99.0) / 1.0e6,
+                pCommand->RoundTrip.percentileNs(99.9) / 1.0e6,
+                pCommand->RoundTrip.maxNs() / 1.0e6);
+    }
+    fflush(pFile);
+}
+
+int CCommandStats::formatTable(char *pszTable, int nMaxLen) const
+{
+    int i;
+    int nLen;
+    int nLineLen;
+    const iOptronCommandCounters *pCommand;
+
+    if(nMaxLen < 1)
+        return 0;
+    nLen = snprintf(pszTable, nMaxLen, "%-12s %6s %7s %7s %7s %4s %4s %8s\n", "command", "sent", "p50 ms", "p99 ms", "max ms", "tmo", "err", "out/in");
+    for(i = 0; i < IOPTRON_NB_COMMANDS && nLen < nMaxLen; i++) {
+        pCommand = &m_Commands[i];
+        if(!pCommand->nSent)
+            continue;
+        nLineLen = snprintf(pszTable + nLen, nMaxLen - nLen, "%-12s %6lu %7.1f %7.1f %7.1f %4lu %4lu %4lu/%lu\n",
+                commandInfo(i).pszCmd,
+                pCommand->nSent,
+                pCommand->RoundTrip.percentileNs(50.0) / 1.0e6,
+                pCommand->RoundTrip.percentileNs(99.0) / 1.0e6,
+                pCommand->RoundTrip.maxNs() / 1.0e6,
+                pCommand->nTimeouts,
+                pCommand->nErrors,
+                pCommand->nBytesWritten,
+                pCommand->nBytesRead);
+        if(nLineLen >= nMaxLen - nLen)
+            break;  // keep whole lines only
+        nLen += nLineLen;
+    }
+    if(nLen >= nMaxLen)
+        nLen = nMaxLen - 1;
+    pszTable[nLen] = 0;
+    return nLen;
+}
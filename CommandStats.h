@@ -0,0 +1,71 @@
+#pragma once
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "iOptronCommands.h"
+
+// Round trip latency distribution, HDR histogram style : microsecond values, exact below
+// LATENCY_SUB_BUCKETS, then every power of 2 split in LATENCY_SUB_BUCKETS/2 linear buckets,
+// so any recorded value is known to within 1/16 (6.25%) from 1 us up to LATENCY_MAX_US.
+// Recording is an index computation and an increment, no allocation.
+
+#define LATENCY_SUB_BUCKET_BITS 5
+#define LATENCY_SUB_BUCKETS     (1 << LATENCY_SUB_BUCKET_BITS)
+#define LATENCY_MAX_US_BITS     27  // 134 s, longer round trips are counted in the last bucket
+#define LATENCY_MAX_US          ((1LL << LATENCY_MAX_US_BITS) - 1)
+#define LATENCY_NB_BUCKETS      (LATENCY_SUB_BUCKETS + (LATENCY_MAX_US_BITS - LATENCY_SUB_BUCKET_BITS) * (LATENCY_SUB_BUCKETS / 2))
+
+class CLatencyHistogram
+{
+public:
+    CLatencyHistogram() { reset(); }
+
+    void        reset();
+    void        record(int64_t nNs);
+
+    uint64_t    count() const { return m_nCount; }
+    int64_t     minNs() const { return m_nCount ? m_nMinNs : 0; }
+    int64_t     maxNs() const { return m_nMaxNs; }
+    int64_t     meanNs() const { return m_nCount ? m_nSumNs / (int64_t)m_nCount : 0; }
+    // value below which dPercentile % of the samples are, middle of the bucket, 0 if empty
+    int64_t     percentileNs(double dPercentile) const;
+
+    static int      bucketIndex(int64_t nUs);
+    static int64_t  bucketLowUs(int nIndex);
+    static int64_t  bucketWidthUs(int nIndex);
+
+private:
+    uint32_t    m_nBuckets[LATENCY_NB_BUCKETS];
+    uint64_t    m_nCount;
+    int64_t     m_nMinNs;
+    int64_t     m_nMaxNs;
+    int64_t     m_nSumNs;
+};
+
+typedef struct {
+    unsigned long       nSent;
+    unsigned long       nTimeouts;      // fewer reply bytes than the catalog says before the read timed out
+    unsigned long       nErrors;        // any other write or read failure
+    unsigned long       nBytesWritten;
+    unsigned long       nBytesRead;
+    CLatencyHistogram   RoundTrip;      // write to end of read, failures included
+} iOptronCommandCounters;
+
+// Per catalog command link statistics, kept by CiOptron::sendCommand() for the session.
+class CCommandStats
+{
+public:
+    CCommandStats() { reset(); }
+
+    void    reset();
+    void    record(int nCmdId, int64_t nRoundTripNs, bool bTimeout, bool bError, unsigned long nBytesWritten, unsigned long nBytesRead);
+    const iOptronCommandCounters &counters(int nCmdId) const { return m_Commands[nCmdId]; }
+
+    void    dump(FILE *pFile) const;
+    // same table, one line per command used, for the settings dialog. Returns the length written.
+    int     formatTable(char *pszTable, int nMaxLen) const;
+
+private:
+    iOptronCommandCounters  m_Commands[IOPTRON_NB_COMMANDS];
+};
@@ -0,0 +1,162 @@
+// Host call round trip budgets (s_HostCallBudgets in HostCallStats.cpp) checked against what X2Mount
+// actually sends. Every host call is driven through its worst path against a simulated mount : the
+// virtual clock is moved past every cache and poll interval between calls, so nothing is answered
+// from cache that could be re-read. Built and run by make test.
+//
+// Not driven : deviceInfo (needs the host BasicStringInterface), execModalSettingsDialog (UI) and
+// the auto date / time part of establishLink (needs the TheSkyX facade).
+
+#include "TestCheck.h"
+#include "X2Fakes.h"
+#include "SimulatedMount.h"
+#include "x2mount.h"
+
+#define START_NS    (1000 * NS_PER_SECOND)
+#define MAX_POLLS   20
+
+static X2Mount *newMount(CSimulatedMount &mount, CVirtualClock &clock)
+{
+    X2Mount *pMount;
+
+    // X2Mount owns and deletes the interfaces it is given
+    pMount = new X2Mount("iOptronV3", 0, new CSimulatedSerial(mount, &clock), NULL, new CFakeSleeper(&clock),
+                         new CFakeIniUtil(), new CFakeLogger(), new CFakeMutex(), new CFakeTickCount());
+    pMount->setClock(&clock);
+    return pMount;
+}
+
+// past the position cache, the status timers and the slew poll interval
+static void later(CVirtualClock &clock)
+{
+    clock.advance(3 * NS_PER_SECOND);
+}
+
+static void checkBudgets(const CHostCallStats &stats)
+{
+    int nCall;
+
+    for(nCall = 0; nCall < X2_NB_HOST_CALLS; nCall++) {
+        const X2HostCallCounters &counters = stats.counters(nCall);
+        const X2HostCallBudget &budget = CHostCallStats::callBudget(nCall);
+        if(!counters.nCalls || budget.nMaxCommands == X2_NO_BUDGET)
+            continue;
+        if(counters.nMaxCommands > budget.nMaxCommands || counters.nMaxBytesRead > budget.nMaxBytesRead) {
+            fprintf(stderr, "%s : %lu commands, %lu bytes read, budget %lu, %lu\n", CHostCallStats::callName(nCall),
+                    counters.nMaxCommands, counters.nMaxBytesRead, budget.nMaxCommands, budget.nMaxBytesRead);
+            testFailures()++;
+        }
+    }
+    TEST_CHECK_EQUAL(stats.overBudgetCount(), 0);
+}
+
+static void testAllHostCalls()
+{
+    CSimulatedMount mount(120);
+    CVirtualClock clock(START_NS);
+    X2Mount *pMount = newMount(mount, clock);
+    double dRa, dDec, dRaRate, dDecRate, dHoursEast, dHoursWest;
+    bool bTrackingOn, bComplete;
+    int nCall;
+    int i;
+
+    TEST_CHECK_EQUAL(pMount->establishLink(), SB_OK);
+
+    later(clock);
+    TEST_CHECK_EQUAL(pMount->raDec(dRa, dDec), SB_OK);
+    later(clock);
+    pMount->isSynced();
+    TEST_CHECK_EQUAL(pMount->syncMount(5.0, 20.0), SB_OK);
+    later(clock);
+    pMount->needsRefactionAdjustments();
+    pMount->gemLimits(dHoursEast, dHoursWest);
+    pMount->rateCountOpenLoopMove();
+
+    later(clock);
+    TEST_CHECK_EQUAL(pMount->trackingRates(bTrackingOn, dRaRate, dDecRate), SB_OK);
+    TEST_CHECK_EQUAL(pMount->setTrackingRates(true, false, 0.5, 0.1), SB_OK);   // custom rate
+    TEST_CHECK_EQUAL(pMount->setTrackingRates(true, true, 0.0, 0.0), SB_OK);
+    TEST_CHECK_EQUAL(pMount->setTrackingRates(false, true, 0.0, 0.0), SB_OK);
+    TEST_CHECK_EQUAL(pMount->siderealTrackingOn(), SB_OK);
+    TEST_CHECK_EQUAL(pMount->trackingOff(), SB_OK);
+
+    later(clock);
+    TEST_CHECK_EQUAL(pMount->startOpenLoopMove(MountDriverInterface::MD_NORTH, 3), SB_OK);
+    later(clock);
+    TEST_CHECK_EQUAL(pMount->endOpenLoopMove(), SB_OK);
+
+    later(clock);
+    TEST_CHECK_EQUAL(pMount->startSlewTo(8.0, 40.0), SB_OK);
+    bComplete = false;
+    for(i = 0; i < MAX_POLLS && !bComplete; i++) {
+        later(clock);
+        TEST_CHECK_EQUAL(pMount->isCompleteSlewTo(bComplete), SB_OK);
+    }
+    TEST_CHECK(bComplete);
+    later(clock);
+    TEST_CHECK_EQUAL(pMount->endSlewTo(), SB_OK);
+
+    later(clock);
+    TEST_CHECK_EQUAL(pMount->startSlewTo(2.0, -10.0), SB_OK);
+    later(clock);
+    TEST_CHECK_EQUAL(pMount->startOpenLoopMove(MountDriverInterface::MD_EAST, 3), SB_OK);    // stops the slew first
+    TEST_CHECK_EQUAL(pMount->endOpenLoopMove(), SB_OK);
+    later(clock);
+    TEST_CHECK_EQUAL(pMount->abort(), SB_OK);
+
+    later(clock);
+    TEST_CHECK_EQUAL(pMount->startPark(0.0, 90.0), SB_OK);
+    bComplete = false;
+    for(i = 0; i < MAX_POLLS && !bComplete; i++) {
+        later(clock);
+        TEST_CHECK_EQUAL(pMount->isCompletePark(bComplete), SB_OK);
+    }
+    TEST_CHECK(bComplete);
+    later(clock);
+    TEST_CHECK(pMount->isParked());
+
+    later(clock);
+    TEST_CHECK_EQUAL(pMount->startUnpark(), SB_OK);
+    bComplete = false;
+    for(i = 0; i < MAX_POLLS && !bComplete; i++) {
+        later(clock);
+        TEST_CHECK_EQUAL(pMount->isCompleteUnpark(bComplete), SB_OK);
+    }
+    TEST_CHECK(bComplete);
+    TEST_CHECK_EQUAL(pMount->terminateLink(), SB_OK);
+
+    checkBudgets(pMount->hostCallStats());
+    for(nCall = 0; nCall < X2_NB_HOST_CALLS; nCall++) {
+        if(nCall == X2_CALL_DEVICE_INFO || nCall == X2_CALL_SETTINGS_DIALOG)
+            continue;
+        if(!pMount->hostCallStats().counters(nCall).nCalls) {
+            fprintf(stderr, "%s was not driven\n", CHostCallStats::callName(nCall));
+            testFailures()++;
+        }
+    }
+    TEST_CHECK_EQUAL(mount.unknownCommands(), 0);
+    if(testFailures())
+        pMount->hostCallStats().dump(stderr);
+    delete pMount;
+}
+
+// a 9600 bauds mount : the 115200 probe goes unanswered, then the probe at 9600
+static void testEstablishLinkFallback()
+{
+    CSimulatedMount mount(60);
+    CVirtualClock clock(START_NS);
+    X2Mount *pMount = newMount(mount, clock);
+
+    TEST_CHECK_EQUAL(pMount->establishLink(), SB_OK);
+    TEST_CHECK_EQUAL(pMount->hostCallStats().counters(X2_CALL_ESTABLISH_LINK).nMaxCommands, 6);
+    checkBudgets(pMount->hostCallStats());
+    TEST_CHECK_EQUAL(mount.unknownCommands(), 0);
+    TEST_CHECK_EQUAL(pMount->terminateLink(), SB_OK);
+    delete pMount;
+}
+
+int main()
+{
+    testAllHostCalls();
+    testEstablishLinkFallback();
+    return testResult("HostCallBudgetTest");
+}
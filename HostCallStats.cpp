@@ -0,0 +1,287 @@
+#include "HostCallStats.h"
+
+static const char *s_szHostCallNames[X2_NB_HOST_CALLS] = {
+    "raDec", "abort", "startSlewTo", "isCompleteSlewTo", "endSlewTo",
+    "syncMount", "isSynced", "setTrackingRates", "trackingRates",
+    "siderealTrackingOn", "trackingOff", "needsRefactionAdjustments",
+    "isParked", "startPark", "isCompletePark", "startUnpark", "isCompleteUnpark",
+    "startOpenLoopMove", "endOpenLoopMove", "rateCountOpenLoopMove", "gemLimits",
+    "establishLink", "terminateLink", "deviceInfo", "execModalSettingsDialog"
+};
+
+static const char *s_szPhaseNames[X2_NB_PHASES] = {
+    "mutex wait", "serial write", "mount wait", "serial read", "parse", "driver"
+};
+
+// Round trips and bytes read each call needs today, in the worst path through the code, with every
+// reply arriving. Retries after a timeout or a bad reply go over budget, as they should.
+// A change making a call go over its budget shows up in overBudgetCount() and in the dump.
+// HostCallBudgetTest (make test) drives the host calls against a simulated mount and checks them.
+static const X2HostCallBudget s_HostCallBudgets[X2_NB_HOST_CALLS] = {
+    {1, 21},    // raDec : :GEP#
+    {2, 2},     // abort : :Q# :ST0#
+    {5, 28},    // startSlewTo : :GLS# :SRA :Sd :MS1#/:MS2# :MS1#
+    {1, 24},    // isCompleteSlewTo : :GLS#
+    {2, 22},    // endSlewTo : :GEP# :MS1#
+    {3, 3},     // syncMount : :SRA :Sd :CM#
+    {1, 24},    // isSynced : :GLS#
+    {2, 2},     // setTrackingRates : :RR :RT4#
+    {1, 24},    // trackingRates : :GLS#
+    {2, 2},     // siderealTrackingOn : :RT0# :ST1#
+    {1, 1},     // trackingOff : :ST0#
+    {0, 0},     // needsRefactionAdjustments : cached model
+    {2, 48},    // isParked : :GLS# x 2
+    {1, 1},     // startPark : :MP1#
+    {1, 24},    // isCompletePark : :GLS#
+    {1, 1},     // startUnpark : :MP0#
+    {2, 48},    // isCompleteUnpark : :GLS# x 2
+    {4, 26},    // startOpenLoopMove : :GLS# :Q# :SRn# :mx#
+    {2, 2},     // endOpenLoopMove : :qD# :qR#
+    {0, 0},     // rateCountOpenLoopMove
+    {0, 0},     // gemLimits : cached
+    {12, 70},   // establishLink : :MountInfo# x 2 (other speed) :RT3# :GMT# :GAL# :GLS#, with auto time :SDS :SG :SUT :SLA :SLO :GLS#
+    {0, 0},     // terminateLink
+    {2, 26},    // deviceInfo : :FW1# :FW2#
+    {X2_NO_BUDGET, X2_NO_BUDGET}    // execModalSettingsDialog : polls the mount for as long as it's open
+};
+
+const char *CHostCallStats::callName(int nCall)
+{
+    if(nCall < 0 || nCall >= X2_NB_HOST_CALLS)
+        return "unknown";
+    return s_szHostCallNames[nCall];
+}
+
+const char *CHostCallStats::phaseName(int nPhase)
+{
+    if(nPhase < 0 || nPhase >= X2_NB_PHASES)
+        return "unknown";
+    return s_szPhaseNames[nPhase];
+}
+
+const X2HostCallBudget &CHostCallStats::callBudget(int nCall)
+{
+    return s_HostCallBudgets[nCall];
+}
+
+void CHostCallStats::reset()
+{
+    int i, j;
+
+    memset(m_Calls, 0, sizeof(m_Calls));
+    m_MutexProfiler.reset();
+    for(i = 0; i < X2_NB_HOST_CALLS; i++) {
+        m_Latency[i].Total.reset();
+        m_Latency[i].nTotalNs = 0;
+        for(j = 0; j < X2_NB_PHASES; j++) {
+            m_Latency[i].Phases[j].reset();
+            m_Latency[i].nPhaseNs[j] = 0;
+        }
+    }
+}
+
+void CHostCallStats::record(int nCall, const iOptronTrafficCounters &delta, float fHoldSeconds, float fStalenessSeconds)
+{
+    X2HostCallCounters *pCall;
+
+    if(nCall < 0 || nCall >= X2_NB_HOST_CALLS)
+        return;
+
+    pCall = &m_Calls[nCall];
+    pCall->nCalls++;
+    pCall->nCommands += delta.nCommands;
+    pCall->nBytesWritten += delta.nBytesWritten;
+    pCall->nBytesRead += delta.nBytesRead;
+    pCall->dHoldSeconds += fHoldSeconds;
+    if(fHoldSeconds > pCall->fMaxHoldSeconds)
+        pCall->fMaxHoldSeconds = fHoldSeconds;
+
+    if(delta.nCommands > pCall->nMaxCommands)
+        pCall->nMaxCommands = delta.nCommands;
+    if(delta.nBytesRead > pCall->nMaxBytesRead)
+        pCall->nMaxBytesRead = delta.nBytesRead;
+    if(delta.nCommands > s_HostCallBudgets[nCall].nMaxCommands || delta.nBytesRead > s_HostCallBudgets[nCall].nMaxBytesRead)
+        pCall->nOverBudget++;
+
+    if(fStalenessSeconds > 0.0) {
+        pCall->nCachedAnswers++;
+        pCall->dStalenessSeconds += fStalenessSeconds;
+        if(fStalenessSeconds > pCall->fMaxStalenessSeconds)
+            pCall->fMaxStalenessSeconds = fStalenessSeconds;
+    }
+}
+
+void CHostCallStats::recordPhases(int nCall, const int64_t (&nPhaseNs)[X2_NB_PHASES])
+{
+    X2HostCallLatency *pLatency;
+    int64_t nTotalNs = 0;
+    int i;
+
+    if(nCall < 0 || nCall >= X2_NB_HOST_CALLS)
+        return;
+
+    pLatency = &m_Latency[nCall];
+    for(i = 0; i < X2_NB_PHASES; i++) {
+        pLatency->Phases[i].record(nPhaseNs[i]);
+        pLatency->nPhaseNs[i] += nPhaseNs[i];
+        nTotalNs += nPhaseNs[i];
+    }
+    pLatency->Total.record(nTotalNs);
+    pLatency->nTotalNs += nTotalNs;
+}
+
+void CHostCallStats::dump(FILE *pFile) const
+{
+    int i;
+    const X2HostCallCounters *pCall;
+
+    if(!pFile)
+        return;
+
+    fprintf(pFile, "%-26s %8s %10s %10s %10s %12s %12s %8s %12s %12s %10s %10s\n",
+            "host call", "calls", "cmds/call", "out/call", "in/call", "hold ms avg", "hold ms max", "cached", "stale ms avg", "stale ms max", "cmds max", "over bdgt");
+    for(i = 0; i < X2_NB_HOST_CALLS; i++) {
+        pCall = &m_Calls[i];
+        if(!pCall->nCalls)
+            continue;
+        fprintf(pFile, "%-26s %8lu %10.2f %10.1f %10.1f %12.3f %12.3f %8lu %12.3f %12.3f %10lu %10lu\n",
+                s_szHostCallNames[i],
+                pCall->nCalls,
+                double(pCall->nCommands) / pCall->nCalls,
+                double(pCall->nBytesWritten) / pCall->nCalls,
+                double(pCall->nBytesRead) / pCall->nCalls,
+                pCall->dHoldSeconds * 1000.0 / pCall->nCalls,
+                pCall->fMaxHoldSeconds * 1000.0,
+                pCall->nCachedAnswers,
+                pCall->nCachedAnswers ? pCall->dStalenessSeconds * 1000.0 / pCall->nCachedAnswers : 0.0,
+                pCall->fMaxStalenessSeconds * 1000.0,
+                pCall->nMaxCommands,
+                pCall->nOverBudget);
+    }
+    for(i = 0; i < X2_NB_HOST_CALLS; i++) {
+        pCall = &m_Calls[i];
+        if(pCall->nOverBudget)
+            fprintf(pFile, "WARNING : %s went over its budget of %lu commands / %lu bytes read %lu times (worst %lu commands / %lu bytes)\n",
+                    s_szHostCallNames[i],
+                    s_HostCallBudgets[i].nMaxCommands, s_HostCallBudgets[i].nMaxBytesRead,
+                    pCall->nOverBudget, pCall->nMaxCommands, pCall->nMaxBytesRead);
+    }
+    fflush(pFile);
+}
+
+void CHostCallStats::report(FILE *pFile) const
+{
+    int nRanked[X2_NB_HOST_CALLS];
+    int nNbRanked = 0;
+    int64_t nAllNs = 0;
+    int i, j, nTmp;
+    const X2HostCallLatency *pLatency;
+    const CLatencyHistogram *pPhase;
+
+    if(!pFile)
+        return;
+
+    for(i = 0; i < X2_NB_HOST_CALLS; i++) {
+        if(!m_Latency[i].Total.count())
+            continue;
+        nAllNs += m_Latency[i].nTotalNs;
+        // insertion sort, costliest first
+        for(j = nNbRanked; j > 0 && m_Latency[nRanked[j-1]].nTotalNs < m_Latency[i].nTotalNs; j--)
+            nRanked[j] = nRanked[j-1];
+        nRanked[j] = i;
+        nNbRanked++;
+    }
+
+    fprintf(pFile, "%4s %-26s %8s %12s %7s %10s %10s %10s %10s\n",
+            "rank", "host call / phase", "calls", "total ms", "share", "mean ms", "p50 ms", "p99 ms", "max ms");
+    for(i = 0; i < nNbRanked; i++) {
+        nTmp = nRanked[i];
+        pLatency = &m_Latency[nTmp];
+        fprintf(pFile, "%4d %-26s %8llu %12.3f %6.1f%% %10.3f %10.3f %10.3f %10.3f\n",
+                i + 1,
+                s_szHostCallNames[nTmp],
+                (unsigned long long)pLatency->Total.count(),
+                pLatency->nTotalNs / 1.0e6,
+                nAllNs ? pLatency->nTotalNs * 100.0 / nAllNs : 0.0,
+                pLatency->Total.meanNs() / 1.0e6,
+                pLatency->Total.percentileNs(50.0) / 1.0e6,
+                pLatency->Total.percentileNs(99.0) / 1.0e6,
+                pLatency->Total.maxNs() / 1.0e6);
+        // share of the phases is within the call
+        for(j = 0; j < X2_NB_PHASES; j++) {
+            pPhase = &pLatency->Phases[j];
+            if(!pLatency->nPhaseNs[j])
+                continue;
+            fprintf(pFile, "%4s   %-24s %8s %12.3f %6.1f%% %10.3f %10.3f %10.3f %10.3f\n",
+                    "",
+                    s_szPhaseNames[j],
+                    "",
+                    pLatency->nPhaseNs[j] / 1.0e6,
+                    pLatency->nTotalNs ? pLatency->nPhaseNs[j] * 100.0 / pLatency->nTotalNs : 0.0,
+                    pPhase->meanNs() / 1.0e6,
+                    pPhase->percentileNs(50.0) / 1.0e6,
+                    pPhase->percentileNs(99.0) / 1.0e6,
+                    pPhase->maxNs() / 1.0e6);
+        }
+    }
+    fprintf(pFile, "\n");
+    m_MutexProfiler.dump(pFile, callName);
+}
+
+unsigned long CHostCallStats::overBudgetCount() const
+{
+    int i;
+    unsigned long nTotal = 0;
+
+    for(i = 0; i < X2_NB_HOST_CALLS; i++)
+        nTotal += m_Calls[i].nOverBudget;
+    return nTotal;
+}
+
+CHostCallProbe::CHostCallProbe(CHostCallStats &stats, CiOptron &mount, int nCall, MutexInterface *pMutex)
+    : m_Stats(stats), m_Mount(mount), m_nCall(nCall), m_Locker(stats.mutexProfiler(), pMutex, nCall, mount.clock()), m_HoldTimer(mount.clock())
+{
+    m_Mount.getTrafficCounters(m_Start);
+    m_Mount.getPhaseTimes(m_StartPhases);
+    m_Mount.resetLastResponseAge();
+    m_Mount.transportRecorder().setHostCall(CHostCallStats::callName(m_nCall));
+}
+
+CHostCallProbe::~CHostCallProbe()
+{
+    iOptronTrafficCounters now;
+    iOptronTrafficCounters delta;
+    iOptronPhaseTimes nowPhases;
+    int64_t nPhaseNs[X2_NB_PHASES];
+    int64_t nHoldNs;
+    int i;
+
+    m_Mount.transportRecorder().setHostCall(NULL);
+    nHoldNs = m_HoldTimer.elapsedNs();
+
+    m_Mount.getTrafficCounters(now);
+    delta.nCommands = now.nCommands - m_Start.nCommands;
+    delta.nBytesWritten = now.nBytesWritten - m_Start.nBytesWritten;
+    delta.nBytesRead = now.nBytesRead - m_Start.nBytesRead;
+
+    m_Stats.record(m_nCall, delta, (float)nsToSeconds(nHoldNs), m_Mount.getLastResponseAge());
+
+    m_Mount.getPhaseTimes(nowPhases);
+    nPhaseNs[X2_PHASE_MUTEX_WAIT] = m_Locker.waitNs();
+    nPhaseNs[X2_PHASE_SERIAL_WRITE] = nowPhases.nNs[PHASE_SERIAL_WRITE] - m_StartPhases.nNs[PHASE_SERIAL_WRITE];
+    nPhaseNs[X2_PHASE_MOUNT_WAIT] = nowPhases.nNs[PHASE_MOUNT_WAIT] - m_StartPhases.nNs[PHASE_MOUNT_WAIT];
+    nPhaseNs[X2_PHASE_SERIAL_READ] = nowPhases.nNs[PHASE_SERIAL_READ] - m_StartPhases.nNs[PHASE_SERIAL_READ];
+    nPhaseNs[X2_PHASE_PARSE] = nowPhases.nNs[PHASE_PARSE] - m_StartPhases.nNs[PHASE_PARSE];
+    nPhaseNs[X2_PHASE_DRIVER] = nHoldNs;
+    for(i = X2_PHASE_SERIAL_WRITE; i <= X2_PHASE_PARSE; i++)
+        nPhaseNs[X2_PHASE_DRIVER] -= nPhaseNs[i];
+    if(nPhaseNs[X2_PHASE_DRIVER] < 0)   // the mount clock was swapped during the call
+        nPhaseNs[X2_PHASE_DRIVER] = 0;
+
+    m_Stats.recordPhases(m_nCall, nPhaseNs);
+
+    if(m_Mount.trace().enabled()) {
+        m_Mount.trace().span(CHostCallStats::callName(m_nCall), "x2", m_Locker.lockedNs() - m_Locker.waitNs(), m_Locker.lockedNs() + nHoldNs);
+        m_Mount.trace().span("mutex wait", "mutex", m_Locker.lockedNs() - m_Locker.waitNs(), m_Locker.lockedNs(), m_Locker.contended() ? "contended" : NULL);
+    }
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include <stdio.h>
+#include <string.h>
+
+#include "MonotonicClock.h"
+#include "CommandStats.h"
+#include "MutexProfiler.h"
+#include "iOptronV3.h"
+
+// Host (TheSkyX) facing calls we account serial traffic for.
+enum X2HostCall {   X2_CALL_RADEC=0, X2_CALL_ABORT, X2_CALL_START_SLEW_TO, X2_CALL_IS_COMPLETE_SLEW_TO, X2_CALL_END_SLEW_TO,
+                    X2_CALL_SYNC_MOUNT, X2_CALL_IS_SYNCED, X2_CALL_SET_TRACKING_RATES, X2_CALL_TRACKING_RATES,
+                    X2_CALL_SIDEREAL_TRACKING_ON, X2_CALL_TRACKING_OFF, X2_CALL_NEEDS_REFRACTION,
+                    X2_CALL_IS_PARKED, X2_CALL_START_PARK, X2_CALL_IS_COMPLETE_PARK, X2_CALL_START_UNPARK, X2_CALL_IS_COMPLETE_UNPARK,
+                    X2_CALL_START_OPEN_LOOP_MOVE, X2_CALL_END_OPEN_LOOP_MOVE, X2_CALL_RATE_COUNT_OPEN_LOOP_MOVE, X2_CALL_GEM_LIMITS,
+                    X2_CALL_ESTABLISH_LINK, X2_CALL_TERMINATE_LINK, X2_CALL_DEVICE_INFO, X2_CALL_SETTINGS_DIALOG,
+                    X2_NB_HOST_CALLS};
+
+static_assert(X2_NB_HOST_CALLS <= MUTEX_PROFILER_MAX_SITES, "host calls are the mutex profiler call sites");
+
+typedef struct {
+    unsigned long   nCalls;
+    unsigned long   nCommands;          // serial commands issued by these calls
+    unsigned long   nBytesWritten;
+    unsigned long   nBytesRead;
+    double          dHoldSeconds;       // total time spent holding the I/O mutex
+    float           fMaxHoldSeconds;
+    unsigned long   nCachedAnswers;     // calls answered from cached data
+    double          dStalenessSeconds;  // sum of the age of the cached data returned
+    float           fMaxStalenessSeconds;
+    unsigned long   nOverBudget;        // calls that went over their round trip budget
+    unsigned long   nMaxCommands;       // worst case seen
+    unsigned long   nMaxBytesRead;
+} X2HostCallCounters;
+
+// Where the wall time of a host call goes. Serial and parse phases come from CiOptron's
+// iOptronPhaseTimes, driver is the rest of the time the mutex is held (logging, conversions, sleeps).
+enum X2CallPhase {  X2_PHASE_MUTEX_WAIT=0, X2_PHASE_SERIAL_WRITE, X2_PHASE_MOUNT_WAIT, X2_PHASE_SERIAL_READ, X2_PHASE_PARSE, X2_PHASE_DRIVER,
+                    X2_NB_PHASES};
+
+typedef struct {
+    CLatencyHistogram   Total;                  // mutex wait + hold
+    CLatencyHistogram   Phases[X2_NB_PHASES];
+    int64_t             nTotalNs;
+    int64_t             nPhaseNs[X2_NB_PHASES];
+} X2HostCallLatency;
+
+#define X2_NO_BUDGET    0xFFFFFFFFUL
+
+// Upper bound of serial traffic a single host call is expected to generate.
+typedef struct {
+    unsigned long   nMaxCommands;
+    unsigned long   nMaxBytesRead;
+} X2HostCallBudget;
+
+// Aggregated per host call serial traffic, so caching changes can be judged on numbers.
+class CHostCallStats
+{
+public:
+    CHostCallStats() { reset(); }
+
+    void reset();
+    void record(int nCall, const iOptronTrafficCounters &delta, float fHoldSeconds, float fStalenessSeconds);
+    void recordPhases(int nCall, const int64_t (&nPhaseNs)[X2_NB_PHASES]);
+    const X2HostCallCounters &counters(int nCall) const { return m_Calls[nCall]; }
+    const X2HostCallLatency &latency(int nCall) const { return m_Latency[nCall]; }
+    CMutexProfiler &mutexProfiler() { return m_MutexProfiler; }
+    void dump(FILE *pFile) const;
+    // host calls ranked by total time spent in them, with the per phase breakdown and the mutex contention
+    void report(FILE *pFile) const;
+    unsigned long overBudgetCount() const;
+
+    static const char *callName(int nCall);
+    static const char *phaseName(int nPhase);
+    static const X2HostCallBudget &callBudget(int nCall);
+
+private:
+    X2HostCallCounters  m_Calls[X2_NB_HOST_CALLS];
+    X2HostCallLatency   m_Latency[X2_NB_HOST_CALLS];
+    CMutexProfiler      m_MutexProfiler;    // call sites are the X2HostCall
+};
+
+// Takes the X2 mutex for the lifetime of the host call, so the time waiting for it and the
+// time holding it are told apart, and the mount counters are only read while it's held.
+class CHostCallProbe
+{
+public:
+    CHostCallProbe(CHostCallStats &stats, CiOptron &mount, int nCall, MutexInterface *pMutex);
+    ~CHostCallProbe();
+
+private:
+    CHostCallStats          &m_Stats;
+    CiOptron                &m_Mount;
+    int                     m_nCall;
+    CProfiledMutexLocker    m_Locker;
+    CClockTimer             m_HoldTimer;    // after m_Locker, starts once the mutex is held
+    iOptronTrafficCounters  m_Start;
+    iOptronPhaseTimes       m_StartPhases;
+};
@@ -0,0 +1,122 @@
+#include "LinkHealth.h"
+
+static const char *s_szLinkStateNames[] = {"healthy", "degraded", "poor"};
+
+void CLinkHealth::reset()
+{
+    memset(&m_Total, 0, sizeof(m_Total));
+    memset(&m_Window, 0, sizeof(m_Window));
+    memset(m_nEvents, 0, sizeof(m_nEvents));
+    memset(m_nBytes, 0, sizeof(m_nBytes));
+    m_nNext = 0;
+}
+
+void CLinkHealth::count(iOptronLinkCounters &counters, unsigned nEvents, unsigned long nUnexpectedBytes, long nSign)
+{
+    counters.nExchanges += nSign;
+    if(nEvents & LINK_EVENT_TIMEOUT)
+        counters.nTimeouts += nSign;
+    if(nEvents & LINK_EVENT_SHORT_READ)
+        counters.nShortReads += nSign;
+    if(nEvents & LINK_EVENT_RESYNC)
+        counters.nResyncs += nSign;
+    if(nEvents & LINK_EVENT_RETRY)
+        counters.nRetries += nSign;
+    if(nEvents & LINK_EVENT_BAD_FRAME)
+        counters.nBadFrames += nSign;
+    counters.nUnexpectedBytes += nSign * (long)nUnexpectedBytes;
+}
+
+void CLinkHealth::record(unsigned nEvents, unsigned long nUnexpectedBytes)
+{
+    // the oldest exchange leaves the window once it's full
+    if(m_Window.nExchanges == LINK_HEALTH_WINDOW)
+        count(m_Window, m_nEvents[m_nNext], m_nBytes[m_nNext], -1);
+    m_nEvents[m_nNext] = (unsigned char)nEvents;
+    m_nBytes[m_nNext] = nUnexpectedBytes;
+    m_nNext = (m_nNext + 1) % LINK_HEALTH_WINDOW;
+
+    count(m_Window, nEvents, nUnexpectedBytes, 1);
+    count(m_Total, nEvents, nUnexpectedBytes, 1);
+}
+
+int CLinkHealth::score() const
+{
+    unsigned long nPenalty;
+
+    if(!m_Window.nExchanges)
+        return 100;
+    // a failed exchange costs a full point, a resync half of one. Retries aren't penalised,
+    // the failure that caused them already was.
+    nPenalty = 2 * (m_Window.nTimeouts + m_Window.nShortReads + m_Window.nBadFrames) + m_Window.nResyncs;
+    if(nPenalty >= 2 * m_Window.nExchanges)
+        return 0;
+    return (int)(100 - (100 * nPenalty) / (2 * m_Window.nExchanges));
+}
+
+int CLinkHealth::state() const
+{
+    int nScore = score();
+
+    if(nScore >= LINK_HEALTHY_SCORE)
+        return LINK_HEALTHY;
+    if(nScore >= LINK_DEGRADED_SCORE)
+        return LINK_DEGRADED;
+    return LINK_POOR;
+}
+
+const char *CLinkHealth::stateName(int nState)
+{
+    if(nState < LINK_HEALTHY || nState > LINK_POOR)
+        return "unknown";
+    return s_szLinkStateNames[nState];
+}
+
+int CLinkHealth::timeoutMs(int nBaseMs) const
+{
+    // a slow or noisy link gets more time before we give up on a reply
+    switch(state()) {
+        case LINK_DEGRADED:
+            return nBaseMs + nBaseMs / 2;
+        case LINK_POOR:
+            return 2 * nBaseMs;
+        default:
+            return nBaseMs;
+    }
+}
+
+int CLinkHealth::retries(const iOptronCommand &command) const
+{
+    // sending a motion or set command twice could move the mount twice
+    if(command.bMutates)
+        return 0;
+    return state() == LINK_HEALTHY ? 1 : 2;
+}
+
+int CLinkHealth::format(char *pszLine, int nMaxLen) const
+{
+    int nLen;
+
+    if(nMaxLen < 1)
+        return 0;
+    nLen = snprintf(pszLine, nMaxLen, "link %s, health %d/100 over %lu exchanges : %lu tmo %lu short %lu resync %lu retry %lu bad frame %lu bytes\n",
+                    stateName(state()), score(), m_Window.nExchanges,
+                    m_Window.nTimeouts, m_Window.nShortReads, m_Window.nResyncs, m_Window.nRetries, m_Window.nBadFrames, m_Window.nUnexpectedBytes);
+    if(nLen >= nMaxLen)
+        nLen = nMaxLen - 1;
+    return nLen;
+}
+
+void CLinkHealth::dump(FILE *pFile) const
+{
+    if(!pFile)
+        return;
+
+    fprintf(pFile, "link health %d/100 (%s) over the last %lu exchanges\n", score(), stateName(state()), m_Window.nExchanges);
+    fprintf(pFile, "%-12s %10s %10s %10s %10s %10s %10s %12s\n", "", "exchanges", "timeouts", "short", "resyncs", "retries", "bad frame", "unexp bytes");
+    fprintf(pFile, "%-12s %10lu %10lu %10lu %10lu %10lu %10lu %12lu\n", "window",
+            m_Window.nExchanges, m_Window.nTimeouts, m_Window.nShortReads, m_Window.nResyncs, m_Window.nRetries, m_Window.nBadFrames, m_Window.nUnexpectedBytes);
+    fprintf(pFile, "%-12s %10lu %10lu %10lu %10lu %10lu %10lu %12lu\n", "connection",
+            m_Total.nExchanges, m_Total.nTimeouts, m_Total.nShortReads, m_Total.nResyncs, m_Total.nRetries, m_Total.nBadFrames, m_Total.nUnexpectedBytes);
+    fflush(pFile);
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <stdio.h>
+#include <string.h>
+
+#include "iOptronCommands.h"
+
+// Serial link error counters and a health score computed over the last LINK_HEALTH_WINDOW exchanges
+// (one write and its reply read, retries are exchanges of their own).
+// The score drives how long CiOptron::sendCommand() waits for replies and how many times it
+// retries the commands that don't change the mount state.
+
+#define LINK_HEALTH_WINDOW  64
+
+// what went wrong in an exchange
+#define LINK_EVENT_NONE             0x00
+#define LINK_EVENT_TIMEOUT          0x01    // read error or nothing read before the timeout
+#define LINK_EVENT_SHORT_READ       0x02    // part of the reply only
+#define LINK_EVENT_RESYNC           0x04    // stale bytes from an earlier exchange were waiting and purged
+#define LINK_EVENT_RETRY            0x08    // this exchange is a retry
+#define LINK_EVENT_BAD_FRAME        0x10    // full length reply without the expected terminator
+
+enum iOptronLinkState {LINK_HEALTHY=0, LINK_DEGRADED, LINK_POOR};
+
+#define LINK_HEALTHY_SCORE  90      // at or above
+#define LINK_DEGRADED_SCORE 60      // at or above, poor below
+
+typedef struct {
+    unsigned long   nExchanges;
+    unsigned long   nTimeouts;
+    unsigned long   nShortReads;
+    unsigned long   nResyncs;
+    unsigned long   nRetries;
+    unsigned long   nBadFrames;
+    unsigned long   nUnexpectedBytes;   // stale bytes purged and bytes of badly framed replies
+} iOptronLinkCounters;
+
+class CLinkHealth
+{
+public:
+    CLinkHealth() { reset(); }
+
+    void    reset();
+    void    record(unsigned nEvents, unsigned long nUnexpectedBytes);
+
+    // 100 = no errors over the window, 0 = every exchange failed
+    int     score() const;
+    int     state() const;          // iOptronLinkState
+    static const char *stateName(int nState);
+
+    // reply timeout to use for a command whose catalog timeout is nBaseMs
+    int     timeoutMs(int nBaseMs) const;
+    // extra attempts allowed after a failed exchange, never for commands changing the mount state
+    int     retries(const iOptronCommand &command) const;
+
+    const iOptronLinkCounters &total() const { return m_Total; }
+    const iOptronLinkCounters &window() const { return m_Window; }
+
+    // one line summary, returns the length written
+    int     format(char *pszLine, int nMaxLen) const;
+    void    dump(FILE *pFile) const;
+
+private:
+    static void count(iOptronLinkCounters &counters, unsigned nEvents, unsigned long nUnexpectedBytes, long nSign);
+
+    iOptronLinkCounters m_Total;        // since reset()
+    iOptronLinkCounters m_Window;       // last LINK_HEALTH_WINDOW exchanges
+    unsigned char       m_nEvents[LINK_HEALTH_WINDOW];
+    unsigned long       m_nBytes[LINK_HEALTH_WINDOW];
+    int                 m_nNext;
+};
@@ -0,0 +1,57 @@
+// Link error counting in CiOptron::exchange() against a simulated mount. Built and run by make test.
+
+#include "TestCheck.h"
+#include "SimulatedMount.h"
+#include "iOptronV3.h"
+
+static iOptronLinkCounters linkTotals(const CiOptron &iOptron)
+{
+    CLinkHealth health;
+
+    iOptron.getLinkHealth(health);
+    return health.total();
+}
+
+// a :GEP# reply of the right length whose '#' is something else is a bad frame, not a position
+static void testBadFrame()
+{
+    CSimulatedMount mount(120);
+    CVirtualClock clock;
+    CSimulatedSerial serial(mount, &clock);
+    CiOptron iOptron;
+    iOptronLinkCounters counters;
+    double dRa, dDec;
+
+    mount.setPosition(CCentiArcsec::fromHours(6.5), CCentiArcsec::fromDegrees(-20.25));
+    iOptron.setSerxPointer(&serial);
+    iOptron.setClock(&clock);
+    TEST_CHECK_EQUAL(iOptron.Connect((char *)"sim"), SB_OK);
+
+    // well framed replies keep their '#' up to the check
+    TEST_CHECK_EQUAL(iOptron.getRaAndDec(dRa, dDec, true), SB_OK);
+    counters = linkTotals(iOptron);
+    TEST_CHECK_EQUAL(counters.nBadFrames, 0);
+    TEST_CHECK_EQUAL(counters.nTimeouts + counters.nShortReads, 0);
+
+    mount.breakNextReply(CMD_GEP);
+    mount.resetCounts();
+    iOptron.getRaAndDec(dRa, dDec, true);   // the retry, if the link score allows one, reads a good reply
+    counters = linkTotals(iOptron);
+    TEST_CHECK_EQUAL(counters.nBadFrames, 1);
+    TEST_CHECK_EQUAL(counters.nUnexpectedBytes, commandInfo(CMD_GEP).nReplyLen);
+    TEST_CHECK_EQUAL(counters.nTimeouts + counters.nShortReads, 0);
+    TEST_CHECK(mount.received(CMD_GEP) >= 1);
+
+    TEST_CHECK_EQUAL(iOptron.getRaAndDec(dRa, dDec, true), SB_OK);
+    TEST_CHECK(fabs(dRa - 6.5) < 1e-6);
+    TEST_CHECK(fabs(dDec + 20.25) < 1e-6);
+    TEST_CHECK_EQUAL(linkTotals(iOptron).nBadFrames, 1);
+
+    iOptron.Disconnect();
+}
+
+int main()
+{
+    testBadFrame();
+    return testResult("LinkHealthTest");
+}
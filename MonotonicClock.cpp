@@ -0,0 +1,41 @@
+#include "MonotonicClock.h"
+
+#if defined(SB_WIN_BUILD)
+#include <windows.h>
+#elif defined(SB_MAC_BUILD)
+#include <mach/mach_time.h>
+#else
+#include <time.h>
+#endif
+
+CMonotonicClock &CMonotonicClock::system()
+{
+    static CSystemClock systemClock;
+    return systemClock;
+}
+
+int64_t CSystemClock::nowNs()
+{
+#if defined(SB_WIN_BUILD)
+    static LARGE_INTEGER nFrequency = {0};
+    LARGE_INTEGER nCount;
+
+    if(!nFrequency.QuadPart)
+        QueryPerformanceFrequency(&nFrequency);
+    QueryPerformanceCounter(&nCount);
+    // split so the multiplication can't overflow
+    return (nCount.QuadPart / nFrequency.QuadPart) * NS_PER_SECOND + ((nCount.QuadPart % nFrequency.QuadPart) * NS_PER_SECOND) / nFrequency.QuadPart;
+#elif defined(SB_MAC_BUILD)
+    static mach_timebase_info_data_t timebase = {0, 0};
+    uint64_t nTicks = mach_absolute_time();
+
+    if(timebase.denom == 0)
+        mach_timebase_info(&timebase);
+    return (int64_t)((nTicks / timebase.denom) * timebase.numer + ((nTicks % timebase.denom) * timebase.numer) / timebase.denom);
+#else
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)now.tv_sec * NS_PER_SECOND + now.tv_nsec;
+#endif
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <stdint.h>
+
+#include <atomic>
+
+// Time source for every timeout, cache age and poll interval in the driver.
+// Durations are integer nanoseconds from a clock that never jumps, so host clock changes
+// (NTP steps, the time being set by hand) can't expire or freeze a cache.
+// CiOptron::setClock() swaps in a CVirtualClock so time dependent logic can be driven
+// faster than real time.
+
+#define NS_PER_SECOND   1000000000LL
+#define NS_PER_MS       1000000LL
+
+inline int64_t secondsToNs(double dSeconds) { return (int64_t)(dSeconds * (double)NS_PER_SECOND); }
+inline double nsToSeconds(int64_t nNs) { return (double)nNs / (double)NS_PER_SECOND; }
+
+class CMonotonicClock
+{
+public:
+    virtual ~CMonotonicClock() {}
+    virtual int64_t nowNs() = 0;
+
+    // CLOCK_MONOTONIC, QueryPerformanceCounter on Windows, mach_absolute_time on macOS. Shared
+    static CMonotonicClock &system();
+};
+
+class CSystemClock : public CMonotonicClock
+{
+public:
+    int64_t nowNs();
+};
+
+// Only moves when told to.
+class CVirtualClock : public CMonotonicClock
+{
+public:
+    explicit CVirtualClock(int64_t nStartNs = 0) : m_nNowNs(nStartNs) {}
+
+    int64_t nowNs() { return m_nNowNs.load(std::memory_order_acquire); }
+    void    advance(int64_t nNs) { m_nNowNs.fetch_add(nNs, std::memory_order_acq_rel); }
+    void    set(int64_t nNowNs) { m_nNowNs.store(nNowNs, std::memory_order_release); }
+
+private:
+    std::atomic<int64_t>    m_nNowNs;
+};
+
+// Elapsed time since the last reset(), on a given clock.
+class CClockTimer
+{
+public:
+    explicit CClockTimer(CMonotonicClock &clock = CMonotonicClock::system()) : m_pClock(&clock) { reset(); }
+
+    void    setClock(CMonotonicClock &clock) { m_pClock = &clock; reset(); }
+    void    reset() { m_nStartNs = m_pClock->nowNs(); }
+    int64_t elapsedNs() const { return m_pClock->nowNs() - m_nStartNs; }
+    double  elapsedSeconds() const { return nsToSeconds(elapsedNs()); }
+
+private:
+    CMonotonicClock *m_pClock;
+    int64_t         m_nStartNs;
+};
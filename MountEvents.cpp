@@ -0,0 +1,221 @@
+#include <math.h>
+#include <stddef.h>
+
+#include "MountEvents.h"
+
+#define CENTI_ARCSEC_FULL_CIRCLE    (360LL * 3600LL * 100LL)
+#define DEGREES_TO_RADIANS          (3.14159265358979323846 / 180.0)   // M_PI isn't there on Windows without _USE_MATH_DEFINES
+
+CMountEvents::CMountEvents()
+{
+    int i;
+
+    for(i = 0; i < MOUNT_MAX_SUBSCRIBERS; i++) {
+        m_Subscribers[i].bActive = false;
+        m_Subscribers[i].nMask = MOUNT_EVENT_NONE;
+        m_Subscribers[i].pfCallback = NULL;
+        m_Subscribers[i].pUserData = NULL;
+        m_Subscribers[i].nThreshold = 0;
+    }
+    m_bConnected = false;
+    reset();
+}
+
+int CMountEvents::subscribe(unsigned nEventMask, MountEventCallback pfCallback, void *pUserData, int64_t nThreshold)
+{
+    int i;
+
+    if(!pfCallback || !(nEventMask & MOUNT_EVENT_ALL))
+        return -1;
+
+    for(i = 0; i < MOUNT_MAX_SUBSCRIBERS; i++) {
+        if(m_Subscribers[i].bActive)
+            continue;
+        m_Subscribers[i].nMask = nEventMask & MOUNT_EVENT_ALL;
+        m_Subscribers[i].pfCallback = pfCallback;
+        m_Subscribers[i].pUserData = pUserData;
+        m_Subscribers[i].nThreshold = nThreshold < 0 ? 0 : nThreshold;
+        m_Subscribers[i].bHasReference = false;
+        m_Subscribers[i].bActive = true;
+        return i;
+    }
+    return -1;
+}
+
+// safe from a callback, the slot is skipped from then on
+void CMountEvents::unsubscribe(int nId)
+{
+    if(nId < 0 || nId >= MOUNT_MAX_SUBSCRIBERS)
+        return;
+    m_Subscribers[nId].bActive = false;
+}
+
+int CMountEvents::subscribers() const
+{
+    int i;
+    int nCount = 0;
+
+    for(i = 0; i < MOUNT_MAX_SUBSCRIBERS; i++)
+        if(m_Subscribers[i].bActive)
+            nCount++;
+    return nCount;
+}
+
+void CMountEvents::reset()
+{
+    int i;
+
+    m_nStatus = MOUNT_STATUS_UNKNOWN;
+    m_bSlewing = false;
+    m_bParked = false;
+    m_nPierSide = MOUNT_STATUS_UNKNOWN;
+    m_bPierKnown = false;
+    m_Ra = CCentiArcsec();
+    m_Dec = CCentiArcsec();
+    // the next position read is a first position for everybody
+    for(i = 0; i < MOUNT_MAX_SUBSCRIBERS; i++)
+        m_Subscribers[i].bHasReference = false;
+}
+
+#pragma mark - reads
+void CMountEvents::statusRead(int nStatus, bool bSlewing, bool bParked, int64_t nTimeNs)
+{
+    iOptronMountEvent event;
+    int nOldStatus = m_nStatus;
+    bool bWasSlewing = m_bSlewing;
+    bool bWasParked = m_bParked;
+
+    if(nStatus == m_nStatus)
+        return;
+
+    // state first, so callbacks reading the hub or CiOptron see the new values
+    m_nStatus = nStatus;
+    m_bSlewing = bSlewing;
+    m_bParked = bParked;
+
+    fillEvent(event, MOUNT_EVENT_STATUS, nTimeNs);
+    event.nOldStatus = nOldStatus;
+    dispatch(event);
+
+    if(bWasSlewing && !bSlewing) {
+        event.nEvent = MOUNT_EVENT_SLEW_DONE;
+        dispatch(event);
+    }
+    if(bParked && !bWasParked) {
+        event.nEvent = MOUNT_EVENT_PARKED;
+        dispatch(event);
+    }
+    else if(bWasParked && !bParked) {
+        event.nEvent = MOUNT_EVENT_UNPARKED;
+        dispatch(event);
+    }
+}
+
+void CMountEvents::positionRead(const CCentiArcsec &Ra, const CCentiArcsec &Dec, int nPierSide, bool bPierKnown, int64_t nTimeNs)
+{
+    iOptronMountEvent event;
+    int nOldPierSide = m_nPierSide;
+    bool bFlipped;
+
+    bFlipped = m_bPierKnown && bPierKnown && nPierSide != m_nPierSide;
+    m_Ra = Ra;
+    m_Dec = Dec;
+    m_nPierSide = nPierSide;
+    m_bPierKnown = bPierKnown;
+
+    fillEvent(event, MOUNT_EVENT_POSITION, nTimeNs);
+    event.nOldPierSide = nOldPierSide;
+    dispatch(event);
+
+    if(bFlipped) {
+        event.nEvent = MOUNT_EVENT_PIER_FLIP;
+        event.nMoved = 0;
+        dispatch(event);
+    }
+}
+
+void CMountEvents::connectionChanged(bool bConnected, int64_t nTimeNs)
+{
+    iOptronMountEvent event;
+
+    if(bConnected == m_bConnected)
+        return;
+    m_bConnected = bConnected;
+    // whatever was read before belongs to the previous session
+    reset();
+    fillEvent(event, MOUNT_EVENT_CONNECTION, nTimeNs);
+    dispatch(event);
+}
+
+#pragma mark - dispatch
+void CMountEvents::fillEvent(iOptronMountEvent &event, unsigned nEvent, int64_t nTimeNs) const
+{
+    event.nEvent = nEvent;
+    event.nTimeNs = nTimeNs;
+    event.nOldStatus = m_nStatus;
+    event.nStatus = m_nStatus;
+    event.nOldPierSide = m_nPierSide;
+    event.nPierSide = m_nPierSide;
+    event.Ra = m_Ra;
+    event.Dec = m_Dec;
+    event.nMoved = 0;
+    event.bConnected = m_bConnected;
+}
+
+void CMountEvents::dispatch(iOptronMountEvent &event)
+{
+    int i;
+    iOptronSubscriber *pSubscriber;
+
+    for(i = 0; i < MOUNT_MAX_SUBSCRIBERS; i++) {
+        pSubscriber = &m_Subscribers[i];
+        if(!pSubscriber->bActive || !(pSubscriber->nMask & event.nEvent))
+            continue;
+
+        if(event.nEvent == MOUNT_EVENT_POSITION) {
+            // each subscriber moves its own reference, a small threshold doesn't hide moves from a large one
+            if(pSubscriber->bHasReference) {
+                event.nMoved = separation(pSubscriber->RefRa, pSubscriber->RefDec, event.Ra, event.Dec);
+                if(event.nMoved < pSubscriber->nThreshold)
+                    continue;
+            }
+            else
+                event.nMoved = 0;
+            pSubscriber->RefRa = event.Ra;
+            pSubscriber->RefDec = event.Dec;
+            pSubscriber->bHasReference = true;
+        }
+        pSubscriber->pfCallback(event, pSubscriber->pUserData);
+    }
+}
+
+int64_t CMountEvents::separation(const CCentiArcsec &Ra1, const CCentiArcsec &Dec1, const CCentiArcsec &Ra2, const CCentiArcsec &Dec2)
+{
+    int64_t nDeltaRa = (Ra2 - Ra1).raw() % CENTI_ARCSEC_FULL_CIRCLE;
+    double dDeltaDec = (double)(Dec2 - Dec1).raw();
+    double dDeltaRa;
+    double dMeanDec;
+
+    // shortest way around, 23h59 to 0h01 is 2 minutes
+    if(nDeltaRa > CENTI_ARCSEC_FULL_CIRCLE / 2)
+        nDeltaRa -= CENTI_ARCSEC_FULL_CIRCLE;
+    else if(nDeltaRa < -CENTI_ARCSEC_FULL_CIRCLE / 2)
+        nDeltaRa += CENTI_ARCSEC_FULL_CIRCLE;
+    dMeanDec = (Dec1.degrees() + Dec2.degrees()) / 2.0 * DEGREES_TO_RADIANS;
+    dDeltaRa = (double)nDeltaRa * cos(dMeanDec);
+    return (int64_t)(sqrt(dDeltaRa * dDeltaRa + dDeltaDec * dDeltaDec) + 0.5);
+}
+
+const char *CMountEvents::eventName(unsigned nEvent)
+{
+    switch(nEvent) {
+        case MOUNT_EVENT_STATUS:        return "status";
+        case MOUNT_EVENT_SLEW_DONE:     return "slew done";
+        case MOUNT_EVENT_PARKED:        return "parked";
+        case MOUNT_EVENT_UNPARKED:      return "unparked";
+        case MOUNT_EVENT_PIER_FLIP:     return "pier flip";
+        case MOUNT_EVENT_POSITION:      return "position";
+        case MOUNT_EVENT_CONNECTION:    return "connection";
+    }
+    return "none";
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <stdint.h>
+
+#include "iOptronProtocol.h"
+
+// Change notifications on the cached mount state.
+// CiOptron feeds every :GLS# and :GEP# read it makes into CMountEvents, which compares it with
+// the previous read and calls the subscribers of what changed. The reads are the ones the host
+// polling already causes (isCompleteSlewTo, isCompletePark, the position polls, the settings
+// dialog timer), so subscribing never adds serial traffic.
+// Callbacks run inside the CiOptron call that made the read, with the X2 I/O mutex held :
+// read the cached state (the Passive getters), don't send commands from them.
+
+#define MOUNT_MAX_SUBSCRIBERS   8
+
+// event types, also the subscription mask bits
+#define MOUNT_EVENT_NONE        0x00
+#define MOUNT_EVENT_STATUS      0x01    // any :GLS# status change, first read after connect included
+#define MOUNT_EVENT_SLEW_DONE   0x02    // SLEWING or FLIPPING to anything else
+#define MOUNT_EVENT_PARKED      0x04    // to PARKED
+#define MOUNT_EVENT_UNPARKED    0x08    // PARKED to anything else
+#define MOUNT_EVENT_PIER_FLIP   0x10    // pier east to west or west to east
+#define MOUNT_EVENT_POSITION    0x20    // moved at least the subscriber threshold since its last event
+#define MOUNT_EVENT_CONNECTION  0x40    // connected or disconnected
+#define MOUNT_EVENT_ALL         0x7F
+
+#define MOUNT_STATUS_UNKNOWN    -1      // nOldStatus / nOldPierSide before the first read
+
+typedef struct {
+    unsigned        nEvent;         // one MOUNT_EVENT_xxx
+    int64_t         nTimeNs;        // CiOptron clock at the read
+    int             nOldStatus;     // iOptronStatus
+    int             nStatus;
+    int             nOldPierSide;   // iOptronPierStatus
+    int             nPierSide;
+    CCentiArcsec    Ra;             // last :GEP# position
+    CCentiArcsec    Dec;
+    int64_t         nMoved;         // centi-arcsec since this subscriber's last position event, MOUNT_EVENT_POSITION only
+    bool            bConnected;
+} iOptronMountEvent;
+
+typedef void (*MountEventCallback)(const iOptronMountEvent &event, void *pUserData);
+
+class CMountEvents
+{
+public:
+    CMountEvents();
+
+    // nThreshold is the move in centi-arcsec that triggers MOUNT_EVENT_POSITION, 0 for every read.
+    // Returns the subscription id to unsubscribe with, -1 when all slots are taken.
+    int     subscribe(unsigned nEventMask, MountEventCallback pfCallback, void *pUserData, int64_t nThreshold = 0);
+    void    unsubscribe(int nId);
+    int     subscribers() const;
+
+    // forget the previous reads, the next ones are first reads again
+    void    reset();
+    // CiOptron side, after each successful read. What the status and pier side values mean stays
+    // in CiOptron, the flags say what matters here.
+    void    statusRead(int nStatus, bool bSlewing, bool bParked, int64_t nTimeNs);
+    void    positionRead(const CCentiArcsec &Ra, const CCentiArcsec &Dec, int nPierSide, bool bPierKnown, int64_t nTimeNs);
+    void    connectionChanged(bool bConnected, int64_t nTimeNs);
+
+    // sky distance between two positions in centi-arcsec, small angle approximation
+    static int64_t separation(const CCentiArcsec &Ra1, const CCentiArcsec &Dec1, const CCentiArcsec &Ra2, const CCentiArcsec &Dec2);
+    static const char *eventName(unsigned nEvent);
+
+private:
+    typedef struct {
+        bool                bActive;
+        unsigned            nMask;
+        MountEventCallback  pfCallback;
+        void                *pUserData;
+        int64_t             nThreshold;
+        bool                bHasReference;  // Ra/Dec of the last position event sent to this subscriber
+        CCentiArcsec        RefRa;
+        CCentiArcsec        RefDec;
+    } iOptronSubscriber;
+
+    void    dispatch(iOptronMountEvent &event);
+    void    fillEvent(iOptronMountEvent &event, unsigned nEvent, int64_t nTimeNs) const;
+
+    iOptronSubscriber   m_Subscribers[MOUNT_MAX_SUBSCRIBERS];
+    int                 m_nStatus;          // MOUNT_STATUS_UNKNOWN until read
+    bool                m_bSlewing;
+    bool                m_bParked;
+    int                 m_nPierSide;        // MOUNT_STATUS_UNKNOWN until read
+    bool                m_bPierKnown;       // east or west, not indeterminate
+    CCentiArcsec        m_Ra;
+    CCentiArcsec        m_Dec;
+    bool                m_bConnected;
+};
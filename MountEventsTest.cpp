@@ -0,0 +1,274 @@
+// CMountEvents transitions fed by hand, the way CiOptron feeds its :GLS# and :GEP# reads.
+// Built and run by make test.
+
+#include <stdlib.h>
+
+#include <vector>
+
+#include "TestCheck.h"
+#include "MountEvents.h"
+#include "iOptronV3.h"      // status and pier side enums
+
+#define ARCSEC              100     // centi-arcsec
+#define ARCMIN              (60 * ARCSEC)
+
+class CEventRecorder
+{
+public:
+    CEventRecorder() : m_pEvents(NULL), m_nUnsubscribeId(-1) {}
+
+    static void callback(const iOptronMountEvent &event, void *pUserData)
+    {
+        CEventRecorder *pMe = (CEventRecorder *)pUserData;
+
+        pMe->m_Events.push_back(event);
+        // unsubscribing from inside the callback, itself or someone else
+        if(pMe->m_pEvents && pMe->m_nUnsubscribeId >= 0) {
+            pMe->m_pEvents->unsubscribe(pMe->m_nUnsubscribeId);
+            pMe->m_nUnsubscribeId = -1;
+        }
+    }
+
+    void    unsubscribeOnNext(CMountEvents &events, int nId) { m_pEvents = &events; m_nUnsubscribeId = nId; }
+    size_t  count() const { return m_Events.size(); }
+    size_t  count(unsigned nEvent) const
+    {
+        size_t i, nCount = 0;
+
+        for(i = 0; i < m_Events.size(); i++)
+            if(m_Events[i].nEvent == nEvent)
+                nCount++;
+        return nCount;
+    }
+    const iOptronMountEvent &last() const { return m_Events.back(); }
+    void    clear() { m_Events.clear(); }
+
+private:
+    std::vector<iOptronMountEvent>  m_Events;
+    CMountEvents                    *m_pEvents;
+    int                             m_nUnsubscribeId;
+};
+
+static void readStatus(CMountEvents &events, int nStatus, int64_t nTimeNs = 0)
+{
+    events.statusRead(nStatus, nStatus == SLEWING || nStatus == FLIPPING, nStatus == PARKED, nTimeNs);
+}
+
+static void readPosition(CMountEvents &events, const CCentiArcsec &Ra, const CCentiArcsec &Dec, int nPierSide, int64_t nTimeNs = 0)
+{
+    events.positionRead(Ra, Dec, nPierSide, nPierSide == PIER_EAST || nPierSide == PIER_WEST, nTimeNs);
+}
+
+static void testStatus()
+{
+    CMountEvents events;
+    CEventRecorder all, slew, park;
+
+    TEST_CHECK(events.subscribe(MOUNT_EVENT_STATUS, CEventRecorder::callback, &all) >= 0);
+    TEST_CHECK(events.subscribe(MOUNT_EVENT_SLEW_DONE, CEventRecorder::callback, &slew) >= 0);
+    TEST_CHECK(events.subscribe(MOUNT_EVENT_PARKED | MOUNT_EVENT_UNPARKED, CEventRecorder::callback, &park) >= 0);
+    TEST_CHECK_EQUAL(events.subscribers(), 3);
+    TEST_CHECK_EQUAL(events.subscribe(MOUNT_EVENT_NONE, CEventRecorder::callback, &all), -1);
+    TEST_CHECK_EQUAL(events.subscribe(MOUNT_EVENT_STATUS, NULL, &all), -1);
+
+    // first read is a change, the same status again isn't
+    readStatus(events, TRACKING, 1);
+    TEST_CHECK_EQUAL(all.count(), 1);
+    TEST_CHECK_EQUAL(all.last().nOldStatus, MOUNT_STATUS_UNKNOWN);
+    TEST_CHECK_EQUAL(all.last().nStatus, TRACKING);
+    TEST_CHECK_EQUAL(all.last().nTimeNs, 1);
+    readStatus(events, TRACKING, 2);
+    TEST_CHECK_EQUAL(all.count(), 1);
+
+    // a goto
+    readStatus(events, SLEWING);
+    TEST_CHECK_EQUAL(slew.count(), 0);
+    readStatus(events, TRACKING);
+    TEST_CHECK_EQUAL(slew.count(), 1);
+    TEST_CHECK_EQUAL(slew.last().nEvent, MOUNT_EVENT_SLEW_DONE);
+    TEST_CHECK_EQUAL(slew.last().nOldStatus, SLEWING);
+    TEST_CHECK_EQUAL(slew.last().nStatus, TRACKING);
+
+    // a meridian flip ending stopped is a slew done too
+    readStatus(events, FLIPPING);
+    readStatus(events, STOPPED);
+    TEST_CHECK_EQUAL(slew.count(), 2);
+
+    // park : slewing then parked, one slew done and one parked
+    readStatus(events, SLEWING);
+    readStatus(events, PARKED);
+    TEST_CHECK_EQUAL(slew.count(), 3);
+    TEST_CHECK_EQUAL(park.count(MOUNT_EVENT_PARKED), 1);
+    TEST_CHECK_EQUAL(park.count(MOUNT_EVENT_UNPARKED), 0);
+    readStatus(events, STOPPED);
+    TEST_CHECK_EQUAL(park.count(MOUNT_EVENT_UNPARKED), 1);
+    TEST_CHECK_EQUAL(park.last().nOldStatus, PARKED);
+    TEST_CHECK_EQUAL(slew.count(), 3);
+
+    TEST_CHECK_EQUAL(all.count(), 8);
+    TEST_CHECK_EQUAL(all.count(MOUNT_EVENT_STATUS), 8);   // only what was subscribed to
+}
+
+static void testPierFlip()
+{
+    CMountEvents events;
+    CEventRecorder flip;
+    CCentiArcsec Ra = CCentiArcsec::fromHours(5.0);
+    CCentiArcsec Dec = CCentiArcsec::fromDegrees(20.0);
+
+    events.subscribe(MOUNT_EVENT_PIER_FLIP, CEventRecorder::callback, &flip);
+
+    // the first side known isn't a flip
+    readPosition(events, Ra, Dec, PIER_EAST);
+    TEST_CHECK_EQUAL(flip.count(), 0);
+    readPosition(events, Ra, Dec, PIER_WEST);
+    TEST_CHECK_EQUAL(flip.count(), 1);
+    TEST_CHECK_EQUAL(flip.last().nOldPierSide, PIER_EAST);
+    TEST_CHECK_EQUAL(flip.last().nPierSide, PIER_WEST);
+    readPosition(events, Ra, Dec, PIER_WEST);
+    TEST_CHECK_EQUAL(flip.count(), 1);
+
+    // through indeterminate, neither change is a flip and neither is the side after it
+    readPosition(events, Ra, Dec, PIER_INDETERMINATE);
+    readPosition(events, Ra, Dec, PIER_EAST);
+    TEST_CHECK_EQUAL(flip.count(), 1);
+    readPosition(events, Ra, Dec, PIER_WEST);
+    TEST_CHECK_EQUAL(flip.count(), 2);
+
+    // nothing known after a reset
+    events.reset();
+    readPosition(events, Ra, Dec, PIER_EAST);
+    TEST_CHECK_EQUAL(flip.count(), 2);
+}
+
+static void testThresholds()
+{
+    CMountEvents events;
+    CEventRecorder every, fine, coarse;
+    CCentiArcsec Ra = CCentiArcsec::fromHours(10.0);
+    CCentiArcsec Dec = CCentiArcsec(0);
+
+    events.subscribe(MOUNT_EVENT_POSITION, CEventRecorder::callback, &every);
+    events.subscribe(MOUNT_EVENT_POSITION, CEventRecorder::callback, &fine, 10 * ARCSEC);
+    events.subscribe(MOUNT_EVENT_POSITION, CEventRecorder::callback, &coarse, ARCMIN);
+
+    // the first position goes to everybody, as the reference
+    readPosition(events, Ra, Dec, PIER_EAST);
+    TEST_CHECK_EQUAL(every.count(), 1);
+    TEST_CHECK_EQUAL(fine.count(), 1);
+    TEST_CHECK_EQUAL(coarse.count(), 1);
+    TEST_CHECK_EQUAL(coarse.last().nMoved, 0);
+
+    // six 15" steps in Dec : the 10" subscriber sees each, the 1' one every fourth
+    Dec = CCentiArcsec(Dec.raw() + 15 * ARCSEC);
+    readPosition(events, Ra, Dec, PIER_EAST);
+    TEST_CHECK_EQUAL(fine.count(), 2);
+    TEST_CHECK_EQUAL(fine.last().nMoved, 15 * ARCSEC);
+    TEST_CHECK_EQUAL(coarse.count(), 1);
+    Dec = CCentiArcsec(Dec.raw() + 15 * ARCSEC);
+    readPosition(events, Ra, Dec, PIER_EAST);
+    Dec = CCentiArcsec(Dec.raw() + 15 * ARCSEC);
+    readPosition(events, Ra, Dec, PIER_EAST);
+    TEST_CHECK_EQUAL(coarse.count(), 1);
+    Dec = CCentiArcsec(Dec.raw() + 15 * ARCSEC);
+    readPosition(events, Ra, Dec, PIER_EAST);
+    TEST_CHECK_EQUAL(coarse.count(), 2);
+    TEST_CHECK_EQUAL(coarse.last().nMoved, ARCMIN);     // from its own reference, not the last read
+    Dec = CCentiArcsec(Dec.raw() + 15 * ARCSEC);
+    readPosition(events, Ra, Dec, PIER_EAST);
+    Dec = CCentiArcsec(Dec.raw() + 15 * ARCSEC);
+    readPosition(events, Ra, Dec, PIER_EAST);
+    TEST_CHECK_EQUAL(every.count(), 7);
+    TEST_CHECK_EQUAL(fine.count(), 7);
+    TEST_CHECK_EQUAL(coarse.count(), 2);
+
+    // under every threshold but the 0 one
+    Dec = CCentiArcsec(Dec.raw() + 5 * ARCSEC);
+    readPosition(events, Ra, Dec, PIER_EAST);
+    TEST_CHECK_EQUAL(every.count(), 8);
+    TEST_CHECK_EQUAL(fine.count(), 7);
+}
+
+static void testSeparation()
+{
+    CCentiArcsec Zero(0);
+    CCentiArcsec Dec60 = CCentiArcsec::fromDegrees(60.0);
+
+    // across 0h, the short way : 23h59m to 0h01m is 2 minutes of RA, 30' on the equator
+    TEST_CHECK_EQUAL(CMountEvents::separation(CCentiArcsec::fromHours(23.0 + 59.0 / 60.0), Zero, CCentiArcsec::fromHours(1.0 / 60.0), Zero), 30 * ARCMIN);
+    TEST_CHECK_EQUAL(CMountEvents::separation(CCentiArcsec::fromHours(1.0 / 60.0), Zero, CCentiArcsec::fromHours(23.0 + 59.0 / 60.0), Zero), 30 * ARCMIN);
+    TEST_CHECK_EQUAL(CMountEvents::separation(Zero, Zero, CCentiArcsec::fromHours(12.0), Zero), 180LL * 60 * ARCMIN);
+    // RA shrinks with cos(dec)
+    TEST_CHECK(llabs(CMountEvents::separation(CCentiArcsec(129600000 - 54000), Dec60, CCentiArcsec(54000), Dec60) - 54000) <= 1);
+    TEST_CHECK_EQUAL(CMountEvents::separation(Zero, Zero, Zero, CCentiArcsec(-300)), 300);
+    TEST_CHECK_EQUAL(CMountEvents::separation(Zero, Zero, CCentiArcsec(300), CCentiArcsec(400)), 500);
+}
+
+static void testUnsubscribeFromCallback()
+{
+    CMountEvents events;
+    CEventRecorder first, second, third;
+    int nFirst, nSecond, nThird;
+
+    nFirst = events.subscribe(MOUNT_EVENT_STATUS, CEventRecorder::callback, &first);
+    nSecond = events.subscribe(MOUNT_EVENT_STATUS, CEventRecorder::callback, &second);
+    nThird = events.subscribe(MOUNT_EVENT_STATUS, CEventRecorder::callback, &third);
+    TEST_CHECK(nFirst >= 0 && nSecond >= 0 && nThird >= 0);
+
+    // the first one drops itself, the second the third one : the third isn't called for this event
+    first.unsubscribeOnNext(events, nFirst);
+    second.unsubscribeOnNext(events, nThird);
+    readStatus(events, TRACKING);
+    TEST_CHECK_EQUAL(first.count(), 1);
+    TEST_CHECK_EQUAL(second.count(), 1);
+    TEST_CHECK_EQUAL(third.count(), 0);
+    TEST_CHECK_EQUAL(events.subscribers(), 1);
+
+    readStatus(events, STOPPED);
+    TEST_CHECK_EQUAL(first.count(), 1);
+    TEST_CHECK_EQUAL(second.count(), 2);
+    TEST_CHECK_EQUAL(third.count(), 0);
+
+    // the freed slots are given out again
+    TEST_CHECK_EQUAL(events.subscribe(MOUNT_EVENT_STATUS, CEventRecorder::callback, &first), nFirst);
+}
+
+static void testConnection()
+{
+    CMountEvents events;
+    CEventRecorder connection, status;
+    int i;
+
+    for(i = 0; i < MOUNT_MAX_SUBSCRIBERS - 2; i++)
+        TEST_CHECK(events.subscribe(MOUNT_EVENT_POSITION, CEventRecorder::callback, &status) >= 0);
+    TEST_CHECK(events.subscribe(MOUNT_EVENT_CONNECTION, CEventRecorder::callback, &connection) >= 0);
+    TEST_CHECK(events.subscribe(MOUNT_EVENT_STATUS, CEventRecorder::callback, &status) >= 0);
+    TEST_CHECK_EQUAL(events.subscribe(MOUNT_EVENT_ALL, CEventRecorder::callback, &status), -1);   // full
+
+    events.connectionChanged(true, 5);
+    events.connectionChanged(true, 6);
+    TEST_CHECK_EQUAL(connection.count(), 1);
+    TEST_CHECK(connection.last().bConnected);
+    readStatus(events, TRACKING);
+    events.connectionChanged(false, 7);
+    TEST_CHECK_EQUAL(connection.count(), 2);
+    TEST_CHECK(!connection.last().bConnected);
+    TEST_CHECK_EQUAL(connection.last().nStatus, MOUNT_STATUS_UNKNOWN);
+
+    // a new session, the same status is a first read again
+    events.connectionChanged(true, 8);
+    status.clear();
+    readStatus(events, TRACKING);
+    TEST_CHECK_EQUAL(status.count(MOUNT_EVENT_STATUS), 1);
+}
+
+int main()
+{
+    testStatus();
+    testPierFlip();
+    testThresholds();
+    testSeparation();
+    testUnsubscribeFromCallback();
+    testConnection();
+    return testResult("MountEventsTest");
+}
@@ -0,0 +1,85 @@
+#include "MutexProfiler.h"
+
+#pragma mark - CMutexProfiler
+void CMutexProfiler::reset()
+{
+    int i;
+
+    for(i = 0; i < MUTEX_PROFILER_MAX_SITES; i++) {
+        m_Sites[i].nAcquisitions = 0;
+        m_Sites[i].nContended = 0;
+        m_Sites[i].nWaitNs = 0;
+        m_Sites[i].nHoldNs = 0;
+        m_Sites[i].Wait.reset();
+        m_Sites[i].Hold.reset();
+    }
+}
+
+void CMutexProfiler::dump(FILE *pFile, const char *(*pfSiteName)(int)) const
+{
+    int i;
+    const X2MutexSiteCounters *pSite;
+
+    if(!pFile)
+        return;
+
+    fprintf(pFile, "%-26s %8s %9s %12s %10s %10s %12s %10s %10s\n",
+            "mutex call site", "locks", "contended", "wait ms", "wait p99", "wait max", "hold ms", "hold p99", "hold max");
+    for(i = 0; i < MUTEX_PROFILER_MAX_SITES; i++) {
+        pSite = &m_Sites[i];
+        if(!pSite->nAcquisitions)
+            continue;
+        fprintf(pFile, "%-26s %8lu %9lu %12.3f %10.3f %10.3f %12.3f %10.3f %10.3f\n",
+                pfSiteName(i),
+                pSite->nAcquisitions,
+                pSite->nContended,
+                pSite->nWaitNs / 1.0e6,
+                pSite->Wait.percentileNs(99.0) / 1.0e6,
+                pSite->Wait.maxNs() / 1.0e6,
+                pSite->nHoldNs / 1.0e6,
+                pSite->Hold.percentileNs(99.0) / 1.0e6,
+                pSite->Hold.maxNs() / 1.0e6);
+    }
+    fflush(pFile);
+}
+
+#pragma mark - CProfiledMutexLocker
+CProfiledMutexLocker::CProfiledMutexLocker(CMutexProfiler &profiler, MutexInterface *pMutex, int nSite, CMonotonicClock &clock)
+    : m_Profiler(profiler), m_pMutex(pMutex), m_nSite(nSite), m_Clock(clock)
+{
+    X2MutexSiteCounters *pSite;
+    int64_t nStartNs;
+
+    nStartNs = m_Clock.nowNs();
+    m_bContended = m_Profiler.m_nUsers.fetch_add(1, std::memory_order_acq_rel) != 0;
+    if(m_pMutex)
+        m_pMutex->lock();
+    m_nLockedNs = m_Clock.nowNs();
+    m_nWaitNs = m_nLockedNs - nStartNs;
+
+    if(m_nSite < 0 || m_nSite >= MUTEX_PROFILER_MAX_SITES)
+        return;
+    pSite = &m_Profiler.m_Sites[m_nSite];
+    pSite->nAcquisitions++;
+    if(m_bContended)
+        pSite->nContended++;
+    pSite->nWaitNs += m_nWaitNs;
+    pSite->Wait.record(m_nWaitNs);
+}
+
+CProfiledMutexLocker::~CProfiledMutexLocker()
+{
+    X2MutexSiteCounters *pSite;
+    int64_t nHoldNs;
+
+    if(m_nSite >= 0 && m_nSite < MUTEX_PROFILER_MAX_SITES) {
+        nHoldNs = m_Clock.nowNs() - m_nLockedNs;
+        pSite = &m_Profiler.m_Sites[m_nSite];
+        pSite->nHoldNs += nHoldNs;
+        pSite->Hold.record(nHoldNs);
+    }
+    // out of the count before the release, so whoever takes the mutex next isn't counted as contended
+    m_Profiler.m_nUsers.fetch_sub(1, std::memory_order_acq_rel);
+    if(m_pMutex)
+        m_pMutex->unlock();
+}
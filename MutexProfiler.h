@@ -0,0 +1,65 @@
+#pragma once
+#include <stdio.h>
+#include <stdint.h>
+
+#include <atomic>
+
+#include "../../licensedinterfaces/mutexinterface.h"
+
+#include "MonotonicClock.h"
+#include "CommandStats.h"
+
+// Contention on the X2 I/O mutex. TheSkyX calls the driver from its UI timer, slew monitor and
+// telemetry threads, and they all serialise on the one MutexInterface from the factory.
+// MutexInterface has no try lock, so an acquisition counts as contended when another thread
+// already held or was waiting for the mutex when we asked for it.
+
+#define MUTEX_PROFILER_MAX_SITES    32
+
+typedef struct {
+    unsigned long       nAcquisitions;
+    unsigned long       nContended;
+    int64_t             nWaitNs;
+    int64_t             nHoldNs;
+    CLatencyHistogram   Wait;
+    CLatencyHistogram   Hold;
+} X2MutexSiteCounters;
+
+class CMutexProfiler
+{
+public:
+    CMutexProfiler() : m_nUsers(0) { reset(); }
+
+    // only call with the mutex held, the counters are protected by the mutex they measure
+    void    reset();
+    const X2MutexSiteCounters &counters(int nSite) const { return m_Sites[nSite]; }
+    // pfSiteName gives the name of a site index
+    void    dump(FILE *pFile, const char *(*pfSiteName)(int)) const;
+
+private:
+    friend class CProfiledMutexLocker;
+
+    X2MutexSiteCounters m_Sites[MUTEX_PROFILER_MAX_SITES];
+    std::atomic<int>    m_nUsers;       // threads holding or waiting for the mutex
+};
+
+// Drop in for X2MutexLocker, accounted to a call site of a CMutexProfiler.
+class CProfiledMutexLocker
+{
+public:
+    CProfiledMutexLocker(CMutexProfiler &profiler, MutexInterface *pMutex, int nSite, CMonotonicClock &clock = CMonotonicClock::system());
+    ~CProfiledMutexLocker();
+
+    int64_t waitNs() const { return m_nWaitNs; }
+    int64_t lockedNs() const { return m_nLockedNs; }     // when the mutex was acquired
+    bool    contended() const { return m_bContended; }
+
+private:
+    CMutexProfiler  &m_Profiler;
+    MutexInterface  *m_pMutex;
+    int             m_nSite;
+    CMonotonicClock &m_Clock;
+    int64_t         m_nLockedNs;
+    int64_t         m_nWaitNs;
+    bool            m_bContended;
+};
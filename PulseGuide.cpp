@@ -0,0 +1,129 @@
+#include "PulseGuide.h"
+
+static const char *s_szGuideDirNames[IOPTRON_NB_GUIDE_DIRS] = {"north", "south", "east", "west"};
+
+#pragma mark - CPriorityLock
+void CPriorityLock::lock(bool bPriority)
+{
+    std::unique_lock<std::mutex> locker(m_Lock);
+
+    m_nWaiters++;
+    if(bPriority) {
+        m_nPriorityWaiters++;
+        m_Released.wait(locker, [this] { return !m_bLocked; });
+        m_nPriorityWaiters--;
+    }
+    else {
+        m_Released.wait(locker, [this] { return !m_bLocked && !m_nPriorityWaiters; });
+    }
+    m_nWaiters--;
+    m_bLocked = true;
+}
+
+void CPriorityLock::unlock()
+{
+    {
+        std::lock_guard<std::mutex> locker(m_Lock);
+        m_bLocked = false;
+    }
+    // a priority waiter and regular ones can all be waiting, only the right one gets through
+    m_Released.notify_all();
+}
+
+int CPriorityLock::waiters()
+{
+    std::lock_guard<std::mutex> locker(m_Lock);
+    return m_nWaiters;
+}
+
+#pragma mark - CGuideStats
+void CGuideStats::reset()
+{
+    memset(m_Dirs, 0, sizeof(m_Dirs));
+    m_Wait.reset();
+    m_Ack.reset();
+    m_Total.reset();
+}
+
+void CGuideStats::record(int nDir, int nDurationMs, int64_t nWaitNs, int64_t nAckNs, bool bError)
+{
+    if(nDir < 0 || nDir >= IOPTRON_NB_GUIDE_DIRS)
+        return;
+
+    m_Dirs[nDir].nPulses++;
+    if(bError) {
+        m_Dirs[nDir].nErrors++;
+        return;
+    }
+    m_Dirs[nDir].nGuideMs += nDurationMs;
+    m_Wait.record(nWaitNs);
+    m_Ack.record(nAckNs);
+    m_Total.record(nWaitNs + nAckNs);
+}
+
+unsigned long CGuideStats::pulses() const
+{
+    int i;
+    unsigned long nPulses = 0;
+
+    for(i = 0; i < IOPTRON_NB_GUIDE_DIRS; i++)
+        nPulses += m_Dirs[i].nPulses;
+    return nPulses;
+}
+
+void CGuideStats::dump(FILE *pFile) const
+{
+    int i;
+    const CLatencyHistogram *pHistograms[] = {&m_Wait, &m_Ack, &m_Total};
+    const char *pszNames[] = {"link wait", "write to ack", "command to ack"};
+
+    if(!pFile)
+        return;
+
+    fprintf(pFile, "%-14s %8s %8s %12s\n", "guide", "pulses", "errors", "guided ms");
+    for(i = 0; i < IOPTRON_NB_GUIDE_DIRS; i++) {
+        fprintf(pFile, "%-14s %8lu %8lu %12lld\n", s_szGuideDirNames[i], m_Dirs[i].nPulses, m_Dirs[i].nErrors, (long long)m_Dirs[i].nGuideMs);
+    }
+    fprintf(pFile, "\n%-14s %10s %10s %10s %10s %10s\n", "pulse latency", "min ms", "p50 ms", "p99 ms", "p99.9 ms", "max ms");
+    for(i = 0; i < 3; i++) {
+        fprintf(pFile, "%-14s %10.3f %10.3f %10.3f %10.3f %10.3f\n",
+                pszNames[i],
+                pHistograms[i]->minNs() / 1.0e6,
+                pHistograms[i]->percentileNs(50.0) / 1.0e6,
+                pHistograms[i]->percentileNs(99.0) / 1.0e6,
+                pHistograms[i]->percentileNs(99.9) / 1.0e6,
+                pHistograms[i]->maxNs() / 1.0e6);
+    }
+    fflush(pFile);
+}
+
+int CGuideStats::format(char *pszLine, int nMaxLen) const
+{
+    int nLen;
+    unsigned long nErrors = 0;
+    int i;
+
+    if(nMaxLen < 1)
+        return 0;
+    pszLine[0] = 0;
+    if(!pulses())
+        return 0;
+
+    for(i = 0; i < IOPTRON_NB_GUIDE_DIRS; i++)
+        nErrors += m_Dirs[i].nErrors;
+    nLen = snprintf(pszLine, nMaxLen, "guide %lu pulses, %lu errors, ack p50 %.1f ms p99 %.1f ms max %.1f ms\n",
+                    pulses(), nErrors,
+                    m_Total.percentileNs(50.0) / 1.0e6,
+                    m_Total.percentileNs(99.0) / 1.0e6,
+                    m_Total.maxNs() / 1.0e6);
+    if(nLen >= nMaxLen)
+        nLen = nMaxLen - 1;
+    return nLen;
+}
+
+const char *CGuideStats::dirName(int nDir)
+{
+    if(nDir < 0 || nDir >= IOPTRON_NB_GUIDE_DIRS)
+        return "unknown";
+    return s_szGuideDirNames[nDir];
+}
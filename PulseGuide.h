@@ -0,0 +1,79 @@
+#pragma once
+#include <stdio.h>
+#include <stdint.h>
+
+#include <mutex>
+#include <condition_variable>
+
+#include "CommandStats.h"
+
+// Timed guide pulses, :MnXXXXX# :MsXXXXX# :MeXXXXX# :MwXXXXX#, move XXXXX ms at the guide rate.
+// CiOptron::pulseGuide() doesn't go through the X2 I/O mutex : it only waits for the serial
+// exchange in progress (CPriorityLock, held for one command and its reply by sendCommand()), and
+// goes ahead of every exchange queued behind it, so a pulse never waits for a whole host call
+// or a run of status polls.
+
+#define IOPTRON_MAX_PULSE_MS    99999   // 5 digits, 0 would mean move until stopped
+
+enum iOptronGuideDir {GUIDE_NORTH=0, GUIDE_SOUTH, GUIDE_EAST, GUIDE_WEST, IOPTRON_NB_GUIDE_DIRS};
+
+// Mutex with two classes of waiters, priority waiters always get it first.
+class CPriorityLock
+{
+public:
+    CPriorityLock() : m_bLocked(false), m_nPriorityWaiters(0), m_nWaiters(0) {}
+
+    void    lock(bool bPriority);
+    void    unlock();
+    int     waiters();      // threads blocked in lock(), both classes
+
+private:
+    std::mutex              m_Lock;
+    std::condition_variable m_Released;
+    bool                    m_bLocked;
+    int                     m_nPriorityWaiters;
+    int                     m_nWaiters;
+};
+
+class CPriorityLocker
+{
+public:
+    CPriorityLocker(CPriorityLock &lock, bool bPriority) : m_Lock(lock) { m_Lock.lock(bPriority); }
+    ~CPriorityLocker() { m_Lock.unlock(); }
+
+private:
+    CPriorityLock   &m_Lock;
+};
+
+typedef struct {
+    unsigned long   nPulses;
+    unsigned long   nErrors;
+    int64_t         nGuideMs;       // pulse durations sent, errors excluded
+} iOptronGuideCounters;
+
+// Pulse guide statistics since Connect. The timed guide commands have no reply : the pulse is
+// acknowledged once it is written and the port flushed, which is as far as the driver can see.
+class CGuideStats
+{
+public:
+    CGuideStats() { reset(); }
+
+    void    reset();
+    // nWaitNs request to link lock, nAckNs link lock to flushed
+    void    record(int nDir, int nDurationMs, int64_t nWaitNs, int64_t nAckNs, bool bError);
+
+    const iOptronGuideCounters &counters(int nDir) const { return m_Dirs[nDir]; }
+    unsigned long   pulses() const;
+    const CLatencyHistogram &commandToAck() const { return m_Total; }
+
+    void    dump(FILE *pFile) const;
+    // one line summary for the settings dialog, returns the length written, 0 if no pulse was sent
+    int     format(char *pszLine, int nMaxLen) const;
+    static const char *dirName(int nDir);
+
+private:
+    iOptronGuideCounters    m_Dirs[IOPTRON_NB_GUIDE_DIRS];
+    CLatencyHistogram       m_Wait;
+    CLatencyHistogram       m_Ack;
+    CLatencyHistogram       m_Total;    // command to ack, what the guider sees
+};
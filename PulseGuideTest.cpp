@@ -0,0 +1,225 @@
+// Guide pulses going ahead of queued exchanges, CPriorityLock on its own and through CiOptron,
+// and the guide statistics. Built and run by make test.
+
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+#include <thread>
+
+#include "TestCheck.h"
+#include "SimulatedMount.h"
+#include "PulseGuide.h"
+#include "iOptronV3.h"
+
+#define WAIT_POLL_US    1000
+#define WAIT_MAX_POLLS  5000
+
+// waits, in real time, for nCount threads to queue on the lock
+static bool waitForWaiters(CPriorityLock &lock, int nCount)
+{
+    int i;
+
+    for(i = 0; i < WAIT_MAX_POLLS && lock.waiters() < nCount; i++)
+        usleep(WAIT_POLL_US);
+    return lock.waiters() == nCount;
+}
+
+static bool waitForWaiters(CiOptron &iOptron, int nCount)
+{
+    int i;
+
+    for(i = 0; i < WAIT_MAX_POLLS && iOptron.getLinkWaiters() < nCount; i++)
+        usleep(WAIT_POLL_US);
+    return iOptron.getLinkWaiters() == nCount;
+}
+
+static void testPriorityLock()
+{
+    CPriorityLock lock;
+    std::mutex orderLock;
+    std::vector<int> order;
+    std::thread threads[4];
+    int i;
+
+    lock.lock(false);
+    // regular waiters first, then the priority one behind them
+    for(i = 0; i < 4; i++) {
+        threads[i] = std::thread([&lock, &orderLock, &order, i] {
+            lock.lock(i == 3);
+            {
+                std::lock_guard<std::mutex> locker(orderLock);
+                order.push_back(i);
+            }
+            lock.unlock();
+        });
+        TEST_CHECK(waitForWaiters(lock, i + 1));
+    }
+    lock.unlock();
+    for(i = 0; i < 4; i++)
+        threads[i].join();
+
+    TEST_CHECK_EQUAL(order.size(), 4);
+    TEST_CHECK(!order.empty() && order[0] == 3);
+    TEST_CHECK_EQUAL(lock.waiters(), 0);
+}
+
+// Records the commands written and holds the first write while closed, the exchange stays
+// in progress with the link lock held. Can also fail writes, like a pulled USB adapter.
+class CGatedSerial : public SerXInterface
+{
+public:
+    explicit CGatedSerial(SerXInterface *pSerX) : m_pSerX(pSerX), m_bOpen(true), m_bHeld(false), m_bFail(false) {}
+
+    void    closeGate() { std::lock_guard<std::mutex> locker(m_Lock); m_bOpen = false; m_bHeld = false; }
+    void    openGate() { { std::lock_guard<std::mutex> locker(m_Lock); m_bOpen = true; } m_Changed.notify_all(); }
+    bool    waitHeld()
+    {
+        std::unique_lock<std::mutex> locker(m_Lock);
+        return m_Changed.wait_for(locker, std::chrono::seconds(5), [this] { return m_bHeld; });
+    }
+    void    setFail(bool bFail) { std::lock_guard<std::mutex> locker(m_Lock); m_bFail = bFail; }
+    std::vector<std::string> written() { std::lock_guard<std::mutex> locker(m_Lock); return m_Written; }
+    void    clearWritten() { std::lock_guard<std::mutex> locker(m_Lock); m_Written.clear(); }
+
+    virtual int     open(const char* pszPort, const unsigned long& dwBaudRate = 9600, const Parity& parity = B_NOPARITY, const char* pszSession = 0) { return m_pSerX->open(pszPort, dwBaudRate, parity, pszSession); }
+    virtual int     close() { return m_pSerX->close(); }
+    virtual bool    isConnected(void) const { return m_pSerX->isConnected(); }
+    virtual int     flushTx(void) { return m_pSerX->flushTx(); }
+    virtual int     purgeTxRx(void) { return m_pSerX->purgeTxRx(); }
+    virtual int     waitForBytesRx(const int& nNumber, const int& nTimeOutMilli) { return m_pSerX->waitForBytesRx(nNumber, nTimeOutMilli); }
+    virtual int     readFile(void* lpBuffer, const unsigned long dwTotalToRead, unsigned long& dwBytesRead, const unsigned long& dwTimeOut = 1000) { return m_pSerX->readFile(lpBuffer, dwTotalToRead, dwBytesRead, dwTimeOut); }
+    virtual int     bytesWaitingRx(int &nBytesWaiting) { return m_pSerX->bytesWaitingRx(nBytesWaiting); }
+    virtual int     writeFile(void* lpBuffer, const unsigned long& dwBytesToWrite, unsigned long& dwBytesWritten)
+    {
+        {
+            std::unique_lock<std::mutex> locker(m_Lock);
+            m_Written.push_back(std::string((const char *)lpBuffer, dwBytesToWrite));
+            if(!m_bOpen) {
+                m_bHeld = true;
+                m_Changed.notify_all();
+                m_Changed.wait(locker, [this] { return m_bOpen; });
+            }
+            if(m_bFail) {
+                dwBytesWritten = 0;
+                return ERR_CMDFAILED;
+            }
+        }
+        return m_pSerX->writeFile(lpBuffer, dwBytesToWrite, dwBytesWritten);
+    }
+
+private:
+    SerXInterface           *m_pSerX;
+    std::mutex              m_Lock;
+    std::condition_variable m_Changed;
+    bool                    m_bOpen;
+    bool                    m_bHeld;
+    bool                    m_bFail;
+    std::vector<std::string>    m_Written;
+};
+
+static void getModel(CiOptron *pIOptron)
+{
+    char szModel[SERIAL_BUFFER_SIZE];
+
+    pIOptron->getMountInfo(szModel, SERIAL_BUFFER_SIZE);
+}
+
+// a pulse asked for while an exchange is on the wire and two more are queued goes out right after it
+static void testPulseGoesFirst()
+{
+    CSimulatedMount mount(120);
+    CVirtualClock clock;
+    CSimulatedSerial simulated(mount, &clock);
+    CGatedSerial serial(&simulated);
+    CiOptron iOptron;
+    std::vector<std::string> written;
+    std::thread inProgress, queued1, queued2, pulse;
+    int nPulseErr = -1;
+
+    iOptron.setSerxPointer(&serial);
+    iOptron.setClock(&clock);
+    TEST_CHECK_EQUAL(iOptron.Connect((char *)"sim"), SB_OK);
+    serial.clearWritten();
+
+    serial.closeGate();
+    inProgress = std::thread(getModel, &iOptron);
+    TEST_CHECK(serial.waitHeld());
+    queued1 = std::thread(getModel, &iOptron);
+    TEST_CHECK(waitForWaiters(iOptron, 1));
+    queued2 = std::thread(getModel, &iOptron);
+    TEST_CHECK(waitForWaiters(iOptron, 2));
+    pulse = std::thread([&iOptron, &nPulseErr] { nPulseErr = iOptron.pulseGuide(MountDriverInterface::MD_NORTH, 100); });
+    TEST_CHECK(waitForWaiters(iOptron, 3));
+    serial.openGate();
+    inProgress.join();
+    queued1.join();
+    queued2.join();
+    pulse.join();
+
+    written = serial.written();
+    TEST_CHECK_EQUAL(nPulseErr, SB_OK);
+    TEST_CHECK_EQUAL(written.size(), 4);
+    if(written.size() == 4) {
+        TEST_CHECK(written[0] == ":MountInfo#");
+        TEST_CHECK(written[1] == ":Mn00100#");
+        TEST_CHECK(written[2] == ":MountInfo#");
+        TEST_CHECK(written[3] == ":MountInfo#");
+    }
+    TEST_CHECK_EQUAL(mount.received(CMD_GUIDE_N), 1);
+    iOptron.Disconnect();
+}
+
+static void testGuideStats()
+{
+    CSimulatedMount mount(120);
+    CVirtualClock clock;
+    CSimulatedSerial simulated(mount, &clock);
+    CGatedSerial serial(&simulated);
+    CiOptron iOptron;
+    CGuideStats stats;
+    char szLine[256];
+
+    iOptron.setSerxPointer(&serial);
+    iOptron.setClock(&clock);
+    TEST_CHECK_EQUAL(iOptron.Connect((char *)"sim"), SB_OK);
+    iOptron.getGuideStats(stats);
+    TEST_CHECK_EQUAL(stats.pulses(), 0);
+    TEST_CHECK_EQUAL(stats.format(szLine, sizeof(szLine)), 0);
+
+    TEST_CHECK_EQUAL(iOptron.pulseGuide(MountDriverInterface::MD_NORTH, 100), SB_OK);
+    TEST_CHECK_EQUAL(iOptron.pulseGuide(MountDriverInterface::MD_NORTH, 250), SB_OK);
+    TEST_CHECK_EQUAL(iOptron.pulseGuide(MountDriverInterface::MD_WEST, 1500), SB_OK);
+    serial.setFail(true);
+    TEST_CHECK(iOptron.pulseGuide(MountDriverInterface::MD_EAST, 400) != SB_OK);
+    serial.setFail(false);
+    TEST_CHECK(iOptron.pulseGuide(MountDriverInterface::MD_SOUTH, 0) != SB_OK);         // refused, not sent
+    TEST_CHECK(iOptron.pulseGuide(MountDriverInterface::MD_SOUTH, 100000) != SB_OK);
+
+    iOptron.getGuideStats(stats);
+    TEST_CHECK_EQUAL(stats.pulses(), 4);
+    TEST_CHECK_EQUAL(stats.counters(GUIDE_NORTH).nPulses, 2);
+    TEST_CHECK_EQUAL(stats.counters(GUIDE_NORTH).nGuideMs, 350);
+    TEST_CHECK_EQUAL(stats.counters(GUIDE_NORTH).nErrors, 0);
+    TEST_CHECK_EQUAL(stats.counters(GUIDE_WEST).nGuideMs, 1500);
+    TEST_CHECK_EQUAL(stats.counters(GUIDE_EAST).nPulses, 1);
+    TEST_CHECK_EQUAL(stats.counters(GUIDE_EAST).nErrors, 1);
+    TEST_CHECK_EQUAL(stats.counters(GUIDE_EAST).nGuideMs, 0);
+    TEST_CHECK_EQUAL(stats.counters(GUIDE_SOUTH).nPulses, 0);
+    TEST_CHECK_EQUAL(stats.commandToAck().count(), 3);     // errors have no latency
+    TEST_CHECK(stats.format(szLine, sizeof(szLine)) > 0);
+    TEST_CHECK(strstr(szLine, "4 pulses, 1 errors") != NULL);
+
+    TEST_CHECK_EQUAL(mount.received(CMD_GUIDE_N), 2);
+    TEST_CHECK_EQUAL(mount.received(CMD_GUIDE_E), 0);
+    TEST_CHECK_EQUAL(mount.received(CMD_GUIDE_S), 0);
+    iOptron.Disconnect();
+}
+
+int main()
+{
+    testPriorityLock();
+    testPulseGoesFirst();
+    testGuideStats();
+    return testResult("PulseGuideTest");
+}
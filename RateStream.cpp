@@ -0,0 +1,213 @@
+#include <string.h>
+
+#include "RateStream.h"
+#include "iOptronProtocol.h"
+
+CRateStreamer::CRateStreamer()
+{
+    m_pfSend = NULL;
+    m_pSendData = NULL;
+    m_pClock = &CMonotonicClock::system();
+    m_pfEphemeris = NULL;
+    m_pEphemerisData = NULL;
+    m_nPeriodNs = RATE_STREAM_DEFAULT_PERIOD_MS * NS_PER_MS;
+    memset(&m_Counters, 0, sizeof(m_Counters));
+    m_Counters.nLastValue = -1;
+    m_bStop = false;
+    m_bRunning = false;
+}
+
+CRateStreamer::~CRateStreamer()
+{
+    stop();
+}
+
+#pragma mark - start / stop
+int CRateStreamer::start(const std::vector<iOptronRatePoint> &profile, int64_t nLastValue, int nPeriodMs)
+{
+    if(!m_pfSend || load(profile, nLastValue, nPeriodMs))
+        return -1;
+    return startThread();
+}
+
+int CRateStreamer::start(RateEphemerisCallback pfEphemeris, void *pUserData, int64_t nLastValue, int nPeriodMs)
+{
+    if(!pfEphemeris || !m_pfSend)
+        return -1;
+
+    stop();
+    {
+        std::lock_guard<std::mutex> locker(m_Lock);
+        m_Profile.clear();
+        m_pfEphemeris = pfEphemeris;
+        m_pEphemerisData = pUserData;
+    }
+    resetCounters(nLastValue, nPeriodMs);
+    return startThread();
+}
+
+int CRateStreamer::load(const std::vector<iOptronRatePoint> &profile, int64_t nLastValue, int nPeriodMs)
+{
+    if(profile.empty())
+        return -1;
+
+    stop();
+    {
+        std::lock_guard<std::mutex> locker(m_Lock);
+        m_Profile = profile;
+        m_pfEphemeris = NULL;
+        m_pEphemerisData = NULL;
+    }
+    resetCounters(nLastValue, nPeriodMs);
+    return 0;
+}
+
+void CRateStreamer::resetCounters(int64_t nLastValue, int nPeriodMs)
+{
+    std::lock_guard<std::mutex> locker(m_Lock);
+    memset(&m_Counters, 0, sizeof(m_Counters));
+    m_Counters.nLastValue = nLastValue;
+    m_nPeriodNs = (int64_t)(nPeriodMs < RATE_STREAM_MIN_PERIOD_MS ? RATE_STREAM_MIN_PERIOD_MS : nPeriodMs) * NS_PER_MS;
+}
+
+int CRateStreamer::startThread()
+{
+    m_bStop = false;
+    m_bRunning = true;
+    m_Scheduler = std::thread(&CRateStreamer::run, this);
+    return 0;
+}
+
+void CRateStreamer::stop()
+{
+    if(!m_Scheduler.joinable())
+        return;
+    {
+        std::lock_guard<std::mutex> locker(m_WakeLock);
+        m_bStop = true;
+    }
+    m_Wake.notify_one();
+    m_Scheduler.join();
+    m_bRunning = false;
+}
+
+void CRateStreamer::run()
+{
+    std::unique_lock<std::mutex> locker(m_WakeLock);
+    int64_t nPeriodNs;
+
+    while(!m_bStop) {
+        locker.unlock();
+        tick();
+        {
+            std::lock_guard<std::mutex> lock(m_Lock);
+            nPeriodNs = m_nPeriodNs;
+        }
+        locker.lock();
+        // real time, a virtual clock only moves the times the rates are looked up at
+        m_Wake.wait_for(locker, std::chrono::nanoseconds(nPeriodNs), [this] { return m_bStop; });
+    }
+}
+
+#pragma mark - scheduler
+void CRateStreamer::tick()
+{
+    int64_t nTargetNs;
+    int64_t nValue;
+    int64_t nStartNs;
+    int64_t nEndNs;
+    double dRate;
+    double dMultiplier;
+    int nErr;
+
+    {
+        std::lock_guard<std::mutex> locker(m_Lock);
+        m_Counters.nTicks++;
+        // the rate in the middle of the time this update will be in effect
+        nTargetNs = m_pClock->nowNs() + m_Counters.nLastRoundTripNs + m_nPeriodNs / 2;
+    }
+    if(!rateAt(nTargetNs, dRate))
+        return;
+
+    dMultiplier = multiplier(dRate);
+    nValue = customRateValue(dMultiplier);
+    {
+        std::lock_guard<std::mutex> locker(m_Lock);
+        if(dMultiplier < RATE_STREAM_MIN_MULTIPLIER || dMultiplier > RATE_STREAM_MAX_MULTIPLIER) {
+            m_Counters.nOutOfRange++;
+            return;
+        }
+        if(nValue == m_Counters.nLastValue) {
+            m_Counters.nSkipped++;
+            return;
+        }
+    }
+
+    nStartNs = m_pClock->nowNs();
+    nErr = m_pfSend(dMultiplier, m_pSendData);
+    nEndNs = m_pClock->nowNs();
+
+    std::lock_guard<std::mutex> locker(m_Lock);
+    if(nErr) {
+        m_Counters.nErrors++;
+        m_Counters.nLastValue = -1;    // don't know what the mount has now
+        return;
+    }
+    m_Counters.nSent++;
+    m_Counters.nLastValue = nValue;
+    m_Counters.nLastRoundTripNs = nEndNs - nStartNs;
+}
+
+bool CRateStreamer::rateAt(int64_t nTimeNs, double &dRaRateArcSecPerSec)
+{
+    RateEphemerisCallback pfEphemeris;
+    void *pEphemerisData;
+    size_t i;
+
+    {
+        std::lock_guard<std::mutex> locker(m_Lock);
+        pfEphemeris = m_pfEphemeris;
+        pEphemerisData = m_pEphemerisData;
+        if(!pfEphemeris) {
+            if(m_Profile.empty())
+                return false;
+            if(nTimeNs <= m_Profile.front().nTimeNs) {
+                dRaRateArcSecPerSec = m_Profile.front().dRaRateArcSecPerSec;
+                return true;
+            }
+            for(i = 1; i < m_Profile.size(); i++) {
+                if(nTimeNs < m_Profile[i].nTimeNs) {
+                    const iOptronRatePoint &from = m_Profile[i - 1];
+                    const iOptronRatePoint &to = m_Profile[i];
+                    dRaRateArcSecPerSec = from.dRaRateArcSecPerSec + (to.dRaRateArcSecPerSec - from.dRaRateArcSecPerSec) * (double)(nTimeNs - from.nTimeNs) / (double)(to.nTimeNs - from.nTimeNs);
+                    return true;
+                }
+            }
+            dRaRateArcSecPerSec = m_Profile.back().dRaRateArcSecPerSec;
+            return true;
+        }
+    }
+    // user code, not under the lock
+    return pfEphemeris(nTimeNs, dRaRateArcSecPerSec, pEphemerisData);
+}
+
+#pragma mark - statistics
+void CRateStreamer::getCounters(iOptronRateStreamCounters &counters)
+{
+    std::lock_guard<std::mutex> locker(m_Lock);
+    counters = m_Counters;
+}
+
+void CRateStreamer::dump(FILE *pFile)
+{
+    iOptronRateStreamCounters counters;
+
+    if(!pFile)
+        return;
+    getCounters(counters);
+    fprintf(pFile, "rate stream %s : %lu ticks, %lu :RR sent, %lu under the 0.0001 resolution, %lu out of range, %lu errors, last :RR%05lld# in %.3f ms\n",
+            running() ? "running" : "stopped",
+            counters.nTicks, counters.nSent, counters.nSkipped, counters.nOutOfRange, counters.nErrors,
+            (long long)counters.nLastValue, counters.nLastRoundTripNs / 1.0e6);
+    fflush(pFile);
+}
@@ -0,0 +1,93 @@
+#pragma once
+#include <stdio.h>
+#include <stdint.h>
+
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+#include "MonotonicClock.h"
+
+// Custom tracking rate streaming for satellites and comets.
+// The caller hands in a time tagged RA rate profile, or an ephemeris callback, and a scheduler thread
+// pushes :RRnnnnn# updates on its own. Each tick looks at the rate half a period ahead plus the last
+// :RR round trip, the middle of the time the update will be in effect, and only sends it when
+// it is a different :RR value : changes under the mount 0.0001 x sidereal resolution cost nothing.
+// Rates are in TheSkyX convention, arcsec/s of RA relative to sidereal, as in setTrackingRates().
+// The mount custom rate is RA only, Dec rates can't be followed.
+
+#define SIDEREAL_RATE_ARCSEC_PER_SEC    15.0410681
+#define RATE_STREAM_DEFAULT_PERIOD_MS   1000
+#define RATE_STREAM_MIN_PERIOD_MS       100
+#define RATE_STREAM_MIN_MULTIPLIER      0.1     // :RR valid range, x sidereal
+#define RATE_STREAM_MAX_MULTIPLIER      1.9
+
+typedef struct {
+    int64_t nTimeNs;                // CiOptron clock
+    double  dRaRateArcSecPerSec;    // linear between points, the first and last ones hold before and after
+} iOptronRatePoint;
+
+// On the scheduler thread. Return false when there is no rate for nTimeNs, the tick is skipped.
+typedef bool (*RateEphemerisCallback)(int64_t nTimeNs, double &dRaRateArcSecPerSec, void *pUserData);
+// Sends :RR, returns an iOptron error code. On the scheduler thread.
+typedef int (*RateSendCallback)(double dMountMultiplierRa, void *pUserData);
+
+typedef struct {
+    unsigned long   nTicks;
+    unsigned long   nSent;
+    unsigned long   nSkipped;       // same :RR value as the last one sent
+    unsigned long   nOutOfRange;    // multiplier outside of [0.1, 1.9], not sent
+    unsigned long   nErrors;
+    int64_t         nLastValue;     // last :RR value sent, -1 if none
+    int64_t         nLastRoundTripNs;
+} iOptronRateStreamCounters;
+
+class CRateStreamer
+{
+public:
+    CRateStreamer();
+    ~CRateStreamer();
+
+    void    setSender(RateSendCallback pfSend, void *pUserData) { m_pfSend = pfSend; m_pSendData = pUserData; }
+    void    setClock(CMonotonicClock &clock) { m_pClock = &clock; }
+
+    // nLastValue is the :RR value the mount already has, -1 if unknown. Restarts a running stream.
+    int     start(const std::vector<iOptronRatePoint> &profile, int64_t nLastValue, int nPeriodMs = RATE_STREAM_DEFAULT_PERIOD_MS);
+    int     start(RateEphemerisCallback pfEphemeris, void *pUserData, int64_t nLastValue, int nPeriodMs = RATE_STREAM_DEFAULT_PERIOD_MS);
+    void    stop();     // waits for the tick in progress, not from a callback
+    // what start() does without starting the scheduler, tick() is then up to the caller
+    int     load(const std::vector<iOptronRatePoint> &profile, int64_t nLastValue, int nPeriodMs = RATE_STREAM_DEFAULT_PERIOD_MS);
+    bool    running() const { return m_bRunning.load(std::memory_order_acquire); }
+
+    // one scheduler tick, what the thread runs every period
+    void    tick();
+    bool    rateAt(int64_t nTimeNs, double &dRaRateArcSecPerSec);
+    static double   multiplier(double dRaRateArcSecPerSec) { return (SIDEREAL_RATE_ARCSEC_PER_SEC - dRaRateArcSecPerSec) / SIDEREAL_RATE_ARCSEC_PER_SEC; }
+
+    void    getCounters(iOptronRateStreamCounters &counters);
+    void    dump(FILE *pFile);
+
+private:
+    void    resetCounters(int64_t nLastValue, int nPeriodMs);
+    int     startThread();
+    void    run();
+
+    RateSendCallback            m_pfSend;
+    void                        *m_pSendData;
+    CMonotonicClock             *m_pClock;
+
+    std::mutex                  m_Lock;         // protects everything below
+    std::vector<iOptronRatePoint>   m_Profile;
+    RateEphemerisCallback       m_pfEphemeris;
+    void                        *m_pEphemerisData;
+    int64_t                     m_nPeriodNs;
+    iOptronRateStreamCounters   m_Counters;
+
+    std::mutex                  m_WakeLock;
+    std::condition_variable     m_Wake;
+    bool                        m_bStop;
+    std::atomic<bool>           m_bRunning;
+    std::thread                 m_Scheduler;
+};
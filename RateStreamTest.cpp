@@ -0,0 +1,217 @@
+// CRateStreamer ticks driven by hand on a virtual clock, then a stream run through CiOptron against
+// a simulated mount. Built and run by make test.
+
+#include <math.h>
+#include <unistd.h>
+
+#include "TestCheck.h"
+#include "SimulatedMount.h"
+#include "RateStream.h"
+#include "iOptronV3.h"
+
+#define SEND_ROUND_TRIP_NS  (20 * NS_PER_MS)
+
+typedef struct {
+    CVirtualClock   *pClock;
+    int             nErr;       // what the next sends return
+    int             nCalls;
+    double          dLastMultiplier;
+} FakeSender;
+
+static int fakeSend(double dMountMultiplierRa, void *pUserData)
+{
+    FakeSender *pSender = (FakeSender *)pUserData;
+
+    pSender->nCalls++;
+    pSender->dLastMultiplier = dMountMultiplierRa;
+    pSender->pClock->advance(SEND_ROUND_TRIP_NS);
+    return pSender->nErr;
+}
+
+// the RA rate, arcsec/s relative to sidereal, for a mount multiplier
+static double rateFor(double dMultiplier)
+{
+    return SIDEREAL_RATE_ARCSEC_PER_SEC * (1.0 - dMultiplier);
+}
+
+static iOptronRatePoint ratePoint(int64_t nTimeNs, double dRate)
+{
+    iOptronRatePoint point;
+
+    point.nTimeNs = nTimeNs;
+    point.dRaRateArcSecPerSec = dRate;
+    return point;
+}
+
+static iOptronRateStreamCounters counters(CRateStreamer &stream)
+{
+    iOptronRateStreamCounters streamCounters;
+
+    stream.getCounters(streamCounters);
+    return streamCounters;
+}
+
+static void testProfile()
+{
+    CRateStreamer stream;
+    std::vector<iOptronRatePoint> profile;
+    double dRate = 0.0;
+
+    profile.push_back(ratePoint(10 * NS_PER_SECOND, 0.0));
+    profile.push_back(ratePoint(20 * NS_PER_SECOND, 1.5));
+    profile.push_back(ratePoint(30 * NS_PER_SECOND, -0.5));
+    TEST_CHECK_EQUAL(stream.load(profile, -1), 0);
+
+    TEST_CHECK(stream.rateAt(0, dRate) && dRate == 0.0);                        // held before the first point
+    TEST_CHECK(stream.rateAt(10 * NS_PER_SECOND, dRate) && dRate == 0.0);
+    TEST_CHECK(stream.rateAt(15 * NS_PER_SECOND, dRate) && fabs(dRate - 0.75) < 1e-12);
+    TEST_CHECK(stream.rateAt(17500 * NS_PER_MS, dRate) && fabs(dRate - 1.125) < 1e-12);
+    TEST_CHECK(stream.rateAt(20 * NS_PER_SECOND, dRate) && dRate == 1.5);
+    TEST_CHECK(stream.rateAt(25 * NS_PER_SECOND, dRate) && fabs(dRate - 0.5) < 1e-12);
+    TEST_CHECK(stream.rateAt(30 * NS_PER_SECOND, dRate) && dRate == -0.5);
+    TEST_CHECK(stream.rateAt(3600 * NS_PER_SECOND, dRate) && dRate == -0.5);    // held after the last one
+
+    profile.clear();
+    TEST_CHECK(stream.load(profile, -1) != 0);
+    TEST_CHECK(!stream.running());
+}
+
+static void testTicks()
+{
+    CVirtualClock clock;
+    CRateStreamer stream;
+    FakeSender sender = {&clock, 0, 0, 0.0};
+    std::vector<iOptronRatePoint> profile;
+    iOptronRateStreamCounters streamCounters;
+    double dExpected;
+
+    stream.setClock(clock);
+    stream.setSender(fakeSend, &sender);
+    profile.push_back(ratePoint(10 * NS_PER_SECOND, rateFor(0.5)));
+    profile.push_back(ratePoint(20 * NS_PER_SECOND, rateFor(1.5)));
+    profile.push_back(ratePoint(30 * NS_PER_SECOND, rateFor(1.5)));
+    profile.push_back(ratePoint(31 * NS_PER_SECOND, rateFor(1.95)));
+    profile.push_back(ratePoint(40 * NS_PER_SECOND, rateFor(1.95)));
+    profile.push_back(ratePoint(41 * NS_PER_SECOND, rateFor(0.05)));
+    TEST_CHECK_EQUAL(stream.load(profile, -1, 1000), 0);
+
+    // before the profile, the first rate
+    clock.set(0);
+    stream.tick();
+    streamCounters = counters(stream);
+    TEST_CHECK_EQUAL(sender.nCalls, 1);
+    TEST_CHECK(fabs(sender.dLastMultiplier - 0.5) < 1e-9);
+    TEST_CHECK_EQUAL(streamCounters.nSent, 1);
+    TEST_CHECK_EQUAL(streamCounters.nLastValue, 5000);
+    TEST_CHECK_EQUAL(streamCounters.nLastRoundTripNs, SEND_ROUND_TRIP_NS);
+
+    // same :RR value, nothing sent
+    stream.tick();
+    streamCounters = counters(stream);
+    TEST_CHECK_EQUAL(sender.nCalls, 1);
+    TEST_CHECK_EQUAL(streamCounters.nSkipped, 1);
+
+    // looked up half a period plus the last round trip ahead, on the ramp
+    clock.set(14 * NS_PER_SECOND);
+    dExpected = 0.5 + (14 * NS_PER_SECOND + SEND_ROUND_TRIP_NS + 500 * NS_PER_MS - 10 * NS_PER_SECOND) / (10.0 * NS_PER_SECOND);
+    stream.tick();
+    streamCounters = counters(stream);
+    TEST_CHECK_EQUAL(sender.nCalls, 2);
+    TEST_CHECK(fabs(sender.dLastMultiplier - dExpected) < 1e-9);
+    TEST_CHECK_EQUAL(streamCounters.nLastValue, customRateValue(dExpected));
+
+    // past the ramp, held
+    clock.set(25 * NS_PER_SECOND);
+    stream.tick();
+    TEST_CHECK_EQUAL(counters(stream).nLastValue, 15000);
+
+    // a send error : what the mount has is unknown, the value that failed isn't taken as sent
+    sender.nErr = COMMAND_FAILED;
+    clock.set(0);
+    stream.tick();
+    streamCounters = counters(stream);
+    TEST_CHECK_EQUAL(sender.nCalls, 4);
+    TEST_CHECK_EQUAL(streamCounters.nErrors, 1);
+    TEST_CHECK_EQUAL(streamCounters.nLastValue, -1);
+    sender.nErr = 0;
+    clock.set(0);
+    stream.tick();
+    streamCounters = counters(stream);
+    TEST_CHECK_EQUAL(sender.nCalls, 5);
+    TEST_CHECK_EQUAL(streamCounters.nLastValue, 5000);
+
+    // outside of [0.1, 1.9] x sidereal, above then below
+    clock.set(35 * NS_PER_SECOND);
+    stream.tick();
+    clock.set(50 * NS_PER_SECOND);
+    stream.tick();
+    streamCounters = counters(stream);
+    TEST_CHECK_EQUAL(streamCounters.nOutOfRange, 2);
+    TEST_CHECK_EQUAL(sender.nCalls, 5);
+    TEST_CHECK_EQUAL(streamCounters.nLastValue, 5000);
+
+    TEST_CHECK_EQUAL(streamCounters.nTicks, 8);
+    TEST_CHECK_EQUAL(streamCounters.nSent, 4);
+    TEST_CHECK_EQUAL(streamCounters.nSkipped, 1);
+}
+
+// waits, in real time, for the scheduler thread to get :RR to the mount
+static bool waitForRate(CSimulatedMount &mount, int64_t nValue)
+{
+    int i;
+
+    for(i = 0; i < 200; i++) {
+        if(mount.customRateValue() == nValue)
+            return true;
+        usleep(10000);
+    }
+    return false;
+}
+
+static void testStream()
+{
+    CSimulatedMount mount(120);
+    CVirtualClock clock;
+    CSimulatedSerial serial(mount, &clock);
+    CiOptron iOptron;
+    std::vector<iOptronRatePoint> profile;
+    unsigned long nRR;
+
+    iOptron.setSerxPointer(&serial);
+    iOptron.setClock(&clock);
+    TEST_CHECK_EQUAL(iOptron.Connect((char *)"sim"), SB_OK);
+    profile.push_back(ratePoint(0, rateFor(0.75)));
+
+    mount.resetCounts();
+    TEST_CHECK_EQUAL(iOptron.startRateStream(profile, RATE_STREAM_MIN_PERIOD_MS), SB_OK);
+    TEST_CHECK_EQUAL(mount.received(CMD_RT4), 1);
+    TEST_CHECK(iOptron.rateStream().running());
+    TEST_CHECK(waitForRate(mount, 7500));
+
+    // the host rate takes over
+    TEST_CHECK_EQUAL(iOptron.setTrackingRates(true, true, 0.0, 0.0), SB_OK);
+    TEST_CHECK(!iOptron.rateStream().running());
+    nRR = mount.received(CMD_RR);
+    usleep(3 * RATE_STREAM_MIN_PERIOD_MS * 1000);
+    TEST_CHECK_EQUAL(mount.received(CMD_RR), nRR);
+
+    profile[0] = ratePoint(0, rateFor(1.25));
+    TEST_CHECK_EQUAL(iOptron.startRateStream(profile, RATE_STREAM_MIN_PERIOD_MS), SB_OK);
+    TEST_CHECK(waitForRate(mount, 12500));
+    iOptron.Disconnect();
+    TEST_CHECK(!iOptron.rateStream().running());
+    nRR = mount.received(CMD_RR);
+    usleep(3 * RATE_STREAM_MIN_PERIOD_MS * 1000);
+    TEST_CHECK_EQUAL(mount.received(CMD_RR), nRR);
+
+    TEST_CHECK_EQUAL(mount.received(CMD_RT4), 2);
+    TEST_CHECK_EQUAL(mount.unknownCommands(), 0);
+}
+
+int main()
+{
+    testProfile();
+    testTicks();
+    testStream();
+    return testResult("RateStreamTest");
+}
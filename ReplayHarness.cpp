@@ -0,0 +1,204 @@
+// Replays a TheSkyX polling pattern against X2Mount and prints what each host call cost : serial
+// commands and bytes per call, I/O mutex hold time and the age of the cached answers.
+// The mount is simulated (virtual clock, no waiting) or a capture file recorded by CSerialCapture,
+// so a caching change can be judged on a recorded session. Built and run by make replay.
+//
+// ReplayHarness [-m model] [-p poll ms] [-n refreshes] [-r capture to record] [-c capture to replay] [-t time scale]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "X2Fakes.h"
+#include "SimulatedMount.h"
+#include "SerialCapture.h"
+#include "x2mount.h"
+
+#define REPLAY_START_NS         (1000 * NS_PER_SECOND)
+#define REPLAY_POLL_MS          500     // TheSkyX telescope refresh period
+#define REPLAY_REFRESHES        20      // tracking refreshes before and after the goto
+#define REPLAY_MAX_POLLS        200     // gives up on a slew or park that never completes
+
+typedef struct {
+    int         nModelCode;
+    int         nPollMs;
+    int         nRefreshes;
+    const char  *pszRecordFile;
+    const char  *pszReplayFile;
+    double      dTimeScale;
+} ReplayOptions;
+
+static int parseOptions(int argc, char **argv, ReplayOptions &options)
+{
+    int i;
+
+    options.nModelCode = SIM_DEFAULT_MODEL;
+    options.nPollMs = REPLAY_POLL_MS;
+    options.nRefreshes = REPLAY_REFRESHES;
+    options.pszRecordFile = NULL;
+    options.pszReplayFile = NULL;
+    options.dTimeScale = 0.0;
+
+    for(i = 1; i < argc; i++) {
+        if(i + 1 >= argc)
+            return ERR_CMDFAILED;
+        if(!strcmp(argv[i], "-m"))
+            options.nModelCode = atoi(argv[++i]);
+        else if(!strcmp(argv[i], "-p"))
+            options.nPollMs = atoi(argv[++i]);
+        else if(!strcmp(argv[i], "-n"))
+            options.nRefreshes = atoi(argv[++i]);
+        else if(!strcmp(argv[i], "-r"))
+            options.pszRecordFile = argv[++i];
+        else if(!strcmp(argv[i], "-c"))
+            options.pszReplayFile = argv[++i];
+        else if(!strcmp(argv[i], "-t"))
+            options.dTimeScale = atof(argv[++i]);
+        else
+            return ERR_CMDFAILED;
+    }
+    if(options.nPollMs <= 0 || options.nRefreshes < 0)
+        return ERR_CMDFAILED;
+    return SB_OK;
+}
+
+// one TheSkyX telescope refresh : position, then tracking state
+static void refresh(X2Mount &mount, CVirtualClock &clock, int nPollMs)
+{
+    double dRa, dDec, dRaRate, dDecRate;
+    bool bTrackingOn;
+
+    clock.advance(nPollMs * NS_PER_MS);
+    mount.raDec(dRa, dDec);
+    mount.trackingRates(bTrackingOn, dRaRate, dDecRate);
+}
+
+// link, track, goto, track, park, unpark, unlink
+static int runSession(X2Mount &mount, CVirtualClock &clock, const ReplayOptions &options)
+{
+    int nErr;
+    int i;
+    bool bComplete;
+    double dRa, dDec;
+
+    nErr = mount.establishLink();
+    if(nErr) {
+        fprintf(stderr, "establishLink failed : %d\n", nErr);
+        return nErr;
+    }
+
+    for(i = 0; i < options.nRefreshes; i++) {
+        refresh(mount, clock, options.nPollMs);
+        if(i % 5 == 0)
+            mount.isParked();
+    }
+
+    mount.startSlewTo(8.0, 40.0);
+    bComplete = false;
+    for(i = 0; i < REPLAY_MAX_POLLS && !bComplete; i++) {
+        clock.advance(options.nPollMs * NS_PER_MS);
+        mount.raDec(dRa, dDec);
+        if(mount.isCompleteSlewTo(bComplete))
+            break;
+    }
+    mount.endSlewTo();
+
+    for(i = 0; i < options.nRefreshes; i++)
+        refresh(mount, clock, options.nPollMs);
+
+    mount.startPark(0.0, 90.0);
+    bComplete = false;
+    for(i = 0; i < REPLAY_MAX_POLLS && !bComplete; i++) {
+        clock.advance(options.nPollMs * NS_PER_MS);
+        if(mount.isCompletePark(bComplete))
+            break;
+    }
+    mount.isParked();
+    mount.startUnpark();
+    bComplete = false;
+    for(i = 0; i < REPLAY_MAX_POLLS && !bComplete; i++) {
+        clock.advance(options.nPollMs * NS_PER_MS);
+        if(mount.isCompleteUnpark(bComplete))
+            break;
+    }
+
+    return mount.terminateLink();
+}
+
+static void printTotals(const CHostCallStats &stats, int64_t nSessionNs)
+{
+    int i;
+    unsigned long nCalls = 0;
+    unsigned long nCommands = 0;
+    unsigned long nBytesWritten = 0;
+    unsigned long nBytesRead = 0;
+    unsigned long nCached = 0;
+
+    for(i = 0; i < X2_NB_HOST_CALLS; i++) {
+        nCalls += stats.counters(i).nCalls;
+        nCommands += stats.counters(i).nCommands;
+        nBytesWritten += stats.counters(i).nBytesWritten;
+        nBytesRead += stats.counters(i).nBytesRead;
+        nCached += stats.counters(i).nCachedAnswers;
+    }
+    printf("session %.1f s, %lu host calls, %lu commands (%.2f per call), %lu bytes out, %lu bytes in, %lu cached answers\n",
+           nsToSeconds(nSessionNs), nCalls, nCommands, nCalls ? (double)nCommands / nCalls : 0.0, nBytesWritten, nBytesRead, nCached);
+}
+
+int main(int argc, char **argv)
+{
+    ReplayOptions options;
+    CSimulatedMount simulated;
+    CVirtualClock clock(REPLAY_START_NS);
+    CSimulatedSerial simulatedSerial(simulated, &clock);
+    CSerialReplay replay;
+    CVirtualTimeSerial replayTiming(&replay, &clock);
+    SerXInterface *pTransport = &simulatedSerial;
+    CSerialCapture *pCapture;
+    X2Mount *pMount;
+    int nErr;
+
+    if(parseOptions(argc, argv, options)) {
+        fprintf(stderr, "usage : %s [-m model] [-p poll ms] [-n refreshes] [-r capture to record] [-c capture to replay] [-t time scale]\n", argv[0]);
+        return 2;
+    }
+
+    if(options.pszReplayFile) {
+        if(replay.load(options.pszReplayFile)) {
+            fprintf(stderr, "can't load %s\n", options.pszReplayFile);
+            return 1;
+        }
+        replay.setTimeScale(options.dTimeScale);
+        pTransport = &replayTiming;    // cache ages as in the simulated session
+        printf("replay of %s, %d records, poll every %d ms\n", options.pszReplayFile, replay.getNbRecords(), options.nPollMs);
+    }
+    else {
+        simulated.setModel(options.nModelCode);
+        printf("simulated %s, poll every %d ms\n", mountModel(options.nModelCode).pszName, options.nPollMs);
+    }
+
+    // X2Mount deletes the capture wrapper, the transport under it stays ours
+    pCapture = new CSerialCapture(pTransport);
+    if(options.pszRecordFile && pCapture->startCapture(options.pszRecordFile)) {
+        fprintf(stderr, "can't create %s\n", options.pszRecordFile);
+        delete pCapture;
+        return 1;
+    }
+    pMount = new X2Mount("iOptronV3", 0, pCapture, NULL, new CFakeSleeper(&clock), new CFakeIniUtil(), new CFakeLogger(), new CFakeMutex(), new CFakeTickCount());
+    pMount->setClock(&clock);
+
+    nErr = runSession(*pMount, clock, options);
+    pCapture->stopCapture();
+
+    printTotals(pMount->hostCallStats(), clock.nowNs() - REPLAY_START_NS);
+    pMount->hostCallStats().dump(stdout);
+    printf("\n");
+    pMount->hostCallStats().report(stdout);
+    if(options.pszReplayFile)
+        printf("\n%d writes differ from the capture, capture %s\n", replay.getWriteMismatches(), replay.isAtEnd() ? "fully replayed" : "not fully replayed");
+    else if(simulated.unknownCommands())
+        printf("\n%lu commands unknown to the simulated mount\n", simulated.unknownCommands());
+
+    delete pMount;
+    return nErr ? 1 : 0;
+}
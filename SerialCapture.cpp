@@ -0,0 +1,336 @@
+#include "SerialCapture.h"
+
+#include <thread>
+#include <chrono>
+
+#include "../../licensedinterfaces/sberrorx.h"
+#include "MonotonicClock.h"
+
+uint64_t captureMonotonicNs()
+{
+    return (uint64_t)CMonotonicClock::system().nowNs();
+}
+
+#pragma mark - CSerialCapture
+CSerialCapture::CSerialCapture(SerXInterface *pSerX)
+{
+    m_pSerX = pSerX;
+    m_pFile = NULL;
+    m_nCaptureStartNs = captureMonotonicNs();
+}
+
+CSerialCapture::~CSerialCapture()
+{
+    stopCapture();
+}
+
+int CSerialCapture::startCapture(const char *pszFile)
+{
+    uint32_t nVersionAndReserved[2] = {1, 0};
+
+    stopCapture();
+    m_pFile = fopen(pszFile, "wb");
+    if(!m_pFile)
+        return ERR_CMDFAILED;
+
+    fwrite(IOPTRON_CAPTURE_MAGIC, 1, IOPTRON_CAPTURE_MAGIC_LEN, m_pFile);
+    fwrite(nVersionAndReserved, sizeof(nVersionAndReserved), 1, m_pFile);
+    m_nCaptureStartNs = captureMonotonicNs();
+    return SB_OK;
+}
+
+void CSerialCapture::stopCapture()
+{
+    if(m_pFile) {
+        fclose(m_pFile);
+        m_pFile = NULL;
+    }
+}
+
+void CSerialCapture::writeRecord(int nType, int nResult, uint32_t nAux, uint64_t nStartNs, const void *pPayload, unsigned long nLength)
+{
+    iOptronCaptureRecordHeader header;
+    uint64_t nEndNs;
+
+    if(!m_pFile)
+        return;
+
+    nEndNs = captureMonotonicNs();
+    if(nLength > 0xFFFF)
+        nLength = 0xFFFF;
+
+    header.nType = (uint8_t)nType;
+    header.nReserved = 0;
+    header.nLength = (uint16_t)nLength;
+    header.nResult = nResult;
+    header.nAux = nAux;
+    header.nDurationUs = (uint32_t)((nEndNs - nStartNs) / 1000);
+    header.nStartNs = nStartNs - m_nCaptureStartNs;
+
+    fwrite(&header, sizeof(header), 1, m_pFile);
+    if(nLength)
+        fwrite(pPayload, 1, nLength, m_pFile);
+    // a read ends an exchange, push it to the file so a crash doesn't lose the end of the session.
+    // One write per exchange, the other records stay in the stdio buffer until then
+    if(nType == CAPTURE_READ)
+        fflush(m_pFile);
+}
+
+int CSerialCapture::open(const char* pszPort, const unsigned long& dwBaudRate, const Parity& parity, const char* pszSession)
+{
+    int nErr;
+    uint64_t nStartNs = captureMonotonicNs();
+
+    nErr = m_pSerX->open(pszPort, dwBaudRate, parity, pszSession);
+    writeRecord(CAPTURE_OPEN, nErr, (uint32_t)dwBaudRate, nStartNs, pszPort, pszPort?strlen(pszPort):0);
+    return nErr;
+}
+
+int CSerialCapture::close()
+{
+    int nErr;
+    uint64_t nStartNs = captureMonotonicNs();
+
+    nErr = m_pSerX->close();
+    writeRecord(CAPTURE_CLOSE, nErr, 0, nStartNs, NULL, 0);
+    if(m_pFile)
+        fflush(m_pFile);
+    return nErr;
+}
+
+int CSerialCapture::flushTx(void)
+{
+    int nErr;
+    uint64_t nStartNs = captureMonotonicNs();
+
+    nErr = m_pSerX->flushTx();
+    writeRecord(CAPTURE_FLUSH_TX, nErr, 0, nStartNs, NULL, 0);
+    return nErr;
+}
+
+int CSerialCapture::purgeTxRx(void)
+{
+    int nErr;
+    uint64_t nStartNs = captureMonotonicNs();
+
+    nErr = m_pSerX->purgeTxRx();
+    writeRecord(CAPTURE_PURGE_TX_RX, nErr, 0, nStartNs, NULL, 0);
+    return nErr;
+}
+
+int CSerialCapture::waitForBytesRx(const int& nNumber, const int& nTimeOutMilli)
+{
+    int nErr;
+    uint64_t nStartNs = captureMonotonicNs();
+
+    nErr = m_pSerX->waitForBytesRx(nNumber, nTimeOutMilli);
+    writeRecord(CAPTURE_WAIT_RX, nErr, (uint32_t)nNumber, nStartNs, NULL, 0);
+    return nErr;
+}
+
+int CSerialCapture::readFile(void* lpBuffer, const unsigned long dwTotalToRead, unsigned long& dwBytesRead, const unsigned long& dwTimeOut)
+{
+    int nErr;
+    uint64_t nStartNs = captureMonotonicNs();
+
+    dwBytesRead = 0;
+    nErr = m_pSerX->readFile(lpBuffer, dwTotalToRead, dwBytesRead, dwTimeOut);
+    writeRecord(CAPTURE_READ, nErr, (uint32_t)dwTotalToRead, nStartNs, lpBuffer, dwBytesRead);
+    return nErr;
+}
+
+int CSerialCapture::writeFile(void* lpBuffer, const unsigned long& dwBytesToWrite, unsigned long& dwBytesWritten)
+{
+    int nErr;
+    uint64_t nStartNs = captureMonotonicNs();
+
+    dwBytesWritten = 0;
+    nErr = m_pSerX->writeFile(lpBuffer, dwBytesToWrite, dwBytesWritten);
+    writeRecord(CAPTURE_WRITE, nErr, (uint32_t)dwBytesToWrite, nStartNs, lpBuffer, dwBytesWritten);
+    return nErr;
+}
+
+int CSerialCapture::bytesWaitingRx(int &nBytesWaiting)
+{
+    int nErr;
+    uint64_t nStartNs = captureMonotonicNs();
+
+    nErr = m_pSerX->bytesWaitingRx(nBytesWaiting);
+    writeRecord(CAPTURE_BYTES_WAITING, nErr, (uint32_t)nBytesWaiting, nStartNs, NULL, 0);
+    return nErr;
+}
+
+#pragma mark - CSerialReplay
+CSerialReplay::CSerialReplay()
+{
+    m_nNextRecord = 0;
+    m_dTimeScale = 1.0;
+    m_bConnected = false;
+    m_nWriteMismatches = 0;
+    m_nReplayStartNs = 0;
+}
+
+int CSerialReplay::load(const char *pszFile)
+{
+    FILE *pFile;
+    char szMagic[IOPTRON_CAPTURE_MAGIC_LEN];
+    uint32_t nVersionAndReserved[2];
+    iOptronCaptureRecord record;
+
+    m_Records.clear();
+    pFile = fopen(pszFile, "rb");
+    if(!pFile)
+        return ERR_CMDFAILED;
+
+    if(fread(szMagic, 1, IOPTRON_CAPTURE_MAGIC_LEN, pFile) != IOPTRON_CAPTURE_MAGIC_LEN ||
+       memcmp(szMagic, IOPTRON_CAPTURE_MAGIC, IOPTRON_CAPTURE_MAGIC_LEN) != 0 ||
+       fread(nVersionAndReserved, sizeof(nVersionAndReserved), 1, pFile) != 1) {
+        fclose(pFile);
+        return ERR_CMDFAILED;
+    }
+
+    while(fread(&record.header, sizeof(record.header), 1, pFile) == 1) {
+        record.payload.resize(record.header.nLength);
+        if(record.header.nLength && fread(&record.payload[0], 1, record.header.nLength, pFile) != record.header.nLength)
+            break;  // truncated capture, keep what we have
+        m_Records.push_back(record);
+    }
+    fclose(pFile);
+
+    rewind();
+    return SB_OK;
+}
+
+void CSerialReplay::rewind()
+{
+    m_nNextRecord = 0;
+    m_nWriteMismatches = 0;
+    m_bConnected = false;
+    m_nReplayStartNs = captureMonotonicNs();
+}
+
+const iOptronCaptureRecord *CSerialReplay::nextRecord(int nType)
+{
+    size_t i;
+
+    // skip anything the driver didn't ask for this time around
+    for(i = m_nNextRecord; i < m_Records.size(); i++) {
+        if(m_Records[i].header.nType == nType) {
+            m_nNextRecord = i + 1;
+            return &m_Records[i];
+        }
+    }
+    return NULL;
+}
+
+void CSerialReplay::waitUntil(uint64_t nCaptureNs)
+{
+    uint64_t nTargetNs;
+    uint64_t nNowNs;
+
+    if(m_dTimeScale <= 0.0)
+        return;
+
+    nTargetNs = m_nReplayStartNs + (uint64_t)((double)nCaptureNs * m_dTimeScale);
+    nNowNs = captureMonotonicNs();
+    if(nTargetNs > nNowNs)
+        std::this_thread::sleep_for(std::chrono::nanoseconds(nTargetNs - nNowNs));
+}
+
+int CSerialReplay::open(const char* /*pszPort*/, const unsigned long& /*dwBaudRate*/, const Parity& /*parity*/, const char* /*pszSession*/)
+{
+    const iOptronCaptureRecord *pRecord;
+
+    pRecord = nextRecord(CAPTURE_OPEN);
+    if(!pRecord)
+        return ERR_NOLINK;
+
+    if(m_nNextRecord == 1)
+        m_nReplayStartNs = captureMonotonicNs() - (uint64_t)((double)pRecord->header.nStartNs * m_dTimeScale);
+    waitUntil(pRecord->header.nStartNs + pRecord->header.nDurationUs * 1000ULL);
+    m_bConnected = (pRecord->header.nResult == 0);
+    return pRecord->header.nResult;
+}
+
+int CSerialReplay::close()
+{
+    const iOptronCaptureRecord *pRecord;
+
+    m_bConnected = false;
+    pRecord = nextRecord(CAPTURE_CLOSE);
+    return pRecord ? pRecord->header.nResult : SB_OK;
+}
+
+int CSerialReplay::flushTx(void)
+{
+    return SB_OK;
+}
+
+int CSerialReplay::purgeTxRx(void)
+{
+    return SB_OK;
+}
+
+int CSerialReplay::waitForBytesRx(const int& /*nNumber*/, const int& /*nTimeOutMilli*/)
+{
+    const iOptronCaptureRecord *pRecord;
+
+    pRecord = nextRecord(CAPTURE_WAIT_RX);
+    if(!pRecord)
+        return ERR_NORESPONSE;
+    waitUntil(pRecord->header.nStartNs + pRecord->header.nDurationUs * 1000ULL);
+    return pRecord->header.nResult;
+}
+
+int CSerialReplay::readFile(void* lpBuffer, const unsigned long dwTotalToRead, unsigned long& dwBytesRead, const unsigned long& /*dwTimeOut*/)
+{
+    const iOptronCaptureRecord *pRecord;
+    unsigned long nBytes;
+
+    dwBytesRead = 0;
+    pRecord = nextRecord(CAPTURE_READ);
+    if(!pRecord)
+        return SB_OK;   // end of capture looks like a timeout to the driver
+
+    // the mount think time and transfer time are in the duration of the read
+    waitUntil(pRecord->header.nStartNs + pRecord->header.nDurationUs * 1000ULL);
+
+    nBytes = pRecord->payload.size();
+    if(nBytes > dwTotalToRead)
+        nBytes = dwTotalToRead;
+    if(nBytes)
+        memcpy(lpBuffer, &pRecord->payload[0], nBytes);
+    dwBytesRead = nBytes;
+    return pRecord->header.nResult;
+}
+
+int CSerialReplay::writeFile(void* lpBuffer, const unsigned long& dwBytesToWrite, unsigned long& dwBytesWritten)
+{
+    const iOptronCaptureRecord *pRecord;
+
+    dwBytesWritten = 0;
+    pRecord = nextRecord(CAPTURE_WRITE);
+    if(!pRecord) {
+        m_nWriteMismatches++;
+        return SB_OK;
+    }
+
+    waitUntil(pRecord->header.nStartNs);
+    if(pRecord->payload.size() != dwBytesToWrite || (dwBytesToWrite && memcmp(&pRecord->payload[0], lpBuffer, dwBytesToWrite) != 0))
+        m_nWriteMismatches++;
+
+    dwBytesWritten = dwBytesToWrite;
+    return pRecord->header.nResult;
+}
+
+int CSerialReplay::bytesWaitingRx(int &nBytesWaiting)
+{
+    const iOptronCaptureRecord *pRecord;
+
+    nBytesWaiting = 0;
+    pRecord = nextRecord(CAPTURE_BYTES_WAITING);
+    if(!pRecord)
+        return SB_OK;
+    nBytesWaiting = (int)pRecord->header.nAux;
+    return pRecord->header.nResult;
+}
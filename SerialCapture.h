@@ -0,0 +1,104 @@
+#pragma once
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+// C++ includes
+#include <string>
+#include <vector>
+
+#include "../../licensedinterfaces/serxinterface.h"
+
+// Binary serial transcript.
+// File : "IOPTCAP1" magic followed by records, each a iOptronCaptureRecordHeader followed by nLength payload bytes.
+// Multi-byte fields are written in host byte order.
+#define IOPTRON_CAPTURE_MAGIC       "IOPTCAP1"
+#define IOPTRON_CAPTURE_MAGIC_LEN   8
+
+enum iOptronCaptureRecordType {CAPTURE_OPEN=1, CAPTURE_CLOSE, CAPTURE_WRITE, CAPTURE_READ, CAPTURE_FLUSH_TX, CAPTURE_PURGE_TX_RX, CAPTURE_WAIT_RX, CAPTURE_BYTES_WAITING};
+
+#pragma pack(push, 1)
+typedef struct {
+    uint8_t     nType;          // iOptronCaptureRecordType
+    uint8_t     nReserved;
+    uint16_t    nLength;        // payload length
+    int32_t     nResult;        // value returned by the call
+    uint32_t    nAux;           // open : baud rate, read : bytes requested, wait : bytes waited for, bytes waiting : count
+    uint32_t    nDurationUs;    // time spent in the call
+    uint64_t    nStartNs;       // monotonic time at the start of the call, relative to the start of the capture
+} iOptronCaptureRecordHeader;
+#pragma pack(pop)
+
+typedef struct {
+    iOptronCaptureRecordHeader  header;
+    std::vector<uint8_t>        payload;
+} iOptronCaptureRecord;
+
+uint64_t captureMonotonicNs();
+
+// Pass-through SerXInterface recording every call with monotonic timestamps.
+class CSerialCapture : public SerXInterface
+{
+public:
+    CSerialCapture(SerXInterface *pSerX);
+    virtual ~CSerialCapture();
+
+    void    setSerX(SerXInterface *pSerX) { m_pSerX = pSerX; }  // only while the port is closed
+    int     startCapture(const char *pszFile);
+    void    stopCapture();
+    bool    isCapturing() const { return m_pFile != NULL; }
+
+    virtual int     open(const char* pszPort, const unsigned long& dwBaudRate = 9600, const Parity& parity = B_NOPARITY, const char* pszSession = 0);
+    virtual int     close();
+    virtual bool    isConnected(void) const { return m_pSerX->isConnected(); }
+    virtual int     flushTx(void);
+    virtual int     purgeTxRx(void);
+    virtual int     waitForBytesRx(const int& nNumber, const int& nTimeOutMilli);
+    virtual int     readFile(void* lpBuffer, const unsigned long dwTotalToRead, unsigned long& dwBytesRead, const unsigned long& dwTimeOut = 1000);
+    virtual int     writeFile(void* lpBuffer, const unsigned long& dwBytesToWrite, unsigned long& dwBytesWritten);
+    virtual int     bytesWaitingRx(int &nBytesWaiting);
+
+private:
+    SerXInterface   *m_pSerX;
+    FILE            *m_pFile;
+    uint64_t        m_nCaptureStartNs;
+
+    void    writeRecord(int nType, int nResult, uint32_t nAux, uint64_t nStartNs, const void *pPayload, unsigned long nLength);
+};
+
+// SerXInterface feeding a capture back to the driver, with the original timing or time-compressed.
+class CSerialReplay : public SerXInterface
+{
+public:
+    CSerialReplay();
+    virtual ~CSerialReplay() {};
+
+    int     load(const char *pszFile);
+    void    setTimeScale(double dScale) { m_dTimeScale = dScale; }  // 1.0 = original timing, 0.1 = ten times faster, 0 = no waiting
+    void    rewind();
+
+    int     getNbRecords() const { return (int)m_Records.size(); }
+    int     getWriteMismatches() const { return m_nWriteMismatches; }   // writes that differ from the capture
+    bool    isAtEnd() const { return m_nNextRecord >= m_Records.size(); }
+
+    virtual int     open(const char* pszPort, const unsigned long& dwBaudRate = 9600, const Parity& parity = B_NOPARITY, const char* pszSession = 0);
+    virtual int     close();
+    virtual bool    isConnected(void) const { return m_bConnected; }
+    virtual int     flushTx(void);
+    virtual int     purgeTxRx(void);
+    virtual int     waitForBytesRx(const int& nNumber, const int& nTimeOutMilli);
+    virtual int     readFile(void* lpBuffer, const unsigned long dwTotalToRead, unsigned long& dwBytesRead, const unsigned long& dwTimeOut = 1000);
+    virtual int     writeFile(void* lpBuffer, const unsigned long& dwBytesToWrite, unsigned long& dwBytesWritten);
+    virtual int     bytesWaitingRx(int &nBytesWaiting);
+
+private:
+    std::vector<iOptronCaptureRecord>   m_Records;
+    size_t      m_nNextRecord;
+    double      m_dTimeScale;
+    bool        m_bConnected;
+    int         m_nWriteMismatches;
+    uint64_t    m_nReplayStartNs;
+
+    const iOptronCaptureRecord *nextRecord(int nType);
+    void        waitUntil(uint64_t nCaptureNs);
+};
@@ -0,0 +1,592 @@
+#include "SimulatedMount.h"
+#include "iOptronV3.h"     // status, GPS, pier enums
+
+#if !defined(SB_WIN_BUILD)
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+#endif
+
+CSimulatedMount::CSimulatedMount(int nModelCode)
+{
+    m_nModelCode = nModelCode;
+    m_Ra = CCentiArcsec(64800000);          // 12h
+    m_Dec = CCentiArcsec(16200000);         // +45°
+    m_TargetRa = m_Ra;
+    m_TargetDec = m_Dec;
+    m_Lat = CCentiArcsec::fromDegrees(45.5);
+    m_Long = CCentiArcsec::fromDegrees(-73.5);
+    m_ParkAz = CCentiArcsec(0);
+    m_ParkAlt = CCentiArcsec(16200000);
+    m_nStatus = STOPPED;
+    m_nStatusAfterSlew = STOPPED;
+    m_nSlewPolls = SIM_DEFAULT_SLEW_POLLS;
+    m_nSlewPollsLeft = 0;
+    m_nTrackingRate = TRACKING_SIDEREAL;
+    m_nMoveRate = 1;
+    m_nUtcOffset = -300;
+    m_bDaylight = true;
+    m_nUtcMs = 845000000000LL;
+    m_nMeridianBehavior = 1;
+    m_nDegreesPastMeridian = 10;
+    m_nAltitudeLimit = 5;
+    m_nCustomRate = -1;
+    memset(m_nReceived, 0, sizeof(m_nReceived));
+    m_nUnknown = 0;
+    m_nBadFrameCmd = -1;
+}
+
+void CSimulatedMount::setModel(int nCode)
+{
+    std::lock_guard<std::mutex> locker(m_Lock);
+    m_nModelCode = nCode;
+}
+
+unsigned long CSimulatedMount::baudRate() const
+{
+    std::lock_guard<std::mutex> locker(m_Lock);
+    return mountModel(m_nModelCode).nDefaultBaud;
+}
+
+void CSimulatedMount::setPosition(const CCentiArcsec &Ra, const CCentiArcsec &Dec)
+{
+    std::lock_guard<std::mutex> locker(m_Lock);
+    m_Ra = Ra;
+    m_Dec = Dec;
+}
+
+void CSimulatedMount::setLocation(const CCentiArcsec &Lat, const CCentiArcsec &Long)
+{
+    std::lock_guard<std::mutex> locker(m_Lock);
+    m_Lat = Lat;
+    m_Long = Long;
+}
+
+void CSimulatedMount::setStatus(int nStatus)
+{
+    std::lock_guard<std::mutex> locker(m_Lock);
+    m_nStatus = nStatus;
+    m_nSlewPollsLeft = 0;
+}
+
+void CSimulatedMount::breakNextReply(int nCmdId)
+{
+    std::lock_guard<std::mutex> locker(m_Lock);
+    m_nBadFrameCmd = nCmdId;
+}
+
+int CSimulatedMount::status() const
+{
+    std::lock_guard<std::mutex> locker(m_Lock);
+    return m_nStatus;
+}
+
+unsigned long CSimulatedMount::received(int nCmdId) const
+{
+    std::lock_guard<std::mutex> locker(m_Lock);
+    return m_nReceived[nCmdId];
+}
+
+unsigned long CSimulatedMount::receivedTotal() const
+{
+    int i;
+    unsigned long nTotal = 0;
+    std::lock_guard<std::mutex> locker(m_Lock);
+
+    for(i = 0; i < IOPTRON_NB_COMMANDS; i++)
+        nTotal += m_nReceived[i];
+    return nTotal;
+}
+
+unsigned long CSimulatedMount::unknownCommands() const
+{
+    std::lock_guard<std::mutex> locker(m_Lock);
+    return m_nUnknown;
+}
+
+int64_t CSimulatedMount::customRateValue() const
+{
+    std::lock_guard<std::mutex> locker(m_Lock);
+    return m_nCustomRate;
+}
+
+void CSimulatedMount::resetCounts()
+{
+    std::lock_guard<std::mutex> locker(m_Lock);
+    memset(m_nReceived, 0, sizeof(m_nReceived));
+    m_nUnknown = 0;
+}
+
+// catalog id of a complete command, the longest matching prefix for the formatted ones
+int CSimulatedMount::commandFromText(const char *pszCmd, int nCmdLen)
+{
+    int i;
+    int nPrefixLen;
+    int nBest = -1;
+    int nBestLen = 0;
+
+    for(i = 0; i < IOPTRON_NB_COMMANDS; i++) {
+        const iOptronCommand &command = commandInfo(i);
+        if(!command.bFormatted) {
+            if(command.nCmdLen == nCmdLen && !memcmp(command.pszCmd, pszCmd, nCmdLen))
+                return i;
+            continue;
+        }
+        nPrefixLen = commandLength(command.pszCmd);
+        if(command.nCmdLen && command.nCmdLen != nCmdLen)
+            continue;
+        if(nPrefixLen < nCmdLen && nPrefixLen > nBestLen && !memcmp(command.pszCmd, pszCmd, nPrefixLen)) {
+            nBest = i;
+            nBestLen = nPrefixLen;
+        }
+    }
+    return nBest;
+}
+
+// signed or unsigned integer between the catalog prefix and the '#'
+bool CSimulatedMount::readArgument(const char *pszCmd, int nCmdLen, int nCmdId, int64_t &nValue)
+{
+    char szArg[IOPTRON_CMD_BUFFER_SIZE];
+    char *pszEnd;
+    int nPrefixLen = commandLength(commandInfo(nCmdId).pszCmd);
+    int nArgLen = nCmdLen - nPrefixLen - 1;
+
+    if(nArgLen < 1 || nArgLen >= IOPTRON_CMD_BUFFER_SIZE)
+        return false;
+    memcpy(szArg, pszCmd + nPrefixLen, nArgLen);
+    szArg[nArgLen] = 0;
+    nValue = strtoll(szArg, &pszEnd, 10);
+    return pszEnd != szArg;
+}
+
+void CSimulatedMount::startSlew(int nStatusAfter)
+{
+    m_nStatusAfterSlew = nStatusAfter;
+    m_nSlewPollsLeft = m_nSlewPolls;
+    m_nStatus = m_nSlewPolls ? SLEWING : nStatusAfter;
+    if(!m_nSlewPolls && nStatusAfter == TRACKING) {
+        m_Ra = m_TargetRa;
+        m_Dec = m_TargetDec;
+    }
+}
+
+// :GLS#, moves the slew in progress along
+int CSimulatedMount::statusReply(char *pszReply, int nMaxLen)
+{
+    if(m_nStatus == SLEWING && m_nSlewPollsLeft > 0 && --m_nSlewPollsLeft == 0) {
+        m_nStatus = m_nStatusAfterSlew;
+        if(m_nStatus == TRACKING) {     // a goto, it ends on the target
+            m_Ra = m_TargetRa;
+            m_Dec = m_TargetDec;
+        }
+    }
+    return snprintf(pszReply, nMaxLen, "%+09lld%08lld%d%d%d%d%d%d#",
+                    (long long)m_Long.raw(), (long long)(m_Lat.raw() + 32400000), GPS_RECEIVING_VALID_DATA, m_nStatus,
+                    m_nTrackingRate, m_nMoveRate, GPS_CONTROLLER, m_Lat.raw() >= 0 ? 1 : 0);
+}
+
+int CSimulatedMount::reply(const char *pszCmd, int nCmdLen, char *pszReply, int nMaxLen)
+{
+    int nCmdId;
+    int nLen;
+    int64_t nValue = 0;
+    std::lock_guard<std::mutex> locker(m_Lock);
+
+    nCmdId = commandFromText(pszCmd, nCmdLen);
+    if(nCmdId < 0) {
+        m_nUnknown++;
+        return -1;
+    }
+    m_nReceived[nCmdId]++;
+    if(commandInfo(nCmdId).bFormatted && nCmdId != CMD_SG && !readArgument(pszCmd, nCmdLen, nCmdId, nValue)) {
+        m_nUnknown++;
+        return -1;
+    }
+
+    nLen = answer(nCmdId, nValue, pszCmd, pszReply, nMaxLen);
+    if(nCmdId == m_nBadFrameCmd && nLen > 0 && nLen < nMaxLen && pszReply[nLen - 1] == '#') {
+        pszReply[nLen - 1] = '0';
+        m_nBadFrameCmd = -1;
+    }
+    return nLen;
+}
+
+int CSimulatedMount::answer(int nCmdId, int64_t nValue, const char *pszCmd, char *pszReply, int nMaxLen)
+{
+    switch(nCmdId) {
+        case CMD_GEP:
+            return snprintf(pszReply, nMaxLen, "%+09lld%09lld%d%d#", (long long)m_Dec.raw(), (long long)m_Ra.raw(), PIER_WEST, COUNTER_WEIGHT_NORMAL);
+        case CMD_GLS:
+            return statusReply(pszReply, nMaxLen);
+        case CMD_GPC:
+            return snprintf(pszReply, nMaxLen, "%08lld%09lld#", (long long)m_ParkAlt.raw(), (long long)m_ParkAz.raw());
+        case CMD_GUT:
+            return snprintf(pszReply, nMaxLen, "%+04d%d%013lld#", m_nUtcOffset, m_bDaylight ? 1 : 0, (long long)m_nUtcMs);
+        case CMD_GMT:
+            return snprintf(pszReply, nMaxLen, "%d%02d#", m_nMeridianBehavior, m_nDegreesPastMeridian);
+        case CMD_GAL:
+            return snprintf(pszReply, nMaxLen, "%+03d#", m_nAltitudeLimit);
+        case CMD_MOUNT_INFO:
+            return snprintf(pszReply, nMaxLen, "%04d", m_nModelCode);
+        case CMD_FW1:
+        case CMD_FW2:
+            return snprintf(pszReply, nMaxLen, "210105210105#");
+
+        case CMD_RT0: case CMD_RT1: case CMD_RT2: case CMD_RT3: case CMD_RT4:
+            m_nTrackingRate = nCmdId - CMD_RT0;
+            break;
+        case CMD_RR:
+            m_nCustomRate = nValue;
+            break;
+        case CMD_ST0:
+            if(m_nStatus == TRACKING || m_nStatus == PEC_TRACKING)
+                m_nStatus = STOPPED;
+            break;
+        case CMD_ST1:
+            if(m_nStatus != PARKED)
+                m_nStatus = TRACKING;
+            break;
+        case CMD_SRA:
+            m_TargetRa = CCentiArcsec(nValue);
+            break;
+        case CMD_SD:
+            m_TargetDec = CCentiArcsec(nValue);
+            break;
+        case CMD_MS1:
+        case CMD_MS2:
+            startSlew(TRACKING);
+            break;
+        case CMD_CM:
+            m_Ra = m_TargetRa;
+            m_Dec = m_TargetDec;
+            break;
+        case CMD_Q:
+            if(m_nStatus == SLEWING) {
+                m_nStatus = STOPPED;
+                m_nSlewPollsLeft = 0;
+            }
+            break;
+        case CMD_SR:
+            m_nMoveRate = (int)nValue;
+            break;
+        case CMD_MH:
+        case CMD_MSH:
+            startSlew(HOMED);
+            break;
+        case CMD_MSS:
+            startSlew(STOPPED);
+            break;
+        case CMD_MP1:
+            startSlew(PARKED);
+            break;
+        case CMD_MP0:
+            if(m_nStatus == PARKED)
+                m_nStatus = STOPPED;
+            break;
+        case CMD_SPA:
+            m_ParkAz = CCentiArcsec(nValue);
+            break;
+        case CMD_SPH:
+            m_ParkAlt = CCentiArcsec(nValue);
+            break;
+        case CMD_SG:
+            m_nUtcOffset = atoi(pszCmd + 3);
+            break;
+        case CMD_SDS:
+            m_bDaylight = nValue != 0;
+            break;
+        case CMD_SLA:
+            m_Lat = CCentiArcsec(nValue);
+            break;
+        case CMD_SLO:
+            m_Long = CCentiArcsec(nValue);
+            break;
+        case CMD_SUT:
+            m_nUtcMs = nValue;
+            break;
+        case CMD_SMT:
+            m_nMeridianBehavior = (int)(nValue / 100);
+            m_nDegreesPastMeridian = (int)(nValue % 100);
+            break;
+        case CMD_SAL:
+            m_nAltitudeLimit = (int)nValue;
+            break;
+        default:
+            // open loop moves, guide pulses, zenith / north targets : nothing to keep
+            break;
+    }
+
+    if(commandInfo(nCmdId).nReplyFormat == REPLY_NONE)
+        return 0;
+    return snprintf(pszReply, nMaxLen, "1");
+}
+
+#pragma mark - in-process serial port
+CSimulatedSerial::CSimulatedSerial(CSimulatedMount &mount, CVirtualClock *pClock)
+    : m_Mount(mount), m_pClock(pClock)
+{
+    m_bConnected = false;
+    m_bSilent = false;
+    m_nBaud = 0;
+    m_nThinkNs = (int64_t)SIM_DEFAULT_THINK_US * 1000;
+    m_nWrites = 0;
+}
+
+int CSimulatedSerial::open(const char* /* pszPort */, const unsigned long& dwBaudRate, const Parity& /* parity */, const char* /* pszSession */)
+{
+    std::lock_guard<std::mutex> locker(m_Lock);
+    m_bConnected = true;
+    m_nBaud = dwBaudRate;
+    m_sCommand.clear();
+    m_sRx.clear();
+    return SB_OK;
+}
+
+int CSimulatedSerial::close()
+{
+    std::lock_guard<std::mutex> locker(m_Lock);
+    m_bConnected = false;
+    return SB_OK;
+}
+
+int CSimulatedSerial::flushTx(void)
+{
+    return m_bConnected ? SB_OK : ERR_NOLINK;
+}
+
+int CSimulatedSerial::purgeTxRx(void)
+{
+    std::lock_guard<std::mutex> locker(m_Lock);
+    m_sRx.clear();
+    return m_bConnected ? SB_OK : ERR_NOLINK;
+}
+
+int CSimulatedSerial::waitForBytesRx(const int& nNumber, const int& nTimeOutMilli)
+{
+    std::lock_guard<std::mutex> locker(m_Lock);
+    if((int)m_sRx.size() >= nNumber)
+        return SB_OK;
+    elapse((int64_t)nTimeOutMilli * NS_PER_MS);
+    return ERR_NORESPONSE;
+}
+
+int CSimulatedSerial::readFile(void* lpBuffer, const unsigned long dwTotalToRead, unsigned long& dwBytesRead, const unsigned long& dwTimeOut)
+{
+    std::lock_guard<std::mutex> locker(m_Lock);
+
+    dwBytesRead = 0;
+    if(!m_bConnected)
+        return ERR_NOLINK;
+
+    dwBytesRead = dwTotalToRead < m_sRx.size() ? dwTotalToRead : (unsigned long)m_sRx.size();
+    memcpy(lpBuffer, m_sRx.data(), dwBytesRead);
+    m_sRx.erase(0, dwBytesRead);
+    // like the host serial port : a short read is not an error, the caller checks the count
+    if(dwBytesRead < dwTotalToRead)
+        elapse((int64_t)dwTimeOut * NS_PER_MS);
+    else
+        elapse(m_nThinkNs + wireNs(dwBytesRead));
+    return SB_OK;
+}
+
+int CSimulatedSerial::writeFile(void* lpBuffer, const unsigned long& dwBytesToWrite, unsigned long& dwBytesWritten)
+{
+    const char *pBytes = (const char *)lpBuffer;
+    char szReply[SIM_BUFFER_SIZE];
+    unsigned long i;
+    size_t nStart;
+    int nReplyLen;
+    std::lock_guard<std::mutex> locker(m_Lock);
+
+    dwBytesWritten = 0;
+    if(!m_bConnected)
+        return ERR_NOLINK;
+
+    m_nWrites++;
+    for(i = 0; i < dwBytesToWrite; i++) {
+        m_sCommand += pBytes[i];
+        if(pBytes[i] != '#')
+            continue;
+        nStart = m_sCommand.find(':');
+        // at the wrong speed the mount can't make sense of anything
+        if(nStart != std::string::npos && !m_bSilent && m_nBaud == m_Mount.baudRate()) {
+            nReplyLen = m_Mount.reply(m_sCommand.data() + nStart, (int)(m_sCommand.size() - nStart), szReply, sizeof(szReply));
+            if(nReplyLen > 0)
+                m_sRx.append(szReply, nReplyLen);
+        }
+        m_sCommand.clear();
+    }
+    dwBytesWritten = dwBytesToWrite;
+    elapse(wireNs(dwBytesToWrite));
+    return SB_OK;
+}
+
+int CSimulatedSerial::bytesWaitingRx(int &nBytesWaiting)
+{
+    std::lock_guard<std::mutex> locker(m_Lock);
+    nBytesWaiting = (int)m_sRx.size();
+    return m_bConnected ? SB_OK : ERR_NOLINK;
+}
+
+#pragma mark - virtual time
+CVirtualTimeSerial::CVirtualTimeSerial(SerXInterface *pSerX, CVirtualClock *pClock)
+    : m_pSerX(pSerX), m_pClock(pClock)
+{
+    m_nBaud = 0;
+}
+
+int CVirtualTimeSerial::open(const char* pszPort, const unsigned long& dwBaudRate, const Parity& parity, const char* pszSession)
+{
+    m_nBaud = dwBaudRate;
+    return m_pSerX->open(pszPort, dwBaudRate, parity, pszSession);
+}
+
+int CVirtualTimeSerial::waitForBytesRx(const int& nNumber, const int& nTimeOutMilli)
+{
+    int nErr = m_pSerX->waitForBytesRx(nNumber, nTimeOutMilli);
+
+    if(nErr)
+        m_pClock->advance((int64_t)nTimeOutMilli * NS_PER_MS);
+    return nErr;
+}
+
+// same accounting as CSimulatedSerial::readFile()
+int CVirtualTimeSerial::readFile(void* lpBuffer, const unsigned long dwTotalToRead, unsigned long& dwBytesRead, const unsigned long& dwTimeOut)
+{
+    int nErr = m_pSerX->readFile(lpBuffer, dwTotalToRead, dwBytesRead, dwTimeOut);
+
+    if(dwBytesRead < dwTotalToRead)
+        m_pClock->advance((int64_t)dwTimeOut * NS_PER_MS);
+    else
+        m_pClock->advance((int64_t)SIM_DEFAULT_THINK_US * 1000 + serialWireNs(dwBytesRead, m_nBaud));
+    return nErr;
+}
+
+int CVirtualTimeSerial::writeFile(void* lpBuffer, const unsigned long& dwBytesToWrite, unsigned long& dwBytesWritten)
+{
+    int nErr = m_pSerX->writeFile(lpBuffer, dwBytesToWrite, dwBytesWritten);
+
+    m_pClock->advance(serialWireNs(dwBytesToWrite, m_nBaud));
+    return nErr;
+}
+
+#if !defined(SB_WIN_BUILD)
+#pragma mark - pseudo terminal
+static speed_t simulatedSpeed(unsigned long nBaudRate)
+{
+    return nBaudRate == 9600 ? B9600 : B115200;
+}
+
+CPtyMount::CPtyMount(CSimulatedMount &mount)
+    : m_Mount(mount)
+{
+    m_nMaster = -1;
+    m_nSlave = -1;
+    m_szSlaveName[0] = 0;
+    m_bStop = false;
+    m_bSilent = false;
+}
+
+CPtyMount::~CPtyMount()
+{
+    stop();
+    if(m_nMaster >= 0)
+        ::close(m_nMaster);
+    if(m_nSlave >= 0)
+        ::close(m_nSlave);
+}
+
+int CPtyMount::start()
+{
+    struct termios tty;
+    const char *pszName;
+
+    m_nMaster = posix_openpt(O_RDWR | O_NOCTTY);
+    if(m_nMaster < 0)
+        return ERR_NOLINK;
+    if(grantpt(m_nMaster) || unlockpt(m_nMaster) || !(pszName = ptsname(m_nMaster)))
+        return ERR_NOLINK;
+    snprintf(m_szSlaveName, sizeof(m_szSlaveName), "%s", pszName);
+
+    // raw right away, a canonical slave would echo the replies back to us
+    m_nSlave = ::open(m_szSlaveName, O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if(m_nSlave < 0 || tcgetattr(m_nSlave, &tty))
+        return ERR_NOLINK;
+    cfmakeraw(&tty);
+    tcsetattr(m_nSlave, TCSANOW, &tty);
+    fcntl(m_nMaster, F_SETFL, fcntl(m_nMaster, F_GETFL) | O_NONBLOCK);
+
+    m_bStop = false;
+    m_Runner = std::thread(&CPtyMount::run, this);
+    return SB_OK;
+}
+
+void CPtyMount::stop()
+{
+    m_bStop = true;
+    if(m_Runner.joinable())
+        m_Runner.join();
+}
+
+int CPtyMount::writeRaw(const char *pBytes, int nLen)
+{
+    return (int)::write(m_nMaster, pBytes, nLen);
+}
+
+void CPtyMount::hangUp()
+{
+    stop();
+    if(m_nMaster >= 0) {
+        ::close(m_nMaster);
+        m_nMaster = -1;
+    }
+}
+
+// the driver sets the speed on its own fd, it's the same tty
+bool CPtyMount::atMountSpeed() const
+{
+    struct termios tty;
+
+    if(tcgetattr(m_nSlave, &tty))
+        return false;
+    return cfgetospeed(&tty) == simulatedSpeed(m_Mount.baudRate());
+}
+
+void CPtyMount::run()
+{
+    std::string sCommand;
+    char szBuffer[SIM_BUFFER_SIZE];
+    char szReply[SIM_BUFFER_SIZE];
+    struct pollfd pfd;
+    ssize_t nRead;
+    ssize_t i;
+    size_t nStart;
+    int nReplyLen;
+
+    pfd.fd = m_nMaster;
+    pfd.events = POLLIN;
+    while(!m_bStop) {
+        if(poll(&pfd, 1, 20) <= 0)
+            continue;
+        nRead = ::read(m_nMaster, szBuffer, sizeof(szBuffer));
+        if(nRead <= 0) {
+            usleep(1000);
+            continue;
+        }
+        for(i = 0; i < nRead; i++) {
+            sCommand += szBuffer[i];
+            if(szBuffer[i] != '#')
+                continue;
+            nStart = sCommand.find(':');
+            if(nStart != std::string::npos && !m_bSilent && atMountSpeed()) {
+                nReplyLen = m_Mount.reply(sCommand.data() + nStart, (int)(sCommand.size() - nStart), szReply, sizeof(szReply));
+                if(nReplyLen > 0 && ::write(m_nMaster, szReply, nReplyLen) != nReplyLen)
+                    break;
+            }
+            sCommand.clear();
+        }
+    }
+}
+#endif
@@ -0,0 +1,190 @@
+#pragma once
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+// C++ includes
+#include <string>
+#include <mutex>
+#include <thread>
+#include <atomic>
+
+#include "../../licensedinterfaces/sberrorx.h"
+#include "../../licensedinterfaces/serxinterface.h"
+
+#include "MonotonicClock.h"
+#include "iOptronProtocol.h"
+#include "iOptronCommands.h"
+#include "iOptronModels.h"
+
+// Simulated iOptron mount for the tests, the benchmarks and the replay harness. Not part of the plugin.
+// Answers every command of the catalog (iOptronCommands.h) with a well formed reply and keeps just enough
+// state (position, status, park, tracking, settings) for the driver to go through its normal paths.
+
+#define SIM_DEFAULT_MODEL       120     // CEM120, 115200 bauds
+#define SIM_DEFAULT_SLEW_POLLS  3       // :GLS# reads a goto, park or home keeps reporting slewing
+#define SIM_DEFAULT_THINK_US    2000    // mount time between the end of a command and its reply
+#define SIM_BUFFER_SIZE         256
+
+class CSimulatedMount
+{
+public:
+    explicit CSimulatedMount(int nModelCode = SIM_DEFAULT_MODEL);
+
+    // one complete command, ':' to '#', in. Returns the number of reply bytes written to pszReply,
+    // -1 for a command that isn't in the catalog (the mount doesn't answer those).
+    int     reply(const char *pszCmd, int nCmdLen, char *pszReply, int nMaxLen);
+
+    void    setModel(int nCode);
+    int     modelCode() const { return m_nModelCode; }
+    unsigned long baudRate() const;     // the only speed the mount answers at
+
+    void    setPosition(const CCentiArcsec &Ra, const CCentiArcsec &Dec);
+    void    setLocation(const CCentiArcsec &Lat, const CCentiArcsec &Long);
+    void    setStatus(int nStatus);     // iOptronStatus
+    int     status() const;
+    void    setSlewPolls(int nPolls) { m_nSlewPolls = nPolls; }
+    void    breakNextReply(int nCmdId);     // the next reply to nCmdId comes back full length with a '0' for its '#'
+
+    // what the driver sent since the last resetCounts()
+    unsigned long received(int nCmdId) const;
+    unsigned long receivedTotal() const;
+    unsigned long unknownCommands() const;
+    int64_t customRateValue() const;    // last :RR value, -1 if none
+    void    resetCounts();
+
+private:
+    mutable std::mutex  m_Lock;         // the PTY runner answers from its own thread
+    int             m_nModelCode;
+    CCentiArcsec    m_Ra;
+    CCentiArcsec    m_Dec;
+    CCentiArcsec    m_TargetRa;         // last :SRA / :Sd
+    CCentiArcsec    m_TargetDec;
+    CCentiArcsec    m_Lat;
+    CCentiArcsec    m_Long;
+    CCentiArcsec    m_ParkAz;
+    CCentiArcsec    m_ParkAlt;
+    int     m_nStatus;
+    int     m_nStatusAfterSlew;         // what the status becomes once the slew polls are over
+    int     m_nSlewPolls;
+    int     m_nSlewPollsLeft;
+    int     m_nTrackingRate;
+    int     m_nMoveRate;
+    int     m_nUtcOffset;
+    bool    m_bDaylight;
+    int64_t m_nUtcMs;
+    int     m_nMeridianBehavior;
+    int     m_nDegreesPastMeridian;
+    int     m_nAltitudeLimit;
+    int64_t m_nCustomRate;
+    unsigned long   m_nReceived[IOPTRON_NB_COMMANDS];
+    unsigned long   m_nUnknown;
+    int             m_nBadFrameCmd;     // breakNextReply(), -1 if none
+
+    static int  commandFromText(const char *pszCmd, int nCmdLen);
+    static bool readArgument(const char *pszCmd, int nCmdLen, int nCmdId, int64_t &nValue);
+    int     answer(int nCmdId, int64_t nValue, const char *pszCmd, char *pszReply, int nMaxLen);
+    void    startSlew(int nStatusAfter);
+    int     statusReply(char *pszReply, int nMaxLen);
+};
+
+// time a byte count takes on the wire at nBaudRate, 8N1
+inline int64_t serialWireNs(unsigned long nBytes, unsigned long nBaudRate)
+{
+    return nBaudRate ? (int64_t)nBytes * 10 * NS_PER_SECOND / (int64_t)nBaudRate : 0;
+}
+
+// In-process SerXInterface wired to a CSimulatedMount. No real waiting : with a virtual clock the
+// wire time at the opened speed, the mount think time and the read timeouts advance it instead,
+// so host call timings come out the same on every run.
+class CSimulatedSerial : public SerXInterface
+{
+public:
+    CSimulatedSerial(CSimulatedMount &mount, CVirtualClock *pClock = NULL);
+    virtual ~CSimulatedSerial() {}
+
+    void    setThinkTimeUs(int nThinkUs) { m_nThinkNs = (int64_t)nThinkUs * 1000; }
+    void    setSilent(bool bSilent) { m_bSilent = bSilent; }    // the mount stops answering, like a pulled cable
+    unsigned long writes() const { return m_nWrites; }
+
+    virtual int     open(const char* pszPort, const unsigned long& dwBaudRate = 9600, const Parity& parity = B_NOPARITY, const char* pszSession = 0);
+    virtual int     close();
+    virtual bool    isConnected(void) const { return m_bConnected; }
+    virtual int     flushTx(void);
+    virtual int     purgeTxRx(void);
+    virtual int     waitForBytesRx(const int& nNumber, const int& nTimeOutMilli);
+    virtual int     readFile(void* lpBuffer, const unsigned long dwTotalToRead, unsigned long& dwBytesRead, const unsigned long& dwTimeOut = 1000);
+    virtual int     writeFile(void* lpBuffer, const unsigned long& dwBytesToWrite, unsigned long& dwBytesWritten);
+    virtual int     bytesWaitingRx(int &nBytesWaiting);
+
+private:
+    CSimulatedMount &m_Mount;
+    CVirtualClock   *m_pClock;
+    std::mutex      m_Lock;         // guide pulses and the rate stream write from their own threads
+    bool            m_bConnected;
+    bool            m_bSilent;
+    unsigned long   m_nBaud;
+    int64_t         m_nThinkNs;
+    std::string     m_sCommand;     // bytes written since the last '#'
+    std::string     m_sRx;          // reply bytes not read yet
+    unsigned long   m_nWrites;
+
+    void    elapse(int64_t nNs) { if(m_pClock) m_pClock->advance(nNs); }
+    int64_t wireNs(unsigned long nBytes) const { return serialWireNs(nBytes, m_nBaud); }
+};
+
+// Moves a virtual clock the way CSimulatedSerial does around another SerXInterface, a CSerialReplay
+// for instance. A capture recorded on the simulated mount then replays with the same cache decisions.
+class CVirtualTimeSerial : public SerXInterface
+{
+public:
+    CVirtualTimeSerial(SerXInterface *pSerX, CVirtualClock *pClock);
+    virtual ~CVirtualTimeSerial() {}
+
+    virtual int     open(const char* pszPort, const unsigned long& dwBaudRate = 9600, const Parity& parity = B_NOPARITY, const char* pszSession = 0);
+    virtual int     close() { return m_pSerX->close(); }
+    virtual bool    isConnected(void) const { return m_pSerX->isConnected(); }
+    virtual int     flushTx(void) { return m_pSerX->flushTx(); }
+    virtual int     purgeTxRx(void) { return m_pSerX->purgeTxRx(); }
+    virtual int     waitForBytesRx(const int& nNumber, const int& nTimeOutMilli);
+    virtual int     readFile(void* lpBuffer, const unsigned long dwTotalToRead, unsigned long& dwBytesRead, const unsigned long& dwTimeOut = 1000);
+    virtual int     writeFile(void* lpBuffer, const unsigned long& dwBytesToWrite, unsigned long& dwBytesWritten);
+    virtual int     bytesWaitingRx(int &nBytesWaiting) { return m_pSerX->bytesWaitingRx(nBytesWaiting); }
+
+private:
+    SerXInterface   *m_pSerX;
+    CVirtualClock   *m_pClock;
+    unsigned long   m_nBaud;
+};
+
+#if !defined(SB_WIN_BUILD)
+// The mount behind a pseudo terminal, so CTermiosSerial is exercised on a real tty.
+// A thread reads the commands on the master side and writes the replies back, it only answers
+// when the slave side is set to the mount speed.
+class CPtyMount
+{
+public:
+    explicit CPtyMount(CSimulatedMount &mount);
+    ~CPtyMount();
+
+    int     start();                // SB_OK, ERR_NOLINK if no pseudo terminal can be had
+    void    stop();
+    const char *portName() const { return m_szSlaveName; }
+
+    void    setSilent(bool bSilent) { m_bSilent = bSilent; }
+    int     writeRaw(const char *pBytes, int nLen);     // bytes out of the blue, as if the mount sent them
+    void    hangUp();               // closes the master side, the tty is gone for the driver
+
+private:
+    CSimulatedMount     &m_Mount;
+    int                 m_nMaster;
+    int                 m_nSlave;   // kept open so the master doesn't read EIO between the driver's opens
+    char                m_szSlaveName[128];
+    std::atomic<bool>   m_bStop;
+    std::atomic<bool>   m_bSilent;
+    std::thread         m_Runner;
+
+    void    run();
+    bool    atMountSpeed() const;
+};
+#endif
@@ -0,0 +1,85 @@
+#include <errno.h>
+
+#include "TelemetryPublisher.h"
+
+#if !defined(SB_WIN_BUILD)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+CTelemetryPublisher::CTelemetryPublisher()
+{
+    m_pSegment = NULL;
+    m_szName[0] = 0;
+}
+
+CTelemetryPublisher::~CTelemetryPublisher()
+{
+    close();
+}
+
+int CTelemetryPublisher::open(int nInstance)
+{
+#if defined(SB_WIN_BUILD)
+    return ENOSYS;
+#else
+    int nFd;
+    void *pMap;
+
+    close();
+    snprintf(m_szName, IOPTRON_TELEMETRY_NAME_SIZE, IOPTRON_TELEMETRY_NAME_FORMAT, nInstance);
+    // a segment left by a crashed TheSkyX can't always be resized (macOS), start from a new one
+    shm_unlink(m_szName);
+    nFd = shm_open(m_szName, O_CREAT | O_EXCL | O_RDWR, 0644);
+    if(nFd < 0)
+        return errno;
+    if(ftruncate(nFd, sizeof(iOptronTelemetrySegment)) < 0) {
+        ::close(nFd);
+        shm_unlink(m_szName);
+        return errno;
+    }
+    pMap = mmap(NULL, sizeof(iOptronTelemetrySegment), PROT_READ | PROT_WRITE, MAP_SHARED, nFd, 0);
+    ::close(nFd);
+    if(pMap == MAP_FAILED) {
+        shm_unlink(m_szName);
+        return errno;
+    }
+
+    m_pSegment = (iOptronTelemetrySegment *)pMap;
+    memset(m_pSegment, 0, sizeof(iOptronTelemetrySegment));
+    m_pSegment->nVersion = IOPTRON_TELEMETRY_VERSION;
+    m_pSegment->nSize = sizeof(iOptronTelemetrySegment);
+    // readers check the magic last
+    __atomic_store_n(&m_pSegment->nMagic, IOPTRON_TELEMETRY_MAGIC, __ATOMIC_RELEASE);
+    return 0;
+#endif
+}
+
+void CTelemetryPublisher::close()
+{
+#if !defined(SB_WIN_BUILD)
+    if(!m_pSegment)
+        return;
+    munmap(m_pSegment, sizeof(iOptronTelemetrySegment));
+    shm_unlink(m_szName);
+    m_pSegment = NULL;
+#endif
+}
+
+void CTelemetryPublisher::publish(const iOptronTelemetryData &data)
+{
+#if !defined(SB_WIN_BUILD)
+    uint64_t nSequence;
+
+    if(!m_pSegment)
+        return;
+    nSequence = __atomic_load_n(&m_pSegment->nSequence, __ATOMIC_RELAXED);
+    __atomic_store_n(&m_pSegment->nSequence, nSequence + 1, __ATOMIC_RELAXED);
+    // the odd sequence is visible before any of the data changes
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memcpy(&m_pSegment->Data, &data, sizeof(iOptronTelemetryData));
+    __atomic_store_n(&m_pSegment->nSequence, nSequence + 2, __ATOMIC_RELEASE);
+#endif
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <stdio.h>
+#include <string.h>
+
+#include "iOptronTelemetry.h"
+
+// Writer side of the shared memory telemetry segment (iOptronTelemetry.h).
+// POSIX shared memory only, open() fails with ENOSYS on Windows and publish() is then a no-op.
+class CTelemetryPublisher
+{
+public:
+    CTelemetryPublisher();
+    ~CTelemetryPublisher();
+
+    // creates (or recreates) the segment of X2 instance nInstance. Returns 0 or errno
+    int     open(int nInstance);
+    void    close();
+    bool    isOpen() const { return m_pSegment != NULL; }
+
+    // seqlock write, never blocks
+    void    publish(const iOptronTelemetryData &data);
+
+private:
+    iOptronTelemetrySegment *m_pSegment;
+    char                    m_szName[IOPTRON_TELEMETRY_NAME_SIZE];
+};
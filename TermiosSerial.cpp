@@ -0,0 +1,263 @@
+#include "TermiosSerial.h"
+
+#if !defined(SB_WIN_BUILD)
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#ifdef SB_LINUX_BUILD
+#include <linux/serial.h>
+#endif
+
+#include "../../licensedinterfaces/sberrorx.h"
+#include "MonotonicClock.h"
+
+#define TERMIOS_WAIT_SLICE_US       1000    // waitForBytesRx() sleep while the reply trickles in
+#define TERMIOS_WRITE_TIMEOUT_MS    1000    // the output queue not draining for that long is a dead port
+
+static speed_t baudToSpeed(unsigned long nBaudRate)
+{
+    switch(nBaudRate) {
+        case 9600:      return B9600;
+        case 19200:     return B19200;
+        case 38400:     return B38400;
+        case 57600:     return B57600;
+        case 115200:    return B115200;
+        case 230400:    return B230400;
+        default:        return B0;
+    }
+}
+
+static long elapsedMs(int64_t nStartNs)
+{
+    return (long)((CMonotonicClock::system().nowNs() - nStartNs) / NS_PER_MS);
+}
+
+CTermiosSerial::CTermiosSerial()
+{
+    m_nFd = -1;
+    m_nVMin = 0;
+    m_nVTime = 0;
+    m_bLowLatency = true;
+}
+
+CTermiosSerial::~CTermiosSerial()
+{
+    close();
+}
+
+int CTermiosSerial::open(const char* pszPort, const unsigned long& dwBaudRate, const Parity& parity, const char* pszSession)
+{
+    struct termios tty;
+    speed_t nSpeed;
+    int nModemBits;
+
+    close();
+
+    nSpeed = baudToSpeed(dwBaudRate);
+    if(nSpeed == B0)
+        return ERR_CMDFAILED;
+
+    m_nFd = ::open(pszPort, O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if(m_nFd < 0)
+        return ERR_NOLINK;
+
+    if(tcgetattr(m_nFd, &tty) != 0) {
+        close();
+        return ERR_NOLINK;
+    }
+
+    cfmakeraw(&tty);
+    cfsetispeed(&tty, nSpeed);
+    cfsetospeed(&tty, nSpeed);
+    tty.c_cflag |= (CLOCAL | CREAD);
+    tty.c_cflag &= ~(CSTOPB | CRTSCTS | PARENB | PARODD);
+    if(parity == B_EVENPARITY)
+        tty.c_cflag |= PARENB;
+    else if(parity == B_ODDPARITY)
+        tty.c_cflag |= (PARENB | PARODD);
+    tty.c_cc[VMIN] = m_nVMin;
+    tty.c_cc[VTIME] = m_nVTime;
+
+    if(tcsetattr(m_nFd, TCSANOW, &tty) != 0) {
+        close();
+        return ERR_NOLINK;
+    }
+
+#ifdef SB_LINUX_BUILD
+    if(m_bLowLatency) {
+        struct serial_struct serial;
+        // not supported by all drivers (and not by pseudo terminals), that's fine
+        if(ioctl(m_nFd, TIOCGSERIAL, &serial) == 0) {
+            serial.flags |= ASYNC_LOW_LATENCY;
+            ioctl(m_nFd, TIOCSSERIAL, &serial);
+        }
+    }
+#endif
+
+    // same as the host serial port "-DTR_CONTROL 1" session option
+    if(pszSession && strstr(pszSession, "-DTR_CONTROL 1")) {
+        nModemBits = TIOCM_DTR;
+        ioctl(m_nFd, TIOCMBIS, &nModemBits);
+    }
+
+    // the fd stays non-blocking whatever VMIN/VTIME are, a blocking read() could wait past the readFile()
+    // deadline (forever with VMIN set and VTIME 0). poll() waits for the data and enforces the deadline.
+
+    tcflush(m_nFd, TCIOFLUSH);
+    return SB_OK;
+}
+
+int CTermiosSerial::close()
+{
+    if(m_nFd >= 0) {
+        ::close(m_nFd);
+        m_nFd = -1;
+    }
+    return SB_OK;
+}
+
+int CTermiosSerial::flushTx(void)
+{
+    if(m_nFd < 0)
+        return ERR_NOLINK;
+    return tcdrain(m_nFd) == 0 ? SB_OK : ERR_CMDFAILED;
+}
+
+int CTermiosSerial::purgeTxRx(void)
+{
+    if(m_nFd < 0)
+        return ERR_NOLINK;
+    return tcflush(m_nFd, TCIOFLUSH) == 0 ? SB_OK : ERR_CMDFAILED;
+}
+
+int CTermiosSerial::waitForBytesRx(const int& nNumber, const int& nTimeOutMilli)
+{
+    int nBytesWaiting = 0;
+    int64_t nStartNs;
+    struct pollfd pfd;
+    long nRemainingMs;
+    bool bPollWaitsForVMin = m_nVMin > 1 && !m_nVTime;
+    bool bSleep;
+
+    if(m_nFd < 0)
+        return ERR_NOLINK;
+
+    nStartNs = CMonotonicClock::system().nowNs();
+    pfd.fd = m_nFd;
+    pfd.events = POLLIN;
+    while(true) {
+        bytesWaitingRx(nBytesWaiting);
+        if(nBytesWaiting >= nNumber)
+            return SB_OK;
+        nRemainingMs = (long)nTimeOutMilli - elapsedMs(nStartNs);
+        if(nRemainingMs <= 0)
+            return ERR_NORESPONSE;
+        // poll() wakes up on the first byte (on VMIN bytes with VMIN > 1 and no VTIME) : once some are
+        // queued it would return at once every time, so look for a hang up only and sleep 1 ms
+        bSleep = nBytesWaiting > 0 || bPollWaitsForVMin;
+        if(poll(&pfd, 1, bSleep ? 0 : (int)nRemainingMs) > 0 && (pfd.revents & (POLLHUP | POLLERR | POLLNVAL))) {
+            // hung up, nothing more will come
+            bytesWaitingRx(nBytesWaiting);
+            return nBytesWaiting >= nNumber ? SB_OK : ERR_CMDFAILED;
+        }
+        if(bSleep)
+            usleep(TERMIOS_WAIT_SLICE_US);
+    }
+}
+
+int CTermiosSerial::readFile(void* lpBuffer, const unsigned long dwTotalToRead, unsigned long& dwBytesRead, const unsigned long& dwTimeOut)
+{
+    int64_t nStartNs;
+    struct pollfd pfd;
+    long nRemainingMs;
+    int nPolled;
+    ssize_t nRead;
+    char *pBuffer = (char *)lpBuffer;
+    bool bPollWaitsForVMin = m_nVMin > 1 && !m_nVTime;
+
+    dwBytesRead = 0;
+    if(m_nFd < 0)
+        return ERR_NOLINK;
+
+    nStartNs = CMonotonicClock::system().nowNs();
+    pfd.fd = m_nFd;
+    pfd.events = POLLIN;
+    while(dwBytesRead < dwTotalToRead) {
+        nRemainingMs = (long)dwTimeOut - elapsedMs(nStartNs);
+        if(nRemainingMs <= 0)
+            break;  // timeout, the caller checks the number of bytes read
+        // with VMIN > 1 and no VTIME, poll() only wakes up once VMIN bytes are there : poll 1 ms at a time
+        // and take whatever has arrived in between
+        nPolled = poll(&pfd, 1, bPollWaitsForVMin ? 1 : (int)nRemainingMs);
+        if(nPolled < 0) {
+            if(errno == EINTR)
+                continue;
+            return ERR_CMDFAILED;
+        }
+        if(nPolled == 0) {
+            if(bPollWaitsForVMin && (nRead = ::read(m_nFd, pBuffer + dwBytesRead, dwTotalToRead - dwBytesRead)) > 0)
+                dwBytesRead += nRead;
+            continue;
+        }
+        // a hang up with bytes still buffered is only reported once they have been read
+        if(!(pfd.revents & POLLIN) && (pfd.revents & (POLLHUP | POLLERR | POLLNVAL)))
+            return ERR_CMDFAILED;
+        nRead = ::read(m_nFd, pBuffer + dwBytesRead, dwTotalToRead - dwBytesRead);
+        if(nRead < 0) {
+            if(errno == EAGAIN || errno == EINTR)
+                continue;
+            return ERR_CMDFAILED;
+        }
+        if(nRead == 0)
+            return ERR_CMDFAILED;   // end of file, the device is gone
+        dwBytesRead += nRead;
+    }
+    return SB_OK;
+}
+
+int CTermiosSerial::writeFile(void* lpBuffer, const unsigned long& dwBytesToWrite, unsigned long& dwBytesWritten)
+{
+    ssize_t nWritten;
+    struct pollfd pfd;
+    int nPolled;
+    const char *pBuffer = (const char *)lpBuffer;
+
+    dwBytesWritten = 0;
+    if(m_nFd < 0)
+        return ERR_NOLINK;
+
+    pfd.fd = m_nFd;
+    pfd.events = POLLOUT;
+    while(dwBytesWritten < dwBytesToWrite) {
+        nWritten = ::write(m_nFd, pBuffer + dwBytesWritten, dwBytesToWrite - dwBytesWritten);
+        if(nWritten < 0) {
+            if(errno == EINTR)
+                continue;
+            if(errno != EAGAIN)
+                return ERR_CMDFAILED;
+            // output queue full, wait for room
+            nPolled = poll(&pfd, 1, TERMIOS_WRITE_TIMEOUT_MS);
+            if(nPolled < 0 && errno == EINTR)
+                continue;
+            if(nPolled <= 0 || (pfd.revents & (POLLHUP | POLLERR | POLLNVAL)))
+                return ERR_CMDFAILED;
+            continue;
+        }
+        dwBytesWritten += nWritten;
+    }
+    return SB_OK;
+}
+
+int CTermiosSerial::bytesWaitingRx(int &nBytesWaiting)
+{
+    nBytesWaiting = 0;
+    if(m_nFd < 0)
+        return ERR_NOLINK;
+    return ioctl(m_nFd, FIONREAD, &nBytesWaiting) == 0 ? SB_OK : ERR_CMDFAILED;
+}
+
+#endif
@@ -0,0 +1,39 @@
+#pragma once
+#include <stdio.h>
+#include <string.h>
+
+#include "../../licensedinterfaces/serxinterface.h"
+
+#if !defined(SB_WIN_BUILD)
+
+// Native POSIX tty SerXInterface, used instead of the host serial port when enabled in the settings.
+// Lets the tty read settings (VMIN / VTIME, low latency) be tuned and their effect on sendCommand measured.
+class CTermiosSerial : public SerXInterface
+{
+public:
+    CTermiosSerial();
+    virtual ~CTermiosSerial();
+
+    // nVMin / nVTime are applied as is to c_cc[VMIN] / c_cc[VTIME] (VTIME is in 1/10 s).
+    // The fd stays non-blocking, so they don't delay read() : the read timeout is always handled by poll().
+    void    setReadMode(int nVMin, int nVTime) { m_nVMin = nVMin; m_nVTime = nVTime; }
+    void    setLowLatency(bool bLowLatency) { m_bLowLatency = bLowLatency; }  // ASYNC_LOW_LATENCY on Linux, ignored elsewhere
+
+    virtual int     open(const char* pszPort, const unsigned long& dwBaudRate = 9600, const Parity& parity = B_NOPARITY, const char* pszSession = 0);
+    virtual int     close();
+    virtual bool    isConnected(void) const { return m_nFd >= 0; }
+    virtual int     flushTx(void);
+    virtual int     purgeTxRx(void);
+    virtual int     waitForBytesRx(const int& nNumber, const int& nTimeOutMilli);
+    virtual int     readFile(void* lpBuffer, const unsigned long dwTotalToRead, unsigned long& dwBytesRead, const unsigned long& dwTimeOut = 1000);
+    virtual int     writeFile(void* lpBuffer, const unsigned long& dwBytesToWrite, unsigned long& dwBytesWritten);
+    virtual int     bytesWaitingRx(int &nBytesWaiting);
+
+private:
+    int     m_nFd;
+    int     m_nVMin;
+    int     m_nVTime;
+    bool    m_bLowLatency;
+};
+
+#endif
@@ -0,0 +1,211 @@
+// CTermiosSerial and CiOptron against a simulated mount behind a pseudo terminal.
+// Built and run by make test.
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <vector>
+
+#include "TestCheck.h"
+#include "SimulatedMount.h"
+#include "TermiosSerial.h"
+#include "iOptronV3.h"
+
+static int64_t msSince(int64_t nStartNs)
+{
+    return (CMonotonicClock::system().nowNs() - nStartNs) / NS_PER_MS;
+}
+
+static int64_t threadCpuNs()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (int64_t)ts.tv_sec * NS_PER_SECOND + ts.tv_nsec;
+}
+
+// waits for the PTY runner to go through what was written
+static void settle()
+{
+    usleep(50000);
+}
+
+static void testSession()
+{
+    CSimulatedMount mount(120);
+    CPtyMount pty(mount);
+    CTermiosSerial serial;
+    CiOptron iOptron;
+    CVirtualClock clock;    // the driver timers only, the tty deadlines stay on the system clock
+    double dRa, dDec;
+    bool bComplete = false;
+    int i;
+
+    if(pty.start()) {
+        printf("SKIP testSession: no pseudo terminal\n");
+        return;
+    }
+    mount.setPosition(CCentiArcsec::fromHours(6.5), CCentiArcsec::fromDegrees(-20.25));
+    iOptron.setSerxPointer(&serial);
+    iOptron.setClock(&clock);
+
+    TEST_CHECK_EQUAL(iOptron.Connect((char *)pty.portName()), SB_OK);
+    TEST_CHECK(iOptron.isConnected());
+    TEST_CHECK_EQUAL(iOptron.getModel().nDefaultBaud, 115200);
+
+    TEST_CHECK_EQUAL(iOptron.getRaAndDec(dRa, dDec, true), SB_OK);
+    TEST_CHECK(fabs(dRa - 6.5) < 1e-6);
+    TEST_CHECK(fabs(dDec + 20.25) < 1e-6);
+
+    TEST_CHECK_EQUAL(iOptron.startSlewTo(10.0, 30.0), SB_OK);
+    for(i = 0; i < 2 * SIM_DEFAULT_SLEW_POLLS && !bComplete; i++) {
+        clock.advance(secondsToNs(iOptron.getModel().fSlewPollInterval) + NS_PER_MS);
+        TEST_CHECK_EQUAL(iOptron.isSlewToComplete(bComplete), SB_OK);
+    }
+    TEST_CHECK(bComplete);
+    TEST_CHECK_EQUAL(iOptron.getRaAndDec(dRa, dDec, true), SB_OK);
+    TEST_CHECK(fabs(dRa - 10.0) < 1e-6);
+    TEST_CHECK(fabs(dDec - 30.0) < 1e-6);
+
+    TEST_CHECK_EQUAL(iOptron.pulseGuide(MountDriverInterface::MD_NORTH, 50), SB_OK);
+    settle();
+    TEST_CHECK_EQUAL(mount.received(CMD_GUIDE_N), 1);
+
+    TEST_CHECK_EQUAL(mount.unknownCommands(), 0);
+    iOptron.Disconnect();
+}
+
+// a 9600 bauds mount, the first probe at 115200 gets nothing back
+static void testSpeedFallback()
+{
+    CSimulatedMount mount(60);
+    CPtyMount pty(mount);
+    CTermiosSerial serial;
+    CiOptron iOptron;
+
+    if(pty.start()) {
+        printf("SKIP testSpeedFallback: no pseudo terminal\n");
+        return;
+    }
+    iOptron.setSerxPointer(&serial);
+    TEST_CHECK_EQUAL(iOptron.Connect((char *)pty.portName()), SB_OK);
+    TEST_CHECK_EQUAL(iOptron.getModel().nDefaultBaud, 9600);
+    TEST_CHECK_EQUAL(mount.received(CMD_MOUNT_INFO), 1);
+    TEST_CHECK_EQUAL(mount.unknownCommands(), 0);
+    iOptron.Disconnect();
+}
+
+// VMIN / VTIME set : a short reply still comes back at the readFile() deadline, not later
+static void testReadModeKeepsDeadline()
+{
+    CSimulatedMount mount;
+    CPtyMount pty(mount);
+    CTermiosSerial serial;
+    char szBuffer[16];
+    unsigned long nRead = 0;
+    int64_t nStartNs;
+
+    if(pty.start()) {
+        printf("SKIP testReadModeKeepsDeadline: no pseudo terminal\n");
+        return;
+    }
+    serial.setReadMode(30, 0);
+    TEST_CHECK_EQUAL(serial.open(pty.portName(), 115200), SB_OK);
+    pty.writeRaw("123", 3);
+
+    nStartNs = CMonotonicClock::system().nowNs();
+    TEST_CHECK_EQUAL(serial.readFile(szBuffer, 10, nRead, 300), SB_OK);
+    TEST_CHECK_EQUAL(nRead, 3);
+    TEST_CHECK(msSince(nStartNs) >= 250 && msSince(nStartNs) < 600);
+
+    // and a blocking read doesn't wait for VMIN bytes when they are all there
+    pty.writeRaw("4567", 4);
+    settle();
+    nStartNs = CMonotonicClock::system().nowNs();
+    TEST_CHECK_EQUAL(serial.readFile(szBuffer, 4, nRead, 1000), SB_OK);
+    TEST_CHECK_EQUAL(nRead, 4);
+    TEST_CHECK(msSince(nStartNs) < 100);
+    serial.close();
+}
+
+// the tty going away fails the read right away instead of spinning until the timeout
+static void testHangUp()
+{
+    CSimulatedMount mount;
+    CPtyMount pty(mount);
+    CTermiosSerial serial;
+    char szBuffer[16];
+    unsigned long nRead = 0;
+    int64_t nStartNs;
+
+    if(pty.start()) {
+        printf("SKIP testHangUp: no pseudo terminal\n");
+        return;
+    }
+    TEST_CHECK_EQUAL(serial.open(pty.portName(), 115200), SB_OK);
+    pty.hangUp();
+
+    nStartNs = CMonotonicClock::system().nowNs();
+    TEST_CHECK_EQUAL(serial.readFile(szBuffer, 10, nRead, 2000), ERR_CMDFAILED);
+    TEST_CHECK(msSince(nStartNs) < 500);
+    TEST_CHECK_EQUAL(serial.waitForBytesRx(1, 2000), ERR_CMDFAILED);
+    TEST_CHECK(msSince(nStartNs) < 1000);
+    serial.close();
+}
+
+// waiting for the rest of a reply, or for room in a full output queue, sleeps instead of spinning
+static void testWaitsDontSpin()
+{
+    CSimulatedMount mount;
+    CPtyMount pty(mount);
+    CTermiosSerial serial;
+    std::vector<char> block(256 * 1024, 'x');
+    unsigned long nWritten = 0;
+    int64_t nStartNs;
+    int64_t nCpuNs;
+    int nMaster;
+
+    if(pty.start()) {
+        printf("SKIP testWaitsDontSpin: no pseudo terminal\n");
+        return;
+    }
+    TEST_CHECK_EQUAL(serial.open(pty.portName(), 115200), SB_OK);
+    pty.writeRaw("123", 3);
+    settle();
+    nStartNs = CMonotonicClock::system().nowNs();
+    nCpuNs = threadCpuNs();
+    TEST_CHECK_EQUAL(serial.waitForBytesRx(10, 300), ERR_NORESPONSE);
+    TEST_CHECK(msSince(nStartNs) >= 300);
+    TEST_CHECK(threadCpuNs() - nCpuNs < 100 * NS_PER_MS);
+    serial.close();
+
+    // a pseudo terminal nobody reads, its output queue fills up
+    nMaster = posix_openpt(O_RDWR | O_NOCTTY);
+    if(nMaster < 0 || grantpt(nMaster) || unlockpt(nMaster)) {
+        printf("SKIP testWaitsDontSpin: no second pseudo terminal\n");
+        if(nMaster >= 0)
+            close(nMaster);
+        return;
+    }
+    TEST_CHECK_EQUAL(serial.open(ptsname(nMaster), 115200), SB_OK);
+    nStartNs = CMonotonicClock::system().nowNs();
+    nCpuNs = threadCpuNs();
+    TEST_CHECK_EQUAL(serial.writeFile(&block[0], block.size(), nWritten), ERR_CMDFAILED);
+    TEST_CHECK(nWritten > 0 && nWritten < block.size());
+    TEST_CHECK(msSince(nStartNs) >= 900);
+    TEST_CHECK(threadCpuNs() - nCpuNs < 100 * NS_PER_MS);
+    serial.close();
+    close(nMaster);
+}
+
+int main()
+{
+    testSession();
+    testSpeedFallback();
+    testReadModeKeepsDeadline();
+    testHangUp();
+    testWaitsDontSpin();
+    return testResult("TermiosSerialTest");
+}
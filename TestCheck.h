@@ -0,0 +1,38 @@
+#pragma once
+#include <stdio.h>
+
+// Minimal checks for the test programs (make test), no test framework in the driver build.
+// Each program returns testFailures() != 0 from main().
+
+inline int &testFailures()
+{
+    static int nFailures = 0;
+    return nFailures;
+}
+
+#define TEST_CHECK(cond) \
+    do { \
+        if(!(cond)) { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            testFailures()++; \
+        } \
+    } while(0)
+
+#define TEST_CHECK_EQUAL(actual, expected) \
+    do { \
+        long long nActual_ = (long long)(actual); \
+        long long nExpected_ = (long long)(expected); \
+        if(nActual_ != nExpected_) { \
+            fprintf(stderr, "%s:%d: check failed: %s == %lld, expected %lld\n", __FILE__, __LINE__, #actual, nActual_, nExpected_); \
+            testFailures()++; \
+        } \
+    } while(0)
+
+inline int testResult(const char *pszProgram)
+{
+    if(testFailures())
+        printf("%s: %d check(s) failed\n", pszProgram, testFailures());
+    else
+        printf("%s: all checks passed\n", pszProgram);
+    return testFailures() ? 1 : 0;
+}
@@ -0,0 +1,248 @@
+#include <errno.h>
+
+#include "TraceLog.h"
+
+#if defined(SB_WIN_BUILD)
+#include <windows.h>
+#elif defined(SB_MAC_BUILD)
+#include <pthread.h>
+#else
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
+
+CTraceLog::CTraceLog()
+{
+    m_bEnabled = false;
+    m_pClock = &CMonotonicClock::system();
+    m_bRecording = false;
+    m_nFilling = 0;
+    m_nNbEvents = 0;
+    m_bPending = false;
+    m_nNbPending = 0;
+    m_bStop = false;
+    m_nDropped = 0;
+    m_pFile = NULL;
+    m_nOriginNs = 0;
+    m_bFirstEvent = true;
+}
+
+CTraceLog::~CTraceLog()
+{
+    stop();
+}
+
+CTraceLog &CTraceLog::disabled()
+{
+    static CTraceLog disabledTrace;
+    return disabledTrace;
+}
+
+uint32_t CTraceLog::currentThreadId()
+{
+    static thread_local uint32_t nThreadId = 0;
+
+    if(!nThreadId) {
+#if defined(SB_WIN_BUILD)
+        nThreadId = (uint32_t)GetCurrentThreadId();
+#elif defined(SB_MAC_BUILD)
+        uint64_t nTid = 0;
+        pthread_threadid_np(NULL, &nTid);
+        nThreadId = (uint32_t)nTid;
+#else
+        nThreadId = (uint32_t)syscall(SYS_gettid);
+#endif
+    }
+    return nThreadId;
+}
+
+int CTraceLog::start(const std::string &sPath, CMonotonicClock &clock)
+{
+    stop();
+
+    m_pFile = fopen(sPath.c_str(), "w");
+    if(!m_pFile)
+        return errno;
+    m_pClock = &clock;
+    m_nOriginNs = m_pClock->nowNs();
+    fprintf(m_pFile, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf(m_pFile, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"iOptronV3 X2\"}}");
+    m_bFirstEvent = false;
+
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+        m_nFilling = 0;
+        m_nNbEvents = 0;
+        m_bPending = false;
+        m_bStop = false;
+        m_nDropped = 0;
+        m_bRecording = true;
+    }
+    m_Writer = std::thread(&CTraceLog::writerThread, this);
+    m_bEnabled = true;
+    return 0;
+}
+
+void CTraceLog::stop()
+{
+    TraceEvent dropped;
+
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+        if(!m_bRecording)
+            return;
+        m_bEnabled = false;
+        m_bRecording = false;
+        m_bStop = true;
+    }
+    m_Wake.notify_one();
+    m_Writer.join();
+
+    // the writer is gone and record() doesn't append anymore, the rest is ours
+    writeEvents(m_Events[m_nFilling], m_nNbEvents);
+    m_nNbEvents = 0;
+    if(m_nDropped) {
+        dropped.pszName = "trace events dropped";
+        dropped.pszCategory = "trace";
+        dropped.pszDetail = "writer behind";
+        dropped.nStartNs = m_pClock->nowNs();
+        dropped.nDurationNs = -1;
+        dropped.nValue = (int64_t)m_nDropped;
+        dropped.nThreadId = currentThreadId();
+        writeEvents(&dropped, 1);
+    }
+    fprintf(m_pFile, "\n]}\n");
+    fclose(m_pFile);
+    m_pFile = NULL;
+}
+
+unsigned long CTraceLog::droppedCount()
+{
+    std::lock_guard<std::mutex> lock(m_Lock);
+    return m_nDropped;
+}
+
+void CTraceLog::span(const char *pszName, const char *pszCategory, int64_t nStartNs, int64_t nEndNs, const char *pszDetail, int64_t nValue)
+{
+    TraceEvent event;
+
+    event.pszName = pszName;
+    event.pszCategory = pszCategory;
+    event.pszDetail = pszDetail;
+    event.nStartNs = nStartNs;
+    event.nDurationNs = nEndNs > nStartNs ? nEndNs - nStartNs : 0;
+    event.nValue = nValue;
+    event.nThreadId = currentThreadId();
+    record(event);
+}
+
+void CTraceLog::instant(const char *pszName, const char *pszCategory, const char *pszDetail, int64_t nValue)
+{
+    TraceEvent event;
+
+    event.pszName = pszName;
+    event.pszCategory = pszCategory;
+    event.pszDetail = pszDetail;
+    event.nStartNs = m_pClock->nowNs();
+    event.nDurationNs = -1;
+    event.nValue = nValue;
+    event.nThreadId = currentThreadId();
+    record(event);
+}
+
+void CTraceLog::record(const TraceEvent &event)
+{
+    std::unique_lock<std::mutex> lock(m_Lock);
+    bool bWake = false;
+
+    if(!m_bRecording)
+        return;
+    // a full buffer goes to the writer on the next event, stop() writes it if there is none
+    if(m_nNbEvents == TRACE_NB_EVENTS) {
+        // the writer still has the other one
+        if(m_bPending) {
+            m_nDropped++;
+            return;
+        }
+        m_nNbPending = m_nNbEvents;
+        m_bPending = true;
+        m_nFilling ^= 1;
+        m_nNbEvents = 0;
+        bWake = true;
+    }
+    m_Events[m_nFilling][m_nNbEvents++] = event;
+    lock.unlock();
+    if(bWake)
+        m_Wake.notify_one();
+}
+
+void CTraceLog::writerThread()
+{
+    std::unique_lock<std::mutex> lock(m_Lock);
+    const TraceEvent *pEvents;
+    int nNbEvents;
+
+    while(true) {
+        m_Wake.wait(lock, [this] { return m_bPending || m_bStop; });
+        if(m_bPending) {
+            // record() doesn't touch the pending buffer until m_bPending is cleared, write it unlocked
+            pEvents = m_Events[m_nFilling ^ 1];
+            nNbEvents = m_nNbPending;
+            lock.unlock();
+            writeEvents(pEvents, nNbEvents);
+            lock.lock();
+            m_bPending = false;
+        }
+        if(m_bStop)
+            break;
+    }
+}
+
+// from the writer thread, or stop() once it's gone
+void CTraceLog::writeEvents(const TraceEvent *pEvents, int nNbEvents)
+{
+    int i;
+    const TraceEvent *pEvent;
+
+    for(i = 0; i < nNbEvents; i++) {
+        pEvent = &pEvents[i];
+        fprintf(m_pFile, "%s\n{\"name\":", m_bFirstEvent ? "" : ",");
+        m_bFirstEvent = false;
+        writeString(pEvent->pszName);
+        fprintf(m_pFile, ",\"cat\":");
+        writeString(pEvent->pszCategory);
+        // microseconds, with the nanoseconds as decimals
+        if(pEvent->nDurationNs < 0)
+            fprintf(m_pFile, ",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f", (pEvent->nStartNs - m_nOriginNs) / 1000.0);
+        else
+            fprintf(m_pFile, ",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f", (pEvent->nStartNs - m_nOriginNs) / 1000.0, pEvent->nDurationNs / 1000.0);
+        fprintf(m_pFile, ",\"pid\":1,\"tid\":%u", pEvent->nThreadId);
+        if(pEvent->pszDetail || pEvent->nValue >= 0) {
+            fprintf(m_pFile, ",\"args\":{");
+            if(pEvent->pszDetail) {
+                fprintf(m_pFile, "\"detail\":");
+                writeString(pEvent->pszDetail);
+            }
+            if(pEvent->nValue >= 0)
+                fprintf(m_pFile, "%s\"value\":%lld", pEvent->pszDetail ? "," : "", (long long)pEvent->nValue);
+            fprintf(m_pFile, "}");
+        }
+        fprintf(m_pFile, "}");
+    }
+    fflush(m_pFile);
+}
+
+// JSON string, the command strings are plain ASCII but escape what has to be anyway
+void CTraceLog::writeString(const char *pszString)
+{
+    const char *pszChar;
+
+    fputc('"', m_pFile);
+    for(pszChar = pszString ? pszString : ""; *pszChar; pszChar++) {
+        if(*pszChar == '"' || *pszChar == '\\')
+            fputc('\\', m_pFile);
+        if((unsigned char)*pszChar >= 0x20)
+            fputc(*pszChar, m_pFile);
+    }
+    fputc('"', m_pFile);
+}
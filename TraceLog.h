@@ -0,0 +1,101 @@
+#pragma once
+#include <stdio.h>
+#include <stdint.h>
+
+#include <string>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
+
+#include "MonotonicClock.h"
+
+// Chrome trace event JSON (chrome://tracing, ui.perfetto.dev) of the driver activity, for deep dives
+// into how the host calls, the mutex and the serial link line up in time.
+// Events are fixed size records kept in memory. When a buffer fills it's handed to a writer thread
+// and recording goes on in the other one, so the file I/O never happens on the traced threads
+// (some of them hold the link lock). If the writer is still busy with the previous buffer when
+// the next one fills, events are dropped and counted, the count is in the trace.
+// Names, categories and details must be string literals or other static strings, only their
+// pointers are kept.
+
+#define TRACE_NB_EVENTS     8192
+
+typedef struct {
+    const char  *pszName;
+    const char  *pszCategory;
+    const char  *pszDetail;     // "detail" argument, NULL for none
+    int64_t     nStartNs;
+    int64_t     nDurationNs;    // -1 for an instant event
+    int64_t     nValue;         // "value" argument, -1 for none. Bytes for serial I/O, data age in us for cache hits
+    uint32_t    nThreadId;
+} TraceEvent;
+
+class CTraceLog
+{
+public:
+    CTraceLog();
+    ~CTraceLog();
+
+    // shared, never started instance for code that hasn't been given a trace
+    static CTraceLog &disabled();
+
+    // starts a new trace file, timestamps from clock. Returns 0 or errno
+    int     start(const std::string &sPath, CMonotonicClock &clock);
+    void    stop();
+    bool    enabled() const { return m_bEnabled.load(std::memory_order_acquire); }
+    int64_t nowNs() const { return m_pClock->nowNs(); }
+    unsigned long   droppedCount();
+
+    // guard with enabled()
+    void    span(const char *pszName, const char *pszCategory, int64_t nStartNs, int64_t nEndNs, const char *pszDetail = NULL, int64_t nValue = -1);
+    void    instant(const char *pszName, const char *pszCategory, const char *pszDetail = NULL, int64_t nValue = -1);
+
+    static uint32_t currentThreadId();
+
+private:
+    void    record(const TraceEvent &event);
+    void    writerThread();
+    void    writeEvents(const TraceEvent *pEvents, int nNbEvents);
+    void    writeString(const char *pszString);
+
+    std::atomic<bool>   m_bEnabled;
+    CMonotonicClock     *m_pClock;
+
+    std::mutex          m_Lock;         // protects everything down to the writer
+    bool                m_bRecording;   // file open, record() appends
+    int                 m_nFilling;     // buffer record() appends to
+    int                 m_nNbEvents;
+    bool                m_bPending;     // the other buffer is being written
+    int                 m_nNbPending;
+    bool                m_bStop;
+    unsigned long       m_nDropped;
+    std::condition_variable m_Wake;
+    std::thread         m_Writer;
+
+    // the writer thread's, and start() / stop()'s while it isn't running
+    FILE                *m_pFile;
+    int64_t             m_nOriginNs;    // trace timestamps are relative to start()
+    bool                m_bFirstEvent;
+    TraceEvent          m_Events[2][TRACE_NB_EVENTS];
+};
+
+// Span covering the scope it's declared in.
+class CTraceScope
+{
+public:
+    CTraceScope(CTraceLog &trace, const char *pszName, const char *pszCategory, const char *pszDetail = NULL)
+        : m_Trace(trace), m_pszName(pszName), m_pszCategory(pszCategory), m_pszDetail(pszDetail), m_nStartNs(trace.enabled() ? trace.nowNs() : 0) {}
+    ~CTraceScope()
+    {
+        if(m_Trace.enabled())
+            m_Trace.span(m_pszName, m_pszCategory, m_nStartNs, m_Trace.nowNs(), m_pszDetail);
+    }
+
+private:
+    CTraceLog   &m_Trace;
+    const char  *m_pszName;
+    const char  *m_pszCategory;
+    const char  *m_pszDetail;
+    int64_t     m_nStartNs;
+};
@@ -0,0 +1,173 @@
+// CTraceLog buffers going to the writer thread, and the traced threads not waiting for the file
+// when the writer is stuck. Built and run by make test.
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <string>
+#include <thread>
+
+#include "TestCheck.h"
+#include "TraceLog.h"
+
+#define TRACE_TEST_EVENTS   (3 * TRACE_NB_EVENTS + 10)
+
+static std::string tempPath(const char *pszName)
+{
+    char szPath[256];
+
+    snprintf(szPath, sizeof(szPath), "/tmp/%s.%d", pszName, (int)getpid());
+    return szPath;
+}
+
+static std::string readFile(const std::string &sPath)
+{
+    std::string sText;
+    char szBuffer[4096];
+    size_t nRead;
+    FILE *pFile = fopen(sPath.c_str(), "r");
+
+    if(!pFile)
+        return sText;
+    while((nRead = fread(szBuffer, 1, sizeof(szBuffer), pFile)) > 0)
+        sText.append(szBuffer, nRead);
+    fclose(pFile);
+    return sText;
+}
+
+static unsigned long countOf(const std::string &sText, const char *pszWhat)
+{
+    unsigned long nCount = 0;
+    size_t nPos = 0;
+
+    while((nPos = sText.find(pszWhat, nPos)) != std::string::npos) {
+        nCount++;
+        nPos += strlen(pszWhat);
+    }
+    return nCount;
+}
+
+// the "value" of the dropped events marker, 0 if there is none
+static unsigned long droppedInTrace(const std::string &sText)
+{
+    size_t nPos = sText.find("\"name\":\"trace events dropped\"");
+
+    if(nPos == std::string::npos || (nPos = sText.find("\"value\":", nPos)) == std::string::npos)
+        return 0;
+    return strtoul(sText.c_str() + nPos + 8, NULL, 10);
+}
+
+static void recordSpans(CTraceLog &trace, CVirtualClock &clock, int nNbSpans)
+{
+    int i;
+
+    for(i = 0; i < nNbSpans; i++) {
+        clock.advance(1000);
+        trace.span("test span", "test", clock.nowNs() - 500, clock.nowNs(), NULL, i);
+    }
+}
+
+// more events than two buffers, all of them in a well formed file
+static void testBuffers()
+{
+    std::string sPath = tempPath("TraceLogTest.json");
+    std::string sText;
+    CVirtualClock clock(1000000);
+    unsigned long nDropped;
+
+    {
+        CTraceLog trace;
+
+        TEST_CHECK_EQUAL(trace.start(sPath, clock), 0);
+        TEST_CHECK(trace.enabled());
+        recordSpans(trace, clock, TRACE_TEST_EVENTS);
+        trace.instant("last", "test");
+        trace.stop();
+        TEST_CHECK(!trace.enabled());
+        nDropped = trace.droppedCount();
+        // after stop() nothing is recorded
+        trace.instant("after stop", "test");
+    }
+    sText = readFile(sPath);
+    unlink(sPath.c_str());
+
+    TEST_CHECK(!strncmp(sText.c_str(), "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", 40));
+    TEST_CHECK(sText.size() > 4 && sText.compare(sText.size() - 4, 4, "\n]}\n") == 0);
+    // the writer can fall behind on a regular file too, whatever is missing has to be counted
+    TEST_CHECK_EQUAL(countOf(sText, "\"name\":\"test span\"") + countOf(sText, "\"name\":\"last\"") + nDropped, (unsigned long)TRACE_TEST_EVENTS + 1);
+    TEST_CHECK_EQUAL(droppedInTrace(sText), nDropped);
+    TEST_CHECK_EQUAL(countOf(sText, "\"name\":\"after stop\""), 0UL);
+    // in order, the first span right after the process name
+    TEST_CHECK(sText.find("\"value\":0}") < sText.find("\"value\":1}"));
+    TEST_CHECK(sText.find("\"ts\":0.500,\"dur\":0.500") != std::string::npos);
+}
+
+// A FIFO nobody reads for a while : the writer blocks in fprintf with the first buffer, the second
+// one fills and the rest is dropped. The spans must still be recorded without waiting for the file.
+static void testWriterStuck()
+{
+    std::string sPath = tempPath("TraceLogTest.fifo");
+    std::string sText;
+    std::thread reader;
+    CVirtualClock clock;
+    unsigned long nDropped;
+    int nFd;
+
+    unlink(sPath.c_str());
+    if(mkfifo(sPath.c_str(), 0600)) {
+        printf("SKIP testWriterStuck: mkfifo failed, errno %d\n", errno);
+        return;
+    }
+    nFd = open(sPath.c_str(), O_RDONLY | O_NONBLOCK);  // so the trace's fopen doesn't wait for a reader
+    if(nFd < 0) {
+        printf("SKIP testWriterStuck: can't open the FIFO, errno %d\n", errno);
+        unlink(sPath.c_str());
+        return;
+    }
+
+    {
+        CTraceLog trace;
+
+        TEST_CHECK_EQUAL(trace.start(sPath, clock), 0);
+        // the pipe and stdio buffers hold a few hundred events, the two buffers 2 * TRACE_NB_EVENTS
+        recordSpans(trace, clock, TRACE_TEST_EVENTS);
+        nDropped = trace.droppedCount();
+        TEST_CHECK(nDropped > 0);
+        TEST_CHECK(nDropped < TRACE_TEST_EVENTS);
+
+        reader = std::thread([nFd, &sText] {
+            char szBuffer[65536];
+            struct pollfd pfd = {nFd, POLLIN, 0};
+            ssize_t nRead;
+
+            while(poll(&pfd, 1, 5000) > 0) {
+                nRead = read(nFd, szBuffer, sizeof(szBuffer));
+                if(nRead > 0)
+                    sText.append(szBuffer, nRead);
+                else if(nRead == 0 || errno != EAGAIN)
+                    break;      // the trace closed its end
+            }
+        });
+        trace.stop();
+        TEST_CHECK_EQUAL(trace.droppedCount(), nDropped);
+    }
+    reader.join();
+    close(nFd);
+    unlink(sPath.c_str());
+
+    TEST_CHECK(sText.size() > 4 && sText.compare(sText.size() - 4, 4, "\n]}\n") == 0);
+    TEST_CHECK_EQUAL(countOf(sText, "\"name\":\"test span\"") + nDropped, (unsigned long)TRACE_TEST_EVENTS);
+    TEST_CHECK_EQUAL(droppedInTrace(sText), nDropped);
+}
+
+int main()
+{
+    testBuffers();
+    testWriterStuck();
+    return testResult("TraceLogTest");
+}
@@ -0,0 +1,157 @@
+#include <time.h>
+
+#include "TransportRecorder.h"
+#include "MonotonicClock.h"
+#include "TraceLog.h"
+#include "iOptronCommands.h"
+
+CTransportRecorder::CTransportRecorder()
+{
+    memset(m_Events, 0, sizeof(m_Events));
+    m_nNextEvent = 0;
+    m_pszHostCall = NULL;
+    m_nSlowNs = 0;
+    m_nLastCaptureNs = 0;
+    m_bCaptured = false;
+    m_bPending = false;
+    m_bStop = false;
+    m_nCaptures = 0;
+}
+
+CTransportRecorder::~CTransportRecorder()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+        m_bStop = true;
+    }
+    m_Wake.notify_one();
+    if(m_Writer.joinable())
+        m_Writer.join();
+}
+
+void CTransportRecorder::setCapture(const std::string &sPathPrefix, int nSlowMs)
+{
+    std::lock_guard<std::mutex> lock(m_Lock);
+
+    m_sPathPrefix = sPathPrefix;
+    m_nSlowNs = nSlowMs > 0 ? nSlowMs * NS_PER_MS : 0;
+}
+
+void CTransportRecorder::record(int nType, int nCmdId, int64_t nStartNs, int64_t nEndNs, int nErr, const void *pData, unsigned long nBytes, const char *pszCaller)
+{
+    TransportEvent *pEvent = &m_Events[m_nNextEvent++ % TRANSPORT_NB_EVENTS];
+
+    pEvent->nType = nType;
+    pEvent->nCmdId = nCmdId;
+    pEvent->nStartNs = nStartNs;
+    pEvent->nDurationNs = nEndNs - nStartNs;
+    pEvent->nErr = nErr;
+    pEvent->nBytes = nBytes;
+    pEvent->pszHostCall = pszCaller ? pszCaller : m_pszHostCall.load(std::memory_order_relaxed);
+    pEvent->nThreadId = CTraceLog::currentThreadId();
+    memset(pEvent->Data, 0, TRANSPORT_EVENT_DATA_SIZE);
+    if(pData)
+        memcpy(pEvent->Data, pData, nBytes < TRANSPORT_EVENT_DATA_SIZE ? nBytes : TRANSPORT_EVENT_DATA_SIZE);
+}
+
+void CTransportRecorder::exchangeDone(int nCmdId, int64_t nRoundTripNs, int64_t nNowNs, const char *pszCaller)
+{
+    unsigned long nFirst;
+    unsigned long i;
+    char szDate[32];
+    time_t tNow;
+
+    if(!m_nSlowNs || nRoundTripNs < m_nSlowNs)
+        return;
+    if(m_bCaptured && nNowNs - m_nLastCaptureNs < TRANSPORT_CAPTURE_INTERVAL_S * NS_PER_SECOND)
+        return;
+
+    std::unique_lock<std::mutex> lock(m_Lock, std::try_to_lock);
+    // the writer still has the previous capture, don't wait for it
+    if(!lock.owns_lock() || m_bPending || m_sPathPrefix.empty())
+        return;
+
+    m_Pending.nCmdId = nCmdId;
+    m_Pending.nRoundTripNs = nRoundTripNs;
+    m_Pending.nThresholdNs = m_nSlowNs;
+    m_Pending.nTriggerNs = nNowNs;
+    m_Pending.pszHostCall = pszCaller ? pszCaller : m_pszHostCall.load(std::memory_order_relaxed);
+    m_Pending.nNbEvents = m_nNextEvent < TRANSPORT_NB_EVENTS ? (int)m_nNextEvent : TRANSPORT_NB_EVENTS;
+    nFirst = m_nNextEvent - m_Pending.nNbEvents;
+    for(i = 0; i < (unsigned long)m_Pending.nNbEvents; i++)
+        m_Pending.Events[i] = m_Events[(nFirst + i) % TRANSPORT_NB_EVENTS];
+
+    tNow = time(NULL);
+    strftime(szDate, sizeof(szDate), "_%Y%m%d_%H%M%S.txt", localtime(&tNow));
+    m_sPendingPath = m_sPathPrefix + szDate;
+    m_bPending = true;
+    m_bCaptured = true;
+    m_nLastCaptureNs = nNowNs;
+    if(!m_Writer.joinable())
+        m_Writer = std::thread(&CTransportRecorder::writerThread, this);
+    lock.unlock();
+    m_Wake.notify_one();
+}
+
+void CTransportRecorder::writerThread()
+{
+    std::unique_lock<std::mutex> lock(m_Lock);
+
+    while(true) {
+        m_Wake.wait(lock, [this] { return m_bPending || m_bStop; });
+        if(m_bPending) {
+            // m_Pending isn't touched by producers while m_bPending is set, write it unlocked
+            lock.unlock();
+            writeCapture(m_Pending, m_sPendingPath);
+            m_nCaptures.fetch_add(1, std::memory_order_relaxed);
+            lock.lock();
+            m_bPending = false;
+        }
+        if(m_bStop)
+            break;
+    }
+}
+
+void CTransportRecorder::writeCapture(const TransportCapture &capture, const std::string &sPath)
+{
+    static const char *szTypes[] = {"write", "read", "purge"};
+    const TransportEvent *pEvent;
+    FILE *pFile;
+    int i;
+    unsigned long j;
+    unsigned long nShown;
+
+    pFile = fopen(sPath.c_str(), "w");
+    if(!pFile)
+        return;
+
+    fprintf(pFile, "slow command %s : %.3f ms round trip, threshold %.3f ms, during %s\n",
+            commandInfo(capture.nCmdId).pszCmd, capture.nRoundTripNs / 1.0e6, capture.nThresholdNs / 1.0e6,
+            capture.pszHostCall ? capture.pszHostCall : "no host call");
+    fprintf(pFile, "last %d transport events, times relative to the end of the slow exchange\n\n", capture.nNbEvents);
+    fprintf(pFile, "%12s %10s %-6s %-14s %5s %5s %-26s %8s  %s\n", "start ms", "took ms", "event", "command", "err", "bytes", "host call", "thread", "data");
+    for(i = 0; i < capture.nNbEvents; i++) {
+        pEvent = &capture.Events[i];
+        fprintf(pFile, "%12.3f %10.3f %-6s %-14s %5d %5lu %-26s %8u  ",
+                (pEvent->nStartNs - capture.nTriggerNs) / 1.0e6,
+                pEvent->nDurationNs / 1.0e6,
+                szTypes[pEvent->nType],
+                commandInfo(pEvent->nCmdId).pszCmd,
+                pEvent->nErr,
+                pEvent->nBytes,
+                pEvent->pszHostCall ? pEvent->pszHostCall : "-",
+                pEvent->nThreadId);
+        // printable as is, the rest in hex
+        nShown = pEvent->nBytes < TRANSPORT_EVENT_DATA_SIZE ? pEvent->nBytes : TRANSPORT_EVENT_DATA_SIZE;
+        if(pEvent->nType == TRANSPORT_PURGE)
+            nShown = 0;
+        for(j = 0; j < nShown; j++) {
+            if(pEvent->Data[j] >= 0x20 && pEvent->Data[j] < 0x7F)
+                fputc(pEvent->Data[j], pFile);
+            else
+                fprintf(pFile, "\\x%02X", pEvent->Data[j]);
+        }
+        fprintf(pFile, "\n");
+    }
+    fclose(pFile);
+}
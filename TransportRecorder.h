@@ -0,0 +1,87 @@
+#pragma once
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#include <string>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+// Flight recorder of the serial transport. The last TRANSPORT_NB_EVENTS writes, reads and purges are
+// kept in memory, bytes included. When an exchange takes longer than the threshold the ring is copied
+// and a background thread writes it to a timestamped diagnostic file, so intermittent latency spikes
+// on unattended sites leave something to look at. The caller only pays for the copy.
+// At most one file every TRANSPORT_CAPTURE_INTERVAL_S, a dead link would otherwise write one per command.
+
+#define TRANSPORT_NB_EVENTS             64      // power of 2
+#define TRANSPORT_EVENT_DATA_SIZE       32      // longest reply is 24 bytes
+#define TRANSPORT_CAPTURE_INTERVAL_S    300
+#define TRANSPORT_DEFAULT_SLOW_MS       800
+
+enum TransportEventType {TRANSPORT_WRITE=0, TRANSPORT_READ, TRANSPORT_PURGE};
+
+typedef struct {
+    int             nType;          // TransportEventType
+    int             nCmdId;         // iOptronCommandId
+    int64_t         nStartNs;       // mount clock
+    int64_t         nDurationNs;
+    int             nErr;
+    unsigned long   nBytes;         // transferred, or dropped by a purge
+    const char      *pszHostCall;   // X2 call in progress or the other thread sending, NULL outside of one
+    uint32_t        nThreadId;
+    unsigned char   Data[TRANSPORT_EVENT_DATA_SIZE];
+} TransportEvent;
+
+typedef struct {
+    int             nCmdId;         // the slow one
+    int64_t         nRoundTripNs;
+    int64_t         nThresholdNs;
+    int64_t         nTriggerNs;
+    const char      *pszHostCall;
+    int             nNbEvents;
+    TransportEvent  Events[TRANSPORT_NB_EVENTS];    // oldest first
+} TransportCapture;
+
+class CTransportRecorder
+{
+public:
+    CTransportRecorder();
+    ~CTransportRecorder();
+
+    // pszPathPrefix gets "_%Y%m%d_%H%M%S.txt" appended, empty to never write. 0 ms turns the watchdog off.
+    void    setCapture(const std::string &sPathPrefix, int nSlowMs);
+    // X2 call the following events belong to, a string literal, NULL when it returns
+    void    setHostCall(const char *pszHostCall) { m_pszHostCall.store(pszHostCall, std::memory_order_relaxed); }
+
+    // pszCaller tags the events of exchanges sent from another thread (guide pulses, rate stream),
+    // NULL for the ones of the host call in progress
+    void    record(int nType, int nCmdId, int64_t nStartNs, int64_t nEndNs, int nErr, const void *pData, unsigned long nBytes, const char *pszCaller = NULL);
+    // end of an exchange, captures the ring if it was slow
+    void    exchangeDone(int nCmdId, int64_t nRoundTripNs, int64_t nNowNs, const char *pszCaller = NULL);
+
+    unsigned long   captureCount() const { return m_nCaptures.load(std::memory_order_relaxed); }
+
+private:
+    void    writerThread();
+    void    writeCapture(const TransportCapture &capture, const std::string &sPath);
+
+    TransportEvent      m_Events[TRANSPORT_NB_EVENTS];
+    unsigned long       m_nNextEvent;
+    std::atomic<const char *>   m_pszHostCall;  // set by the host thread, read by whoever sends
+    std::string         m_sPathPrefix;
+    int64_t             m_nSlowNs;
+    int64_t             m_nLastCaptureNs;
+    bool                m_bCaptured;
+
+    // hand off to the writer thread, started on the first capture
+    std::mutex              m_Lock;
+    std::condition_variable m_Wake;
+    std::thread             m_Writer;
+    bool                    m_bPending;
+    bool                    m_bStop;
+    TransportCapture        m_Pending;
+    std::string             m_sPendingPath;
+    std::atomic<unsigned long>  m_nCaptures;
+};
@@ -0,0 +1,95 @@
+#pragma once
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// C++ includes
+#include <string>
+#include <map>
+#include <mutex>
+
+#include "../../licensedinterfaces/sleeperinterface.h"
+#include "../../licensedinterfaces/loggerinterface.h"
+#include "../../licensedinterfaces/mutexinterface.h"
+#include "../../licensedinterfaces/tickcountinterface.h"
+#include "../../licensedinterfaces/basiciniutilinterface.h"
+
+#include "MonotonicClock.h"
+
+// Stand-ins for the TheSkyX services X2Mount is constructed with, for the test programs, the
+// benchmarks and the replay harness. X2Mount deletes them, allocate them with new.
+
+class CFakeSleeper : public SleeperInterface
+{
+public:
+    explicit CFakeSleeper(CVirtualClock *pClock = NULL) : m_pClock(pClock) {}
+    virtual void sleep(const int& nMs) { if(m_pClock) m_pClock->advance(nMs * NS_PER_MS); }
+
+private:
+    CVirtualClock   *m_pClock;
+};
+
+class CFakeLogger : public LoggerInterface
+{
+public:
+    virtual int out(const char* /* pszLine */) { return 0; }
+};
+
+class CFakeMutex : public MutexInterface
+{
+public:
+    virtual void lock() { m_Lock.lock(); }
+    virtual void unlock() { m_Lock.unlock(); }
+
+private:
+    std::mutex  m_Lock;
+};
+
+class CFakeTickCount : public TickCountInterface
+{
+public:
+    virtual int elapsed() { return (int)(CMonotonicClock::system().nowNs() / NS_PER_MS); }
+};
+
+// settings kept in memory, unset keys read back as their default
+class CFakeIniUtil : public BasicIniUtilInterface
+{
+public:
+    virtual int readInt(const char *pszParent, const char *pszChild, const int& nDefault)
+    {
+        std::map<std::string, std::string>::const_iterator it = m_Values.find(key(pszParent, pszChild));
+        return it == m_Values.end() ? nDefault : atoi(it->second.c_str());
+    }
+    virtual int writeInt(const char *pszParent, const char *pszChild, const int& nValue)
+    {
+        m_Values[key(pszParent, pszChild)] = std::to_string(nValue);
+        return 0;
+    }
+    virtual double readDouble(const char *pszParent, const char *pszChild, const double& dDefault)
+    {
+        std::map<std::string, std::string>::const_iterator it = m_Values.find(key(pszParent, pszChild));
+        return it == m_Values.end() ? dDefault : atof(it->second.c_str());
+    }
+    virtual int writeDouble(const char *pszParent, const char *pszChild, const double& dValue)
+    {
+        m_Values[key(pszParent, pszChild)] = std::to_string(dValue);
+        return 0;
+    }
+    virtual void readString(const char *pszParent, const char *pszChild, const char *pszDefault, char *pszOut, int nMaxSize)
+    {
+        std::map<std::string, std::string>::const_iterator it = m_Values.find(key(pszParent, pszChild));
+        const char *pszValue = it == m_Values.end() ? pszDefault : it->second.c_str();
+        if(pszOut != pszValue)
+            snprintf(pszOut, nMaxSize, "%s", pszValue);
+    }
+    virtual int writeString(const char *pszParent, const char *pszChild, const char *pszValue)
+    {
+        m_Values[key(pszParent, pszChild)] = pszValue;
+        return 0;
+    }
+
+private:
+    std::map<std::string, std::string>  m_Values;
+
+    static std::string key(const char *pszParent, const char *pszChild) { return std::string(pszParent) + "/" + pszChild; }
+};
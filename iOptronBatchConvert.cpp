@@ -0,0 +1,195 @@
+#include "iOptronBatchConvert.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define IOPTRON_BATCH_SSE2
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define IOPTRON_BATCH_NEON
+#include <arm_neon.h>
+#endif
+
+// Every operation below is the one CCentiArcsec does, in the same order, so each lane rounds exactly like the scalar code.
+
+#pragma mark - SSE2
+#if defined(IOPTRON_BATCH_SSE2)
+
+// exact int64 -> double for |n| < 2^51 : put n in the mantissa of 2^52 + 2^51, then subtract it
+static inline __m128d int64ToDouble(__m128i nValues)
+{
+    const __m128i nMagic = _mm_set1_epi64x(0x4338000000000000LL);
+    const __m128d dMagic = _mm_set1_pd(6755399441055744.0);    // 2^52 + 2^51
+
+    return _mm_sub_pd(_mm_castsi128_pd(_mm_add_epi64(nValues, nMagic)), dMagic);
+}
+
+static void centiArcsecToScaled(const int64_t *pnIn, double *pdOut, size_t nCount, double dScale)
+{
+    size_t i;
+    const __m128d dScales = _mm_set1_pd(dScale);
+
+    for(i = 0; i + 2 <= nCount; i += 2) {
+        __m128i nValues = _mm_loadu_si128((const __m128i *)(pnIn + i));
+        _mm_storeu_pd(pdOut + i, _mm_mul_pd(int64ToDouble(nValues), dScales));
+    }
+    for(; i < nCount; i++)
+        pdOut[i] = (double)pnIn[i] * dScale;
+}
+
+// truncation toward zero of 2 doubles, lanes outside the int32 range are redone the scalar way
+static inline void storeTruncated(__m128d dValues, int64_t *pnOut)
+{
+    int32_t nTrunc[4];
+    double dLanes[2];
+    int k;
+
+    _mm_storeu_si128((__m128i *)nTrunc, _mm_cvttpd_epi32(dValues));
+    for(k = 0; k < 2; k++) {
+        if(nTrunc[k] == INT32_MIN) {
+            _mm_storeu_pd(dLanes, dValues);
+            pnOut[k] = (int64_t)dLanes[k];
+        }
+        else
+            pnOut[k] = nTrunc[k];
+    }
+}
+
+void hoursToCentiArcsec(const double *pdIn, int64_t *pnOut, size_t nCount)
+{
+    size_t i;
+    const __m128d d24 = _mm_set1_pd(24.0);
+    const __m128d d360 = _mm_set1_pd(360.0);
+    const __m128d d60 = _mm_set1_pd(60.0);
+    const __m128d dCenti = _mm_set1_pd(0.01);
+    __m128d dValues;
+
+    for(i = 0; i + 2 <= nCount; i += 2) {
+        dValues = _mm_div_pd(_mm_loadu_pd(pdIn + i), d24);
+        dValues = _mm_mul_pd(dValues, d360);
+        dValues = _mm_mul_pd(dValues, d60);
+        dValues = _mm_mul_pd(dValues, d60);
+        storeTruncated(_mm_div_pd(dValues, dCenti), pnOut + i);
+    }
+    for(; i < nCount; i++)
+        pnOut[i] = CCentiArcsec::fromHours(pdIn[i]).raw();
+}
+
+void degreesToCentiArcsec(const double *pdIn, int64_t *pnOut, size_t nCount)
+{
+    size_t i;
+    const __m128d d60 = _mm_set1_pd(60.0);
+    const __m128d dCenti = _mm_set1_pd(0.01);
+    __m128d dValues;
+
+    for(i = 0; i + 2 <= nCount; i += 2) {
+        dValues = _mm_mul_pd(_mm_loadu_pd(pdIn + i), d60);
+        dValues = _mm_mul_pd(dValues, d60);
+        storeTruncated(_mm_div_pd(dValues, dCenti), pnOut + i);
+    }
+    for(; i < nCount; i++)
+        pnOut[i] = CCentiArcsec::fromDegrees(pdIn[i]).raw();
+}
+
+const char *batchConvertImplementation()
+{
+    return "sse2";
+}
+
+#pragma mark - NEON
+#elif defined(IOPTRON_BATCH_NEON)
+
+static void centiArcsecToScaled(const int64_t *pnIn, double *pdOut, size_t nCount, double dScale)
+{
+    size_t i;
+    const float64x2_t dScales = vdupq_n_f64(dScale);
+
+    for(i = 0; i + 2 <= nCount; i += 2)
+        vst1q_f64(pdOut + i, vmulq_f64(vcvtq_f64_s64(vld1q_s64(pnIn + i)), dScales));
+    for(; i < nCount; i++)
+        pdOut[i] = (double)pnIn[i] * dScale;
+}
+
+void hoursToCentiArcsec(const double *pdIn, int64_t *pnOut, size_t nCount)
+{
+    size_t i;
+    const float64x2_t d24 = vdupq_n_f64(24.0);
+    const float64x2_t d360 = vdupq_n_f64(360.0);
+    const float64x2_t d60 = vdupq_n_f64(60.0);
+    const float64x2_t dCenti = vdupq_n_f64(0.01);
+    float64x2_t dValues;
+
+    for(i = 0; i + 2 <= nCount; i += 2) {
+        dValues = vdivq_f64(vld1q_f64(pdIn + i), d24);
+        dValues = vmulq_f64(dValues, d360);
+        dValues = vmulq_f64(dValues, d60);
+        dValues = vmulq_f64(dValues, d60);
+        vst1q_s64(pnOut + i, vcvtq_s64_f64(vdivq_f64(dValues, dCenti)));
+    }
+    for(; i < nCount; i++)
+        pnOut[i] = CCentiArcsec::fromHours(pdIn[i]).raw();
+}
+
+void degreesToCentiArcsec(const double *pdIn, int64_t *pnOut, size_t nCount)
+{
+    size_t i;
+    const float64x2_t d60 = vdupq_n_f64(60.0);
+    const float64x2_t dCenti = vdupq_n_f64(0.01);
+    float64x2_t dValues;
+
+    for(i = 0; i + 2 <= nCount; i += 2) {
+        dValues = vmulq_f64(vld1q_f64(pdIn + i), d60);
+        dValues = vmulq_f64(dValues, d60);
+        vst1q_s64(pnOut + i, vcvtq_s64_f64(vdivq_f64(dValues, dCenti)));
+    }
+    for(; i < nCount; i++)
+        pnOut[i] = CCentiArcsec::fromDegrees(pdIn[i]).raw();
+}
+
+const char *batchConvertImplementation()
+{
+    return "neon";
+}
+
+#pragma mark - scalar
+#else
+
+static void centiArcsecToScaled(const int64_t *pnIn, double *pdOut, size_t nCount, double dScale)
+{
+    size_t i;
+
+    for(i = 0; i < nCount; i++)
+        pdOut[i] = (double)pnIn[i] * dScale;
+}
+
+void hoursToCentiArcsec(const double *pdIn, int64_t *pnOut, size_t nCount)
+{
+    size_t i;
+
+    for(i = 0; i < nCount; i++)
+        pnOut[i] = CCentiArcsec::fromHours(pdIn[i]).raw();
+}
+
+void degreesToCentiArcsec(const double *pdIn, int64_t *pnOut, size_t nCount)
+{
+    size_t i;
+
+    for(i = 0; i < nCount; i++)
+        pnOut[i] = CCentiArcsec::fromDegrees(pdIn[i]).raw();
+}
+
+const char *batchConvertImplementation()
+{
+    return "scalar";
+}
+
+#endif
+
+#pragma mark - common
+void centiArcsecToHours(const int64_t *pnIn, double *pdOut, size_t nCount)
+{
+    centiArcsecToScaled(pnIn, pdOut, nCount, CENTI_ARCSEC_TO_HOURS);
+}
+
+void centiArcsecToDegrees(const int64_t *pnIn, double *pdOut, size_t nCount)
+{
+    centiArcsecToScaled(pnIn, pdOut, nCount, CENTI_ARCSEC_TO_DEGREES);
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include <stddef.h>
+
+#include "iOptronProtocol.h"
+
+// Batch conversions between mount units (0.01 arc-second) and hours / degrees over contiguous arrays.
+// Same formulas as CCentiArcsec and bit for bit the same results, 2 values at a time with SSE2 or NEON,
+// plain loops otherwise. Meant for replay analysis, pointing model fits and trajectory tools,
+// the driver itself converts one position at a time.
+// Integer inputs must be within +/- 2^51, far beyond anything the mount sends.
+
+void centiArcsecToHours(const int64_t *pnIn, double *pdOut, size_t nCount);
+void centiArcsecToDegrees(const int64_t *pnIn, double *pdOut, size_t nCount);
+void hoursToCentiArcsec(const double *pdIn, int64_t *pnOut, size_t nCount);
+void degreesToCentiArcsec(const double *pdIn, int64_t *pnOut, size_t nCount);
+
+// "sse2", "neon" or "scalar"
+const char *batchConvertImplementation();
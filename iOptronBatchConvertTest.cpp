@@ -0,0 +1,155 @@
+// The batch conversion kernels (iOptronBatchConvert.cpp) against CCentiArcsec, bit for bit.
+// Every array length from 0 to 2 x the vector width plus a large one, so the SIMD body and the scalar
+// tail both run, unaligned starts, and values on the truncation edges. Built and run by make test.
+
+#include <math.h>
+#include <string.h>
+
+// C++ includes
+#include <vector>
+
+#include "TestCheck.h"
+#include "iOptronBatchConvert.h"
+
+#define MAX_SHORT_LENGTH    9
+#define LONG_LENGTH         10001
+
+static uint64_t s_nRandom = 0x9E3779B97F4A7C15ULL;
+
+// deterministic, the failures have to be reproducible
+static uint64_t nextRandom()
+{
+    s_nRandom ^= s_nRandom << 13;
+    s_nRandom ^= s_nRandom >> 7;
+    s_nRandom ^= s_nRandom << 17;
+    return s_nRandom;
+}
+
+static bool sameBits(double d1, double d2)
+{
+    return !memcmp(&d1, &d2, sizeof(double));
+}
+
+// raw values, and the doubles just below, on and just above each of them
+static void addEdges(std::vector<double> &values, double dUnit, int64_t nRaw)
+{
+    double dValue = (double)nRaw * dUnit;
+
+    values.push_back(nextafter(dValue, -INFINITY));
+    values.push_back(dValue);
+    values.push_back(nextafter(dValue, INFINITY));
+    // halfway between two mount units
+    values.push_back(((double)nRaw + 0.5) * dUnit);
+}
+
+static std::vector<double> angleValues(double dUnit, double dRange)
+{
+    std::vector<double> values;
+    const int64_t nEdges[] = {0, 1, -1, 2, -2, 49, 50, 51, -50, 99, 100, 101, -100, 4320000, 8640000, -8640000, 16200000, -16200000,
+                              32400000, -32400000, 64800000, 129599999, 129600000, INT32_MAX, (int64_t)INT32_MAX + 1, INT32_MIN,
+                              (int64_t)INT32_MIN - 1, 100000000000LL, -100000000000LL};
+    size_t i;
+
+    values.push_back(0.0);
+    values.push_back(-0.0);
+    values.push_back(1e-300);
+    values.push_back(-1e-300);
+    for(i = 0; i < sizeof(nEdges) / sizeof(nEdges[0]); i++)
+        addEdges(values, dUnit, nEdges[i]);
+    while(values.size() < LONG_LENGTH)
+        values.push_back(((double)(nextRandom() >> 11) / 9007199254740992.0 * 2.0 - 1.0) * dRange);
+    return values;
+}
+
+static std::vector<int64_t> rawValues()
+{
+    std::vector<int64_t> values;
+    const int64_t nEdges[] = {0, 1, -1, 2, -2, 100, -100, 129599999, 129600000, -32400000, 32400000, INT32_MAX, INT32_MIN,
+                              (int64_t)INT32_MAX + 1, (int64_t)INT32_MIN - 1, (1LL << 51) - 1, -(1LL << 51) + 1};
+    size_t i;
+
+    for(i = 0; i < sizeof(nEdges) / sizeof(nEdges[0]); i++)
+        values.push_back(nEdges[i]);
+    while(values.size() < LONG_LENGTH)
+        values.push_back((int64_t)(nextRandom() % 259200001ULL) - 129600000);
+    return values;
+}
+
+// nCount values from pIn + nStart through the kernel, each compared with the scalar conversion
+static void checkToCentiArcsec(const char *pszName, void (*pfKernel)(const double *, int64_t *, size_t),
+                               CCentiArcsec (*pfScalar)(double), const std::vector<double> &values, size_t nStart, size_t nCount)
+{
+    std::vector<int64_t> out(nCount + 1);
+    size_t i;
+
+    pfKernel(values.data() + nStart, out.data(), nCount);
+    for(i = 0; i < nCount; i++) {
+        if(out[i] != pfScalar(values[nStart + i]).raw()) {
+            fprintf(stderr, "%s(%.17g) : %lld, CCentiArcsec %lld (length %zu, index %zu)\n", pszName, values[nStart + i],
+                    (long long)out[i], (long long)pfScalar(values[nStart + i]).raw(), nCount, i);
+            testFailures()++;
+            return;
+        }
+    }
+}
+
+static void checkFromCentiArcsec(const char *pszName, void (*pfKernel)(const int64_t *, double *, size_t), bool bHours,
+                                 const std::vector<int64_t> &values, size_t nStart, size_t nCount)
+{
+    std::vector<double> out(nCount + 1);
+    double dExpected;
+    size_t i;
+
+    pfKernel(values.data() + nStart, out.data(), nCount);
+    for(i = 0; i < nCount; i++) {
+        dExpected = bHours ? CCentiArcsec(values[nStart + i]).hours() : CCentiArcsec(values[nStart + i]).degrees();
+        if(!sameBits(out[i], dExpected)) {
+            fprintf(stderr, "%s(%lld) : %.17g, CCentiArcsec %.17g (length %zu, index %zu)\n", pszName, (long long)values[nStart + i],
+                    out[i], dExpected, nCount, i);
+            testFailures()++;
+            return;
+        }
+    }
+}
+
+static void testToCentiArcsec()
+{
+    std::vector<double> hours = angleValues(CENTI_ARCSEC_TO_HOURS, 48.0);
+    std::vector<double> degrees = angleValues(CENTI_ARCSEC_TO_DEGREES, 720.0);
+    size_t nStart, nCount;
+
+    // every short length at an even and an odd start, the vector loads are unaligned either way
+    for(nStart = 0; nStart + MAX_SHORT_LENGTH < hours.size(); nStart++) {
+        for(nCount = 0; nCount <= MAX_SHORT_LENGTH; nCount++) {
+            checkToCentiArcsec("hoursToCentiArcsec", hoursToCentiArcsec, CCentiArcsec::fromHours, hours, nStart, nCount);
+            checkToCentiArcsec("degreesToCentiArcsec", degreesToCentiArcsec, CCentiArcsec::fromDegrees, degrees, nStart, nCount);
+        }
+        if(nStart > 200)
+            break;
+    }
+    checkToCentiArcsec("hoursToCentiArcsec", hoursToCentiArcsec, CCentiArcsec::fromHours, hours, 0, hours.size());
+    checkToCentiArcsec("degreesToCentiArcsec", degreesToCentiArcsec, CCentiArcsec::fromDegrees, degrees, 1, degrees.size() - 1);
+}
+
+static void testFromCentiArcsec()
+{
+    std::vector<int64_t> raw = rawValues();
+    size_t nStart, nCount;
+
+    for(nStart = 0; nStart < 40; nStart++) {
+        for(nCount = 0; nCount <= MAX_SHORT_LENGTH; nCount++) {
+            checkFromCentiArcsec("centiArcsecToHours", centiArcsecToHours, true, raw, nStart, nCount);
+            checkFromCentiArcsec("centiArcsecToDegrees", centiArcsecToDegrees, false, raw, nStart, nCount);
+        }
+    }
+    checkFromCentiArcsec("centiArcsecToHours", centiArcsecToHours, true, raw, 0, raw.size());
+    checkFromCentiArcsec("centiArcsecToDegrees", centiArcsecToDegrees, false, raw, 1, raw.size() - 1);
+}
+
+int main()
+{
+    printf("batch conversions : %s\n", batchConvertImplementation());
+    testToCentiArcsec();
+    testFromCentiArcsec();
+    return testResult("iOptronBatchConvertTest");
+}
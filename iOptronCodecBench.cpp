@@ -0,0 +1,166 @@
+// Microbenchmark of the protocol codec hot paths : reply parsing and command formatting.
+// Reports ns/op and heap allocations per op, the old snprintf formatting is timed alongside for
+// reference. Built and run by make bench, optional argument : iterations per benchmark.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// C++ includes
+#include <atomic>
+#include <new>
+
+#include "MonotonicClock.h"
+#include "iOptronProtocol.h"
+#include "iOptronCommands.h"
+
+#define BENCH_DEFAULT_ITERATIONS    2000000L
+#define BENCH_WARMUP_ITERATIONS     10000L
+
+// every heap allocation in the process goes through these
+static std::atomic<unsigned long> s_nAllocations(0);
+
+void *operator new(size_t nSize)
+{
+    void *p;
+
+    s_nAllocations.fetch_add(1, std::memory_order_relaxed);
+    p = malloc(nSize ? nSize : 1);
+    if(!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+void *operator new[](size_t nSize)
+{
+    return operator new(nSize);
+}
+
+void operator delete(void *p) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void *p, size_t) noexcept
+{
+    free(p);
+}
+
+// results land here so the loops can't be optimized away
+static volatile int64_t s_nSink;
+
+template<typename Body>
+static void bench(const char *pszName, long nIterations, Body body)
+{
+    long i;
+    int64_t nAcc = 0;
+    int64_t nStartNs;
+    int64_t nElapsedNs;
+    unsigned long nAllocations;
+
+    for(i = 0; i < BENCH_WARMUP_ITERATIONS; i++)
+        nAcc += body(i);
+
+    nAllocations = s_nAllocations.load();
+    nStartNs = CMonotonicClock::system().nowNs();
+    for(i = 0; i < nIterations; i++)
+        nAcc += body(i);
+    nElapsedNs = CMonotonicClock::system().nowNs() - nStartNs;
+    nAllocations = s_nAllocations.load() - nAllocations;
+    s_nSink = nAcc;
+
+    printf("%-36s %12ld %10.2f %12.3f\n", pszName, nIterations, (double)nElapsedNs / (double)nIterations,
+           (double)nAllocations / (double)nIterations);
+}
+
+int main(int argc, char **argv)
+{
+    long nIterations = argc > 1 ? atol(argv[1]) : BENCH_DEFAULT_ITERATIONS;
+    // one well formed reply per query, as the mount sends them
+    static const char szGEP[] = "+16200000064800000" "11#";
+    static const char szGLS[] = "-26460000" "48780000" "210131#";
+    static const char szGPC[] = "16200000" "000000000#";
+    static const char szGUT[] = "-300" "1" "0845000000000#";
+    static const char szGMT[] = "110#";
+    static const char szGAL[] = "+05#";
+
+    if(nIterations <= 0)
+        nIterations = BENCH_DEFAULT_ITERATIONS;
+
+    printf("%-36s %12s %10s %12s\n", "benchmark", "iterations", "ns/op", "allocs/op");
+
+    bench("parsePositionReply :GEP#", nIterations, [&](long) {
+        iOptronPositionReply reply;
+        return parsePositionReply(szGEP, reply) ? (int64_t)0 : reply.Ra.raw();
+    });
+    bench("parseStatusReply :GLS#", nIterations, [&](long) {
+        iOptronStatusReply reply;
+        return parseStatusReply(szGLS, reply) ? (int64_t)0 : reply.Lat.raw() + reply.nStatus;
+    });
+    bench("parseParkPositionReply :GPC#", nIterations, [&](long) {
+        CCentiArcsec Az, Alt;
+        return parseParkPositionReply(szGPC, Az, Alt) ? (int64_t)0 : Alt.raw();
+    });
+    bench("parseUtcOffsetReply :GUT#", nIterations, [&](long) {
+        char szOffset[5];
+        bool bDaylight;
+        return parseUtcOffsetReply(szGUT, szOffset, bDaylight) ? (int64_t)0 : (int64_t)szOffset[1] + bDaylight;
+    });
+    bench("parseMeridianTreatmentReply :GMT#", nIterations, [&](long) {
+        int iBehavior, iDegrees;
+        return parseMeridianTreatmentReply(szGMT, iBehavior, iDegrees) ? (int64_t)0 : (int64_t)(iBehavior + iDegrees);
+    });
+    bench("parseAltitudeLimitReply :GAL#", nIterations, [&](long) {
+        int iDegrees;
+        return parseAltitudeLimitReply(szGAL, iDegrees) ? (int64_t)0 : (int64_t)iDegrees;
+    });
+    bench("decodeQueryResponse :GLS#", nIterations, [&](long) {
+        int64_t nFields[IOPTRON_MAX_QUERY_FIELDS];
+        return decodeQueryResponse(QUERY_GLS, szGLS, nFields) ? (int64_t)0 : nFields[GLS_LAT];
+    });
+
+    bench("formatRaCommand :SRA", nIterations, [&](long i) {
+        char szCmd[IOPTRON_CMD_BUFFER_SIZE];
+        return (int64_t)formatRaCommand(szCmd, sizeof(szCmd), CCentiArcsec(i)) + szCmd[5];
+    });
+    bench("snprintf :SRA (before)", nIterations, [&](long i) {
+        char szCmd[IOPTRON_CMD_BUFFER_SIZE];
+        return (int64_t)snprintf(szCmd, sizeof(szCmd), ":SRA%09lld#", (long long)i) + szCmd[5];
+    });
+    bench("formatDecCommand :Sd", nIterations, [&](long i) {
+        char szCmd[IOPTRON_CMD_BUFFER_SIZE];
+        return (int64_t)formatDecCommand(szCmd, sizeof(szCmd), CCentiArcsec(-i)) + szCmd[4];
+    });
+    bench("snprintf :Sd (before)", nIterations, [&](long i) {
+        char szCmd[IOPTRON_CMD_BUFFER_SIZE];
+        return (int64_t)snprintf(szCmd, sizeof(szCmd), ":Sd%+09lld#", (long long)-i) + szCmd[4];
+    });
+    bench("formatCustomRateCommand :RR", nIterations, [&](long i) {
+        char szCmd[IOPTRON_CMD_BUFFER_SIZE];
+        return (int64_t)formatCustomRateCommand(szCmd, sizeof(szCmd), 1.0 + (double)(i & 0xFFF) * 1e-4) + szCmd[4];
+    });
+    bench("formatUtcTimeCommand :SUT", nIterations, [&](long i) {
+        char szCmd[IOPTRON_CMD_BUFFER_SIZE];
+        return (int64_t)formatUtcTimeCommand(szCmd, sizeof(szCmd), 845000000000.0 + (double)i) + szCmd[6];
+    });
+    bench("formatLatitudeCommand :SLA", nIterations, [&](long i) {
+        char szCmd[IOPTRON_CMD_BUFFER_SIZE];
+        return (int64_t)formatLatitudeCommand(szCmd, sizeof(szCmd), CCentiArcsec(16380000 - i)) + szCmd[6];
+    });
+    bench("formatGuidePulseCommand :Mn", nIterations, [&](long i) {
+        char szCmd[IOPTRON_CMD_BUFFER_SIZE];
+        return (int64_t)formatGuidePulseCommand(szCmd, sizeof(szCmd), CMD_GUIDE_N, (int)(i % 10000)) + szCmd[4];
+    });
+
+    return 0;
+}
@@ -0,0 +1,145 @@
+#pragma once
+
+#include "iOptronProtocol.h"
+
+// Catalog of every command the driver sends to the mount, built at compile time.
+// Transport, cache invalidation and instrumentation all index it by iOptronCommandId.
+
+enum iOptronCommandId {
+    // queries
+    CMD_GEP=0, CMD_GLS, CMD_GPC, CMD_GUT, CMD_GMT, CMD_GAL, CMD_MOUNT_INFO, CMD_FW1, CMD_FW2,
+    // tracking
+    CMD_RT0, CMD_RT1, CMD_RT2, CMD_RT3, CMD_RT4, CMD_RR, CMD_ST0, CMD_ST1,
+    // motion
+    CMD_SRA, CMD_SD, CMD_MS1, CMD_MS2, CMD_CM, CMD_Q, CMD_SR, CMD_MN, CMD_MS, CMD_ME, CMD_MW, CMD_QD, CMD_QR,
+    CMD_GUIDE_N, CMD_GUIDE_S, CMD_GUIDE_E, CMD_GUIDE_W,
+    CMD_MH, CMD_MSH, CMD_SA_ZENITH, CMD_SZ_NORTH, CMD_MSS,
+    // park
+    CMD_MP1, CMD_MP0, CMD_SPA, CMD_SPH,
+    // settings
+    CMD_SG, CMD_SDS, CMD_SLA, CMD_SLO, CMD_SUT, CMD_SMT, CMD_SAL,
+    IOPTRON_NB_COMMANDS
+};
+
+enum iOptronReplyFormat {REPLY_NONE=0, REPLY_ACK, REPLY_FIELDS, REPLY_TEXT};
+
+enum iOptronTimeoutClass {TIMEOUT_QUERY=0, TIMEOUT_SET, TIMEOUT_MOTION, IOPTRON_NB_TIMEOUT_CLASSES};
+
+#define MAX_TIMEOUT 1000         // was 500 ms
+
+// cached data a command makes stale
+#define CACHE_NONE      0x00
+#define CACHE_POSITION  0x01    // :GEP# data, m_dRa / m_dDec / pier side
+#define CACHE_STATUS    0x02    // :GLS# data, system status, tracking, park
+
+typedef struct {
+    const char  *pszCmd;        // full command, or the leading part for formatted commands
+    int         nCmdLen;        // length of the full command, 0 if it varies
+    int         nReplyLen;      // bytes to read back, terminator included
+    int         nReplyFormat;   // iOptronReplyFormat
+    int         nQuery;         // iOptronQuery for REPLY_FIELDS, -1 otherwise
+    int         nTimeoutClass;  // iOptronTimeoutClass
+    bool        bMutates;       // changes mount state
+    bool        bFormatted;     // pszCmd is only the prefix, the caller builds the command
+    unsigned    nInvalidates;   // CACHE_xxx
+} iOptronCommand;
+
+constexpr int commandLength(const char *pszCmd)
+{
+    return *pszCmd ? 1 + commandLength(pszCmd + 1) : 0;
+}
+
+constexpr iOptronCommand queryCommand(const char *pszCmd, int nReplyLen, int nQuery)
+{
+    return iOptronCommand{pszCmd, commandLength(pszCmd), nReplyLen, nQuery < 0 ? REPLY_TEXT : REPLY_FIELDS, nQuery, TIMEOUT_QUERY, false, false, CACHE_NONE};
+}
+
+constexpr iOptronCommand actionCommand(const char *pszCmd, int nReplyLen, int nTimeoutClass, unsigned nInvalidates)
+{
+    return iOptronCommand{pszCmd, commandLength(pszCmd), nReplyLen, nReplyLen ? REPLY_ACK : REPLY_NONE, -1, nTimeoutClass, true, false, nInvalidates};
+}
+
+constexpr iOptronCommand formattedCommand(const char *pszPrefix, int nCmdLen, int nTimeoutClass, unsigned nInvalidates)
+{
+    return iOptronCommand{pszPrefix, nCmdLen, 1, REPLY_ACK, -1, nTimeoutClass, true, true, nInvalidates};
+}
+
+// timed guide pulse, no reply
+constexpr iOptronCommand guideCommand(const char *pszPrefix)
+{
+    return iOptronCommand{pszPrefix, 9, 0, REPLY_NONE, -1, TIMEOUT_MOTION, true, true, CACHE_POSITION};
+}
+
+struct iOptronCommandCatalog
+{
+    static constexpr iOptronCommand commands[IOPTRON_NB_COMMANDS] = {
+        queryCommand(":GEP#", 21, QUERY_GEP),
+        queryCommand(":GLS#", 24, QUERY_GLS),
+        queryCommand(":GPC#", 18, QUERY_GPC),
+        queryCommand(":GUT#", 19, QUERY_GUT),
+        queryCommand(":GMT#", 4, QUERY_GMT),
+        queryCommand(":GAL#", 4, QUERY_GAL),
+        queryCommand(":MountInfo#", 4, -1),
+        queryCommand(":FW1#", 13, -1),
+        queryCommand(":FW2#", 13, -1),
+
+        // tracking rate changes are mirrored in the cache by the caller
+        actionCommand(":RT0#", 1, TIMEOUT_SET, CACHE_NONE),
+        actionCommand(":RT1#", 1, TIMEOUT_SET, CACHE_NONE),
+        actionCommand(":RT2#", 1, TIMEOUT_SET, CACHE_NONE),
+        actionCommand(":RT3#", 1, TIMEOUT_SET, CACHE_NONE),
+        actionCommand(":RT4#", 1, TIMEOUT_SET, CACHE_NONE),
+        formattedCommand(":RR", 9, TIMEOUT_SET, CACHE_NONE),            // :RRnnnnn#
+        actionCommand(":ST0#", 1, TIMEOUT_SET, CACHE_STATUS),
+        actionCommand(":ST1#", 1, TIMEOUT_SET, CACHE_STATUS),
+
+        formattedCommand(":SRA", 14, TIMEOUT_SET, CACHE_NONE),          // :SRATTTTTTTTT#
+        formattedCommand(":Sd", 13, TIMEOUT_SET, CACHE_NONE),           // :SdsTTTTTTTT#
+        actionCommand(":MS1#", 1, TIMEOUT_MOTION, CACHE_POSITION | CACHE_STATUS),
+        actionCommand(":MS2#", 1, TIMEOUT_MOTION, CACHE_POSITION | CACHE_STATUS),
+        actionCommand(":CM#", 1, TIMEOUT_MOTION, CACHE_POSITION),
+        actionCommand(":Q#", 1, TIMEOUT_MOTION, CACHE_POSITION | CACHE_STATUS),
+        formattedCommand(":SR", 5, TIMEOUT_SET, CACHE_NONE),            // :SRn#
+        actionCommand(":mn#", 0, TIMEOUT_MOTION, CACHE_POSITION),
+        actionCommand(":ms#", 0, TIMEOUT_MOTION, CACHE_POSITION),
+        actionCommand(":me#", 0, TIMEOUT_MOTION, CACHE_POSITION),
+        actionCommand(":mw#", 0, TIMEOUT_MOTION, CACHE_POSITION),
+        actionCommand(":qD#", 1, TIMEOUT_MOTION, CACHE_POSITION),
+        actionCommand(":qR#", 1, TIMEOUT_MOTION, CACHE_POSITION),
+        guideCommand(":Mn"),                                            // :MnXXXXX# XXXXX ms at the guide rate
+        guideCommand(":Ms"),
+        guideCommand(":Me"),
+        guideCommand(":Mw"),
+        actionCommand(":MH#", 1, TIMEOUT_MOTION, CACHE_POSITION | CACHE_STATUS),
+        actionCommand(":MSH#", 1, TIMEOUT_MOTION, CACHE_POSITION | CACHE_STATUS),
+        actionCommand(":Sa+32400000#", 1, TIMEOUT_SET, CACHE_NONE),
+        actionCommand(":Sz000000000#", 1, TIMEOUT_SET, CACHE_NONE),
+        actionCommand(":MSS#", 1, TIMEOUT_MOTION, CACHE_POSITION | CACHE_STATUS),
+
+        actionCommand(":MP1#", 1, TIMEOUT_MOTION, CACHE_POSITION | CACHE_STATUS),
+        actionCommand(":MP0#", 1, TIMEOUT_MOTION, CACHE_POSITION | CACHE_STATUS),
+        formattedCommand(":SPA", 14, TIMEOUT_SET, CACHE_NONE),          // :SPATTTTTTTTT#
+        formattedCommand(":SPH", 13, TIMEOUT_SET, CACHE_NONE),          // :SPHTTTTTTTT#
+
+        formattedCommand(":SG", 0, TIMEOUT_SET, CACHE_NONE),            // :SGsMMM#, as typed in the settings
+        formattedCommand(":SDS", 6, TIMEOUT_SET, CACHE_NONE),           // :SDSn#
+        formattedCommand(":SLA", 14, TIMEOUT_SET, CACHE_STATUS),        // :SLAsTTTTTTTT#
+        formattedCommand(":SLO", 14, TIMEOUT_SET, CACHE_STATUS),        // :SLOsTTTTTTTT#
+        formattedCommand(":SUT", 18, TIMEOUT_SET, CACHE_NONE),          // :SUTXXXXXXXXXXXXX#
+        formattedCommand(":SMT", 8, TIMEOUT_SET, CACHE_NONE),           // :SMTnnn#, mirrored by the caller
+        formattedCommand(":SAL", 8, TIMEOUT_SET, CACHE_NONE)            // :SALsnn#, mirrored by the caller
+    };
+};
+
+constexpr const iOptronCommand &commandInfo(int nCmdId)
+{
+    return iOptronCommandCatalog::commands[nCmdId];
+}
+
+// catalog entry back to its id
+inline int commandId(const iOptronCommand &command)
+{
+    return (int)(&command - iOptronCommandCatalog::commands);
+}
+
+static_assert(commandInfo(CMD_MOUNT_INFO).nCmdLen == 11, "command lengths are computed at compile time");
@@ -0,0 +1,63 @@
+#include "iOptronModels.h"
+
+// first entry is what unknown codes resolve to
+static constexpr iOptronModel s_Models[] = {
+    //  code    name                    baud    refraction  GPS             EC      query / set / motion timeouts           slew poll
+    {IOPTRON_UNKNOWN_MODEL, "Unsupported Mount", 115200, false, GPS_NOT_FITTED, false, {MAX_TIMEOUT, MAX_TIMEOUT, MAX_TIMEOUT}, 2.0f},
+    {26,    "CEM26",                9600,   false,      GPS_OPTIONAL,   false,  {MAX_TIMEOUT, MAX_TIMEOUT, MAX_TIMEOUT},    2.0f},
+    {27,    "CEM26-EC",             9600,   false,      GPS_OPTIONAL,   true,   {MAX_TIMEOUT, MAX_TIMEOUT, MAX_TIMEOUT},    2.0f},
+    {28,    "GEM28",                9600,   false,      GPS_OPTIONAL,   false,  {MAX_TIMEOUT, MAX_TIMEOUT, MAX_TIMEOUT},    2.0f},
+    {29,    "GEM28-EC",             9600,   false,      GPS_OPTIONAL,   true,   {MAX_TIMEOUT, MAX_TIMEOUT, MAX_TIMEOUT},    2.0f},
+    {30,    "iEQ30 Pro",            9600,   false,      GPS_BUILT_IN,   false,  {MAX_TIMEOUT, MAX_TIMEOUT, MAX_TIMEOUT},    2.0f},
+    {60,    "CEM60",                9600,   false,      GPS_BUILT_IN,   false,  {MAX_TIMEOUT, MAX_TIMEOUT, MAX_TIMEOUT},    2.0f},
+    {61,    "CEM60-EC",             9600,   false,      GPS_BUILT_IN,   true,   {MAX_TIMEOUT, MAX_TIMEOUT, MAX_TIMEOUT},    2.0f},
+    {70,    "CEM70(G)",             9600,   false,      GPS_OPTIONAL,   false,  {MAX_TIMEOUT, MAX_TIMEOUT, MAX_TIMEOUT},    2.0f},
+    {71,    "CEM70(G)-EC",          9600,   false,      GPS_OPTIONAL,   true,   {MAX_TIMEOUT, MAX_TIMEOUT, MAX_TIMEOUT},    2.0f},
+    {120,   "CEM120",               115200, true,       GPS_BUILT_IN,   false,  {MAX_TIMEOUT, MAX_TIMEOUT, MAX_TIMEOUT},    2.0f},
+    {121,   "CEM120-EC",            115200, true,       GPS_BUILT_IN,   true,   {MAX_TIMEOUT, MAX_TIMEOUT, MAX_TIMEOUT},    2.0f},
+    {122,   "CEM120-EC2",           115200, true,       GPS_BUILT_IN,   true,   {MAX_TIMEOUT, MAX_TIMEOUT, MAX_TIMEOUT},    2.0f}
+};
+
+#define IOPTRON_NB_MODELS   (int)(sizeof(s_Models) / sizeof(s_Models[0]))
+
+// model code -> s_Models index, 0 (unknown) for the gaps, 16 codes per line
+static constexpr unsigned char s_ModelIndex[IOPTRON_MODEL_CODE_RANGE] = {
+    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  1,  2,  3,  4,  5,  0,     // 26 - 30 CEM26, GEM28, iEQ30 Pro
+    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  6,  7,  0,  0,     // 60 - 61 CEM60
+    0,  0,  0,  0,  0,  0,  8,  9,  0,  0,  0,  0,  0,  0,  0,  0,     // 70 - 71 CEM70
+    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+    0,  0,  0,  0,  0,  0,  0,  0, 10, 11, 12,  0,  0,  0,  0,  0      // 120 - 122 CEM120
+};
+
+// every model is indexed under its code, and every index entry points at the model with that code
+constexpr bool modelsIndexed(int i)
+{
+    return i >= IOPTRON_NB_MODELS || (s_ModelIndex[s_Models[i].nCode] == i && modelsIndexed(i + 1));
+}
+
+constexpr bool indexMatches(int nCode)
+{
+    return nCode >= IOPTRON_MODEL_CODE_RANGE ||
+           (s_ModelIndex[nCode] < IOPTRON_NB_MODELS && (!s_ModelIndex[nCode] || s_Models[s_ModelIndex[nCode]].nCode == nCode) && indexMatches(nCode + 1));
+}
+
+static_assert(modelsIndexed(1) && indexMatches(0), "s_ModelIndex doesn't match s_Models");
+
+const iOptronModel &mountModel(int nCode)
+{
+    if(nCode < 0 || nCode >= IOPTRON_MODEL_CODE_RANGE)
+        return s_Models[0];
+    return s_Models[s_ModelIndex[nCode]];
+}
+
+const iOptronModel &mountModelFromReply(const char *pszResp)
+{
+    int64_t nCode;
+
+    if(!readUnsignedField(pszResp, 4, 0, 9999, nCode))
+        return s_Models[0];
+    return mountModel((int)nCode);
+}
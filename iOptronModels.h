@@ -0,0 +1,29 @@
+#pragma once
+
+#include "iOptronCommands.h"
+
+// Mount models as reported by :MountInfo#, one descriptor per model.
+// CiOptron resolves the descriptor once when it connects and keeps a pointer to it.
+// The reply timeouts and slew poll interval haven't been characterised per model yet, every model
+// has the same MAX_TIMEOUT and 2 s placeholders until they are measured on the mounts.
+
+enum iOptronGPSHardware {GPS_NOT_FITTED=0, GPS_OPTIONAL, GPS_BUILT_IN};
+
+#define IOPTRON_MODEL_CODE_RANGE    128     // highest known :MountInfo# code is 0122
+#define IOPTRON_UNKNOWN_MODEL       9999
+
+typedef struct {
+    int             nCode;                  // :MountInfo# value
+    const char      *pszName;
+    unsigned long   nDefaultBaud;
+    bool            bRefractionInFirmware;  // the mount corrects for refraction, TSX must not
+    int             nGPS;                   // iOptronGPSHardware
+    bool            bECEncoder;             // high resolution RA encoder (EC / EC2)
+    int             nTimeouts[IOPTRON_NB_TIMEOUT_CLASSES];  // reply timeout in ms of each iOptronTimeoutClass
+    float           fSlewPollInterval;      // seconds between status reads while slewing
+} iOptronModel;
+
+// Descriptor for a model code, the "Unsupported Mount" one if the code is unknown.
+const iOptronModel &mountModel(int nCode);
+// Same from the 4 digit :MountInfo# reply.
+const iOptronModel &mountModelFromReply(const char *pszResp);
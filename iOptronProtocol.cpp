@@ -0,0 +1,314 @@
+#include "iOptronProtocol.h"
+#include "iOptronCommands.h"
+
+constexpr iOptronCommand iOptronCommandCatalog::commands[IOPTRON_NB_COMMANDS];
+
+#pragma mark - response schemas
+// :GEP# “sTTTTTTTTTTTTTTTTnn#”
+static const iOptronFieldSchema s_GEPFields[GEP_NB_FIELDS] = {
+    {0,  9, FIELD_SIGNED,   -32400000, 32400000,    0, CENTI_ARCSEC_TO_DEGREES},    // dec
+    {9,  9, FIELD_UNSIGNED, 0,         129600000,   0, CENTI_ARCSEC_TO_HOURS},      // ra
+    {18, 1, FIELD_DIGIT,    0,         2,           0, 1.0},                        // pier side
+    {19, 1, FIELD_DIGIT,    0,         1,           0, 1.0}                         // counterweight
+};
+
+// :GLS# “sTTTTTTTTTTTTTTTTnnnnnn#”
+static const iOptronFieldSchema s_GLSFields[GLS_NB_FIELDS] = {
+    {0,  9, FIELD_SIGNED,   -64800000, 64800000,    0,          CENTI_ARCSEC_TO_DEGREES},   // longitude
+    {9,  8, FIELD_UNSIGNED, 0,         64800000,    -32400000,  CENTI_ARCSEC_TO_DEGREES},   // latitude, sent +90°
+    {17, 1, FIELD_DIGIT,    0,         2,           0,          1.0},   // GPS status
+    {18, 1, FIELD_DIGIT,    0,         7,           0,          1.0},   // system status
+    {19, 1, FIELD_DIGIT,    0,         4,           0,          1.0},   // tracking rate
+    {20, 1, FIELD_DIGIT,    0,         9,           0,          1.0},   // moving speed
+    {21, 1, FIELD_DIGIT,    0,         3,           0,          1.0},   // time source
+    {22, 1, FIELD_DIGIT,    0,         1,           0,          1.0}    // hemisphere
+};
+
+// :GPC# “TTTTTTTTTTTTTTTTT#”
+static const iOptronFieldSchema s_GPCFields[GPC_NB_FIELDS] = {
+    {0,  8, FIELD_UNSIGNED, 0,         32400000,    0, CENTI_ARCSEC_TO_DEGREES},    // altitude
+    {8,  9, FIELD_UNSIGNED, 0,         129600000,   0, CENTI_ARCSEC_TO_HOURS}       // azimuth, in hours like TSX wants it
+};
+
+// :GUT# “sMMMnYYYYYYYYYYYYY#”
+static const iOptronFieldSchema s_GUTFields[GUT_NB_FIELDS] = {
+    {0,  4, FIELD_SIGNED,   -720,      780,             0, 1.0},    // UTC offset in minutes
+    {4,  1, FIELD_DIGIT,    0,         1,               0, 1.0},    // DST
+    {5, 13, FIELD_UNSIGNED, 0,         9999999999999LL, 0, 1.0}     // ms since J2000
+};
+
+// :GMT# “nnn#”
+static const iOptronFieldSchema s_GMTFields[GMT_NB_FIELDS] = {
+    {0,  1, FIELD_DIGIT,    0,         1,           0, 1.0},    // stop or flip
+    {1,  2, FIELD_UNSIGNED, 0,         99,          0, 1.0}     // degrees past meridian
+};
+
+// :GAL# “snn#”
+static const iOptronFieldSchema s_GALFields[GAL_NB_FIELDS] = {
+    {0,  3, FIELD_SIGNED,   -89,       89,          0, 1.0}     // altitude limit in degrees
+};
+
+static const iOptronQuerySchema s_QuerySchemas[IOPTRON_NB_QUERIES] = {
+    {21, '#', GEP_NB_FIELDS, s_GEPFields},
+    {24, '#', GLS_NB_FIELDS, s_GLSFields},
+    {18, '#', GPC_NB_FIELDS, s_GPCFields},
+    {19, '#', GUT_NB_FIELDS, s_GUTFields},
+    {4,  '#', GMT_NB_FIELDS, s_GMTFields},
+    {4,  '#', GAL_NB_FIELDS, s_GALFields}
+};
+
+const iOptronQuerySchema &querySchema(int nQuery)
+{
+    return s_QuerySchemas[nQuery];
+}
+
+int decodeQueryResponse(int nQuery, const char *pszResp, int64_t *pnFields)
+{
+    int i;
+    int nDigit;
+    const iOptronQuerySchema &query = s_QuerySchemas[nQuery];
+    const iOptronFieldSchema *pField;
+
+    if(pszResp[query.nResponseLen-1] != query.cTerminator)
+        return ERR_PARSE;
+
+    for(i = 0; i < query.nNbFields; i++) {
+        pField = &query.pFields[i];
+        switch(pField->nType) {
+            case FIELD_UNSIGNED:
+                if(!readUnsignedField(pszResp + pField->nOffset, pField->nWidth, pField->nMin, pField->nMax, pnFields[i]))
+                    return ERR_PARSE;
+                break;
+            case FIELD_SIGNED:
+                if(!readSignedField(pszResp + pField->nOffset, pField->nWidth, pField->nMin, pField->nMax, pnFields[i]))
+                    return ERR_PARSE;
+                break;
+            case FIELD_DIGIT:
+                if(!readDigitField(pszResp + pField->nOffset, (int)pField->nMin, (int)pField->nMax, nDigit))
+                    return ERR_PARSE;
+                pnFields[i] = nDigit;
+                break;
+            default:
+                return ERR_PARSE;
+        }
+    }
+    return 0;
+}
+
+#pragma mark - reply parsers
+int parsePositionReply(const char *pszResp, iOptronPositionReply &reply)
+{
+    int64_t nFields[IOPTRON_MAX_QUERY_FIELDS];
+
+    if(decodeQueryResponse(QUERY_GEP, pszResp, nFields))
+        return ERR_PARSE;
+
+    reply.Dec = CCentiArcsec(nFields[GEP_DEC]);
+    reply.Ra = CCentiArcsec(nFields[GEP_RA]);
+    reply.nPierSide = (int)nFields[GEP_PIER_SIDE];
+    reply.nCounterWeight = (int)nFields[GEP_COUNTERWEIGHT];
+    return 0;
+}
+
+int parseStatusReply(const char *pszResp, iOptronStatusReply &reply)
+{
+    int64_t nFields[IOPTRON_MAX_QUERY_FIELDS];
+
+    if(decodeQueryResponse(QUERY_GLS, pszResp, nFields))
+        return ERR_PARSE;
+
+    reply.Long = CCentiArcsec(nFields[GLS_LONG]);
+    reply.Lat = CCentiArcsec(nFields[GLS_LAT] + querySchema(QUERY_GLS).pFields[GLS_LAT].nBias);
+    reply.nGPSStatus = (int)nFields[GLS_GPS_STATUS];
+    reply.nStatus = (int)nFields[GLS_STATUS];
+    reply.nTrackingRate = (int)nFields[GLS_TRACKING_RATE];
+    reply.nTimeSource = (int)nFields[GLS_TIME_SOURCE];
+    return 0;
+}
+
+int parseParkPositionReply(const char *pszResp, CCentiArcsec &Az, CCentiArcsec &Alt)
+{
+    int64_t nFields[IOPTRON_MAX_QUERY_FIELDS];
+
+    if(decodeQueryResponse(QUERY_GPC, pszResp, nFields))
+        return ERR_PARSE;
+
+    Az = CCentiArcsec(nFields[GPC_AZ]);
+    Alt = CCentiArcsec(nFields[GPC_ALT]);
+    return 0;
+}
+
+int parseUtcOffsetReply(const char *pszResp, char *pszUtcOffsetInMins, bool &bDaylight)
+{
+    int64_t nFields[IOPTRON_MAX_QUERY_FIELDS];
+
+    if(decodeQueryResponse(QUERY_GUT, pszResp, nFields))
+        return ERR_PARSE;
+
+    // offset is kept as text, it's what the settings dialog shows and sends back
+    memcpy(pszUtcOffsetInMins, pszResp, 4);
+    pszUtcOffsetInMins[4] = 0;
+    bDaylight = (nFields[GUT_DST] == 1);
+    return 0;
+}
+
+int parseMeridianTreatmentReply(const char *pszResp, int &iBehavior, int &iDegreesPastMeridian)
+{
+    int64_t nFields[IOPTRON_MAX_QUERY_FIELDS];
+
+    if(decodeQueryResponse(QUERY_GMT, pszResp, nFields))
+        return ERR_PARSE;
+
+    iBehavior = (int)nFields[GMT_BEHAVIOR];
+    iDegreesPastMeridian = (int)nFields[GMT_DEGREES_PAST_MERIDIAN];
+    return 0;
+}
+
+int parseAltitudeLimitReply(const char *pszResp, int &iDegreesAltLimit)
+{
+    int64_t nFields[IOPTRON_MAX_QUERY_FIELDS];
+
+    if(decodeQueryResponse(QUERY_GAL, pszResp, nFields))
+        return ERR_PARSE;
+
+    iDegreesAltLimit = (int)nFields[GAL_DEGREES];
+    return 0;
+}
+
+#pragma mark - command formatters
+static int formatCommand(char *pszCmd, int nMaxLen, int nCmdId, int64_t nValue, bool bSigned)
+{
+    const iOptronCommand &command = commandInfo(nCmdId);
+    int nPrefixLen = commandLength(command.pszCmd);
+    int nWidth = command.nCmdLen - nPrefixLen - 1;
+    char *pszEnd;
+
+    if(nWidth < 1 || nMaxLen <= command.nCmdLen)
+        return 0;
+
+    memcpy(pszCmd, command.pszCmd, nPrefixLen);
+    if(bSigned)
+        pszEnd = writeSignedField(pszCmd + nPrefixLen, nWidth, nValue);
+    else
+        pszEnd = writeUnsignedField(pszCmd + nPrefixLen, nWidth, nValue);
+    if(!pszEnd) {
+        pszCmd[0] = 0;
+        return 0;
+    }
+    pszEnd[0] = '#';
+    pszEnd[1] = 0;
+    return command.nCmdLen;
+}
+
+int formatUnsignedCommand(char *pszCmd, int nMaxLen, int nCmdId, int64_t nValue)
+{
+    return formatCommand(pszCmd, nMaxLen, nCmdId, nValue, false);
+}
+
+int formatSignedCommand(char *pszCmd, int nMaxLen, int nCmdId, int64_t nValue)
+{
+    return formatCommand(pszCmd, nMaxLen, nCmdId, nValue, true);
+}
+
+// dValue * dScale rounded to the nearest integer, ties to even, on the exact product.
+// That's how printf rounds "%.Nf", the plain rounded product can land on a tie the real value isn't on.
+static int64_t roundScaled(double dValue, double dScale)
+{
+    double dProduct = dValue * dScale;
+    double dError = fma(dValue, dScale, -dProduct);
+    double dNearest = nearbyint(dProduct);
+
+    if(dProduct - dNearest == 0.5 && dError > 0)
+        dNearest += 1.0;
+    else if(dProduct - dNearest == -0.5 && dError < 0)
+        dNearest -= 1.0;
+    return (int64_t)dNearest;
+}
+
+// :SRATTTTTTTTT#   ra  Valid data range is [0, 129,600,000].
+int formatRaCommand(char *pszCmd, int nMaxLen, const CCentiArcsec &Ra)
+{
+    return formatUnsignedCommand(pszCmd, nMaxLen, CMD_SRA, Ra.raw());
+}
+
+// :SdsTTTTTTTT#    dec  Valid data range is [-32,400,000, +32,400,000].
+int formatDecCommand(char *pszCmd, int nMaxLen, const CCentiArcsec &Dec)
+{
+    return formatSignedCommand(pszCmd, nMaxLen, CMD_SD, Dec.raw());
+}
+
+// “:SPATTTTTTTTT#”
+int formatParkAzCommand(char *pszCmd, int nMaxLen, const CCentiArcsec &Az)
+{
+    return formatUnsignedCommand(pszCmd, nMaxLen, CMD_SPA, Az.raw());
+}
+
+// “:SPHTTTTTTTT#”
+int formatParkAltCommand(char *pszCmd, int nMaxLen, const CCentiArcsec &Alt)
+{
+    return formatUnsignedCommand(pszCmd, nMaxLen, CMD_SPH, Alt.raw());
+}
+
+int64_t customRateValue(double dMountMultiplierRa)
+{
+    // n.nnnn * sidereal rate, without the decimal point
+    return roundScaled(dMountMultiplierRa, 10000.0);
+}
+
+int formatCustomRateCommand(char *pszCmd, int nMaxLen, double dMountMultiplierRa)
+{
+    // :RRnnnnn#
+    return formatUnsignedCommand(pszCmd, nMaxLen, CMD_RR, customRateValue(dMountMultiplierRa));
+}
+
+int formatLatitudeCommand(char *pszCmd, int nMaxLen, const CCentiArcsec &Lat)
+{
+    // “:SLAsTTTTTTTT#”
+    return formatSignedCommand(pszCmd, nMaxLen, CMD_SLA, Lat.raw());
+}
+
+int formatLongitudeCommand(char *pszCmd, int nMaxLen, const CCentiArcsec &Long)
+{
+    // “:SLOsTTTTTTTT#”
+    return formatSignedCommand(pszCmd, nMaxLen, CMD_SLO, Long.raw());
+}
+
+int formatUtcTimeCommand(char *pszCmd, int nMaxLen, double dMsSinceJ2000)
+{
+    // “:SUTXXXXXXXXXXXXX#”, the offset rounded to the ms
+    return formatUnsignedCommand(pszCmd, nMaxLen, CMD_SUT, roundScaled(dMsSinceJ2000, 1.0));
+}
+
+int formatDSTCommand(char *pszCmd, int nMaxLen, bool bDaylight)
+{
+    // “:SDS0#” or “:SDS1#”
+    return formatUnsignedCommand(pszCmd, nMaxLen, CMD_SDS, bDaylight ? 1 : 0);
+}
+
+int formatMoveRateCommand(char *pszCmd, int nMaxLen, int nRate)
+{
+    // :SRn# n=1..7
+    return formatUnsignedCommand(pszCmd, nMaxLen, CMD_SR, nRate);
+}
+
+int formatMeridianTreatmentCommand(char *pszCmd, int nMaxLen, int iBehavior, int iDegreesPastMeridian)
+{
+    // “:SMTnnn#”, behavior digit then 2 digits of degrees past meridian
+    if(iBehavior < 0 || iBehavior > 9 || iDegreesPastMeridian < 0 || iDegreesPastMeridian > 99)
+        return 0;
+    return formatUnsignedCommand(pszCmd, nMaxLen, CMD_SMT, iBehavior * 100 + iDegreesPastMeridian);
+}
+
+int formatAltitudeLimitCommand(char *pszCmd, int nMaxLen, int iDegreesAltLimit)
+{
+    // “:SALsnn#”
+    return formatSignedCommand(pszCmd, nMaxLen, CMD_SAL, iDegreesAltLimit);
+}
+
+int formatGuidePulseCommand(char *pszCmd, int nMaxLen, int nCmdId, int nDurationMs)
+{
+    // “:MnXXXXX#” ... “:MwXXXXX#”, 1 to 99999 ms, 0 would move until stopped
+    if(nCmdId < CMD_GUIDE_N || nCmdId > CMD_GUIDE_W || nDurationMs < 1 || nDurationMs > 99999)
+        return 0;
+    return formatUnsignedCommand(pszCmd, nMaxLen, nCmdId, nDurationMs);
+}
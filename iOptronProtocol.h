@@ -0,0 +1,233 @@
+#pragma once
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+
+// iOptron RS-232 command language V3 codecs.
+// Pure functions, no I/O and no state, so they can be exercised and timed without a mount.
+
+#define ERR_PARSE   1
+
+#define IOPTRON_CMD_BUFFER_SIZE 32  // longest command is :SUTXXXXXXXXXXXXX#
+
+// ---- coordinates ----
+
+// 0.01 arc-second to degrees and to hours
+#define CENTI_ARCSEC_TO_DEGREES (0.01 / 3600.0)
+#define CENTI_ARCSEC_TO_HOURS   (0.01 / 3600.0 * 24.0 / 360.0)
+
+// An angle in the mount's own unit, 0.01 arc-second.
+// All positions are kept in this unit inside the driver and compared as integers,
+// hours and degrees only exist for what is handed to or received from TheSkyX.
+class CCentiArcsec
+{
+public:
+    CCentiArcsec() : m_nValue(0) {}
+    explicit CCentiArcsec(int64_t nValue) : m_nValue(nValue) {}
+
+    // truncated toward zero, like the mount commands have always been built
+    static CCentiArcsec fromHours(double dHours)        { return CCentiArcsec((int64_t)(((dHours / 24.0 * 360.0) * 60.0 * 60.0) / 0.01)); }
+    static CCentiArcsec fromDegrees(double dDegrees)    { return CCentiArcsec((int64_t)((dDegrees * 60.0 * 60.0) / 0.01)); }
+
+    int64_t raw() const         { return m_nValue; }
+    double  hours() const       { return (double)m_nValue * CENTI_ARCSEC_TO_HOURS; }
+    double  degrees() const     { return (double)m_nValue * CENTI_ARCSEC_TO_DEGREES; }
+
+    bool operator==(const CCentiArcsec &other) const    { return m_nValue == other.m_nValue; }
+    bool operator!=(const CCentiArcsec &other) const    { return m_nValue != other.m_nValue; }
+    bool operator<(const CCentiArcsec &other) const     { return m_nValue < other.m_nValue; }
+    bool operator>(const CCentiArcsec &other) const     { return m_nValue > other.m_nValue; }
+    CCentiArcsec operator-(const CCentiArcsec &other) const { return CCentiArcsec(m_nValue - other.m_nValue); }
+
+private:
+    int64_t m_nValue;
+};
+
+// ---- response schemas ----
+
+// Every query reply is described once in s_QuerySchemas (iOptronProtocol.cpp) : length, terminator and fields.
+// The command itself is in the catalog (iOptronCommands.h).
+// decodeQueryResponse() does all the decoding from that table.
+
+enum iOptronQuery {QUERY_GEP=0, QUERY_GLS, QUERY_GPC, QUERY_GUT, QUERY_GMT, QUERY_GAL, IOPTRON_NB_QUERIES};
+
+enum iOptronFieldType {FIELD_UNSIGNED=0, FIELD_SIGNED, FIELD_DIGIT};
+
+// field indexes, in the order of the schema table
+enum iOptronGEPFields {GEP_DEC=0, GEP_RA, GEP_PIER_SIDE, GEP_COUNTERWEIGHT, GEP_NB_FIELDS};
+enum iOptronGLSFields {GLS_LONG=0, GLS_LAT, GLS_GPS_STATUS, GLS_STATUS, GLS_TRACKING_RATE, GLS_MOVING_SPEED, GLS_TIME_SOURCE, GLS_HEMISPHERE, GLS_NB_FIELDS};
+enum iOptronGPCFields {GPC_ALT=0, GPC_AZ, GPC_NB_FIELDS};
+enum iOptronGUTFields {GUT_UTC_OFFSET=0, GUT_DST, GUT_JD_MS, GUT_NB_FIELDS};
+enum iOptronGMTFields {GMT_BEHAVIOR=0, GMT_DEGREES_PAST_MERIDIAN, GMT_NB_FIELDS};
+enum iOptronGALFields {GAL_DEGREES=0, GAL_NB_FIELDS};
+
+#define IOPTRON_MAX_QUERY_FIELDS    8
+
+typedef struct {
+    int         nOffset;
+    int         nWidth;         // sign included for FIELD_SIGNED
+    int         nType;          // iOptronFieldType
+    int64_t     nMin;           // valid range of the raw value
+    int64_t     nMax;
+    int64_t     nBias;          // natural value = (raw + nBias) * dScale
+    double      dScale;
+} iOptronFieldSchema;
+
+typedef struct {
+    int                         nResponseLen;   // terminator included, same as the command catalog reply length
+    char                        cTerminator;
+    int                         nNbFields;
+    const iOptronFieldSchema    *pFields;
+} iOptronQuerySchema;
+
+const iOptronQuerySchema &querySchema(int nQuery);
+
+// Check the terminator and decode all fields of the reply to nQuery into pnFields (IOPTRON_MAX_QUERY_FIELDS entries).
+// Returns ERR_PARSE if anything is malformed or out of range, pnFields is then undefined.
+int decodeQueryResponse(int nQuery, const char *pszResp, int64_t *pnFields);
+
+// raw field value converted with the schema bias and scale
+inline double queryFieldValue(int nQuery, int nField, const int64_t *pnFields)
+{
+    const iOptronFieldSchema &field = querySchema(nQuery).pFields[nField];
+    return (double)(pnFields[nField] + field.nBias) * field.dScale;
+}
+
+// :GEP# reply, current position
+typedef struct {
+    CCentiArcsec    Ra;
+    CCentiArcsec    Dec;
+    int             nPierSide;      // iOptronPierStatus
+    int             nCounterWeight; // iOptronCounterWeightStatus
+} iOptronPositionReply;
+
+// :GLS# reply, location and status
+typedef struct {
+    CCentiArcsec    Long;
+    CCentiArcsec    Lat;    // bias removed, north positive
+    int     nGPSStatus;     // iOptronGPSStatus
+    int     nStatus;        // iOptronStatus
+    int     nTrackingRate;  // iOptronTrackingRate
+    int     nTimeSource;    // iOptronTimeSource
+} iOptronStatusReply;
+
+// ---- fixed width fields ----
+
+// Read straight from the response bytes, no copy and no locale dependent libc call.
+// Return false if a character isn't a digit (or sign) or if the value is out of [nMin, nMax].
+
+inline bool readUnsignedField(const char *pszField, int nWidth, int64_t nMin, int64_t nMax, int64_t &nValue)
+{
+    int i;
+    int64_t nAcc = 0;
+
+    for(i = 0; i < nWidth; i++) {
+        if(pszField[i] < '0' || pszField[i] > '9')
+            return false;
+        nAcc = nAcc * 10 + (pszField[i] - '0');
+    }
+    if(nAcc < nMin || nAcc > nMax)
+        return false;
+    nValue = nAcc;
+    return true;
+}
+
+// first character is the sign, '+' or '-', the width includes it
+inline bool readSignedField(const char *pszField, int nWidth, int64_t nMin, int64_t nMax, int64_t &nValue)
+{
+    int64_t nAcc;
+
+    if(nWidth < 2 || (pszField[0] != '+' && pszField[0] != '-'))
+        return false;
+    if(!readUnsignedField(pszField+1, nWidth-1, 0, INT64_MAX, nAcc))
+        return false;
+    if(pszField[0] == '-')
+        nAcc = -nAcc;
+    if(nAcc < nMin || nAcc > nMax)
+        return false;
+    nValue = nAcc;
+    return true;
+}
+
+inline bool readDigitField(const char *pszField, int nMin, int nMax, int &nValue)
+{
+    int nDigit;
+
+    if(pszField[0] < '0' || pszField[0] > '9')
+        return false;
+    nDigit = pszField[0] - '0';
+    if(nDigit < nMin || nDigit > nMax)
+        return false;
+    nValue = nDigit;
+    return true;
+}
+
+// single byte “1” / “0” command acknowledgements, 0 if it's not a digit (same as atoi did)
+inline int parseDigitReply(const char *pszResp)
+{
+    return (pszResp[0] >= '0' && pszResp[0] <= '9') ? pszResp[0] - '0' : 0;
+}
+
+// ---- fixed width field encoders ----
+
+// Write straight into the command buffer, same bytes as printf "%0*d" / "%+0*d" for a value that fits.
+// Return the position after the field, NULL if the value doesn't fit in nWidth.
+
+inline char *writeUnsignedField(char *pszField, int nWidth, int64_t nValue)
+{
+    int i;
+
+    if(nValue < 0)
+        return NULL;
+    for(i = nWidth-1; i >= 0; i--) {
+        pszField[i] = (char)('0' + nValue % 10);
+        nValue /= 10;
+    }
+    return nValue ? NULL : pszField + nWidth;
+}
+
+// sign always written, the width includes it
+inline char *writeSignedField(char *pszField, int nWidth, int64_t nValue)
+{
+    if(nWidth < 2)
+        return NULL;
+    pszField[0] = nValue < 0 ? '-' : '+';
+    return writeUnsignedField(pszField+1, nWidth-1, nValue < 0 ? -nValue : nValue);
+}
+
+// ---- replies ----
+
+// Typed views over decodeQueryResponse(), pszResp must hold at least the schema response length.
+// Return ERR_PARSE and leave the output untouched if a field is malformed or out of range.
+int parsePositionReply(const char *pszResp, iOptronPositionReply &reply);
+int parseStatusReply(const char *pszResp, iOptronStatusReply &reply);
+int parseParkPositionReply(const char *pszResp, CCentiArcsec &Az, CCentiArcsec &Alt);
+int parseUtcOffsetReply(const char *pszResp, char *pszUtcOffsetInMins, bool &bDaylight); // pszUtcOffsetInMins gets 4 chars + null
+int parseMeridianTreatmentReply(const char *pszResp, int &iBehavior, int &iDegreesPastMeridian);
+int parseAltitudeLimitReply(const char *pszResp, int &iDegreesAltLimit);
+
+// ---- commands ----
+
+// Catalog prefix of nCmdId, one integer field filling the rest of the catalog length, and the '#'.
+// Return the command length, 0 if the value doesn't fit the field or nMaxLen is too small.
+int formatUnsignedCommand(char *pszCmd, int nMaxLen, int nCmdId, int64_t nValue);
+int formatSignedCommand(char *pszCmd, int nMaxLen, int nCmdId, int64_t nValue);
+
+// Typed formatters, byte for byte what the old snprintf calls produced.
+// Return the command length, 0 if the value can't be sent.
+int formatRaCommand(char *pszCmd, int nMaxLen, const CCentiArcsec &Ra);
+int formatDecCommand(char *pszCmd, int nMaxLen, const CCentiArcsec &Dec);
+int formatParkAzCommand(char *pszCmd, int nMaxLen, const CCentiArcsec &Az);
+int formatParkAltCommand(char *pszCmd, int nMaxLen, const CCentiArcsec &Alt);
+int formatCustomRateCommand(char *pszCmd, int nMaxLen, double dMountMultiplierRa);
+int64_t customRateValue(double dMountMultiplierRa);     // what :RR sends, two multipliers with the same value are the same rate for the mount
+int formatLatitudeCommand(char *pszCmd, int nMaxLen, const CCentiArcsec &Lat);
+int formatLongitudeCommand(char *pszCmd, int nMaxLen, const CCentiArcsec &Long);
+int formatUtcTimeCommand(char *pszCmd, int nMaxLen, double dMsSinceJ2000);
+int formatDSTCommand(char *pszCmd, int nMaxLen, bool bDaylight);
+int formatMoveRateCommand(char *pszCmd, int nMaxLen, int nRate);
+int formatMeridianTreatmentCommand(char *pszCmd, int nMaxLen, int iBehavior, int iDegreesPastMeridian);
+int formatAltitudeLimitCommand(char *pszCmd, int nMaxLen, int iDegreesAltLimit);
+int formatGuidePulseCommand(char *pszCmd, int nMaxLen, int nCmdId, int nDurationMs);   // CMD_GUIDE_N .. CMD_GUIDE_W
@@ -0,0 +1,329 @@
+// Command encoders checked byte for byte against the snprintf formats they replaced, and replies
+// decoded back to the values they were built from. Built and run by make test.
+
+#include <math.h>
+#include <string.h>
+
+#include "TestCheck.h"
+#include "iOptronProtocol.h"
+#include "iOptronCommands.h"
+
+#define RANDOM_VALUES   200000
+
+static uint64_t s_nRandom = 0x2545F4914F6CDD1DULL;
+
+static uint64_t nextRandom()
+{
+    s_nRandom ^= s_nRandom << 13;
+    s_nRandom ^= s_nRandom >> 7;
+    s_nRandom ^= s_nRandom << 17;
+    return s_nRandom;
+}
+
+// uniform in [dMin, dMax)
+static double randomDouble(double dMin, double dMax)
+{
+    return dMin + (double)(nextRandom() >> 11) / 9007199254740992.0 * (dMax - dMin);
+}
+
+static int64_t randomInt(int64_t nMin, int64_t nMax)
+{
+    return nMin + (int64_t)(nextRandom() % (uint64_t)(nMax - nMin + 1));
+}
+
+// pszExpected is what the old code sent, pszCmd / nLen what the encoder wrote
+static void checkSame(const char *pszWhat, const char *pszCmd, int nLen, const char *pszExpected)
+{
+    if(nLen != (int)strlen(pszExpected) || strcmp(pszCmd, pszExpected)) {
+        fprintf(stderr, "%s : \"%s\" (%d), snprintf \"%s\"\n", pszWhat, nLen ? pszCmd : "", nLen, pszExpected);
+        testFailures()++;
+    }
+}
+
+// the field of a formatted command read back with the reply field readers
+static bool readCommandField(const char *pszCmd, int nCmdId, bool bSigned, int64_t &nValue)
+{
+    const iOptronCommand &command = commandInfo(nCmdId);
+    int nPrefixLen = commandLength(command.pszCmd);
+    int nWidth = command.nCmdLen - nPrefixLen - 1;
+
+    if(pszCmd[command.nCmdLen - 1] != '#' || pszCmd[command.nCmdLen] != 0)
+        return false;
+    if(bSigned)
+        return readSignedField(pszCmd + nPrefixLen, nWidth, INT64_MIN + 1, INT64_MAX, nValue);
+    return readUnsignedField(pszCmd + nPrefixLen, nWidth, 0, INT64_MAX, nValue);
+}
+
+#pragma mark - encoders
+static void testPositionCommands()
+{
+    char szCmd[IOPTRON_CMD_BUFFER_SIZE];
+    char szOld[IOPTRON_CMD_BUFFER_SIZE];
+    double dHours, dDegrees;
+    int64_t nValue;
+    int nLen;
+    int i;
+
+    for(i = 0; i < RANDOM_VALUES; i++) {
+        dHours = i < 24 ? (double)i : randomDouble(0.0, 24.0);
+        nLen = formatRaCommand(szCmd, sizeof(szCmd), CCentiArcsec::fromHours(dHours));
+        snprintf(szOld, sizeof(szOld), ":SRA%09d#", int(((dHours / 24.0 * 360.0) * 60.0 * 60.0) / 0.01));
+        checkSame("formatRaCommand", szCmd, nLen, szOld);
+        TEST_CHECK(readCommandField(szCmd, CMD_SRA, false, nValue) && nValue == CCentiArcsec::fromHours(dHours).raw());
+
+        dDegrees = i < 181 ? (double)(i - 90) : randomDouble(-90.0, 90.0);
+        nLen = formatDecCommand(szCmd, sizeof(szCmd), CCentiArcsec::fromDegrees(dDegrees));
+        snprintf(szOld, sizeof(szOld), ":Sd%+09d#", int((dDegrees * 60.0 * 60.0) / 0.01));
+        checkSame("formatDecCommand", szCmd, nLen, szOld);
+        TEST_CHECK(readCommandField(szCmd, CMD_SD, true, nValue) && nValue == CCentiArcsec::fromDegrees(dDegrees).raw());
+
+        nValue = randomInt(0, 129600000);
+        nLen = formatParkAzCommand(szCmd, sizeof(szCmd), CCentiArcsec(nValue));
+        snprintf(szOld, sizeof(szOld), ":SPA%09d#", int(nValue));
+        checkSame("formatParkAzCommand", szCmd, nLen, szOld);
+
+        nValue = randomInt(0, 32400000);
+        nLen = formatParkAltCommand(szCmd, sizeof(szCmd), CCentiArcsec(nValue));
+        snprintf(szOld, sizeof(szOld), ":SPH%08d#", int(nValue));
+        checkSame("formatParkAltCommand", szCmd, nLen, szOld);
+
+        nValue = randomInt(-32400000, 32400000);
+        nLen = formatLatitudeCommand(szCmd, sizeof(szCmd), CCentiArcsec(nValue));
+        snprintf(szOld, sizeof(szOld), ":SLA%+09d#", int(nValue));
+        checkSame("formatLatitudeCommand", szCmd, nLen, szOld);
+
+        nValue = randomInt(-64800000, 64800000);
+        nLen = formatLongitudeCommand(szCmd, sizeof(szCmd), CCentiArcsec(nValue));
+        snprintf(szOld, sizeof(szOld), ":SLO%+09d#", int(nValue));
+        checkSame("formatLongitudeCommand", szCmd, nLen, szOld);
+    }
+
+    // range ends, the sign of zero, values that don't fit
+    nLen = formatDecCommand(szCmd, sizeof(szCmd), CCentiArcsec(0));
+    checkSame("formatDecCommand", szCmd, nLen, ":Sd+00000000#");
+    nLen = formatDecCommand(szCmd, sizeof(szCmd), CCentiArcsec(-32400000));
+    checkSame("formatDecCommand", szCmd, nLen, ":Sd-32400000#");
+    nLen = formatLongitudeCommand(szCmd, sizeof(szCmd), CCentiArcsec(-64800000));
+    checkSame("formatLongitudeCommand", szCmd, nLen, ":SLO-64800000#");
+    TEST_CHECK_EQUAL(formatRaCommand(szCmd, sizeof(szCmd), CCentiArcsec(-1)), 0);
+    TEST_CHECK_EQUAL(formatRaCommand(szCmd, sizeof(szCmd), CCentiArcsec(1000000000)), 0);
+    TEST_CHECK_EQUAL(formatDecCommand(szCmd, sizeof(szCmd), CCentiArcsec(100000000)), 0);
+    TEST_CHECK_EQUAL(formatParkAltCommand(szCmd, sizeof(szCmd), CCentiArcsec(100000000)), 0);
+    TEST_CHECK_EQUAL(formatRaCommand(szCmd, 14, CCentiArcsec(0)), 0);    // no room for the null
+}
+
+// ":RR%1.4f#" with the decimal point taken out, as the old code did
+static void oldCustomRateCommand(char *pszCmd, int nMaxLen, double dMountMultiplierRa)
+{
+    char szTmp[16];
+
+    memset(szTmp, 0, sizeof(szTmp));
+    snprintf(szTmp, sizeof(szTmp), ":RR%1.4f#", dMountMultiplierRa);
+    memset(pszCmd, 0, nMaxLen);
+    memcpy(pszCmd, szTmp, 4);
+    memcpy(pszCmd + 4, szTmp + 5, 5);
+}
+
+static void testCustomRateCommand()
+{
+    char szCmd[IOPTRON_CMD_BUFFER_SIZE];
+    char szOld[IOPTRON_CMD_BUFFER_SIZE];
+    double dRate;
+    int64_t nValue;
+    int nLen;
+    int i;
+
+    for(i = 0; i < RANDOM_VALUES; i++) {
+        switch(i % 4) {
+            case 0:     // anywhere
+                dRate = randomDouble(0.0, 9.9999);
+                break;
+            case 1:     // on a step
+                dRate = (double)randomInt(0, 99999) / 10000.0;
+                break;
+            case 2:     // on a printf rounding tie, or a double next to it
+                dRate = nextafter(((double)randomInt(0, 99998) + 0.5) / 10000.0, (i & 8) ? INFINITY : -INFINITY);
+                break;
+            default:
+                dRate = ((double)randomInt(0, 99998) + 0.5) / 10000.0;
+                break;
+        }
+        nLen = formatCustomRateCommand(szCmd, sizeof(szCmd), dRate);
+        oldCustomRateCommand(szOld, sizeof(szOld), dRate);
+        checkSame("formatCustomRateCommand", szCmd, nLen, szOld);
+        TEST_CHECK(readCommandField(szCmd, CMD_RR, false, nValue) && nValue == customRateValue(dRate));
+    }
+    TEST_CHECK_EQUAL(formatCustomRateCommand(szCmd, sizeof(szCmd), 10.0), 0);
+    TEST_CHECK_EQUAL(formatCustomRateCommand(szCmd, sizeof(szCmd), -0.5), 0);
+}
+
+static void testTimeCommands()
+{
+    char szCmd[IOPTRON_CMD_BUFFER_SIZE];
+    char szOld[IOPTRON_CMD_BUFFER_SIZE];
+    double dMs;
+    int64_t nValue;
+    int nLen;
+    int i;
+
+    for(i = 0; i < RANDOM_VALUES; i++) {
+        switch(i % 3) {
+            case 0:
+                dMs = randomDouble(0.0, 2.0e12);
+                break;
+            case 1:     // half ms, printf rounds those to even
+                dMs = (double)randomInt(0, 2000000000000LL) + 0.5;
+                break;
+            default:
+                dMs = nextafter((double)randomInt(0, 2000000000000LL) + 0.5, (i & 4) ? INFINITY : -INFINITY);
+                break;
+        }
+        nLen = formatUtcTimeCommand(szCmd, sizeof(szCmd), dMs);
+        snprintf(szOld, sizeof(szOld), ":SUT%013.0f#", dMs);
+        checkSame("formatUtcTimeCommand", szCmd, nLen, szOld);
+        TEST_CHECK(readCommandField(szCmd, CMD_SUT, false, nValue));
+    }
+
+    nLen = formatDSTCommand(szCmd, sizeof(szCmd), true);
+    snprintf(szOld, sizeof(szOld), ":SDS%.1d#", 1);
+    checkSame("formatDSTCommand", szCmd, nLen, szOld);
+    nLen = formatDSTCommand(szCmd, sizeof(szCmd), false);
+    snprintf(szOld, sizeof(szOld), ":SDS%.1d#", 0);
+    checkSame("formatDSTCommand", szCmd, nLen, szOld);
+}
+
+static void testSettingCommands()
+{
+    char szCmd[IOPTRON_CMD_BUFFER_SIZE];
+    char szOld[IOPTRON_CMD_BUFFER_SIZE];
+    int nLen;
+    int i, j;
+
+    for(i = 1; i <= 9; i++) {
+        nLen = formatMoveRateCommand(szCmd, sizeof(szCmd), i);
+        snprintf(szOld, sizeof(szOld), ":SR%1d#", i);
+        checkSame("formatMoveRateCommand", szCmd, nLen, szOld);
+    }
+    for(i = 0; i <= 9; i++) {
+        for(j = 0; j <= 99; j++) {
+            nLen = formatMeridianTreatmentCommand(szCmd, sizeof(szCmd), i, j);
+            snprintf(szOld, sizeof(szOld), ":SMT%.1d%02d#", i, j);
+            checkSame("formatMeridianTreatmentCommand", szCmd, nLen, szOld);
+        }
+    }
+    for(i = -99; i <= 99; i++) {
+        nLen = formatAltitudeLimitCommand(szCmd, sizeof(szCmd), i);
+        snprintf(szOld, sizeof(szOld), ":SAL%+.2d#", i);
+        checkSame("formatAltitudeLimitCommand", szCmd, nLen, szOld);
+    }
+    for(i = 1; i <= 99999; i += 7) {
+        nLen = formatGuidePulseCommand(szCmd, sizeof(szCmd), CMD_GUIDE_W, i);
+        snprintf(szOld, sizeof(szOld), ":Mw%05d#", i);
+        checkSame("formatGuidePulseCommand", szCmd, nLen, szOld);
+    }
+
+    // the old formats would have sent these with a wrong length
+    TEST_CHECK_EQUAL(formatMoveRateCommand(szCmd, sizeof(szCmd), 10), 0);
+    TEST_CHECK_EQUAL(formatMeridianTreatmentCommand(szCmd, sizeof(szCmd), 1, 100), 0);
+    TEST_CHECK_EQUAL(formatAltitudeLimitCommand(szCmd, sizeof(szCmd), 100), 0);
+    TEST_CHECK_EQUAL(formatGuidePulseCommand(szCmd, sizeof(szCmd), CMD_GUIDE_N, 0), 0);
+    TEST_CHECK_EQUAL(formatGuidePulseCommand(szCmd, sizeof(szCmd), CMD_GUIDE_N, 100000), 0);
+    TEST_CHECK_EQUAL(formatGuidePulseCommand(szCmd, sizeof(szCmd), CMD_SRA, 100), 0);
+}
+
+#pragma mark - decoders
+static void testReplyRoundTrip()
+{
+    char szResp[32];
+    iOptronPositionReply position;
+    iOptronStatusReply status;
+    CCentiArcsec Az, Alt;
+    char szOffset[5];
+    bool bDaylight;
+    int64_t nRa, nDec, nLong, nLat, nAlt, nAz, nMs;
+    int nPier, nWeight, nGPS, nStatus, nRate, nSource, nOffset, nBehavior, nDegrees;
+    int i;
+
+    for(i = 0; i < RANDOM_VALUES / 10; i++) {
+        nDec = randomInt(-32400000, 32400000);
+        nRa = randomInt(0, 129600000);
+        nPier = (int)randomInt(0, 2);
+        nWeight = (int)randomInt(0, 1);
+        snprintf(szResp, sizeof(szResp), "%+09lld%09lld%d%d#", (long long)nDec, (long long)nRa, nPier, nWeight);
+        TEST_CHECK_EQUAL(parsePositionReply(szResp, position), 0);
+        TEST_CHECK(position.Ra.raw() == nRa && position.Dec.raw() == nDec && position.nPierSide == nPier && position.nCounterWeight == nWeight);
+
+        nLong = randomInt(-64800000, 64800000);
+        nLat = randomInt(-32400000, 32400000);
+        nGPS = (int)randomInt(0, 2);
+        nStatus = (int)randomInt(0, 7);
+        nRate = (int)randomInt(0, 4);
+        nSource = (int)randomInt(0, 3);
+        snprintf(szResp, sizeof(szResp), "%+09lld%08lld%d%d%d%d%d%d#", (long long)nLong, (long long)(nLat + 32400000), nGPS, nStatus, nRate, 5, nSource, nLat >= 0 ? 1 : 0);
+        TEST_CHECK_EQUAL(parseStatusReply(szResp, status), 0);
+        TEST_CHECK(status.Long.raw() == nLong && status.Lat.raw() == nLat && status.nGPSStatus == nGPS && status.nStatus == nStatus &&
+                   status.nTrackingRate == nRate && status.nTimeSource == nSource);
+
+        nAlt = randomInt(0, 32400000);
+        nAz = randomInt(0, 129600000);
+        snprintf(szResp, sizeof(szResp), "%08lld%09lld#", (long long)nAlt, (long long)nAz);
+        TEST_CHECK_EQUAL(parseParkPositionReply(szResp, Az, Alt), 0);
+        TEST_CHECK(Az.raw() == nAz && Alt.raw() == nAlt);
+
+        nOffset = (int)randomInt(-720, 780);
+        nMs = randomInt(0, 9999999999999LL);
+        snprintf(szResp, sizeof(szResp), "%+04d%d%013lld#", nOffset, i & 1, (long long)nMs);
+        TEST_CHECK_EQUAL(parseUtcOffsetReply(szResp, szOffset, bDaylight), 0);
+        TEST_CHECK(atoi(szOffset) == nOffset && bDaylight == ((i & 1) != 0));
+    }
+
+    for(nBehavior = 0; nBehavior <= 1; nBehavior++) {
+        for(nDegrees = 0; nDegrees <= 99; nDegrees++) {
+            int iBehavior, iDegrees;
+            snprintf(szResp, sizeof(szResp), "%d%02d#", nBehavior, nDegrees);
+            TEST_CHECK_EQUAL(parseMeridianTreatmentReply(szResp, iBehavior, iDegrees), 0);
+            TEST_CHECK(iBehavior == nBehavior && iDegrees == nDegrees);
+        }
+    }
+    for(nDegrees = -89; nDegrees <= 89; nDegrees++) {
+        int iDegrees;
+        snprintf(szResp, sizeof(szResp), "%+03d#", nDegrees);
+        TEST_CHECK_EQUAL(parseAltitudeLimitReply(szResp, iDegrees), 0);
+        TEST_CHECK_EQUAL(iDegrees, nDegrees);
+    }
+}
+
+// malformed or out of range replies are refused and the outputs left alone
+static void testBadReplies()
+{
+    iOptronPositionReply position;
+    iOptronStatusReply status;
+    int iDegrees = 42;
+
+    position.Ra = CCentiArcsec(7);
+    TEST_CHECK_EQUAL(parsePositionReply("+16200000064800000" "11*", position), ERR_PARSE);     // terminator
+    TEST_CHECK_EQUAL(parsePositionReply("+1620000006480000x" "11#", position), ERR_PARSE);     // not a digit
+    TEST_CHECK_EQUAL(parsePositionReply(" 16200000064800000" "11#", position), ERR_PARSE);     // no sign
+    TEST_CHECK_EQUAL(parsePositionReply("+32400001064800000" "11#", position), ERR_PARSE);     // dec past the pole
+    TEST_CHECK_EQUAL(parsePositionReply("+16200000129600001" "11#", position), ERR_PARSE);     // ra past 24h
+    TEST_CHECK_EQUAL(parsePositionReply("+16200000064800000" "31#", position), ERR_PARSE);     // pier side
+    TEST_CHECK_EQUAL(position.Ra.raw(), 7);
+    TEST_CHECK_EQUAL(parseStatusReply("-26460000" "48780000" "280131#", status), ERR_PARSE);   // status 8
+    TEST_CHECK_EQUAL(parseStatusReply("-26460000" "64800001" "210131#", status), ERR_PARSE);   // latitude
+    TEST_CHECK_EQUAL(parseAltitudeLimitReply("+90#", iDegrees), ERR_PARSE);
+    TEST_CHECK_EQUAL(parseAltitudeLimitReply("05#", iDegrees), ERR_PARSE);
+    TEST_CHECK_EQUAL(iDegrees, 42);
+    TEST_CHECK_EQUAL(parseDigitReply("1"), 1);
+    TEST_CHECK_EQUAL(parseDigitReply("x"), 0);
+}
+
+int main()
+{
+    testPositionCommands();
+    testCustomRateCommand();
+    testTimeCommands();
+    testSettingCommands();
+    testReplyRoundTrip();
+    testBadReplies();
+    return testResult("iOptronProtocolTest");
+}
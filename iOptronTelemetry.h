@@ -0,0 +1,80 @@
+/*
+ * Mount telemetry the iOptronV3 X2 plugin publishes in POSIX shared memory, for processes other than
+ * TheSkyX (dome, guider, safety monitor) that need the mount state without going through TheSkyX
+ * or the serial link.
+ *
+ * Plain C, shared by the plugin (writer) and iOptronTelemetryReader.c (readers).
+ * The segment is a seqlock : the writer makes nSequence odd, updates Data, then makes it even again.
+ * Readers copy Data between two reads of an even, unchanged nSequence, they never block the writer
+ * and take no lock.
+ */
+#ifndef IOPTRON_TELEMETRY_H
+#define IOPTRON_TELEMETRY_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define IOPTRON_TELEMETRY_NAME_FORMAT   "/iOptronV3.telemetry.%d"   /* X2 instance index */
+#define IOPTRON_TELEMETRY_NAME_SIZE     32
+#define IOPTRON_TELEMETRY_MAGIC         0x5450496FU                 /* "oIPT" */
+#define IOPTRON_TELEMETRY_VERSION       1
+
+typedef struct {
+    int32_t     bConnected;
+    int32_t     nModelCode;             /* :MountInfo# code */
+    /* last :GEP# */
+    int64_t     nRaCentiArcsec;         /* raw, 0.01 arcsec */
+    int64_t     nDecCentiArcsec;
+    double      dRaHours;
+    double      dDecDegrees;
+    int32_t     nPierSide;              /* iOptronPierStatus */
+    int32_t     nCounterWeight;         /* iOptronCounterWeightStatus */
+    /* last :GLS# */
+    int32_t     nStatus;                /* iOptronStatus */
+    int32_t     nTrackingRate;          /* iOptronTrackingRate */
+    int32_t     nGPSStatus;             /* iOptronGPSStatus */
+    int32_t     nTimeSource;            /* iOptronTimeSource */
+    int32_t     bParked;
+    int32_t     nReserved;
+    double      dLatitude;              /* degrees, north positive */
+    double      dLongitude;             /* degrees, east positive */
+    /* limits */
+    int32_t     nAltitudeLimit;         /* degrees */
+    int32_t     nDegreesPastMeridian;
+    /* link */
+    int32_t     nLinkHealth;            /* 0-100 */
+    int32_t     nReserved2;
+    /* CLOCK_MONOTONIC (mach_absolute_time on macOS) nanoseconds of the reads from the mount, 0 = never */
+    int64_t     nPositionTimeNs;
+    int64_t     nStatusTimeNs;
+} iOptronTelemetryData;
+
+typedef struct {
+    uint32_t                nMagic;
+    uint32_t                nVersion;
+    uint32_t                nSize;          /* sizeof(iOptronTelemetrySegment) */
+    uint32_t                nReserved;
+    uint64_t                nSequence;      /* odd while Data is being written */
+    iOptronTelemetryData    Data;
+} iOptronTelemetrySegment;
+
+/* Reader library, iOptronTelemetryReader.c */
+typedef struct iOptronTelemetryReader iOptronTelemetryReader;
+
+/* 0 or errno (ENOENT until the plugin publishes, EAGAIN while it is still setting the segment up,
+   EPROTO for a layout version mismatch) */
+int     iOptronTelemetryOpen(int nInstance, iOptronTelemetryReader **ppReader);
+/* consistent copy of the latest data, 0 or EAGAIN if the writer kept it busy */
+int     iOptronTelemetryRead(iOptronTelemetryReader *pReader, iOptronTelemetryData *pData);
+/* same clock as the nXxxTimeNs fields, to compute the age of the data */
+int64_t iOptronTelemetryNowNs(void);
+void    iOptronTelemetryClose(iOptronTelemetryReader *pReader);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
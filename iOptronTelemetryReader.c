@@ -0,0 +1,115 @@
+/*
+ * Lock free reader of the iOptronV3 telemetry segment, see iOptronTelemetry.h.
+ * Built as libiOptronV3Telemetry.a by the Makefile, link with -lrt on older Linux.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#if defined(__APPLE__)
+#include <mach/mach_time.h>
+#endif
+
+#include "iOptronTelemetry.h"
+
+#define IOPTRON_TELEMETRY_READ_TRIES    1000
+
+struct iOptronTelemetryReader {
+    const iOptronTelemetrySegment   *pSegment;
+};
+
+int iOptronTelemetryOpen(int nInstance, iOptronTelemetryReader **ppReader)
+{
+    char szName[IOPTRON_TELEMETRY_NAME_SIZE];
+    int nFd;
+    struct stat st;
+    void *pMap;
+    uint32_t nMagic;
+    const iOptronTelemetrySegment *pSegment;
+    iOptronTelemetryReader *pReader;
+
+    *ppReader = NULL;
+    snprintf(szName, sizeof(szName), IOPTRON_TELEMETRY_NAME_FORMAT, nInstance);
+    nFd = shm_open(szName, O_RDONLY, 0);
+    if(nFd < 0)
+        return errno;
+    /* the plugin sizes the segment right after creating it */
+    if(fstat(nFd, &st) < 0 || st.st_size < (off_t)sizeof(iOptronTelemetrySegment)) {
+        close(nFd);
+        return EAGAIN;
+    }
+    pMap = mmap(NULL, sizeof(iOptronTelemetrySegment), PROT_READ, MAP_SHARED, nFd, 0);
+    close(nFd);
+    if(pMap == MAP_FAILED)
+        return errno;
+
+    pSegment = (const iOptronTelemetrySegment *)pMap;
+    /* the plugin stores the magic last, once the header is filled in */
+    nMagic = __atomic_load_n(&pSegment->nMagic, __ATOMIC_ACQUIRE);
+    if(nMagic == 0) {
+        munmap(pMap, sizeof(iOptronTelemetrySegment));
+        return EAGAIN;
+    }
+    if(nMagic != IOPTRON_TELEMETRY_MAGIC || pSegment->nVersion != IOPTRON_TELEMETRY_VERSION || pSegment->nSize != sizeof(iOptronTelemetrySegment)) {
+        munmap(pMap, sizeof(iOptronTelemetrySegment));
+        return EPROTO;
+    }
+
+    pReader = (iOptronTelemetryReader *)malloc(sizeof(iOptronTelemetryReader));
+    if(!pReader) {
+        munmap(pMap, sizeof(iOptronTelemetrySegment));
+        return ENOMEM;
+    }
+    pReader->pSegment = pSegment;
+    *ppReader = pReader;
+    return 0;
+}
+
+int iOptronTelemetryRead(iOptronTelemetryReader *pReader, iOptronTelemetryData *pData)
+{
+    uint64_t nBefore;
+    uint64_t nAfter;
+    int nTry;
+
+    for(nTry = 0; nTry < IOPTRON_TELEMETRY_READ_TRIES; nTry++) {
+        nBefore = __atomic_load_n(&pReader->pSegment->nSequence, __ATOMIC_ACQUIRE);
+        if(nBefore & 1)
+            continue;   /* being written */
+        memcpy(pData, (const void *)&pReader->pSegment->Data, sizeof(iOptronTelemetryData));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        nAfter = __atomic_load_n(&pReader->pSegment->nSequence, __ATOMIC_RELAXED);
+        if(nAfter == nBefore)
+            return 0;
+    }
+    return EAGAIN;
+}
+
+int64_t iOptronTelemetryNowNs(void)
+{
+#if defined(__APPLE__)
+    static mach_timebase_info_data_t timebase = {0, 0};
+    uint64_t nTicks = mach_absolute_time();
+
+    if(timebase.denom == 0)
+        mach_timebase_info(&timebase);
+    return (int64_t)((nTicks / timebase.denom) * timebase.numer + ((nTicks % timebase.denom) * timebase.numer) / timebase.denom);
+#else
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)now.tv_sec * 1000000000LL + now.tv_nsec;
+#endif
+}
+
+void iOptronTelemetryClose(iOptronTelemetryReader *pReader)
+{
+    if(!pReader)
+        return;
+    munmap((void *)pReader->pSegment, sizeof(iOptronTelemetrySegment));
+    free(pReader);
+}
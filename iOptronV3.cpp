@@ -1,5 +1,7 @@
 #include "iOptronV3.h"
 
+static const char *s_szLinkUserNames[IOPTRON_NB_LINK_USERS] = {"host", "pulse guide", "rate stream"};
+
 // Constructor for IOPTRON
 CiOptron::CiOptron() {
 
@@ -8,39 +10,56 @@ CiOptron::CiOptron() {
     m_bParked = false;  // probably not good to assume we're parked.  Power could have shut down or we're at zero position or we're parked
     m_nGPSStatus = GPS_BROKE_OR_MISSING;  // unread to start (stating broke or missing)
     m_nTimeSource = TIME_SRC_UNKNOWN;  // unread to start
-
-#if defined IOPTRON_DEBUG
-    Logfile = NULL;
-#endif
-    m_dRa = 0.0;
-    m_dDec = 0.0;
+    m_nStatus = STOPPED;    // the rest is unread too, but the telemetry can be published before we connect
+    m_nTrackingRate = TRACKING_SIDEREAL;
+    m_pierStatus = PIER_INDETERMINATE;
+    m_counterWeightStatus = COUNTER_WEIGHT_NORMAL;
+    m_nAltitudeLimit = 0;
+
+    Logfile = &CAsyncLog::disabled();
+    m_pTrace = &CTraceLog::disabled();
     m_nDegreesPastMeridian = 0;
     m_nCacheLimitStatus = NO_STATUS;   // initialize to no status
     m_fCustomRaMultiplier = 1.0;   // sidereal to start
-    slewToTimer.Reset();
-    cmdTimer.Reset();
-    trackRatesTimer.Reset();
-    getAtParkTimer.Reset();
+    m_pModel = &mountModel(IOPTRON_UNKNOWN_MODEL);
+    m_pClock = &CMonotonicClock::system();
+
+    m_nStaleCaches = CACHE_NONE;
+    memset(m_Traffic, 0, sizeof(m_Traffic));
+    memset(&m_PhaseTimes, 0, sizeof(m_PhaseTimes));
+    m_nLastResponseAgeNs = 0;
+    m_nLinkBaud = 0;
+    m_bResyncPending = false;
+    m_nPositionTimeNs = 0;
+    m_nStatusTimeNs = 0;
+    m_nCustomRateValue = -1;
+    m_RateStream.setSender(sendStreamRate, this);
 }
 
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-void CiOptron::setLogFile(FILE *daFile) {
-    Logfile = daFile;
-    if (Logfile) {
-        fprintf(Logfile, "[%s] IOPTRON setLogFile Called\n", getTimestamp());
-        fflush(Logfile);
+void CiOptron::setLogFile(CAsyncLog *daFile) {
+    Logfile = daFile ? daFile : &CAsyncLog::disabled();
+    if (Logfile->enabled(LOG_TRANSPORT, LOG_DEBUG)) {
+        Logfile->log("IOPTRON setLogFile Called\n");
     }
 }
-#endif
+
+void CiOptron::setClock(CMonotonicClock *pClock)
+{
+    m_pClock = pClock ? pClock : &CMonotonicClock::system();
+    slewToTimer.setClock(*m_pClock);
+    cmdTimer.setClock(*m_pClock);
+    trackRatesTimer.setClock(*m_pClock);
+    getAtParkTimer.setClock(*m_pClock);
+    statusAgeTimer.setClock(*m_pClock);
+    m_RateStream.setClock(*m_pClock);
+}
 
 CiOptron::~CiOptron(void)
 {
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] IOPTRON Destructor Called\n", getTimestamp());
-        fflush(Logfile);
+    stopRateStream();  // its thread sends through us
+    if (Logfile->enabled(LOG_TRANSPORT, LOG_DEBUG)) {
+        Logfile->log("IOPTRON Destructor Called\n");
     }
-#endif
 }
 
 int CiOptron::Connect(char *pszPort)
@@ -48,57 +67,61 @@ int CiOptron::Connect(char *pszPort)
     int nErr = IOPTRON_OK;
     char szResp[SERIAL_BUFFER_SIZE];
     int iBehavior, iDegreesPastMeridian, iDegreesAltLimit;
-    int connectSpeed = 115200;  // default for CEM120xxx
-
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] CiOptron::Connect Called %s\n", getTimestamp(), pszPort);
-        fflush(Logfile);
-    }
-#endif
-
-    // 9600 8N1 (non CEM120xxx mounts) or 115200 (CEM120xx mounts)
-    while(true) {
-        nErr = m_pSerx->open(pszPort, connectSpeed, SerXInterface::B_NOPARITY, "-DTR_CONTROL 1") ;
-        if(nErr == 0)
-            m_bIsConnected = true;
-        else {
-            m_pSerx->flushTx();
-            m_pSerx->purgeTxRx();
-            m_pSerx->close();
-            m_bIsConnected = false;
-            return nErr;
-        }
-        // get mount model to see if we're properly connected
-        nErr = getMountInfo(m_szHardwareModel, SERIAL_BUFFER_SIZE);
-        if(nErr)
-            m_bIsConnected = false;
+    int connectSpeed = (int)m_pModel->nDefaultBaud;  // speed of the last mount we talked to, CEM120xxx speed the first time
+    bool bOtherSpeedTried = false;
+
+    if (Logfile->enabled(LOG_TRANSPORT, LOG_DEBUG)) {
+        Logfile->log("CiOptron::Connect Called %s\n", pszPort);
+    }
+    m_nCustomRateValue = -1;   // the mount keeps :RR through power cycles, but we don't know what it was
+    {
+        // the port is opened and closed at each speed tried, a guide pulse mustn't be written in between
+        CPriorityLocker locker(m_LinkLock, false);
+        m_CommandStats.reset();    // link statistics are per connection
+        m_LinkHealth.reset();      // the probe gets the catalog timeouts
+        m_GuideStats.reset();
+        m_bResyncPending = false;
+
+        // 9600 8N1 (non CEM120xxx mounts) or 115200 (CEM120xx mounts)
+        while(true) {
+            nErr = m_pSerx->open(pszPort, connectSpeed, SerXInterface::B_NOPARITY, "-DTR_CONTROL 1") ;
+            if(nErr) {
+                m_pSerx->flushTx();
+                m_pSerx->purgeTxRx();
+                m_pSerx->close();
+                m_bIsConnected = false;
+                return nErr;
+            }
+            m_nLinkBaud = connectSpeed;
+            // get mount model to see if we're properly connected. No retry, at the wrong speed it would only
+            // time out again and double the time before the other speed is tried.
+            nErr = readMountInfo(m_szHardwareModel, SERIAL_BUFFER_SIZE, false);
+            if(!nErr) {
+                m_bIsConnected = true;
+                break;
+            }
 
-        if(!m_bIsConnected && connectSpeed == 115200) {
             m_pSerx->flushTx();
             m_pSerx->purgeTxRx();
             m_pSerx->close();
-            connectSpeed = 9600;
-            continue;
-        }
-        else if(!m_bIsConnected && connectSpeed == 9600) {
-            // connection failed at both speed.
-            m_pSerx->flushTx();
-            m_pSerx->purgeTxRx();
-            m_pSerx->close();
-            return ERR_NORESPONSE;
+            if(bOtherSpeedTried) {
+                // connection failed at both speed.
+                m_bIsConnected = false;
+                return ERR_NORESPONSE;
+            }
+            connectSpeed = (connectSpeed == 115200) ? 9600 : 115200;
+            bOtherSpeedTried = true;
         }
-        break;
+        // the probe failing at the other speed is expected, it mustn't start the session degraded
+        m_LinkHealth.reset();
+        m_bResyncPending = false;
     }
 
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] CiOptron::Connect connected at %d on %s\n", getTimestamp(), connectSpeed, pszPort);
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_TRANSPORT, LOG_DEBUG)) {
+        Logfile->log("CiOptron::Connect connected at %d on %s\n", connectSpeed, pszPort);
     }
-#endif
 
-    nErr = sendCommand(":RT3#", szResp, 1);  // sets tracking rate to King by default .. effectively clears any custom rate that existed before
+    nErr = sendCommand(CMD_RT3, szResp);  // sets tracking rate to King by default .. effectively clears any custom rate that existed before
     if(nErr) {
         m_bIsConnected = false;
         return nErr;
@@ -118,37 +141,101 @@ int CiOptron::Connect(char *pszPort)
     }
     m_nAltitudeLimit = iDegreesAltLimit;  // save altitude limit
 
+    m_Events.connectionChanged(true, m_pClock->nowNs());
     getInfoAndSettings();
+    publishTelemetry();
     return nErr;
 }
 
 
 int CiOptron::Disconnect(void)
 {
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] CiOptron::Disconnect Called\n", getTimestamp());
-        fflush(Logfile);
-    }
-#endif
-	if (m_bIsConnected) {
-        if(m_pSerx){
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-            if (Logfile) {
-                fprintf(Logfile, "[%s] CiOptron::Disconnect closing serial port\n", getTimestamp());
-                fflush(Logfile);
+    if (Logfile->enabled(LOG_TRANSPORT, LOG_DEBUG)) {
+        Logfile->log("CiOptron::Disconnect Called\n");
+    }
+    stopRateStream();
+    {
+        // not while a guide pulse is being written, and a pulse waiting for the lock must see we're disconnected
+        CPriorityLocker locker(m_LinkLock, false);
+        if (m_bIsConnected && m_pSerx) {
+            if (Logfile->enabled(LOG_TRANSPORT, LOG_DEBUG)) {
+                Logfile->log("CiOptron::Disconnect closing serial port\n");
             }
-#endif
             m_pSerx->flushTx();
             m_pSerx->purgeTxRx();
             m_pSerx->close();
         }
+        m_bIsConnected = false;
     }
-	m_bIsConnected = false;
+    publishTelemetry();
+    m_Events.connectionChanged(false, m_pClock->nowNs());
 
 	return SB_OK;
 }
 
+#pragma mark - shared memory telemetry
+int CiOptron::setTelemetry(bool bPublish, int nInstance)
+{
+    int nErr = IOPTRON_OK;
+
+    if(!bPublish) {
+        m_Telemetry.close();
+        return nErr;
+    }
+    nErr = m_Telemetry.open(nInstance);
+    if (nErr && Logfile->enabled(LOG_TRANSPORT, LOG_ERROR)) {
+        Logfile->log("[CiOptron::setTelemetry] can't create the telemetry segment of instance %d, errno %d\n", nInstance, nErr);
+    }
+    publishTelemetry();
+    return nErr;
+}
+
+// Called after every read from the mount, a copy of what we cached
+void CiOptron::publishTelemetry()
+{
+    iOptronTelemetryData data;
+
+    if(!m_Telemetry.isOpen())
+        return;
+
+    memset(&data, 0, sizeof(data));
+    data.bConnected = m_bIsConnected;
+    data.nModelCode = m_pModel->nCode;
+    data.nRaCentiArcsec = m_Ra.raw();
+    data.nDecCentiArcsec = m_Dec.raw();
+    data.dRaHours = m_Ra.hours();
+    data.dDecDegrees = m_Dec.degrees();
+    data.nPierSide = m_pierStatus;
+    data.nCounterWeight = m_counterWeightStatus;
+    data.nStatus = m_nStatus;
+    data.nTrackingRate = m_nTrackingRate;
+    data.nGPSStatus = m_nGPSStatus;
+    data.nTimeSource = m_nTimeSource;
+    data.bParked = m_bParked;
+    data.dLatitude = m_Lat.degrees();
+    data.dLongitude = m_Long.degrees();
+    data.nAltitudeLimit = m_nAltitudeLimit;
+    data.nDegreesPastMeridian = m_nDegreesPastMeridian;
+    data.nLinkHealth = getLinkScore();
+    data.nPositionTimeNs = m_nPositionTimeNs;
+    data.nStatusTimeNs = m_nStatusTimeNs;
+    m_Telemetry.publish(data);
+}
+
+#pragma mark - change notifications
+// m_nStatus changed, read from the mount or set by us
+void CiOptron::notifyStatus()
+{
+    m_Events.statusRead(m_nStatus, m_nStatus == SLEWING || m_nStatus == FLIPPING, m_nStatus == PARKED, m_pClock->nowNs());
+}
+
+int64_t CiOptron::getStatusAgeNs() const
+{
+    if(!m_nStatusTimeNs || (m_nStaleCaches & CACHE_STATUS))
+        return INT64_MAX;
+    return statusAgeTimer.elapsedNs();
+}
+
 #pragma mark - Used by OpenLoopMoveInterface
 int CiOptron::getNbSlewRates()
 {
@@ -157,12 +244,9 @@ int CiOptron::getNbSlewRates()
 
 int CiOptron::getRateName(int nZeroBasedIndex, char *pszOut, unsigned int nOutMaxSize)
 {
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::getRateName] index was %i\n", getTimestamp(), nZeroBasedIndex);
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_SLEW, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::getRateName] index was %i\n", nZeroBasedIndex);
     }
-#endif
 
     if (nZeroBasedIndex > IOPTRON_NB_SLEW_SPEEDS)
         return IOPTRON_ERROR;
@@ -175,44 +259,42 @@ int CiOptron::getRateName(int nZeroBasedIndex, char *pszOut, unsigned int nOutMa
 int CiOptron::startOpenSlew(const MountDriverInterface::MoveDir Dir, unsigned int nRate) // todo: not trivial how to slew in V3
 {
     int nErr = IOPTRON_OK;
-    char szCmd[SERIAL_BUFFER_SIZE];
+    char szCmd[IOPTRON_CMD_BUFFER_SIZE];
     char szResp[SERIAL_BUFFER_SIZE];
 
     m_nOpenLoopDir = Dir;
 
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::startOpenSlew] setting to Dir %d\n", getTimestamp(), Dir);
-        fprintf(Logfile, "[%s] [CiOptron::startOpenSlew] Setting rate to %d\n", getTimestamp(), nRate);
-    fflush(Logfile);
+    if (Logfile->enabled(LOG_SLEW, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::startOpenSlew] setting to Dir %d\n", Dir);
+        Logfile->log("[CiOptron::startOpenSlew] Setting rate to %d\n", nRate);
     }
-#endif
 
     nErr = getInfoAndSettings();
     if(nErr)
         return nErr;
     if (m_nStatus == SLEWING) {
         // interrupt slewing since user pressed button
-        nErr = sendCommand(":Q#", szResp, 1);
+        nErr = sendCommand(CMD_Q, szResp);
     }
 
     // select rate.  :SRn# n=1..7  1=1x, 2=2x, 3=8x, 4=16x, 5=64x, 6=128x, 7=256x
-    snprintf(szCmd, SERIAL_BUFFER_SIZE, ":SR%1d#", nRate+1);
-    nErr = sendCommand(szCmd, szResp, 1);
+    if(!formatMoveRateCommand(szCmd, IOPTRON_CMD_BUFFER_SIZE, nRate+1))
+        return COMMAND_FAILED;
+    nErr = sendCommand(CMD_SR, szCmd, szResp);
 
     // figure out direction
     switch(Dir){
         case MountDriverInterface::MD_NORTH:
-            nErr = sendCommand(":mn#", szResp, 0);
+            nErr = sendCommand(CMD_MN, szResp);
             break;
         case MountDriverInterface::MD_SOUTH:
-            nErr = sendCommand(":ms#", szResp, 0);
+            nErr = sendCommand(CMD_MS, szResp);
             break;
         case MountDriverInterface::MD_EAST:
-            nErr = sendCommand(":me#", szResp, 0);
+            nErr = sendCommand(CMD_ME, szResp);
             break;
         case MountDriverInterface::MD_WEST:
-            nErr = sendCommand(":mw#", szResp, 0);
+            nErr = sendCommand(CMD_MW, szResp);
             break;
     }
 
@@ -224,21 +306,18 @@ int CiOptron::stopOpenLoopMove()
     int nErr = IOPTRON_OK;
     char szResp[SERIAL_BUFFER_SIZE];
 
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::stopOpenLoopMove] Dir was %d\n", getTimestamp(), m_nOpenLoopDir);
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_SLEW, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::stopOpenLoopMove] Dir was %d\n", m_nOpenLoopDir);
     }
-#endif
 
     switch(m_nOpenLoopDir){
         case MountDriverInterface::MD_NORTH:
         case MountDriverInterface::MD_SOUTH:
-            nErr = sendCommand(":qD#", szResp, 1);
+            nErr = sendCommand(CMD_QD, szResp);
             break;
         case MountDriverInterface::MD_EAST:
         case MountDriverInterface::MD_WEST:
-            nErr = sendCommand(":qR#", szResp, 1);
+            nErr = sendCommand(CMD_QR, szResp);
             break;
     }
 
@@ -246,157 +325,291 @@ int CiOptron::stopOpenLoopMove()
 }
 
 
+#pragma mark - pulse guiding
+int CiOptron::pulseGuide(const MountDriverInterface::MoveDir Dir, int nDurationMs)
+{
+    int nErr = IOPTRON_OK;
+    char szCmd[IOPTRON_CMD_BUFFER_SIZE];
+    int nCmdId;
+    int nCmdLen;
+    int nGuideDir;
+    int64_t nRequestNs;
+    int64_t nLockedNs;
+    int64_t nAckNs;
+
+    switch(Dir) {
+        case MountDriverInterface::MD_NORTH:
+            nCmdId = CMD_GUIDE_N;
+            nGuideDir = GUIDE_NORTH;
+            break;
+        case MountDriverInterface::MD_SOUTH:
+            nCmdId = CMD_GUIDE_S;
+            nGuideDir = GUIDE_SOUTH;
+            break;
+        case MountDriverInterface::MD_EAST:
+            nCmdId = CMD_GUIDE_E;
+            nGuideDir = GUIDE_EAST;
+            break;
+        case MountDriverInterface::MD_WEST:
+            nCmdId = CMD_GUIDE_W;
+            nGuideDir = GUIDE_WEST;
+            break;
+        default:
+            return COMMAND_FAILED;
+    }
+    nCmdLen = formatGuidePulseCommand(szCmd, IOPTRON_CMD_BUFFER_SIZE, nCmdId, nDurationMs);
+    if(!nCmdLen) {
+        if (Logfile->enabled(LOG_TRACKING, LOG_ERROR)) {
+            Logfile->log("[CiOptron::pulseGuide] invalid pulse of %d ms, 1 to %d ms\n", nDurationMs, IOPTRON_MAX_PULSE_MS);
+        }
+        return COMMAND_FAILED;
+    }
+
+    nRequestNs = m_pClock->nowNs();
+    {
+        // ahead of every command waiting for the port, behind the one being exchanged only
+        CPriorityLocker locker(m_LinkLock, true);
+
+        nLockedNs = m_pClock->nowNs();
+        if(!m_bIsConnected)
+            return NOT_CONNECTED;
+        nErr = sendCommandLocked(commandInfo(nCmdId), szCmd, nCmdLen, NULL, LINK_USER_GUIDE);
+        nAckNs = m_pClock->nowNs();
+        m_GuideStats.record(nGuideDir, nDurationMs, nLockedNs - nRequestNs, nAckNs - nLockedNs, nErr != IOPTRON_OK);
+    }
+
+    if(m_pTrace->enabled()) {
+        m_pTrace->span("guide wait", "guide", nRequestNs, nLockedNs, CGuideStats::dirName(nGuideDir));
+        m_pTrace->span("pulse guide", "guide", nLockedNs, nAckNs, CGuideStats::dirName(nGuideDir), nDurationMs);
+    }
+    if (Logfile->enabled(LOG_TRACKING, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::pulseGuide] %s %d ms, waited %.3f ms, acked after %.3f ms, nErr = %d\n", CGuideStats::dirName(nGuideDir), nDurationMs, (nLockedNs - nRequestNs) / 1.0e6, (nAckNs - nRequestNs) / 1.0e6, nErr);
+    }
+    return nErr;
+}
+
 #pragma mark - IOPTRON communication
-int CiOptron::sendCommand(const char *pszCmd, char *pszResult, int nExpectedResultLen)
+int CiOptron::sendCommand(int nCmdId, char *pszResult)
+{
+    const iOptronCommand &command = commandInfo(nCmdId);
+
+    return sendCommand(command, command.pszCmd, command.nCmdLen, pszResult);
+}
+
+int CiOptron::sendCommand(int nCmdId, const char *pszCmd, char *pszResult)
+{
+    const iOptronCommand &command = commandInfo(nCmdId);
+
+    // formatted commands with a variable length are the only ones we still need to measure
+    return sendCommand(command, pszCmd, command.nCmdLen ? command.nCmdLen : (int)strlen(pszCmd), pszResult);
+}
+
+int CiOptron::sendCommand(const iOptronCommand &command, const char *pszCmd, int nCmdLen, char *pszResult, int nLinkUser)
+{
+    CPriorityLocker locker(m_LinkLock, false);
+
+    return sendCommandLocked(command, pszCmd, nCmdLen, pszResult, nLinkUser);
+}
+
+int CiOptron::sendCommandLocked(const iOptronCommand &command, const char *pszCmd, int nCmdLen, char *pszResult, int nLinkUser, bool bRetry)
 {
     int nErr = IOPTRON_OK;
     char szResp[SERIAL_BUFFER_SIZE];
-    unsigned long  ulBytesWrite;
+    int nAttempt;
+    int nRetries = bRetry ? m_LinkHealth.retries(command) : 0;
+    int nLinkState = m_LinkHealth.state();
 
-    m_pSerx->purgeTxRx();
-
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] *** CiOptron::sendCommand sending : '%s'\n", getTimestamp(), pszCmd);
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_TRANSPORT, LOG_DEBUG)) {
+        Logfile->log("*** CiOptron::sendCommand sending : '%s'\n", pszCmd);
     }
-#endif
 
-    nErr = m_pSerx->writeFile((void *)pszCmd, strlen((char*)pszCmd), ulBytesWrite);
-    m_pSerx->flushTx();
-    if(nErr) {
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-        if (Logfile) {
-            fprintf(Logfile, "[%s] *** CiOptron::sendCommand ***** ERROR SENDING COMMAND **** error = %d , pszCmd : '%s'\n", getTimestamp(), nErr, pszCmd);
-            fflush(Logfile);
+    for(nAttempt = 0; ; nAttempt++) {
+        nErr = exchange(command, pszCmd, nCmdLen, szResp, nAttempt ? LINK_EVENT_RETRY : LINK_EVENT_NONE, nLinkUser);
+        if(!nErr || nAttempt >= nRetries)
+            break;
+        if (Logfile->enabled(LOG_TRANSPORT, LOG_ERROR)) {
+            Logfile->log("*** CiOptron::sendCommand retrying '%s' after error %d, retry %d of %d\n", pszCmd, nErr, nAttempt + 1, nRetries);
         }
-#endif
+    }
+
+    if(m_LinkHealth.state() != nLinkState && Logfile->enabled(LOG_TRANSPORT, LOG_ERROR)) {
+        Logfile->log("*** CiOptron::sendCommand link is now %s, health %d/100\n", CLinkHealth::stateName(m_LinkHealth.state()), m_LinkHealth.score());
+    }
+    if(nErr)
         return nErr;
+
+    if (Logfile->enabled(LOG_TRANSPORT, LOG_DEBUG)) {
+        Logfile->log("*** CiOptron::sendCommand response : '%s'\n", szResp);
     }
-    // read response
-    nErr = readResponse(szResp, nExpectedResultLen);
+
+    if(pszResult)
+        strncpy(pszResult, szResp, SERIAL_BUFFER_SIZE);
+
+    m_nStaleCaches |= command.nInvalidates;
+
+    return nErr;
+}
+
+// One write and reply read, accounted in the command stats and the link health, and in the traffic
+// and phase times of nLinkUser. The reply keeps its terminator, the bad frame check here and the
+// schema decoders look for it.
+int CiOptron::exchange(const iOptronCommand &command, const char *pszCmd, int nCmdLen, char *szResp, unsigned nEvents, int nLinkUser)
+{
+    int nErr = IOPTRON_OK;
+    unsigned long  ulBytesWrite = 0;
+    unsigned long  ulBytesRead = 0;
+    iOptronTrafficCounters *pTraffic = &m_Traffic[nLinkUser];
+    bool bHost = nLinkUser == LINK_USER_HOST;
+    const char *pszCaller = bHost ? NULL : s_szLinkUserNames[nLinkUser];
+    unsigned long  ulUnexpectedBytes = 0;
+    int nBytesWaiting = 0;
+    int64_t nStartNs;
+    int64_t nWrittenNs;
+    int64_t nReadNs;
+
+    // a late reply to the exchange that failed could still be on its way, count what the purge drops
+    if(m_bResyncPending) {
+        m_pSerx->bytesWaitingRx(nBytesWaiting);
+        if(nBytesWaiting > 0) {
+            nEvents |= LINK_EVENT_RESYNC;
+            ulUnexpectedBytes += (unsigned long)nBytesWaiting;
+            nStartNs = m_pClock->nowNs();
+            m_Recorder.record(TRANSPORT_PURGE, commandId(command), nStartNs, nStartNs, IOPTRON_OK, NULL, (unsigned long)nBytesWaiting, pszCaller);
+        }
+        m_bResyncPending = false;
+    }
+    m_pSerx->purgeTxRx();
+
+    nStartNs = m_pClock->nowNs();
+    nErr = m_pSerx->writeFile((void *)pszCmd, nCmdLen, ulBytesWrite);
+    m_pSerx->flushTx();
+    nWrittenNs = m_pClock->nowNs();
+    if(bHost)
+        m_PhaseTimes.nNs[PHASE_SERIAL_WRITE] += nWrittenNs - nStartNs;
+    if(m_pTrace->enabled())
+        m_pTrace->span("serial write", "serial", nStartNs, nWrittenNs, command.pszCmd, (int64_t)ulBytesWrite);
+    m_Recorder.record(TRANSPORT_WRITE, commandId(command), nStartNs, nWrittenNs, nErr, pszCmd, ulBytesWrite, pszCaller);
+    pTraffic->nCommands++;
+    pTraffic->nBytesWritten += ulBytesWrite;
     if(nErr) {
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-        if (Logfile) {
-            fprintf(Logfile, "[%s] *** CiOptron::sendCommand ***** ERROR READING RESPONSE **** error = %d , response : '%s'\n", getTimestamp(), nErr, szResp);
-            fflush(Logfile);
+        m_CommandStats.record(commandId(command), nWrittenNs - nStartNs, false, true, ulBytesWrite, 0);
+        m_LinkHealth.record(nEvents | LINK_EVENT_TIMEOUT, ulUnexpectedBytes);  // nothing will come back
+        m_Recorder.exchangeDone(commandId(command), nWrittenNs - nStartNs, nWrittenNs, pszCaller);
+        m_bResyncPending = true;
+        if (Logfile->enabled(LOG_TRANSPORT, LOG_ERROR)) {
+            Logfile->log("*** CiOptron::sendCommand ***** ERROR SENDING COMMAND **** error = %d , pszCmd : '%s'\n", nErr, pszCmd);
         }
-#endif
         return nErr;
     }
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] *** CiOptron::sendCommand response : '%s'\n", getTimestamp(), szResp);
-        fflush(Logfile);
+    // read response
+    nErr = readResponse(szResp, command.nReplyLen, m_LinkHealth.timeoutMs(m_pModel->nTimeouts[command.nTimeoutClass]), ulBytesRead);
+    nReadNs = m_pClock->nowNs();
+    pTraffic->nBytesRead += ulBytesRead;
+    if(bHost)
+        accountReadTime(nReadNs - nWrittenNs, ulBytesRead);
+    if(m_pTrace->enabled())
+        m_pTrace->span("serial read", "serial", nWrittenNs, nReadNs, command.pszCmd, (int64_t)ulBytesRead);
+    m_Recorder.record(TRANSPORT_READ, commandId(command), nWrittenNs, nReadNs, nErr, szResp, ulBytesRead, pszCaller);
+
+    if(command.nReplyLen && !ulBytesRead)
+        nEvents |= LINK_EVENT_TIMEOUT;
+    else if(ulBytesRead < (unsigned long)command.nReplyLen)
+        nEvents |= LINK_EVENT_SHORT_READ;
+    else if(!nErr && command.nReplyFormat == REPLY_FIELDS && szResp[command.nReplyLen - 1] != querySchema(command.nQuery).cTerminator) {
+        nEvents |= LINK_EVENT_BAD_FRAME;
+        ulUnexpectedBytes += ulBytesRead;
+        nErr = IOPTRON_BAD_CMD_RESPONSE;
     }
-#endif
-
-    if(pszResult)
-        strncpy(pszResult, szResp, SERIAL_BUFFER_SIZE);
+    if(nErr)
+        m_bResyncPending = true;
+    m_LinkHealth.record(nEvents, ulUnexpectedBytes);
 
+    m_CommandStats.record(commandId(command), nReadNs - nStartNs, ulBytesRead < (unsigned long)command.nReplyLen, nErr != IOPTRON_OK, ulBytesWrite, ulBytesRead);
+    m_Recorder.exchangeDone(commandId(command), nReadNs - nStartNs, nReadNs, pszCaller);
+    if (nErr && Logfile->enabled(LOG_TRANSPORT, LOG_ERROR)) {
+        Logfile->log("*** CiOptron::sendCommand ***** ERROR READING RESPONSE **** error = %d , response : '%s'\n", nErr, szResp);
+    }
     return nErr;
 }
 
-int CiOptron::readResponse(char *szRespBuffer, int nBytesToRead)
+// reads nBytesToRead reply bytes as they come, the '#' included
+int CiOptron::readResponse(char *szRespBuffer, int nBytesToRead, int nTimeout, unsigned long &ulBytesActuallyRead)
 {
     int nErr = IOPTRON_OK;
-    unsigned long ulBytesActuallyRead = 0;
     char *pszBufPtr;
 
+    ulBytesActuallyRead = 0;
     if (nBytesToRead == 0)
         return nErr;
 
     memset(szRespBuffer, 0, (size_t) SERIAL_BUFFER_SIZE);
     pszBufPtr = szRespBuffer;
 
-    nErr = m_pSerx->readFile(pszBufPtr, nBytesToRead, ulBytesActuallyRead, MAX_TIMEOUT);
+    nErr = m_pSerx->readFile(pszBufPtr, nBytesToRead, ulBytesActuallyRead, nTimeout);
     if(nErr) {
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 3
-        if (Logfile) {
-            fprintf(Logfile, "[%s] [CiOptron::readResponse] szRespBuffer = '%s'\n", getTimestamp(), szRespBuffer);
-            fflush(Logfile);
+        if (Logfile->enabled(LOG_TRANSPORT, LOG_VERBOSE)) {
+            Logfile->log("[CiOptron::readResponse] szRespBuffer = '%s'\n", szRespBuffer);
         }
-#endif
         return nErr;
     }
 
     if (ulBytesActuallyRead !=nBytesToRead) { // timeout or something screwed up with command passed in
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-        if (Logfile) {
-            fprintf(Logfile, "[%s] CiOptron::readResponse number of bytes read not what expected.  Number of bytes read: %lu.  Number expected: %i\n", getTimestamp(), ulBytesActuallyRead, nBytesToRead);
-            fflush(Logfile);
+        if (Logfile->enabled(LOG_TRANSPORT, LOG_DEBUG)) {
+            Logfile->log("CiOptron::readResponse number of bytes read not what expected.  Number of bytes read: %lu.  Number expected: %i\n", ulBytesActuallyRead, nBytesToRead);
         }
-#endif
 
         nErr = IOPTRON_BAD_CMD_RESPONSE;
     }
 
-    if(ulBytesActuallyRead && *(pszBufPtr-1) == '#')
-        *(pszBufPtr-1) = 0; //remove the #
-
     return nErr;
 }
 
+void CiOptron::accountReadTime(int64_t nReadNs, unsigned long ulBytesRead)
+{
+    int64_t nWireNs = 0;
+
+    // time the reply bytes take on the wire at 10 bits per byte, the rest is the mount thinking
+    if(m_nLinkBaud > 0)
+        nWireNs = (int64_t)ulBytesRead * 10 * NS_PER_SECOND / m_nLinkBaud;
+    if(nWireNs > nReadNs)
+        nWireNs = nReadNs;
+
+    m_PhaseTimes.nNs[PHASE_SERIAL_READ] += nWireNs;
+    m_PhaseTimes.nNs[PHASE_MOUNT_WAIT] += nReadNs - nWireNs;
+}
+
+int CiOptron::accountParseTime(int nParseErr, int64_t nParseStartNs)
+{
+    m_PhaseTimes.nNs[PHASE_PARSE] += m_pClock->nowNs() - nParseStartNs;
+    return nParseErr;
+}
+
 
 #pragma mark - mount controller informations
 int CiOptron::getMountInfo(char *model, unsigned int strMaxLen)
 {
-    int nErr = IOPTRON_OK;
-    char szResp[SERIAL_BUFFER_SIZE];
     if(!m_bIsConnected)
         return NOT_CONNECTED;
 
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::getMountInfo] called\n", getTimestamp());
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_TRANSPORT, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::getMountInfo] called\n");
     }
-#endif
 
-    nErr = sendCommand(":MountInfo#", szResp, 4);
+    CPriorityLocker locker(m_LinkLock, false);
+    return readMountInfo(model, strMaxLen, true);
+}
+
+int CiOptron::readMountInfo(char *model, unsigned int strMaxLen, bool bRetry)
+{
+    int nErr = IOPTRON_OK;
+    char szResp[SERIAL_BUFFER_SIZE];
+
+    nErr = sendCommandLocked(commandInfo(CMD_MOUNT_INFO), commandInfo(CMD_MOUNT_INFO).pszCmd, commandInfo(CMD_MOUNT_INFO).nCmdLen, szResp, LINK_USER_HOST, bRetry);
     if(nErr)
         return nErr;
 
-    if (strcmp(szResp, IEQ30PRO) == 0) {
-        strncpy(model, "iEQ30 Pro", strMaxLen);
-        strncpy(m_sModel, IEQ30PRO, 5);
-    } else if (strcmp(szResp, CEM26) == 0) {
-        strncpy(model, "CEM26", strMaxLen);
-        strncpy(m_sModel, CEM26, 5);
-    } else if (strcmp(szResp, CEM26_EC) == 0) {
-        strncpy(model, "CEM26-EC", strMaxLen);
-        strncpy(m_sModel, CEM26_EC, 5);
-    } else if (strcmp(szResp, GEM28) == 0) {
-        strncpy(model, "GEM28", strMaxLen);
-        strncpy(m_sModel, GEM28, 5);
-    } else if (strcmp(szResp, GEM28_EC) == 0) {
-        strncpy(model, "GEM28-EC", strMaxLen);
-        strncpy(m_sModel, GEM28_EC, 5);
-    } else if (strcmp(szResp, CEM70) == 0) {
-        strncpy(model, "CEM70(G)", strMaxLen);
-        strncpy(m_sModel, CEM70, 5);
-    } else if (strcmp(szResp, CEM70_EC) == 0) {
-        strncpy(model, "CEM70(G)-EC", strMaxLen);
-        strncpy(m_sModel, CEM70_EC, 5);
-    } else if (strcmp(szResp, CEM60) == 0) {
-        strncpy(model, "CEM60", strMaxLen);
-        strncpy(m_sModel, CEM60, 5);
-    } else if (strcmp(szResp, CEM60_EC) == 0) {
-        strncpy(model, "CEM60-EC", strMaxLen);
-        strncpy(m_sModel, CEM60_EC, 5);
-    } else if (strcmp(szResp, CEM120) == 0) {
-        strncpy(model, "CEM120", strMaxLen);
-        strncpy(m_sModel, CEM120, 5);
-    } else if (strcmp(szResp, CEM120_EC) == 0) {
-        strncpy(model, "CEM120-EC", strMaxLen);
-        strncpy(m_sModel, CEM120_EC, 5);
-    } else if (strcmp(szResp, CEM120_EC2) == 0) {
-        strncpy(model, "CEM120-EC2", strMaxLen);
-        strncpy(m_sModel, CEM120_EC2, 5);
-    } else {
-        strncpy(model, "Unsupported Mount", strMaxLen);
-        strncpy(m_sModel, UKNOWN_MOUNT, 5);
-    }
+    m_pModel = &mountModelFromReply(szResp);
+    strncpy(model, m_pModel->pszName, strMaxLen);
     return nErr;
 }
 
@@ -414,25 +627,22 @@ int CiOptron::getFirmwareVersion(char *pszVersion, unsigned int nStrMaxLen)
     char szResp[SERIAL_BUFFER_SIZE];
     std::string sFirmwares;
 
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::getFirmwareVersion] called\n", getTimestamp());
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_TRANSPORT, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::getFirmwareVersion] called\n");
     }
-#endif
 
 
     if(!m_bIsConnected)
         return NOT_CONNECTED;
 
-    nErr = sendCommand(":FW1#", szResp, 13);
+    nErr = sendCommand(CMD_FW1, szResp);
     if(nErr)
         return nErr;
 
     sFirmwares+= szResp;
     sFirmwares+= " ";
 
-    nErr = sendCommand(":FW2#", szResp, 13);
+    nErr = sendCommand(CMD_FW2, szResp);
     if(nErr)
         return nErr;
     sFirmwares+= szResp;
@@ -446,70 +656,63 @@ int CiOptron::getRaAndDec(double &dRaInDecimalHours, double &dDecInDecimalDegree
 {
 
 
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::getRaAndDec] called \n", getTimestamp());
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_CACHE, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::getRaAndDec] called \n");
     }
-#endif
     int nErr = IOPTRON_OK;
     char szResp[SERIAL_BUFFER_SIZE];
-
-    char szRa[SERIAL_BUFFER_SIZE], szDec[SERIAL_BUFFER_SIZE], szPier[SERIAL_BUFFER_SIZE], szCounter[SERIAL_BUFFER_SIZE];
-    int nRa, nDec;
+    int64_t nParseStartNs;
+    iOptronPositionReply position;
 
     // don't ask the mount too often, returned cached value
-    if(cmdTimer.GetElapsedSeconds()<0.1 && !bForceMountCall) {
-        dRaInDecimalHours = m_dRa;
-        dDecInDecimalDegrees = m_dDec;
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-        if (Logfile) {
-            fprintf(Logfile, "[%s] [CiOptron::getRaAndDec] SHORT circuiting TSX from going nuts on the mount. \n", getTimestamp());
-            fflush(Logfile);
+    if(cmdTimer.elapsedNs() < 100 * NS_PER_MS && !bForceMountCall && !(m_nStaleCaches & CACHE_POSITION)) {
+        dRaInDecimalHours = m_Ra.hours();
+        dDecInDecimalDegrees = m_Dec.degrees();
+        m_nLastResponseAgeNs = cmdTimer.elapsedNs();
+        if(m_pTrace->enabled())
+            m_pTrace->instant("position cache hit", "cache", "getRaAndDec", m_nLastResponseAgeNs / 1000);
+        if (Logfile->enabled(LOG_CACHE, LOG_DEBUG)) {
+            Logfile->log("[CiOptron::getRaAndDec] SHORT circuiting TSX from going nuts on the mount. \n");
         }
-#endif
         return nErr;
     }
-    cmdTimer.Reset();
-    nErr = sendCommand(":GEP#", szResp, 21);
+    if(m_pTrace->enabled())
+        m_pTrace->instant("position cache miss", "cache", "getRaAndDec");
+    cmdTimer.reset();
+    nErr = sendCommand(CMD_GEP, szResp);
     if(nErr)
         return nErr;
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::getRaAndDec] response to :GEP# %s\n", getTimestamp(), szResp);
-        fflush(Logfile);
-    }
-#endif
-
-    memset(szRa, 0, SERIAL_BUFFER_SIZE);
-    memset(szDec, 0, SERIAL_BUFFER_SIZE);
-    memcpy(szDec, szResp, 9);
-    memcpy(szRa, szResp+9, 9);
-    nRa = atoi(szRa);
-    nDec = atoi(szDec);
-    dRaInDecimalHours = (nRa*0.01 * 24.0 / 360.0)/ 60.0 /60.0 ;
-    dDecInDecimalDegrees = (nDec * 0.01)/ 60.0 /60.0 ;
-
-    m_dRa = dRaInDecimalHours;
-    m_dDec = dDecInDecimalDegrees;
-
-    memcpy(szPier, szResp+18, 1);
-    m_pierStatus = atoi(szPier);
-
-    memcpy(szCounter, szResp+19, 1);
-    m_counterWeightStatus = atoi(szCounter);
-
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::getRaAndDec] nRa : %d\n", getTimestamp(), nRa);
-        fprintf(Logfile, "[%s] [CiOptron::getRaAndDec] nDec : %d\n", getTimestamp(), nDec);
-        fprintf(Logfile, "[%s] [CiOptron::getRaAndDec] Ra : %f\n", getTimestamp(), dRaInDecimalHours);
-        fprintf(Logfile, "[%s] [CiOptron::getRaAndDec] Dec : %f\n", getTimestamp(), dDecInDecimalDegrees);
-        fprintf(Logfile, "[%s] [CiOptron::getRaAndDec] pier side: : %s\n", getTimestamp(), (m_pierStatus==PIER_EAST)?"pier east" : (m_pierStatus==PIER_WEST)?"pier west":"pier indeterminate");
-        fprintf(Logfile, "[%s] [CiOptron::getRaAndDec] counterweight status: : %s\n", getTimestamp(), (m_counterWeightStatus==COUNTER_WEIGHT_UP)?"counterweight up" : "counterweight normal");
-        fflush(Logfile);
-    }
-#endif
+    if (Logfile->enabled(LOG_CACHE, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::getRaAndDec] response to :GEP# %s\n", szResp);
+    }
+
+    nParseStartNs = m_pClock->nowNs();
+    if(accountParseTime(parsePositionReply(szResp, position), nParseStartNs)) {
+        if (Logfile->enabled(LOG_CACHE, LOG_ERROR)) {
+            Logfile->log("[CiOptron::getRaAndDec] ERROR parsing :GEP# response %s\n", szResp);
+        }
+        return IOPTRON_BAD_CMD_RESPONSE;
+    }
+    m_Ra = position.Ra;
+    m_Dec = position.Dec;
+    dRaInDecimalHours = m_Ra.hours();
+    dDecInDecimalDegrees = m_Dec.degrees();
+    m_nStaleCaches &= ~CACHE_POSITION;
+    m_pierStatus = position.nPierSide;
+    m_counterWeightStatus = position.nCounterWeight;
+    // the system clock whatever m_pClock is, readers in other processes compare with their own
+    m_nPositionTimeNs = CMonotonicClock::system().nowNs();
+    publishTelemetry();
+    m_Events.positionRead(m_Ra, m_Dec, m_pierStatus, m_pierStatus == PIER_EAST || m_pierStatus == PIER_WEST, m_pClock->nowNs());
+
+    if (Logfile->enabled(LOG_CACHE, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::getRaAndDec] nRa : %lld\n", (long long)m_Ra.raw());
+        Logfile->log("[CiOptron::getRaAndDec] nDec : %lld\n", (long long)m_Dec.raw());
+        Logfile->log("[CiOptron::getRaAndDec] Ra : %f\n", dRaInDecimalHours);
+        Logfile->log("[CiOptron::getRaAndDec] Dec : %f\n", dDecInDecimalDegrees);
+        Logfile->log("[CiOptron::getRaAndDec] pier side: : %s\n", (m_pierStatus==PIER_EAST)?"pier east" : (m_pierStatus==PIER_WEST)?"pier west":"pier indeterminate");
+        Logfile->log("[CiOptron::getRaAndDec] counterweight status: : %s\n", (m_counterWeightStatus==COUNTER_WEIGHT_UP)?"counterweight up" : "counterweight normal");
+    }
 
     return nErr;
 }
@@ -519,27 +722,23 @@ int CiOptron::syncTo(double dRaInDecimalHours, double dDecInDecimalDegrees)
 {
     int nErr = IOPTRON_OK;
     char szResp[SERIAL_BUFFER_SIZE];
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::syncTo] called Ra : %f  Dec: %f\n", getTimestamp(), dRaInDecimalHours, dDecInDecimalDegrees);
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_SLEW, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::syncTo] called Ra : %f  Dec: %f\n", dRaInDecimalHours, dDecInDecimalDegrees);
     }
-#endif
 
     if(!m_bIsConnected) {
         return NOT_CONNECTED;
     }
 
-    nErr = setRaAndDec("CiOptron::syncTo", dRaInDecimalHours, dDecInDecimalDegrees);
+    nErr = setRaAndDec("CiOptron::syncTo", CCentiArcsec::fromHours(dRaInDecimalHours), CCentiArcsec::fromDegrees(dDecInDecimalDegrees));
     if (nErr) {
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-        fprintf(Logfile, "[%s] [CiOptron::syncTo] Error: error setting ra and Dec.  nErr: %i\n", getTimestamp(), nErr);
-        fflush(Logfile);
-#endif
+        if (Logfile->enabled(LOG_SLEW, LOG_ERROR)) {
+            Logfile->log("[CiOptron::syncTo] Error: error setting ra and Dec.  nErr: %i\n", nErr);
+        }
         return nErr;
     }
 
-    nErr = sendCommand(":CM#", szResp, 1);  // call Snc
+    nErr = sendCommand(CMD_CM, szResp);  // call Snc
 
      return nErr;
 }
@@ -550,28 +749,22 @@ int CiOptron::setSiderealTrackingOn() {
 
     int nErr = IOPTRON_OK;
     char szResp[SERIAL_BUFFER_SIZE];
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::setSiderealTrackingOn] called \n", getTimestamp());
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_TRACKING, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::setSiderealTrackingOn] called \n");
     }
-#endif
 
     // Set tracking to sidereal
-    nErr = sendCommand(":RT0#", szResp, 1);  // use macro command to set this
+    nErr = sendCommand(CMD_RT0, szResp);  // use macro command to set this
 
     if (nErr)
         return nErr;
 
     // and turn on
-    nErr = sendCommand(":ST1#", szResp, 1);  // and start tracking
+    nErr = sendCommand(CMD_ST1, szResp);  // and start tracking
 
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::setSiderealTrackingOn] finished.  Result: %s\n", getTimestamp(), szResp);
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_TRACKING, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::setSiderealTrackingOn] finished.  Result: %s\n", szResp);
     }
-#endif
 
     return nErr;
 
@@ -583,21 +776,16 @@ int CiOptron::setTrackingOff() {
     int nErr = IOPTRON_OK;
     char szResp[SERIAL_BUFFER_SIZE];
 
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::setTrackingOff] called \n", getTimestamp());
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_TRACKING, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::setTrackingOff] called \n");
     }
-#endif
+    stopRateStream();
 
-    nErr = sendCommand(":ST0#", szResp, 1);  // use macro command to set this
+    nErr = sendCommand(CMD_ST0, szResp);  // use macro command to set this
 
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::setTrackingOff] finished.  Result: %s\n", getTimestamp(), szResp);
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_TRACKING, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::setTrackingOff] finished.  Result: %s\n", szResp);
     }
-#endif
 
     return nErr;
 
@@ -607,17 +795,15 @@ int CiOptron::setTrackingRates(bool bTrackingOn, bool bIgnoreRates, double dRaRa
 {
     int nErr = IOPTRON_OK;
     char szResp[SERIAL_BUFFER_SIZE];
-    char szCmdTmp[SERIAL_BUFFER_SIZE];
-    char szCmd[SERIAL_BUFFER_SIZE];
+    char szCmd[IOPTRON_CMD_BUFFER_SIZE];
+    int nCmdId = CMD_RT3;
     double dMountMultiplierRa = 1.0;
     bool bCustomRate = false;  // assume not a custom rate
 
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::setTrackingRates] called bTrackingOn: %s, bIgnoreRate: %s, dRaRateArcSecPerSec: %f, dDecRateArcSecPerSec %f\n", getTimestamp(), bTrackingOn?"true":"false", bIgnoreRates?"true":"false", dRaRateArcSecPerSec, dDecRateArcSecPerSec);
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_TRACKING, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::setTrackingRates] called bTrackingOn: %s, bIgnoreRate: %s, dRaRateArcSecPerSec: %f, dDecRateArcSecPerSec %f\n", bTrackingOn?"true":"false", bIgnoreRates?"true":"false", dRaRateArcSecPerSec, dDecRateArcSecPerSec);
     }
-#endif
+    stopRateStream();  // the host rate takes over
 
 // :RRnnnnn# - set the tracking rate of the RA axis to n.nnnn *sidereal rate
 //           - Valid data range is [0.1000, 1.9000] * sidereal rate.
@@ -629,90 +815,77 @@ int CiOptron::setTrackingRates(bool bTrackingOn, bool bIgnoreRates, double dRaRa
 
     if (bTrackingOn) {
         if (bIgnoreRates) {
-            strcpy(szCmd, ":RT3#");  // use 'macro' command to set sidereal/king (King is better)
+            nCmdId = CMD_RT3;  // use 'macro' command to set sidereal/king (King is better)
         } else {
             // Sidereal rate
             if (-0.00001 < dRaRateArcSecPerSec && dRaRateArcSecPerSec < 0.00001 && -0.00001 < dDecRateArcSecPerSec && dDecRateArcSecPerSec < 0.00001) {
-                strcpy(szCmd, ":RT3#");  // use 'macro' command to set sidereal/king (King is better)
+                nCmdId = CMD_RT3;  // use 'macro' command to set sidereal/king (King is better)
                 nErr = ERR_COMMANDNOTSUPPORTED;
                 m_fCustomRaMultiplier = 1.0;  // set immediately b/c we dont overwhelm the mount and take current cached values
                 m_nTrackingRate = TRACKING_KING; // set immediately b/c we dont overwhelm the mount and take current cached values
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-                if (Logfile) {
-                    fprintf(Logfile, "[%s] [CiOptron::setTrackingRates] interpreted incoming rate as sidereal! \n", getTimestamp());
-                    fflush(Logfile);
+                if (Logfile->enabled(LOG_TRACKING, LOG_DEBUG)) {
+                    Logfile->log("[CiOptron::setTrackingRates] interpreted incoming rate as sidereal! \n");
                 }
-#endif
             }
             // Lunar rate (tolerances increased based on JPL ephemeris generator)
             else if (0.30 < dRaRateArcSecPerSec && dRaRateArcSecPerSec < 0.83 && -0.25 < dDecRateArcSecPerSec && dDecRateArcSecPerSec < 0.25) {
-                strcpy(szCmd, ":RT1#");  // use 'macro' command to set to lunar
+                nCmdId = CMD_RT1;  // use 'macro' command to set to lunar
                 nErr = ERR_COMMANDNOTSUPPORTED;
                 m_fCustomRaMultiplier = 1.0;  // set cache immediately
                 m_nTrackingRate = TRACKING_LUNAR; // set immediately b/c we dont overwhelm the mount and take current cached values
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-                if (Logfile) {
-                    fprintf(Logfile, "[%s] [CiOptron::setTrackingRates] interpreted incoming rate as lunar! \n", getTimestamp());
-                    fflush(Logfile);
+                if (Logfile->enabled(LOG_TRACKING, LOG_DEBUG)) {
+                    Logfile->log("[CiOptron::setTrackingRates] interpreted incoming rate as lunar! \n");
                 }
-#endif
             }
             // Solar rate (tolerances increased based on JPL ephemeris generator, since TSX demanded a rate outside previous tolerance)
             else if (0.037 < dRaRateArcSecPerSec && dRaRateArcSecPerSec < 0.043 && -0.017 < dDecRateArcSecPerSec && dDecRateArcSecPerSec < 0.017) {
-                strcpy(szCmd, ":RT2#");  // use 'macro' command to set to solar
+                nCmdId = CMD_RT2;  // use 'macro' command to set to solar
                 nErr = ERR_COMMANDNOTSUPPORTED;
                 m_fCustomRaMultiplier = 1.0; // set cache immediately
                 m_nTrackingRate = TRACKING_SOLAR; // set immediately b/c we dont overwhelm the mount and take current cached values
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-                if (Logfile) {
-                    fprintf(Logfile, "[%s] [CiOptron::setTrackingRates] interpreted incoming rate as solar! \n", getTimestamp());
-                    fflush(Logfile);
+                if (Logfile->enabled(LOG_TRACKING, LOG_DEBUG)) {
+                    Logfile->log("[CiOptron::setTrackingRates] interpreted incoming rate as solar! \n");
                 }
-#endif
             } else {
                 // full custom rate (tracking a satellite or comet or TSX asked (via user request) to add tracking)
                 dMountMultiplierRa = (15.0410681 - dRaRateArcSecPerSec) / 15.0410681;
                 if (dMountMultiplierRa < 0.0001) {
                     // trying to 'stop' tracking by sending us sidereal.  ok,.. lets not do custom tracking
-                    strcpy(szCmd, ":ST0#");  // use command to stop tracking
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-                    if (Logfile) {
-                        fprintf(Logfile, "[%s] [CiOptron::setTrackingRates] interpreted incoming rate as wanting to be stopped! \n", getTimestamp());
-                        fflush(Logfile);
+                    nCmdId = CMD_ST0;  // use command to stop tracking
+                    if (Logfile->enabled(LOG_TRACKING, LOG_DEBUG)) {
+                        Logfile->log("[CiOptron::setTrackingRates] interpreted incoming rate as wanting to be stopped! \n");
                     }
-#endif
                 } else {
                     bCustomRate = true;
                     m_fCustomRaMultiplier = dMountMultiplierRa;  // cache on instance since we dont ask mount over and over all the time
                     m_nTrackingRate = TRACKING_CUSTOM; // set immediately b/c we dont overwhelm the mount and take current cached values
-                    memset(szCmdTmp, 0, SERIAL_BUFFER_SIZE);  // prep temp buffer to write to
-                    snprintf(szCmdTmp, SERIAL_BUFFER_SIZE, ":RR%1.4f#", dMountMultiplierRa);  // write including decimal to make it easy to remove
-
-                    memset(szCmd, 0, SERIAL_BUFFER_SIZE);  // prep actual buffer to send to mount
-                    memcpy(szCmd, szCmdTmp, 4);  // copy before decimal
-                    memcpy(szCmd+4, szCmdTmp+5, 5);  // copy after decimal
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-                    if (Logfile) {
-                        fprintf(Logfile, "[%s] [CiOptron::setTrackingRates] interpreted incoming rate as custom! \n", getTimestamp());
-                        fprintf(Logfile, "[%s] [CiOptron::setTrackingRates] we are at a custom rate!  Sending mount ra multiplier command: %s\n", getTimestamp(), szCmd);
-                        fflush(Logfile);
+                    if(!formatCustomRateCommand(szCmd, IOPTRON_CMD_BUFFER_SIZE, dMountMultiplierRa))
+                        return COMMAND_FAILED;  // 10x sidereal or more, can't be sent
+                    if (Logfile->enabled(LOG_TRACKING, LOG_DEBUG)) {
+                        Logfile->log("[CiOptron::setTrackingRates] interpreted incoming rate as custom! \n");
+                        Logfile->log("[CiOptron::setTrackingRates] we are at a custom rate!  Sending mount ra multiplier command: %s\n", szCmd);
                     }
-#endif
-                    nErr = sendCommand(szCmd, szResp, 1);  // sets tracking rate and returns a single byte
-                    if (nErr)
-                        return nErr;
-                    strcpy(szCmd, ":RT4#");  // use 'macro' command to set to custom
+                    // TheSkyX calls again whenever the rate changes, most calls don't change the :RR value
+                    if(customRateValue(dMountMultiplierRa) != m_nCustomRateValue) {
+                        nErr = sendCommand(CMD_RR, szCmd, szResp);  // sets tracking rate and returns a single byte
+                        if (nErr)
+                            return nErr;
+                        m_nCustomRateValue = customRateValue(dMountMultiplierRa);
+                    }
+                    else if (Logfile->enabled(LOG_TRACKING, LOG_DEBUG)) {
+                        Logfile->log("[CiOptron::setTrackingRates] same :RR value as the last one sent, not sent again\n");
+                    }
+                    nCmdId = CMD_RT4;  // use 'macro' command to set to custom
                 }
 
             }
 
         }
 
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-        fprintf(Logfile, "[%s] [CiOptron::setTrackingRates] tracking on: %s, determined we are custom: %s.  Sending command: %s\n", getTimestamp(), bTrackingOn?"true":"false", bCustomRate?"true":"false", szCmd);
-        fflush(Logfile);
-#endif
-        nErr = sendCommand(szCmd, szResp, 1);  // set tracking 'go'.  all commands return a single byte
+        if (Logfile->enabled(LOG_TRACKING, LOG_DEBUG)) {
+            Logfile->log("[CiOptron::setTrackingRates] tracking on: %s, determined we are custom: %s.  Sending command: %s\n", bTrackingOn?"true":"false", bCustomRate?"true":"false", commandInfo(nCmdId).pszCmd);
+        }
+        nErr = sendCommand(nCmdId, szResp);  // set tracking 'go'.  all commands return a single byte
         if (nErr)
             return nErr;
     }
@@ -720,24 +893,93 @@ int CiOptron::setTrackingRates(bool bTrackingOn, bool bIgnoreRates, double dRaRa
     return nErr;
 }
 
+#pragma mark - custom rate streaming
+int CiOptron::startRateStream(const std::vector<iOptronRatePoint> &profile, int nPeriodMs)
+{
+    if(!m_bIsConnected)
+        return NOT_CONNECTED;
+    if(m_RateStream.start(profile, m_nCustomRateValue, nPeriodMs))
+        return COMMAND_FAILED;
+    return selectCustomRate();
+}
+
+int CiOptron::startRateStream(RateEphemerisCallback pfEphemeris, void *pUserData, int nPeriodMs)
+{
+    if(!m_bIsConnected)
+        return NOT_CONNECTED;
+    if(m_RateStream.start(pfEphemeris, pUserData, m_nCustomRateValue, nPeriodMs))
+        return COMMAND_FAILED;
+    return selectCustomRate();
+}
+
+void CiOptron::stopRateStream()
+{
+    if(!m_RateStream.running())
+        return;
+    m_RateStream.stop();
+    if (Logfile->enabled(LOG_TRACKING, LOG_DEBUG)) {
+        iOptronRateStreamCounters counters;
+        m_RateStream.getCounters(counters);
+        Logfile->log("[CiOptron::stopRateStream] %lu ticks, %lu :RR sent, %lu skipped under the 0.0001 resolution\n", counters.nTicks, counters.nSent, counters.nSkipped);
+    }
+}
+
+// the scheduler sends the first :RR right away, on its own thread
+int CiOptron::selectCustomRate()
+{
+    int nErr;
+    char szResp[SERIAL_BUFFER_SIZE];
+
+    nErr = sendCommand(CMD_RT4, szResp);
+    if(nErr) {
+        m_RateStream.stop();
+        return nErr;
+    }
+    m_nTrackingRate = TRACKING_CUSTOM;
+    return nErr;
+}
+
+// On the rate stream scheduler thread, sendCommand() holds the link lock for the exchange
+int CiOptron::sendStreamRate(double dMountMultiplierRa, void *pUserData)
+{
+    CiOptron *pMe = (CiOptron *)pUserData;
+    int nErr;
+    char szCmd[IOPTRON_CMD_BUFFER_SIZE];
+    char szResp[SERIAL_BUFFER_SIZE];
+
+    if(!formatCustomRateCommand(szCmd, IOPTRON_CMD_BUFFER_SIZE, dMountMultiplierRa))
+        return COMMAND_FAILED;
+    nErr = pMe->sendCommand(commandInfo(CMD_RR), szCmd, (int)strlen(szCmd), szResp, LINK_USER_RATE_STREAM);
+    if(nErr) {
+        pMe->m_nCustomRateValue = -1;
+        return nErr;
+    }
+    pMe->m_fCustomRaMultiplier = (float)dMountMultiplierRa;
+    pMe->m_nCustomRateValue = customRateValue(dMountMultiplierRa);
+    if (pMe->Logfile->enabled(LOG_TRACKING, LOG_VERBOSE)) {
+        pMe->Logfile->log("[CiOptron::sendStreamRate] %s\n", szCmd);
+    }
+    return nErr;
+}
+
 int CiOptron::getTrackRates(bool &bTrackingOn, double &dTrackRaArcSecPerSec, double &dTrackDecArcSecPerSec)
 {
     int nErr = IOPTRON_OK;
     char szResp[SERIAL_BUFFER_SIZE];
     double fRa = m_fCustomRaMultiplier;  // initialize with cached value
 
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::getTrackRates] called.\n", getTimestamp());
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_TRACKING, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::getTrackRates] called.\n");
     }
-#endif
     memset(szResp, 0, SERIAL_BUFFER_SIZE);
 
     // don't ask the mount its general status too often .. doesn't change much
-    if(trackRatesTimer.GetElapsedSeconds()>1.0) {
+    if(trackRatesTimer.elapsedNs() > NS_PER_SECOND || (m_nStaleCaches & CACHE_STATUS)) {
+        if(m_pTrace->enabled())
+            m_pTrace->instant("status cache miss", "cache", "getTrackRates");
         getInfoAndSettings();
-        trackRatesTimer.Reset();
+        trackRatesTimer.reset();
+        m_nLastResponseAgeNs = 0;
 
         // iOptron bug in firmware: this always returns 1.0000: :GTR#
         // Response: “nnnnn#”
@@ -752,14 +994,16 @@ int CiOptron::getTrackRates(bool &bTrackingOn, double &dTrackRaArcSecPerSec, dou
 //        memcpy(szRa+2, szResp+1, 4);
 //        fRa = atof(szRa);
 
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-        if (Logfile) {
-            fprintf(Logfile, "[%s] [CiOptron::getTrackRates] asked mount for actual rate multiplier.  response: %s.  And interpreted to be a double: %f.\n", getTimestamp(), szResp, fRa);
-            fflush(Logfile);
+        if (Logfile->enabled(LOG_TRACKING, LOG_DEBUG)) {
+            Logfile->log("[CiOptron::getTrackRates] asked mount for actual rate multiplier.  response: %s.  And interpreted to be a double: %f.\n", szResp, fRa);
         }
-#endif
 
     }
+    else {
+        m_nLastResponseAgeNs = statusAgeTimer.elapsedNs();
+        if(m_pTrace->enabled())
+            m_pTrace->instant("status cache hit", "cache", "getTrackRates", m_nLastResponseAgeNs / 1000);
+    }
 
     switch (m_nStatus) {
         case STOPPED:
@@ -830,12 +1074,9 @@ int CiOptron::getTrackRates(bool &bTrackingOn, double &dTrackRaArcSecPerSec, dou
             dTrackDecArcSecPerSec = 0.0;
             break;
     }
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::getTrackRates] done. returning: bTrackingOn: %s, dTrackRaArcSecPerSec: %f, dTrackDecArcSecPerSec: %f\n", getTimestamp(), bTrackingOn?"true":"false", dTrackRaArcSecPerSec, dTrackDecArcSecPerSec);
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_TRACKING, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::getTrackRates] done. returning: bTrackingOn: %s, dTrackRaArcSecPerSec: %f, dTrackDecArcSecPerSec: %f\n", bTrackingOn?"true":"false", dTrackRaArcSecPerSec, dTrackDecArcSecPerSec);
     }
-#endif
     return nErr;
 }
 
@@ -845,25 +1086,19 @@ int CiOptron::gotoZeroPosition() {
 
     int nErr = IOPTRON_OK;
     char szResp[SERIAL_BUFFER_SIZE];
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::gotoZeroPosition] called \n", getTimestamp());
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_SLEW, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::gotoZeroPosition] called \n");
     }
-#endif
 
     // Goto Zero position / home position
-    nErr = sendCommand(":MH#", szResp, 1);
+    nErr = sendCommand(CMD_MH, szResp);
 
     if (nErr)
         return nErr;
 
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::gotoZeroPosition] finished.  Result: %s\n", getTimestamp(), szResp);
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_SLEW, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::gotoZeroPosition] finished.  Result: %s\n", szResp);
     }
-#endif
 
     return nErr;
 
@@ -887,64 +1122,46 @@ int CiOptron::gotoFlatsPosition() {
     int nErr = IOPTRON_OK;
     char szResp[SERIAL_BUFFER_SIZE];
 
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::gotoFlatsPosition] called \n", getTimestamp());
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_SLEW, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::gotoFlatsPosition] called \n");
     }
-#endif
 
     // set alt/az position
     // altitude: :SasTTTTTTTT# (Valid data range is [-32,400,000, 32,400,000])
-    nErr = sendCommand(":Sa+32400000#", szResp, 1);  // point straight up
+    nErr = sendCommand(CMD_SA_ZENITH, szResp);  // point straight up
     if (nErr) {
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-        if (Logfile) {
-            fprintf(Logfile, "[%s] [CiOptron::gotoFlatsPosition] error %i sending :Sa+32400000# : %s\n", getTimestamp(), nErr, szResp);
-            fflush(Logfile);
+        if (Logfile->enabled(LOG_SLEW, LOG_ERROR)) {
+            Logfile->log("[CiOptron::gotoFlatsPosition] error %i sending :Sa+32400000# : %s\n", nErr, szResp);
         }
-#endif
         return nErr;
     }
     // azimuth: :SzTTTTTTTTT# (Valid data range is [0, 129,600,000])
-    nErr = sendCommand(":Sz000000000#", szResp, 1);  // point north
+    nErr = sendCommand(CMD_SZ_NORTH, szResp);  // point north
     if (nErr) {
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-        if (Logfile) {
-            fprintf(Logfile, "[%s] [CiOptron::gotoFlatsPosition] error %i sending :Sz000000000# : %s\n", getTimestamp(), nErr, szResp);
-            fflush(Logfile);
+        if (Logfile->enabled(LOG_SLEW, LOG_ERROR)) {
+            Logfile->log("[CiOptron::gotoFlatsPosition] error %i sending :Sz000000000# : %s\n", nErr, szResp);
         }
-#endif
         return nErr;
     }
 
     // Goto Zero alt/az position defined
-    nErr = sendCommand(":MSS#", szResp, 1);
+    nErr = sendCommand(CMD_MSS, szResp);
     if (nErr) {
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-        if (Logfile) {
-            fprintf(Logfile, "[%s] [CiOptron::gotoFlatsPosition] error %i sending :MSS# : %s\n", getTimestamp(), nErr, szResp);
-            fflush(Logfile);
+        if (Logfile->enabled(LOG_SLEW, LOG_ERROR)) {
+            Logfile->log("[CiOptron::gotoFlatsPosition] error %i sending :MSS# : %s\n", nErr, szResp);
         }
-#endif
         return nErr;
     }
 
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::gotoFlatsPosition] MSS slew command finished.  Result (want 1): %s\n", getTimestamp(), szResp);
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_SLEW, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::gotoFlatsPosition] MSS slew command finished.  Result (want 1): %s\n", szResp);
     }
-#endif
     // dont track
-    nErr = sendCommand(":ST0#", szResp, 1);
+    nErr = sendCommand(CMD_ST0, szResp);
 
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::gotoFlatsPosition] finished.  Result of final stop-tracking command (want 0): %i\n", getTimestamp(), nErr);
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_SLEW, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::gotoFlatsPosition] finished.  Result of final stop-tracking command (want 0): %i\n", nErr);
     }
-#endif
 
     return nErr;
 
@@ -955,22 +1172,16 @@ int CiOptron::findZeroPosition() {
 
     int nErr = IOPTRON_OK;
     char szResp[SERIAL_BUFFER_SIZE];
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::calibrateZeroPosition] called \n", getTimestamp());
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_SLEW, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::calibrateZeroPosition] called \n");
     }
-#endif
 
     // Find Zero position / home position
-    nErr = sendCommand(":MSH#", szResp, 1);
+    nErr = sendCommand(CMD_MSH, szResp);
 
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::calibrateZeroPosition] finished.  Result: %s\n", getTimestamp(), szResp);
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_SLEW, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::calibrateZeroPosition] finished.  Result: %s\n", szResp);
     }
-#endif
 
     return nErr;
 
@@ -980,31 +1191,23 @@ int CiOptron::getUtcOffsetAndDST(char *pszUtcOffsetInMins, bool &bDaylight)
 {
     int nErr = IOPTRON_OK;
     char szResp[SERIAL_BUFFER_SIZE];
-    char szTmp[SERIAL_BUFFER_SIZE];
+    int64_t nParseStartNs;
 
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::getUtcOffsetAndDST] called \n", getTimestamp());
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_UI, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::getUtcOffsetAndDST] called \n");
     }
-#endif
 
     // Get time related info
-    nErr = sendCommand(":GUT#", szResp, 19);
+    nErr = sendCommand(CMD_GUT, szResp);
 
     memset(pszUtcOffsetInMins,0, SERIAL_BUFFER_SIZE);
-    memcpy(pszUtcOffsetInMins, szResp, 4);
-
-    memset(szTmp,0, SERIAL_BUFFER_SIZE);
-    memcpy(szTmp, szResp+4, 1);
-    bDaylight = (atoi(szTmp) == 1);
+    nParseStartNs = m_pClock->nowNs();
+    if(!nErr && accountParseTime(parseUtcOffsetReply(szResp, pszUtcOffsetInMins, bDaylight), nParseStartNs))
+        nErr = IOPTRON_BAD_CMD_RESPONSE;
 
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::getUtcOffsetAndDST] finished.  nErr = %i, Command Result: %s, utcOffsetInMins: %s, daylight: %s\n", getTimestamp(), nErr, szResp, pszUtcOffsetInMins, bDaylight?"true":"false");
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_UI, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::getUtcOffsetAndDST] finished.  nErr = %i, Command Result: %s, utcOffsetInMins: %s, daylight: %s\n", nErr, szResp, pszUtcOffsetInMins, bDaylight?"true":"false");
     }
-#endif
 
     return nErr;
 }
@@ -1015,12 +1218,9 @@ int CiOptron::setUtcOffset(char *pszUtcOffsetInMins)
     char szResp[SERIAL_BUFFER_SIZE];
     char szCmd[SERIAL_BUFFER_SIZE];
 
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::setUtcOffset] called \n", getTimestamp());
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_UI, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::setUtcOffset] called \n");
     }
-#endif
 
     // :SGsMMM#
     // This command sets the minute offset from UTC (The Daylight-Saving Time will
@@ -1029,21 +1229,15 @@ int CiOptron::setUtcOffset(char *pszUtcOffsetInMins)
 
     snprintf(szCmd, SERIAL_BUFFER_SIZE, ":SG%s#", pszUtcOffsetInMins);
 
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::setUtcOffset] buffer to send to mount %s\n", getTimestamp(), szCmd);
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_UI, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::setUtcOffset] buffer to send to mount %s\n", szCmd);
     }
-#endif
 
-    nErr = sendCommand(szCmd, szResp, 1);
+    nErr = sendCommand(CMD_SG, szCmd, szResp);
 
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::setUtcOffset] done, nErr = %i\n", getTimestamp(), nErr);
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_UI, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::setUtcOffset] done, nErr = %i\n", nErr);
     }
-#endif
 
     return nErr;
 }
@@ -1052,14 +1246,11 @@ int CiOptron::setDST(bool bDaylight)
 {
     int nErr = IOPTRON_OK;
     char szResp[SERIAL_BUFFER_SIZE];
-    char szCmd[SERIAL_BUFFER_SIZE];
+    char szCmd[IOPTRON_CMD_BUFFER_SIZE];
 
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::setDST] called \n", getTimestamp());
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_UI, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::setDST] called \n");
     }
-#endif
 
     //  Command: “:SDS0#” or “:SDS1#”
     //  Response: “1”
@@ -1067,135 +1258,99 @@ int CiOptron::setDST(bool bDaylight)
     //  “:SDS1#” means Daylight Saving Time has been observed,
     //  “:SDS0#” means Daylight Saving Time has not been observed.
 
-    snprintf(szCmd, SERIAL_BUFFER_SIZE, ":SDS%.1d#", bDaylight?1:0);
+    formatDSTCommand(szCmd, IOPTRON_CMD_BUFFER_SIZE, bDaylight);
 
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::setDST] buffer to send to mount %s\n", getTimestamp(), szCmd);
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_UI, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::setDST] buffer to send to mount %s\n", szCmd);
     }
-#endif
 
-    nErr = sendCommand(szCmd, szResp, 1);
+    nErr = sendCommand(CMD_SDS, szCmd, szResp);
 
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::setDST] done, nErr = %i\n", getTimestamp(), nErr);
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_UI, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::setDST] done, nErr = %i\n", nErr);
     }
-#endif
 
     return nErr;
 }
 
-int CiOptron::getLocation(float &fLat, float &fLong) // make passive version
+int CiOptron::getLocation(CCentiArcsec &Lat, CCentiArcsec &Long) // make passive version
 {
     int nErr = IOPTRON_OK;
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::getLocation] called \n", getTimestamp());
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_CACHE, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::getLocation] called \n");
     }
-#endif
 
     getInfoAndSettings();  // this case we want to be accurate
-    getLocationPassive(fLat, fLong); // no way error would have been returned
+    getLocationPassive(Lat, Long); // no way error would have been returned
 
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::getLocation] finished.  Result: Latitude: %g, Longitude %g, with error code: %i\n", getTimestamp(), fLat, fLong, nErr);
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_CACHE, LOG_ERROR)) {
+        Logfile->log("[CiOptron::getLocation] finished.  Result: Latitude: %g, Longitude %g, with error code: %i\n", Lat.degrees(), Long.degrees(), nErr);
     }
-#endif
 
     return nErr;
 }
 
-int CiOptron::getLocationPassive(float &fLat, float &fLong)
+int CiOptron::getLocationPassive(CCentiArcsec &Lat, CCentiArcsec &Long)
 {
     int nErr = IOPTRON_OK;
 
-    fLat = m_fLat;
-    fLong = m_fLong;
+    Lat = m_Lat;
+    Long = m_Long;
 
     return nErr;
 }
 
-int CiOptron::setLocation(float fLat, float fLong)
+int CiOptron::setLocation(const CCentiArcsec &Lat, const CCentiArcsec &Long)
 {
     int nErr = IOPTRON_OK;
     char szResp[SERIAL_BUFFER_SIZE];
-    char szCmd[SERIAL_BUFFER_SIZE];
-    long lLatToSend;
-    long lLongToSend;
+    char szCmd[IOPTRON_CMD_BUFFER_SIZE];
 
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::setLocation] called \n", getTimestamp());
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_UI, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::setLocation] called \n");
     }
-#endif
-
-    //  extracting lat:   m_fLat = ((atof(szTmp)-32400000)*0.01)/ 60.0 /60.0;
-    lLatToSend = (fLat * 60.0 * 60.0 / 0.01);
 
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::setLocation] setting Latitude from %f to iOptron value %d\n", getTimestamp(), m_fLat, lLatToSend);
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_UI, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::setLocation] setting Latitude from %f to iOptron value %lld\n", m_Lat.degrees(), (long long)Lat.raw());
     }
-#endif
 
     //  Command: “:SLAsTTTTTTTT#”
     //  Response: “1”
     //  This command sets the current latitude. Valid data range is [-32,400,000, +32,400,000].
     //  Note: North is positive, and the resolution is 0.01 arc-second.
 
-    snprintf(szCmd, SERIAL_BUFFER_SIZE, ":SLA%+09d#", lLatToSend);
+    if(!formatLatitudeCommand(szCmd, IOPTRON_CMD_BUFFER_SIZE, Lat))
+        return COMMAND_FAILED;
 
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::setLocation] buffer to send for Lat to mount %s\n", getTimestamp(), szCmd);
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_UI, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::setLocation] buffer to send for Lat to mount %s\n", szCmd);
     }
-#endif
 
-    nErr = sendCommand(szCmd, szResp, 1);
+    nErr = sendCommand(CMD_SLA, szCmd, szResp);
 
-    if (atoi(szResp) != 1) {
+    if (parseDigitReply(szResp) != 1) {
         return 1; // meaning error
     }
-    // extracing long:   m_fLong = (atof(szTmp)*0.01)/ 60.0 /60.0;
-    lLongToSend = (fLong * 60.0 * 60.0 / 0.01);
-
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::setLocation] setting Longitude from %f to iOptron value %d\n", getTimestamp(), m_fLong, lLongToSend);
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_UI, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::setLocation] setting Longitude from %f to iOptron value %lld\n", m_Long.degrees(), (long long)Long.raw());
     }
-#endif
     //
     //  Command: “:SLOsTTTTTTTT#”
     //  Response: “1”
     //  This command sets the current longitude. Valid data range is [-64,800,000, +64,800,000].
     //  Note: East is positive, and the resolution is 0.01 arc-second.
 
-    snprintf(szCmd, SERIAL_BUFFER_SIZE, ":SLO%+09d#", lLongToSend);
+    if(!formatLongitudeCommand(szCmd, IOPTRON_CMD_BUFFER_SIZE, Long))
+        return COMMAND_FAILED;
 
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::setLocation] buffer to send for Long to mount %s\n", getTimestamp(), szCmd);
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_UI, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::setLocation] buffer to send for Long to mount %s\n", szCmd);
     }
-#endif
-    nErr = sendCommand(szCmd, szResp, 1);
+    nErr = sendCommand(CMD_SLO, szCmd, szResp);
 
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::setLocation] done, nErr = %i\n", getTimestamp(), nErr);
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_UI, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::setLocation] done, nErr = %i\n", nErr);
     }
-#endif
 
     // update data after setting the new values.
     getInfoAndSettings();
@@ -1209,7 +1364,7 @@ int CiOptron::setTimeAndDate(double dJulianDateRightNow)
     int nErr = IOPTRON_OK;
     double dMountsDesiredJulianDateOffset;
     char szResp[SERIAL_BUFFER_SIZE];
-    char szCmd[SERIAL_BUFFER_SIZE];
+    char szCmd[IOPTRON_CMD_BUFFER_SIZE];
 
 //    Command: “:SUTXXXXXXXXXXXXX#”
 //    Response: “1”
@@ -1217,31 +1372,23 @@ int CiOptron::setTimeAndDate(double dJulianDateRightNow)
 //    Note: JD(current UTC time) means Julian Date of current UTC time. The resolution is 1 millisecond.
 
     dMountsDesiredJulianDateOffset = (dJulianDateRightNow-2451545.0L)*86400000.0L;
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::setTimeAndDate] calculated float: %f as the JD time offset\n", getTimestamp(), dMountsDesiredJulianDateOffset);
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_UI, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::setTimeAndDate] calculated float: %f as the JD time offset\n", dMountsDesiredJulianDateOffset);
     }
-#endif
-    snprintf(szCmd, SERIAL_BUFFER_SIZE, ":SUT%013.0f#", dMountsDesiredJulianDateOffset);
+    if(!formatUtcTimeCommand(szCmd, IOPTRON_CMD_BUFFER_SIZE, dMountsDesiredJulianDateOffset))
+        return COMMAND_FAILED;
 
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::setTimeAndDate] will send command %s to mount\n", getTimestamp(), szCmd);
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_UI, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::setTimeAndDate] will send command %s to mount\n", szCmd);
     }
-#endif
 
-    nErr = sendCommand(szCmd, szResp, 1);
+    nErr = sendCommand(CMD_SUT, szCmd, szResp);
 
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::setTimeAndDate] done, response is %s nErr = %i\n", getTimestamp(), szResp, nErr);
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_UI, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::setTimeAndDate] done, response is %s nErr = %i\n", szResp, nErr);
     }
-#endif
 
-    if (atoi(szResp) != 1) {
+    if (parseDigitReply(szResp) != 1) {
         return 1; // meaning error
     } else {
         return nErr;  // return any communication error or 0 if none
@@ -1370,34 +1517,25 @@ int CiOptron::getLimits(double &dHoursEast, double &dHoursWest)
     dHoursWest = m_nDegreesPastMeridian / 15.0;
     dHoursEast = m_nDegreesPastMeridian / 15.0;
 
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::getLimits] called. scope setup for %i degrees past meridian. returning hoursEast %f, hoursWest %f\n", getTimestamp(), m_nDegreesPastMeridian, dHoursEast, dHoursWest);
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_SLEW, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::getLimits] called. scope setup for %i degrees past meridian. returning hoursEast %f, hoursWest %f\n", m_nDegreesPastMeridian, dHoursEast, dHoursWest);
     }
-#endif
     return nErr;
 }
 
 int CiOptron::beyondThePole(bool& bYes)
 {
     int nErr = IOPTRON_OK;
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::beyondThePole] called. \n", getTimestamp());
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_SLEW, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::beyondThePole] called. \n");
     }
-#endif
 
     //bYes = (m_pierStatus == PIER_WEST) && (m_counterWeightStatus == COUNTER_WEIGHT_UP); // this means beyond the meridian
     bYes = (m_pierStatus == PIER_WEST);  // this means OTA even hinting to be on that side of the pier.  Likely this is what TSX wants
 
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::beyondThePole] finished.  Returned: %s since piers is: %s \n", getTimestamp(), bYes?"true":"false", (m_pierStatus==PIER_EAST)?"pier east" : (m_pierStatus==PIER_WEST)?"pier west":"pier indeterminate");
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_SLEW, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::beyondThePole] finished.  Returned: %s since piers is: %s \n", bYes?"true":"false", (m_pierStatus==PIER_EAST)?"pier east" : (m_pierStatus==PIER_WEST)?"pier west":"pier indeterminate");
     }
-#endif
     return nErr;
 }
 
@@ -1412,37 +1550,31 @@ int CiOptron::startSlewTo(double dRaInDecimalHours, double dDecInDecimalDegrees)
     bool bGPSOrLatLongGood;
     char szResp[SERIAL_BUFFER_SIZE];
 
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::startSlewTo] called Ra: %f and Dec: %f\n", getTimestamp(), dRaInDecimalHours, dDecInDecimalDegrees);
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_SLEW, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::startSlewTo] called Ra: %f and Dec: %f\n", dRaInDecimalHours, dDecInDecimalDegrees);
     }
-#endif
 
     nErr = isGPSOrLatLongGood(bGPSOrLatLongGood);
     if (nErr) {
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-        fprintf(Logfile, "[%s] [CiOptron::startSlewTo] Error calling isGPSOrLatLongGood.  nErr: %i\n", getTimestamp(), nErr);
-        fflush(Logfile);
-#endif
+        if (Logfile->enabled(LOG_SLEW, LOG_ERROR)) {
+            Logfile->log("[CiOptron::startSlewTo] Error calling isGPSOrLatLongGood.  nErr: %i\n", nErr);
+        }
         return nErr;
     }
 
     if (!bGPSOrLatLongGood) {
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-        if (Logfile) {
-            fprintf(Logfile, "[%s] [CiOptron::startSlewTo] called Ra: %f and Dec: %f .. ABORTING due to GPS signal not being good OR lat/long not being set properly\n", getTimestamp(), dRaInDecimalHours, dDecInDecimalDegrees);
-            fflush(Logfile);
+        if (Logfile->enabled(LOG_SLEW, LOG_DEBUG)) {
+            Logfile->log("[CiOptron::startSlewTo] called Ra: %f and Dec: %f .. ABORTING due to GPS signal not being good OR lat/long not being set properly\n", dRaInDecimalHours, dDecInDecimalDegrees);
         }
-#endif
         return ERR_ABORTEDPROCESS;
     }
-    nErr = setRaAndDec("CiOptron::startSlewTo", dRaInDecimalHours, dDecInDecimalDegrees);
+    m_GotoRaTarget = CCentiArcsec::fromHours(dRaInDecimalHours);
+    m_GotoDecTarget = CCentiArcsec::fromDegrees(dDecInDecimalDegrees);
+    nErr = setRaAndDec("CiOptron::startSlewTo", m_GotoRaTarget, m_GotoDecTarget);
     if (nErr) {
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-        fprintf(Logfile, "[%s] [CiOptron::startSlewTo] Error: error setting ra and Dec.  nErr: %i\n", getTimestamp(), nErr);
-        fflush(Logfile);
-#endif
+        if (Logfile->enabled(LOG_SLEW, LOG_ERROR)) {
+            Logfile->log("[CiOptron::startSlewTo] Error: error setting ra and Dec.  nErr: %i\n", nErr);
+        }
         return nErr;
     }
 
@@ -1451,119 +1583,73 @@ int CiOptron::startSlewTo(double dRaInDecimalHours, double dDecInDecimalDegrees)
     //This command queries the number of available position for most recently defined right ascension and declination coordinates
     // which not exceed the mechanical limits, altitude limits and meridian flip limits (including normal position and counterweight up position).
     // Checking if we will exceed mount's limits.  The possible response is  0#, 1# and 2#.
-//    nErr = sendCommand(":QAP#", szResp, 2);
-//    if (nErr) {
-//#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-//        fprintf(Logfile, "[%s] [CiOptron::startSlewTo] Error: sendCommand bombed sending :QAP#.  nErr: %i\n", getTimestamp(), nErr);
-//        fflush(Logfile);
-//#endif
-//        return nErr;
-//    }
-//    szResp[1] = 0;
-//    m_nCacheLimitStatus = atoi(szResp);   // again 0 = problem, 1=ok with 1 position to slew to, 2=ok with two positions to slew to
-//
-//    if (m_nCacheLimitStatus == LIMITS_EXCEEDED_OR_BELOW_ALTITUDE) {
-//#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-//        if (Logfile) {
-//            fprintf(Logfile, "[%s] [CiOptron::startSlewTo] Warning: Commands:  Ra [0, 129,600,000]: %s and Dec [-32,400,000, +32,400,000]: %s exceed mechanical limits, altitude limits or meridian flip limits.\n", getTimestamp(), szCmdRa, szCmdDec);
-//            fflush(Logfile);
-//        }
-//#endif
-//        return ERR_LIMITSEXCEEDED;
-//    }
-
-//#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-//    if (Logfile) {
-//        fprintf(Logfile, "[%s] [CiOptron::startSlewTo] Slewing to 1 of %i position(s) using commands:  Ra [0, 129,600,000]: %s and Dec [-32,400,000, +32,400,000]: %s\n", getTimestamp(), m_nCacheLimitStatus, szCmdRa, szCmdDec);
-//        fflush(Logfile);
-//    }
-//#endif
+    // Not sent for now, the slew always goes to the normal position.
     m_nCacheLimitStatus = NO_ISSUE_SLEW_TRACK_ONE_OPTION;
     if (m_nCacheLimitStatus == NO_ISSUE_SLEW_TRACK_ONE_OPTION) {
         // :MS1#   slew to normal position
         memset(szResp, 0, SERIAL_BUFFER_SIZE);  // clear response buffer
-        nErr = sendCommand(":MS1#", szResp, 1);
-        #if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-        if (nErr) {
-            fprintf(Logfile, "[%s] [CiOptron::startSlewTo] Error: sendCommand bombed sending :MS1.  nErr: %i\n", getTimestamp(), nErr);
-            fflush(Logfile);
+        nErr = sendCommand(CMD_MS1, szResp);
+        if (Logfile->enabled(LOG_SLEW, LOG_ERROR)) {
+            if (nErr) {
+                Logfile->log("[CiOptron::startSlewTo] Error: sendCommand bombed sending :MS1.  nErr: %i\n", nErr);
+            }
         }
-        #endif
     } else if (m_nCacheLimitStatus == NO_ISSUE_SLEW_TRACK_TWO_OPTIONS) {
         // :MS2#   slew to counterweight up position I think
         memset(szResp, 0, SERIAL_BUFFER_SIZE);  // clear response buffer
-        nErr = sendCommand(":MS2#", szResp, 1);
-        #if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
+        nErr = sendCommand(CMD_MS2, szResp);
         if (nErr) {
-            if (Logfile) {
-                fprintf(Logfile, "[%s] [CiOptron::startSlewTo] Error: sendCommand bombed sending :MS2.  nErr: %i\n", getTimestamp(), nErr);
-                fflush(Logfile);
+            if (Logfile->enabled(LOG_SLEW, LOG_ERROR)) {
+                Logfile->log("[CiOptron::startSlewTo] Error: sendCommand bombed sending :MS2.  nErr: %i\n", nErr);
             }
         }
-        #endif
     } else if (m_nCacheLimitStatus == LIMITS_EXCEEDED_OR_BELOW_ALTITUDE) {
-        #if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-        if (Logfile) {
-            fprintf(Logfile, "[%s] [CiOptron::startSlewTo] m_nCacheLimitStatus == LIMITS_EXCEEDED_OR_BELOW_ALTITUDE !!!  \n", getTimestamp());
-            fflush(Logfile);
+        if (Logfile->enabled(LOG_SLEW, LOG_DEBUG)) {
+            Logfile->log("[CiOptron::startSlewTo] m_nCacheLimitStatus == LIMITS_EXCEEDED_OR_BELOW_ALTITUDE !!!  \n");
         }
-        #endif
         return ERR_LIMITSEXCEEDED;  // redundant but just in case
     }
 
     if (nErr) {
         return nErr;
-    } else if (atoi(szResp) == SLEW_EXCEED_LIMIT_OR_BELOW_ALTITUDE && m_nCacheLimitStatus == NO_ISSUE_SLEW_TRACK_ONE_OPTION) {
-        #if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-        //        fprintf(Logfile, "[%s] [CiOptron::startSlewTo] Error: Slewing to normal position was rejected by mount even though it told me it only had one position to go to.  Gettn out of dodge.\n", getTimestamp());
-        if (Logfile) {
-            fprintf(Logfile, "[%s] [CiOptron::startSlewTo] Error: Slewing to normal position was rejected by mount likely due to limit issues.  Gettn out of dodge.\n", getTimestamp());
-            fflush(Logfile);
+    } else if (parseDigitReply(szResp) == SLEW_EXCEED_LIMIT_OR_BELOW_ALTITUDE && m_nCacheLimitStatus == NO_ISSUE_SLEW_TRACK_ONE_OPTION) {
+        //        Logfile->log("[CiOptron::startSlewTo] Error: Slewing to normal position was rejected by mount even though it told me it only had one position to go to.  Gettn out of dodge.\n");
+        if (Logfile->enabled(LOG_SLEW, LOG_ERROR)) {
+            Logfile->log("[CiOptron::startSlewTo] Error: Slewing to normal position was rejected by mount likely due to limit issues.  Gettn out of dodge.\n");
         }
-        #endif
         return ERR_LIMITSEXCEEDED;  // regular slew to a place that is bad for mount
-    } else if (atoi(szResp) == SLEW_EXCEED_LIMIT_OR_BELOW_ALTITUDE && m_nCacheLimitStatus == NO_ISSUE_SLEW_TRACK_TWO_OPTIONS) {
+    } else if (parseDigitReply(szResp) == SLEW_EXCEED_LIMIT_OR_BELOW_ALTITUDE && m_nCacheLimitStatus == NO_ISSUE_SLEW_TRACK_TWO_OPTIONS) {
         // attempt was made to slew to counterweight up position, and mount said NO.. so attempt normal
-        #if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-        if (Logfile) {
-            fprintf(Logfile, "[%s] [CiOptron::startSlewTo] Slewing to counterweight up position was rejected by mount.  Slewing to normal position.\n", getTimestamp());
-            fflush(Logfile);
+        if (Logfile->enabled(LOG_SLEW, LOG_DEBUG)) {
+            Logfile->log("[CiOptron::startSlewTo] Slewing to counterweight up position was rejected by mount.  Slewing to normal position.\n");
         }
-        #endif
         m_nCacheLimitStatus = NO_ISSUE_SLEW_TRACK_ONE_OPTION;  // act as if we had only one option
         memset(szResp, 0, SERIAL_BUFFER_SIZE);  // clear response buffer
-        nErr = sendCommand(":MS1#", szResp, 1);
+        nErr = sendCommand(CMD_MS1, szResp);
         if (nErr) {
-            #if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-            if (Logfile) {
-                fprintf(Logfile, "[%s] [CiOptron::startSlewTo] Error: sendCommand bombed sending :MS2 then :MS1  nErr: %i\n", getTimestamp(), nErr);
-                fflush(Logfile);
+            if (Logfile->enabled(LOG_SLEW, LOG_ERROR)) {
+                Logfile->log("[CiOptron::startSlewTo] Error: sendCommand bombed sending :MS2 then :MS1  nErr: %i\n", nErr);
             }
-            #endif
             return nErr;
-        } else if (atoi(szResp) == SLEW_EXCEED_LIMIT_OR_BELOW_ALTITUDE) {
-            #if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-            if (Logfile) {
-                fprintf(Logfile, "[%s] [CiOptron::startSlewTo] Error: Slewing to normal position was rejected by mount after attempting to slew to counterweight up option.  (:MS2 then :MS1).  Gettn out of dodge.\n", getTimestamp());
-                fflush(Logfile);
+        } else if (parseDigitReply(szResp) == SLEW_EXCEED_LIMIT_OR_BELOW_ALTITUDE) {
+            if (Logfile->enabled(LOG_SLEW, LOG_ERROR)) {
+                Logfile->log("[CiOptron::startSlewTo] Error: Slewing to normal position was rejected by mount after attempting to slew to counterweight up option.  (:MS2 then :MS1).  Gettn out of dodge.\n");
             }
-            #endif
             return ERR_LIMITSEXCEEDED;
         } else {
             m_nStatus = SLEWING;
-            slewToTimer.Reset();  // keep TSX under control
+            slewToTimer.reset();  // keep TSX under control
+            notifyStatus();     // so the slew done event fires even if the slew ends before the next :GLS#
         }
     } else {
         m_nStatus = SLEWING;
-        slewToTimer.Reset();  // keep TSX under control
+        slewToTimer.reset();  // keep TSX under control
+        notifyStatus();
     }
 
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::startSlewTo] end. \n", getTimestamp());
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_SLEW, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::startSlewTo] end. \n");
     }
-#endif
 
     return nErr;
 }
@@ -1575,12 +1661,9 @@ int CiOptron::endSlewTo()
     double dRaInDecimalHours, dDecInDecimalDegrees;
     char szResp[SERIAL_BUFFER_SIZE];
 
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::endSlewTo] called\n", getTimestamp());
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_SLEW, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::endSlewTo] called\n");
     }
-#endif
 
     // find out where we are at
     getRaAndDec(dRaInDecimalHours, dDecInDecimalDegrees, true);
@@ -1592,41 +1675,29 @@ int CiOptron::endSlewTo()
         if (m_pierStatus==PIER_WEST && m_counterWeightStatus==COUNTER_WEIGHT_UP) {
             // picked the 'wrong' slew.  Re-slew to normal position
             memset(szResp, 0, SERIAL_BUFFER_SIZE);  // clear response buffer
-            nErr = sendCommand(":MS1#", szResp, 1);
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
+            nErr = sendCommand(CMD_MS1, szResp);
             if (nErr) {
-                if (Logfile) {
-                    fprintf(Logfile, "[%s] [CiOptron::endSlewTo] Error: sendCommand bombed sending :MS1 with value nErr: %i.  Gettn out of dodge.\n", getTimestamp(), nErr);
-                    fflush(Logfile);
+                if (Logfile->enabled(LOG_SLEW, LOG_ERROR)) {
+                    Logfile->log("[CiOptron::endSlewTo] Error: sendCommand bombed sending :MS1 with value nErr: %i.  Gettn out of dodge.\n", nErr);
                 }
                 return nErr;
             }
-#endif
-            if (atoi(szResp) == 0) {
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-                if (Logfile) {
-                    fprintf(Logfile, "[%s] [CiOptron::endSlewTo] Error: reslewing to 'normal' counterweight down position gave me a '0' back (The desired object is below the altitude limit or exceed the mechanical limits.).  Gettn out of dodge.\n", getTimestamp());
-                    fflush(Logfile);
+            if (parseDigitReply(szResp) == 0) {
+                if (Logfile->enabled(LOG_SLEW, LOG_ERROR)) {
+                    Logfile->log("[CiOptron::endSlewTo] Error: reslewing to 'normal' counterweight down position gave me a '0' back (The desired object is below the altitude limit or exceed the mechanical limits.).  Gettn out of dodge.\n");
                 }
-#endif
                 nErr = ERR_LIMITSEXCEEDED;  // all is lost
             } else {
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-                if (Logfile) {
-                    fprintf(Logfile, "[%s] [CiOptron::endSlewTo] reslewing to 'normal' counterweight down position\n", getTimestamp());
-                    fflush(Logfile);
+                if (Logfile->enabled(LOG_SLEW, LOG_DEBUG)) {
+                    Logfile->log("[CiOptron::endSlewTo] reslewing to 'normal' counterweight down position\n");
                 }
-#endif
             }
         }
     }
 
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::endSlewTo] end\n", getTimestamp());
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_SLEW, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::endSlewTo] end\n");
     }
-#endif
 
     m_nCacheLimitStatus = NO_STATUS;  // we've processed everygthing we could for now this must happen at end of slewTo
     return nErr;
@@ -1637,21 +1708,22 @@ int CiOptron::isSlewToComplete(bool &bComplete)
 {
     int nErr = IOPTRON_OK;
 
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::isSlewToComplete] called\n", getTimestamp());
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_SLEW, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::isSlewToComplete] called\n");
     }
-#endif
 
-    if(slewToTimer.GetElapsedSeconds()>2) {
+    if(slewToTimer.elapsedNs() > secondsToNs(m_pModel->fSlewPollInterval)) {
         // go ahead and check by calling mount for status
-        slewToTimer.Reset();
+        CTraceScope pollSpan(*m_pTrace, "slew poll", "poller", "isSlewToComplete");
+        slewToTimer.reset();
 
         nErr = getInfoAndSettings();
 
     } else {
         // we're checking for comletion too quickly and too often for no reason, just use local variable
+        m_nLastResponseAgeNs = statusAgeTimer.elapsedNs();
+        if(m_pTrace->enabled())
+            m_pTrace->instant("status cache hit", "cache", "isSlewToComplete", m_nLastResponseAgeNs / 1000);
     }
 
     if (m_nStatus == SLEWING || m_nStatus == FLIPPING) {
@@ -1660,12 +1732,9 @@ int CiOptron::isSlewToComplete(bool &bComplete)
         bComplete = true;
     }
 
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::isSlewToComplete] returning : %s\n", getTimestamp(), bComplete?"true":"false");
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_SLEW, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::isSlewToComplete] returning : %s\n", bComplete?"true":"false");
     }
-#endif
 
     return nErr;
 }
@@ -1673,86 +1742,68 @@ int CiOptron::isSlewToComplete(bool &bComplete)
 int CiOptron::isGPSReceivingDataPassive(bool &bGPSReceivingData)
 {
     int nErr = IOPTRON_OK;
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::isGPSReceivingDataPassive] called \n", getTimestamp());
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_CACHE, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::isGPSReceivingDataPassive] called \n");
     }
-#endif
 
     bGPSReceivingData = (m_nGPSStatus == GPS_RECEIVING_VALID_DATA);
 
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::isGPSReceivingDataPassive] end. Result %s \n", getTimestamp(), bGPSReceivingData?"true":"false");
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_CACHE, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::isGPSReceivingDataPassive] end. Result %s \n", bGPSReceivingData?"true":"false");
     }
-#endif
     return nErr;
 }
 
 int CiOptron::isGPSOrLatLongGood(bool &bGPSOrLatLongGood)
 {
     int nErr = IOPTRON_OK;
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::isGPSOrLatLongGood] called \n", getTimestamp());
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_CACHE, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::isGPSOrLatLongGood] called \n");
     }
-#endif
     getInfoAndSettings();
     nErr = isGPSOrLatLongGoodPassive(bGPSOrLatLongGood);
 
     if (nErr) {
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-        if (Logfile) {
-            fprintf(Logfile, "[%s] [CiOptron::isGPSOrLatLongGood] Error: calling isGPSOrLatLongGoodPassive.  nErr: %i\n", getTimestamp(), nErr);
-            fflush(Logfile);
+        if (Logfile->enabled(LOG_CACHE, LOG_ERROR)) {
+            Logfile->log("[CiOptron::isGPSOrLatLongGood] Error: calling isGPSOrLatLongGoodPassive.  nErr: %i\n", nErr);
         }
-#endif
         return nErr;
     }
 
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::isGPSOrLatLongGood] end. Result %s \n", getTimestamp(), bGPSOrLatLongGood?"true":"false");
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_CACHE, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::isGPSOrLatLongGood] end. Result %s \n", bGPSOrLatLongGood?"true":"false");
     }
-#endif
     return nErr;
 }
 
 int CiOptron::isGPSOrLatLongGoodPassive(bool &bGPSOrLatLongGood)
 {
-    float fLat;
-    float fLong;
+    CCentiArcsec Lat;
+    CCentiArcsec Long;
+    bool bLatLongGood;
     bool bGPSReceivingData;
     int nErr = IOPTRON_OK;
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::isGPSOrLatLongGoodPassive] called \n", getTimestamp());
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_CACHE, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::isGPSOrLatLongGoodPassive] called \n");
     }
-#endif
-    nErr = getLocationPassive(fLat, fLong);
+    nErr = getLocationPassive(Lat, Long);
     nErr = isGPSReceivingDataPassive(bGPSReceivingData);
 
     // determine if mount supports GPS and make determinations based on that
     bool bMountHasFunctioningGPS;
     mountHasFunctioningGPSPassive(bMountHasFunctioningGPS); // ignore error since never will err out
 
+    // 90 and 180 degrees in 0.01 arc-second
+    bLatLongGood = Lat.raw() && (Lat.raw() <= 32400000) && (Lat.raw() >= -32400000) && Long.raw() && (Long.raw() <= 64800000) && (Long.raw() >= -64800000);
     if (bMountHasFunctioningGPS) {
-        bGPSOrLatLongGood = (fLat && (fLat <=90) && (fLat >= -90) && fLong && (fLong <= 180) && (fLong >=-180)) || bGPSReceivingData;
+        bGPSOrLatLongGood = bLatLongGood || bGPSReceivingData;
     } else {
-        bGPSOrLatLongGood = (fLat && (fLat <=90) && (fLat >= -90) && fLong && (fLong <= 180) && (fLong >=-180));
+        bGPSOrLatLongGood = bLatLongGood;
     }
 
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::isGPSOrLatLongGoodPassive] end. Result %s \n", getTimestamp(), bGPSOrLatLongGood?"true":"false");
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_CACHE, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::isGPSOrLatLongGoodPassive] end. Result %s \n", bGPSOrLatLongGood?"true":"false");
     }
-#endif
     return nErr;
 }
 
@@ -1762,12 +1813,13 @@ int CiOptron::parkMount()
     char szResp[SERIAL_BUFFER_SIZE];
     int nParkResult;
 
+    stopRateStream();
     // ER: the scope comes with park already set
-    nErr = sendCommand(":MP1#", szResp, 1);  // merely ask to park
+    nErr = sendCommand(CMD_MP1, szResp);  // merely ask to park
     if(nErr)
         return nErr;
 
-    nParkResult = atoi(szResp);
+    nParkResult = parseDigitReply(szResp);
     if(nParkResult != 1)
         return ERR_CMDFAILED;
 
@@ -1777,36 +1829,26 @@ int CiOptron::parkMount()
 int CiOptron::setParkPosition(double dAz, double dAlt)
 {
     int nErr = IOPTRON_OK;
-    char szCmd[SERIAL_BUFFER_SIZE];
+    char szCmd[IOPTRON_CMD_BUFFER_SIZE];
     char szResp[SERIAL_BUFFER_SIZE];
-    double dAzArcSec, dAltArcSec;
 
     // set az park position :  “:SPATTTTTTTTT#”
-    // convert dAz to arcsec then to 0.01 arcsec
-//    dAzArcSec = (dAz * 60 * 60) / 0.01;   wrong!
-    dAzArcSec = ((dAz / 24.0 * 360.0) * 60.0 * 60.0) / 0.01;  // actually hundreths of arc sec
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::setParkPosition] setting  Park Az to : %d\n", getTimestamp(), int(dAzArcSec));
-        fflush(Logfile);
-    }
-#endif
-    snprintf(szCmd, SERIAL_BUFFER_SIZE, ":SPA%09d#", int(dAzArcSec));
-    nErr = sendCommand(szCmd, szResp, 1);
+    if(!formatParkAzCommand(szCmd, IOPTRON_CMD_BUFFER_SIZE, CCentiArcsec::fromHours(dAz)))
+        return COMMAND_FAILED;
+    if (Logfile->enabled(LOG_SLEW, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::setParkPosition] setting  Park Az : %s\n", szCmd);
+    }
+    nErr = sendCommand(CMD_SPA, szCmd, szResp);
     if(nErr)
         return nErr;
 
     // set Alt park postion : “:SPHTTTTTTTT#”
-    // convert dAlt to arcsec then to 0.01 arcsec
-    dAltArcSec = (dAlt * 60.0 * 60.0) / 0.01;
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::setParkPosition] setting  Park Alt to : %d\n", getTimestamp(), int(dAltArcSec));
-        fflush(Logfile);
-    }
-#endif
-    snprintf(szCmd, SERIAL_BUFFER_SIZE, ":SPH%08d#", int(dAltArcSec));
-    nErr = sendCommand(szCmd, szResp, 1);
+    if(!formatParkAltCommand(szCmd, IOPTRON_CMD_BUFFER_SIZE, CCentiArcsec::fromDegrees(dAlt)))
+        return COMMAND_FAILED;
+    if (Logfile->enabled(LOG_SLEW, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::setParkPosition] setting  Park Alt : %s\n", szCmd);
+    }
+    nErr = sendCommand(CMD_SPH, szCmd, szResp);
     if(nErr)
         return nErr;
 
@@ -1818,46 +1860,32 @@ int CiOptron::getParkPosition(double &dAz, double &dAlt)
 {
     int nErr = IOPTRON_OK;
     char szResp[SERIAL_BUFFER_SIZE];
-    char szParkAz[SERIAL_BUFFER_SIZE], szParkAlt[SERIAL_BUFFER_SIZE];
-    int nAzArcSec, nAltArcSec;
+    int64_t nParseStartNs;
+    CCentiArcsec Az, Alt;
 
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::getParkPosition] called\n", getTimestamp());
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_SLEW, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::getParkPosition] called\n");
     }
-#endif
 
     // Response: “TTTTTTTTTTTTTTTTT#”
-    nErr = sendCommand(":GPC#", szResp, 18);
+    nErr = sendCommand(CMD_GPC, szResp);
 
     if(nErr)
         return nErr;
 
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::getParkPosition] :GPC# command response %s\n", getTimestamp(), szResp);
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_SLEW, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::getParkPosition] :GPC# command response %s\n", szResp);
     }
-#endif
-
-    memset(szParkAz, 0, SERIAL_BUFFER_SIZE);
-    memset(szParkAlt, 0, SERIAL_BUFFER_SIZE);
 
-    memcpy(szParkAlt, szResp, 8); // The first 8 digits indicate the altitude of parking position. Valid data range is [0, 32,400,000]. Note: The resolution is 0.01 arc-second.
-    memcpy(szParkAz, szResp+8, 9); // The last 9 digits indicate the azimuth of parking position. Valid data range is [0, 129,600,000]. Note: The resolution is 0.01 arc-second.
-    nAzArcSec = atoi(szParkAz);
-    nAltArcSec = atoi(szParkAlt);
-//    dAz = (nAzArcSec*0.01)/ 60 /60 ;   az calculated the same??
-    dAz = (nAzArcSec * 0.01 * 24.0 / 360.0)/ 60.0 /60.0 ;
-    dAlt = (nAltArcSec * 0.01)/ 60.0 /60.0 ;
+    nParseStartNs = m_pClock->nowNs();
+    if(accountParseTime(parseParkPositionReply(szResp, Az, Alt), nParseStartNs))
+        return IOPTRON_BAD_CMD_RESPONSE;
+    dAz = Az.hours();
+    dAlt = Alt.degrees();
 
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::getParkPosition] azmuth: %f and alt: %f\n", getTimestamp(), dAz, dAlt);
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_SLEW, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::getParkPosition] azmuth: %f and alt: %f\n", dAz, dAlt);
     }
-#endif
     return nErr;
 }
 
@@ -1867,31 +1895,32 @@ int CiOptron::getAtPark(bool &bParked)
 
     bParked = false;
 
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::getAtPark] called \n", getTimestamp());
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_SLEW, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::getAtPark] called \n");
     }
-#endif
-    if(getAtParkTimer.GetElapsedSeconds()>2) {
+    if(getAtParkTimer.elapsedNs() > 2 * NS_PER_SECOND || (m_nStaleCaches & CACHE_STATUS)) {
         // go ahead and check by calling mount for status
-        getAtParkTimer.Reset();
+        if(m_pTrace->enabled())
+            m_pTrace->instant("status cache miss", "cache", "getAtPark");
+        getAtParkTimer.reset();
 
         nErr = getInfoAndSettings();
         if(nErr)
           return nErr;
 
     }
+    else {
+        m_nLastResponseAgeNs = statusAgeTimer.elapsedNs();
+        if(m_pTrace->enabled())
+            m_pTrace->instant("status cache hit", "cache", "getAtPark", m_nLastResponseAgeNs / 1000);
+    }
     // use m_bParked even if it was cached
 
     bParked = m_bParked;
 
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::getAtPark] end. Result: %s \n", getTimestamp(), bParked?"true":"false");
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_SLEW, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::getAtPark] end. Result: %s \n", bParked?"true":"false");
     }
-#endif
     return nErr;
 }
 
@@ -1900,13 +1929,10 @@ int CiOptron::unPark()
     int nErr = IOPTRON_OK;
     char szResp[SERIAL_BUFFER_SIZE];
 
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::unPark] \n", getTimestamp());
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_SLEW, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::unPark] \n");
     }
-#endif
-    nErr = sendCommand(":MP0#", szResp, 1);  // merely ask to unpark
+    nErr = sendCommand(CMD_MP0, szResp);  // merely ask to unpark
 
     return nErr;
 }
@@ -1914,35 +1940,15 @@ int CiOptron::unPark()
 
 int CiOptron::getRefractionCorrEnabled(bool &bEnabled)
 {
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::getRefractionCorrEnabled] called. Current m_sModel value: %s.  Value of CEM120_EC2 %s\n", getTimestamp(), m_sModel, CEM120_EC2);
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_TRACKING, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::getRefractionCorrEnabled] called. Current model: %s\n", m_pModel->pszName);
     }
-#endif
     int nErr = IOPTRON_OK;
 
-    if (strcmp(m_sModel, IEQ30PRO) == 0) {
-        bEnabled = false;
-    } else if (strcmp(m_sModel, CEM60) == 0) {
-        bEnabled = false;
-    } else if (strcmp(m_sModel, CEM60_EC) == 0) {
-        bEnabled = false;
-    } else if (strcmp(m_sModel, CEM120) == 0) {
-        bEnabled = true;
-    } else if (strcmp(m_sModel, CEM120_EC) == 0) {
-        bEnabled = true;
-    } else if (strcmp(m_sModel, CEM120_EC2) == 0) {
-        bEnabled = true;
-    } else {
-        bEnabled = false;
-    }
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::getRefractionCorrEnabled] finished result %s \n", getTimestamp(), bEnabled ? "true":"false");
-        fflush(Logfile);
+    bEnabled = m_pModel->bRefractionInFirmware;
+    if (Logfile->enabled(LOG_TRACKING, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::getRefractionCorrEnabled] finished result %s \n", bEnabled ? "true":"false");
     }
-#endif
     return nErr;
 }
 
@@ -1952,20 +1958,18 @@ int CiOptron::Abort()
     int nErr = IOPTRON_OK;
     char szResp[SERIAL_BUFFER_SIZE];
 
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::Abort]  abort called.  Stopping slewing and stopping tracking.\n", getTimestamp());
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_SLEW, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::Abort]  abort called.  Stopping slewing and stopping tracking.\n");
     }
-#endif
+    stopRateStream();
 
     // stop slewing
-    nErr = sendCommand(":Q#", szResp, 1);
+    nErr = sendCommand(CMD_Q, szResp);
     if(nErr)
         return nErr;
 
     // stop tracking
-    nErr = sendCommand(":ST0#", szResp, 1);
+    nErr = sendCommand(CMD_ST0, szResp);
 
     return nErr;
 }
@@ -1975,113 +1979,83 @@ int CiOptron::getInfoAndSettings()
 {
     int nErr = IOPTRON_OK;
     char szResp[SERIAL_BUFFER_SIZE];
-    char szTmp[SERIAL_BUFFER_SIZE];
+    int64_t nParseStartNs;
+    iOptronStatusReply status;
 
-    nErr = sendCommand(":GLS#", szResp, 24);
+    nErr = sendCommand(CMD_GLS, szResp);
     if(nErr)
         return nErr;
+    statusAgeTimer.reset();
 
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::getInfoAndSettings]  :GLS# response is: %s\n", getTimestamp(), szResp);
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_CACHE, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::getInfoAndSettings]  :GLS# response is: %s\n", szResp);
     }
-#endif
-
-    memset(szTmp,0, SERIAL_BUFFER_SIZE);
-    memcpy(szTmp, szResp, 9);
-    m_fLong = (atof(szTmp)*0.01)/ 60.0 /60.0;
 
-    memset(szTmp,0, SERIAL_BUFFER_SIZE);
-    memcpy(szTmp, szResp+9, 8);
-    m_fLat = ((atof(szTmp)-32400000)*0.01)/ 60.0 /60.0;
-
-    memset(szTmp,0, SERIAL_BUFFER_SIZE);
-    memcpy(szTmp, szResp+17, 1);
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::getInfoAndSettings]  GPS status from mount returned is: %s, \n", getTimestamp(), szTmp);
-        fflush(Logfile);
+    nParseStartNs = m_pClock->nowNs();
+    if(accountParseTime(parseStatusReply(szResp, status), nParseStartNs)) {
+        if (Logfile->enabled(LOG_CACHE, LOG_ERROR)) {
+            Logfile->log("[CiOptron::getInfoAndSettings] ERROR parsing :GLS# response %s\n", szResp);
+        }
+        return IOPTRON_BAD_CMD_RESPONSE;
     }
-#endif
-    m_nGPSStatus = atoi(szTmp);
-
-    memset(szTmp,0, SERIAL_BUFFER_SIZE);
-    memcpy(szTmp, szResp+18, 1);
-    m_nStatus = atoi(szTmp);
+    m_Long = status.Long;
+    m_Lat = status.Lat;
+    m_nGPSStatus = status.nGPSStatus;
+    m_nStatus = status.nStatus;
+    m_nTrackingRate = status.nTrackingRate;
+    m_nTimeSource = status.nTimeSource;
+    m_nStaleCaches &= ~CACHE_STATUS;
 
-    memset(szTmp,0, SERIAL_BUFFER_SIZE);
-    memcpy(szTmp, szResp+19, 1);
-    m_nTrackingRate = atoi(szTmp);
-
-    memset(szTmp,0, SERIAL_BUFFER_SIZE);
-    memcpy(szTmp, szResp+21, 1);
-    m_nTimeSource = atoi(szTmp);
-
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::getInfoAndSettings]  MOUNT lat is : %f, MOUNT long is: %f, status is: %i, trackingRate is: %i, gpsStatus is: %i, timeSource is: %i\n", getTimestamp(), m_fLat , m_fLong , m_nStatus, m_nTrackingRate, m_nGPSStatus, m_nTimeSource);
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_CACHE, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::getInfoAndSettings]  MOUNT lat is : %f, MOUNT long is: %f, status is: %i, trackingRate is: %i, gpsStatus is: %i, timeSource is: %i\n", m_Lat.degrees(), m_Long.degrees(), m_nStatus, m_nTrackingRate, m_nGPSStatus, m_nTimeSource);
     }
-#endif
 
     m_bParked = m_nStatus == PARKED?true:false;
+    m_nStatusTimeNs = CMonotonicClock::system().nowNs();
+    publishTelemetry();
+    notifyStatus();
     return nErr;
 
 }
 
 #pragma mark - internal set ra/dec on mount
-int CiOptron::setRaAndDec(char *pszLocationCalling, double dRaInDecimalHours, double dDecInDecimalDegrees)
+int CiOptron::setRaAndDec(char *pszLocationCalling, const CCentiArcsec &Ra, const CCentiArcsec &Dec)
 {
     int nErr = IOPTRON_OK;
-    char szCmdRa[SERIAL_BUFFER_SIZE];
-    char szCmdDec[SERIAL_BUFFER_SIZE];
+    char szCmdRa[IOPTRON_CMD_BUFFER_SIZE];
+    char szCmdDec[IOPTRON_CMD_BUFFER_SIZE];
     char szResp[SERIAL_BUFFER_SIZE];
-    double dRaArcSec, dDecArcSec;
-
 
-    dRaArcSec = ((dRaInDecimalHours / 24.0 * 360.0) * 60.0 * 60.0) / 0.01;  // actually hundreths of arc sec
     // :SRATTTTTTTTT#   ra  Valid data range is [0, 129,600,000].
     // Note: The resolution is 0.01 arc-second.
-    snprintf(szCmdRa, SERIAL_BUFFER_SIZE, ":SRA%09d#", int(dRaArcSec));
+    if(!formatRaCommand(szCmdRa, IOPTRON_CMD_BUFFER_SIZE, Ra))
+        return COMMAND_FAILED;
 
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [%s] computed command for RA coordinate set: %s\n", getTimestamp(), pszLocationCalling, szCmdRa);
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_SLEW, LOG_DEBUG)) {
+        Logfile->log("[%s] computed command for RA coordinate set: %s\n", pszLocationCalling, szCmdRa);
     }
-#endif
 
-    nErr = sendCommand(szCmdRa, szResp, 1); // set RA
+    nErr = sendCommand(CMD_SRA, szCmdRa, szResp); // set RA
     if (nErr) {
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-        if (Logfile) {
-            fprintf(Logfile, "[%s] [%s] Error: sendCommand bombed sending %s.  nErr: %i\n", getTimestamp(), pszLocationCalling, szCmdRa, nErr);
-            fflush(Logfile);
+        if (Logfile->enabled(LOG_SLEW, LOG_ERROR)) {
+            Logfile->log("[%s] Error: sendCommand bombed sending %s.  nErr: %i\n", pszLocationCalling, szCmdRa, nErr);
         }
-#endif
         return nErr;
     }
 
-    dDecArcSec = (dDecInDecimalDegrees * 60.0 * 60.0) / 0.01; // actually hundreths of arc sec - converts same way
     // :SdsTTTTTTTT#    dec  Valid data range is [-32,400,000, +32,400,000].
     // Note: The resolution is 0.01 arc-second.
-    snprintf(szCmdDec, SERIAL_BUFFER_SIZE, ":Sd%+09d#", int(dDecArcSec));
+    if(!formatDecCommand(szCmdDec, IOPTRON_CMD_BUFFER_SIZE, Dec))
+        return COMMAND_FAILED;
 
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [%s] computed command for DEC coordinate set: %s\n", getTimestamp(), pszLocationCalling, szCmdDec);
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_SLEW, LOG_DEBUG)) {
+        Logfile->log("[%s] computed command for DEC coordinate set: %s\n", pszLocationCalling, szCmdDec);
     }
-#endif
-    nErr = sendCommand(szCmdDec, szResp, 1);  // set DEC
+    nErr = sendCommand(CMD_SD, szCmdDec, szResp);  // set DEC
     if (nErr) {
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-        if (Logfile) {
-            fprintf(Logfile, "[%s] [%s] Error: sendCommand bombed sending %s.  nErr: %i\n", getTimestamp(), pszLocationCalling, szCmdDec, nErr);
-            fflush(Logfile);
+        if (Logfile->enabled(LOG_SLEW, LOG_ERROR)) {
+            Logfile->log("[%s] Error: sendCommand bombed sending %s.  nErr: %i\n", pszLocationCalling, szCmdDec, nErr);
         }
-#endif
         return nErr;
     }
 
@@ -2092,45 +2066,32 @@ int CiOptron::getMeridianTreatment(int &iBehavior, int &iDegreesPastMeridian)
 {
     int nErr = IOPTRON_OK;
     char szResp[SERIAL_BUFFER_SIZE];
-    char szDegreesPastMeridian[SERIAL_BUFFER_SIZE], szBehavior[2];
+    int64_t nParseStartNs;
 
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::getMeridianTreatment] called\n", getTimestamp());
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_UI, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::getMeridianTreatment] called\n");
     }
-#endif
 
     // Response: “nnn#”
     // The first digit 0 stands for stop at the position limit set below.
     // The first digit 1 stands for flip at the position limit set below.
     // The last 2 digits stands for the position limit of degrees past meridian.
-    nErr = sendCommand(":GMT#", szResp, 4);
+    nErr = sendCommand(CMD_GMT, szResp);
 
     if(nErr)
         return nErr;
 
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::getMeridianTreatment] :GMT# command response %s\n", getTimestamp(), szResp);
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_UI, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::getMeridianTreatment] :GMT# command response %s\n", szResp);
     }
-#endif
 
-    memset(szDegreesPastMeridian, 0, SERIAL_BUFFER_SIZE);
-    memset(szBehavior, 0, 2);
+    nParseStartNs = m_pClock->nowNs();
+    if(accountParseTime(parseMeridianTreatmentReply(szResp, iBehavior, iDegreesPastMeridian), nParseStartNs))
+        return IOPTRON_BAD_CMD_RESPONSE;
 
-    memcpy(szBehavior, szResp, 1); // The first digit is the behavior
-    memcpy(szDegreesPastMeridian, szResp+1, 2); // The last 2 digits indicate degrees past meridian
-    iBehavior = atoi(szBehavior);
-    iDegreesPastMeridian = atoi(szDegreesPastMeridian);
-
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::getMeridianTreatment] behavior: %i and degrees: %i\n", getTimestamp(), iBehavior, iDegreesPastMeridian);
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_UI, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::getMeridianTreatment] behavior: %i and degrees: %i\n", iBehavior, iDegreesPastMeridian);
     }
-#endif
     return nErr;
 }
 
@@ -2138,48 +2099,38 @@ int CiOptron::getAltitudeLimit(int &iDegreesAltLimit)
 {
     int nErr = IOPTRON_OK;
     char szResp[SERIAL_BUFFER_SIZE];
-    char szDegreesAltLimit[SERIAL_BUFFER_SIZE];
+    int64_t nParseStartNs;
 
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::getAltitudeLimit] called\n", getTimestamp());
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_UI, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::getAltitudeLimit] called\n");
     }
-#endif
 
     // Response: “snn#”
     // The first digit is the sign of the degree (why that would be negative is beyond me)
     // The last 2 digits stands for the degrees altitude limit
-    nErr = sendCommand(":GAL#", szResp, 4);
+    nErr = sendCommand(CMD_GAL, szResp);
 
     if(nErr)
         return nErr;
 
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::getAltitudeLimit] :GAL# command response %s\n", getTimestamp(), szResp);
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_UI, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::getAltitudeLimit] :GAL# command response %s\n", szResp);
     }
-#endif
-
-    memset(szDegreesAltLimit, 0, SERIAL_BUFFER_SIZE);
 
-    memcpy(szDegreesAltLimit, szResp, 3);
-    iDegreesAltLimit = atoi(szDegreesAltLimit);
+    nParseStartNs = m_pClock->nowNs();
+    if(accountParseTime(parseAltitudeLimitReply(szResp, iDegreesAltLimit), nParseStartNs))
+        return IOPTRON_BAD_CMD_RESPONSE;
 
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] [CiOptron::getAltitudeLimit] degrees: %i\n", getTimestamp(), iDegreesAltLimit);
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_UI, LOG_DEBUG)) {
+        Logfile->log("[CiOptron::getAltitudeLimit] degrees: %i\n", iDegreesAltLimit);
     }
-#endif
     return nErr;
 }
 
 int CiOptron::setMeridianTreatement(int iBehavior, int iDegreesPastMeridian)
 {
     int nErr = IOPTRON_OK;
-    char szCmd[SERIAL_BUFFER_SIZE];
+    char szCmd[IOPTRON_CMD_BUFFER_SIZE];
     char szResp[SERIAL_BUFFER_SIZE];
 
     // Command: “:SMTnnn#”
@@ -2188,23 +2139,18 @@ int CiOptron::setMeridianTreatement(int iBehavior, int iDegreesPastMeridian)
     //  The first digit 0 stands for stop at the position limit set below.
     //  The first digit 1 stands for flip at the position limit set below.
     //  The last 2 digits stands for the position limit of degrees past meridian.
-    snprintf(szCmd, SERIAL_BUFFER_SIZE, ":SMT%.1d%02d#", iBehavior, iDegreesPastMeridian);
+    if(!formatMeridianTreatmentCommand(szCmd, IOPTRON_CMD_BUFFER_SIZE, iBehavior, iDegreesPastMeridian))
+        return COMMAND_FAILED;
 
-    #if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] computed command for setting meridian treatment: %s\n", getTimestamp(), szCmd);
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_UI, LOG_DEBUG)) {
+        Logfile->log("computed command for setting meridian treatment: %s\n", szCmd);
     }
-    #endif
 
-    nErr = sendCommand(szCmd, szResp, 1);  // set meridian treatment
+    nErr = sendCommand(CMD_SMT, szCmd, szResp);  // set meridian treatment
     if (nErr) {
-        #if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-        if (Logfile) {
-            fprintf(Logfile, "[%s] Error: sendCommand for setting meridian treatment bombed: command was: %s. nErr: %i\n", getTimestamp(), szCmd, nErr);
-            fflush(Logfile);
+        if (Logfile->enabled(LOG_UI, LOG_ERROR)) {
+            Logfile->log("Error: sendCommand for setting meridian treatment bombed: command was: %s. nErr: %i\n", szCmd, nErr);
         }
-        #endif
         return nErr;
     }
     m_nDegreesPastMeridian = iDegreesPastMeridian; // cache this value but only if everything above worked
@@ -2214,7 +2160,7 @@ int CiOptron::setMeridianTreatement(int iBehavior, int iDegreesPastMeridian)
 int CiOptron::setAltitudeLimit(int iDegreesAltLimit)
 {
     int nErr = IOPTRON_OK;
-    char szCmd[SERIAL_BUFFER_SIZE];
+    char szCmd[IOPTRON_CMD_BUFFER_SIZE];
     char szResp[SERIAL_BUFFER_SIZE];
 
     // Command: “:SALsnn#”
@@ -2223,23 +2169,18 @@ int CiOptron::setAltitudeLimit(int iDegreesAltLimit)
     // but also applies to slewing. Movement caused by arrow buttons does not affect by this limit.
     // Tracking will be stopped if you move the mount to a position exceeds any limit.
     // Note: Valid data range is [-89, +89]. The resolution is 1 degree.
-    snprintf(szCmd, SERIAL_BUFFER_SIZE, ":SAL%+.2d#", iDegreesAltLimit);
+    if(!formatAltitudeLimitCommand(szCmd, IOPTRON_CMD_BUFFER_SIZE, iDegreesAltLimit))
+        return COMMAND_FAILED;
 
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-    if (Logfile) {
-        fprintf(Logfile, "[%s] computed command for setting altitude limit: %s\n", getTimestamp(), szCmd);
-        fflush(Logfile);
+    if (Logfile->enabled(LOG_UI, LOG_DEBUG)) {
+        Logfile->log("computed command for setting altitude limit: %s\n", szCmd);
     }
-#endif
 
-    nErr = sendCommand(szCmd, szResp, 1);  // set altitude limit
+    nErr = sendCommand(CMD_SAL, szCmd, szResp);  // set altitude limit
     if (nErr) {
-#if defined IOPTRON_DEBUG && IOPTRON_DEBUG >= 2
-        if (Logfile) {
-            fprintf(Logfile, "[%s] Error: sendCommand for setting altitude limit bombed: command was: %s. nErr: %i\n", getTimestamp(), szCmd, nErr);
-            fflush(Logfile);
+        if (Logfile->enabled(LOG_UI, LOG_ERROR)) {
+            Logfile->log("Error: sendCommand for setting altitude limit bombed: command was: %s. nErr: %i\n", szCmd, nErr);
         }
-#endif
         return nErr;
     }
     m_nAltitudeLimit = iDegreesAltLimit; // set only if all succeeded
@@ -2247,14 +2188,5 @@ int CiOptron::setAltitudeLimit(int iDegreesAltLimit)
     return nErr;
 }
 
-#ifdef IOPTRON_DEBUG
-char* CiOptron::getTimestamp()
-{
-    ltime = time(NULL);
-    timestamp = asctime(localtime(&ltime));
-    timestamp[strlen(timestamp) - 1] = 0;
-    return timestamp;
-}
-#endif
 
 
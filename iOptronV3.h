@@ -16,6 +16,7 @@
 #include <vector>
 #include <sstream>
 #include <iostream>
+#include <atomic>
 
 #include "../../licensedinterfaces/sberrorx.h"
 #include "../../licensedinterfaces/theskyxfacadefordriversinterface.h"
@@ -24,31 +25,27 @@
 #include "../../licensedinterfaces/loggerinterface.h"
 #include "../../licensedinterfaces/mountdriverinterface.h"
 
-#include "StopWatch.h"
+#include "MonotonicClock.h"
+#include "CommandStats.h"
+#include "LinkHealth.h"
+#include "iOptronProtocol.h"
+#include "iOptronCommands.h"
+#include "iOptronModels.h"
+#include "AsyncLog.h"
+#include "TraceLog.h"
+#include "TransportRecorder.h"
+#include "TelemetryPublisher.h"
+#include "MountEvents.h"
+#include "PulseGuide.h"
+#include "RateStream.h"
 
 
-// #define IOPTRON_DEBUG 3   // define this to have log files, 1 = bad stuff only, 2 and up.. full debug
+// log levels are set at runtime, per category, see CAsyncLog and the LogLevel ini keys in x2mount.h
 
 #define DRIVER_VERSION 1.7
 
 enum iOptron {IOPTRON_OK=0, NOT_CONNECTED, IOPTRON_CANT_CONNECT, IOPTRON_BAD_CMD_RESPONSE, COMMAND_FAILED, IOPTRON_ERROR};
 
-#define CEM26 "0026"
-#define CEM26_EC "0027"
-#define GEM28 "0028"
-#define GEM28_EC "0029"
-#define IEQ30PRO  "0030"
-#define CEM60  "0060"
-#define CEM60_EC  "0061"
-#define CEM70  "0070"
-#define CEM70_EC  "0071"
-#define CEM120  "0120"
-#define CEM120_EC  "0121"
-#define CEM120_EC2  "0122"
-#define UKNOWN_MOUNT "9999"
-
-//OPTIONAL_GPS_MOUNTS { CEM26, CEM26_EC, GEM28, GEM28_EC };
-
 enum iOptronStatus {STOPPED = 0, TRACKING, SLEWING, GUIDING, FLIPPING, PEC_TRACKING, PARKED, HOMED};
 
 enum iOptronGPSStatus {GPS_BROKE_OR_MISSING=0, GPS_WORKING_NOT_RECEIVED_DATA, GPS_RECEIVING_VALID_DATA};
@@ -68,14 +65,32 @@ enum iSlewResponse {SLEW_EXCEED_LIMIT_OR_BELOW_ALTITUDE=0, SLEW_ACCEPTED};
 enum iMeridianBehavior {STOP_AT_POSITION_LIMIT=0, FLIP_AT_POSITION_LIMIT};
 
 #define SERIAL_BUFFER_SIZE 256
-#define MAX_TIMEOUT 1000         // was 500 ms
 #define IOPTRON_LOG_BUFFER_SIZE 1024
-#define ERR_PARSE   1
 
 
 #define IOPTRON_NB_SLEW_SPEEDS 7
 #define IOPTRON_SLEW_NAME_LENGHT 5
 
+// serial link accounting, cumulative since the object was created
+typedef struct {
+    unsigned long   nCommands;      // commands written to the mount
+    unsigned long   nBytesWritten;  // bytes written to the mount
+    unsigned long   nBytesRead;     // bytes actually read back from the mount
+} iOptronTrafficCounters;
+
+// who an exchange is for. CHostCallProbe measures the host traffic only : guide pulses and the rate
+// stream are sent from their own threads, in the middle of whatever host call is in progress.
+enum iOptronLinkUser {LINK_USER_HOST=0, LINK_USER_GUIDE, LINK_USER_RATE_STREAM, IOPTRON_NB_LINK_USERS};
+
+// where the time of a command goes, cumulative since the object was created. Host exchanges only.
+// The serial read is split from the mount think time using the link speed (10 bits per byte on 8N1)
+// rather than extra timestamps, so the accounting costs two clock reads per command.
+enum iOptronPhase {PHASE_SERIAL_WRITE=0, PHASE_MOUNT_WAIT, PHASE_SERIAL_READ, PHASE_PARSE, IOPTRON_NB_PHASES};
+
+typedef struct {
+    int64_t nNs[IOPTRON_NB_PHASES];
+} iOptronPhaseTimes;
+
 
 // Define Class for Astrometric Instruments IOPTRON controller.
 class CiOptron
@@ -83,9 +98,11 @@ class CiOptron
 public:
 	CiOptron();
 	~CiOptron();
-#ifdef IOPTRON_DEBUG
-	void setLogFile(FILE *);
-#endif
+	void setLogFile(CAsyncLog *);  // NULL to stop logging
+    void setTrace(CTraceLog *pTrace) { m_pTrace = pTrace ? pTrace : &CTraceLog::disabled(); }  // NULL to stop tracing
+    CTraceLog &trace() const { return *m_pTrace; }
+    void setClock(CMonotonicClock *pClock);    // all timers, resets them. NULL for the system clock
+    CMonotonicClock &clock() const { return *m_pClock; }
 	
 	int Connect(char *pszPort);
 	int Disconnect();
@@ -100,10 +117,11 @@ public:
     int getRateName(int nZeroBasedIndex, char *pszOut, unsigned int nOutMaxSize);
 
     int getMountInfo(char *model, unsigned int strMaxLen);
+    const iOptronModel &getModel() const { return *m_pModel; }   // no mount call, last :MountInfo# answer
     int getFirmwareVersion(char *version, unsigned int strMaxLen);
 
     int getRaAndDec(double &dRa, double &dDec, bool bForceMountCall);
-    int setRaAndDec(char *pszLocationCalling, double dRaInDecimalHours, double dDecInDecimalDegrees);
+    int setRaAndDec(char *pszLocationCalling, const CCentiArcsec &Ra, const CCentiArcsec &Dec);
     int syncTo(double dRa, double dDec);
     int isGPSReceivingDataPassive(bool &bGPSReceivingData);
     int mountHasFunctioningGPSPassive(bool &bMountHasFunctioningGPS);
@@ -120,6 +138,12 @@ public:
     int setSiderealTrackingOn();
     int setTrackingOff();
     int getTrackingStatusPassive(char *strTrackingStatus, unsigned int strMaxLen);
+    // custom rate streaming, :RR updates pushed by a scheduler thread, see RateStream.h. Selects the custom rate (:RT4#).
+    // setTrackingRates(), setTrackingOff(), Abort(), parkMount() and Disconnect() stop it.
+    int startRateStream(const std::vector<iOptronRatePoint> &profile, int nPeriodMs = RATE_STREAM_DEFAULT_PERIOD_MS);
+    int startRateStream(RateEphemerisCallback pfEphemeris, void *pUserData, int nPeriodMs = RATE_STREAM_DEFAULT_PERIOD_MS);
+    void stopRateStream();
+    CRateStreamer &rateStream() { return m_RateStream; }
 
     int startSlewTo(double dRaInDecimalHours, double dDecInDecimalDegrees);
     int isSlewToComplete(bool &bComplete);
@@ -128,6 +152,9 @@ public:
     int startOpenSlew(const MountDriverInterface::MoveDir Dir, unsigned int nRate);
     int stopOpenLoopMove();
 
+    // timed guide pulse at the mount guide rate, callable from any thread without the X2 I/O mutex, see PulseGuide.h
+    int pulseGuide(const MountDriverInterface::MoveDir Dir, int nDurationMs);
+
     int parkMount();
     int setParkPosition(double dAz, double dAlt);
     int getParkPosition(double &dAz, double &dAlt);
@@ -149,9 +176,9 @@ public:
     int setUtcOffset(char *pszUtcOffsetInMins);
     int setDST(bool bDaylight);
     int getUtcOffsetAndDST(char *pszUtcOffsetInMins, bool &bDaylight);
-    int getLocation(float &fLat, float &fLong);
-    int getLocationPassive(float &fLat, float &fLong);
-    int setLocation(float fLat, float fLong);
+    int getLocation(CCentiArcsec &Lat, CCentiArcsec &Long);
+    int getLocationPassive(CCentiArcsec &Lat, CCentiArcsec &Long);
+    int setLocation(const CCentiArcsec &Lat, const CCentiArcsec &Long);
     int setTimeAndDate(double julianDateOfUTCTimeIncludingMillis);
 
     int getMeridianTreatment(int &iBehavior, int &iDegreesPastMeridian);
@@ -160,6 +187,24 @@ public:
     int setAltitudeLimit(int iDegreesAltLimit);
     int getInfoAndSettings();
 
+    // traffic accounting, so the cost of each host call can be measured
+    // the link lock is taken since pulseGuide() and the rate stream can be sending from other threads
+    void getTrafficCounters(iOptronTrafficCounters &counters, int nLinkUser = LINK_USER_HOST) const { CPriorityLocker locker(m_LinkLock, false); counters = m_Traffic[nLinkUser]; }
+    void resetLastResponseAge() { m_nLastResponseAgeNs = 0; }
+    float getLastResponseAge() const { return (float)nsToSeconds(m_nLastResponseAgeNs); }  // age in seconds of the cached data last returned, 0 if it came from the mount
+    void getCommandStats(CCommandStats &stats) const { CPriorityLocker locker(m_LinkLock, false); stats = m_CommandStats; }    // round trips per catalog command since Connect
+    void getPhaseTimes(iOptronPhaseTimes &times) const { CPriorityLocker locker(m_LinkLock, false); times = m_PhaseTimes; }
+    void getGuideStats(CGuideStats &stats) const { CPriorityLocker locker(m_LinkLock, false); stats = m_GuideStats; }  // pulses since Connect
+    void getLinkHealth(CLinkHealth &health) const { CPriorityLocker locker(m_LinkLock, false); health = m_LinkHealth; }    // error counters and score since Connect
+    int  getLinkScore() const { CPriorityLocker locker(m_LinkLock, false); return m_LinkHealth.score(); }
+    int  getLinkWaiters() const { return m_LinkLock.waiters(); }  // threads queued for the port behind the exchange in progress
+    CTransportRecorder &transportRecorder() { return m_Recorder; }         // slow command watchdog
+    // publish the cached mount state in shared memory for other processes, see iOptronTelemetry.h
+    int  setTelemetry(bool bPublish, int nInstance);
+    // status, park, pier side and position change callbacks, see MountEvents.h
+    CMountEvents &events() { return m_Events; }
+    int64_t getStatusAgeNs() const;     // since the last :GLS# read, INT64_MAX when the cached status can't be used
+
 private:
 
     SerXInterface                       *m_pSerx;
@@ -167,11 +212,12 @@ private:
     TheSkyXFacadeForDriversInterface    *m_pTsx;
     SleeperInterface                    *m_pSleeper;
 
-    float   m_fLat;
-    float   m_fLong;
+    CCentiArcsec    m_Lat;      // north positive
+    CCentiArcsec    m_Long;     // east positive
     int     m_nStatus;			// defined in iOptronStatus (stopped tracking slewing.. etc)
     int  	m_nTrackingRate;    // sidereal, lunar, solar, king, custom defined by iOptronTrackingRate
-    float	m_fCustomRaMultiplier; // cached tracking rate multiplier received from :GTR# call in getTrackRates when tracking custom
+    std::atomic<float>	m_fCustomRaMultiplier; // cached tracking rate multiplier received from :GTR# call in getTrackRates when tracking custom, also set by the rate stream
+    std::atomic<int64_t>    m_nCustomRateValue; // last :RR value sent since Connect, -1 if none
     int     m_pierStatus;         // which side of the meridian is the OTA
     int     m_counterWeightStatus; // counterweight up (about to get ugly) or normal
     int     m_nDegreesPastMeridian;  // degrees past the meridian
@@ -179,44 +225,68 @@ private:
     int	 	m_nCacheLimitStatus; // cache if we had no, 1, or 2 slew options last time we slewed.  Filled when we startSlewTo and issue command :QAP#
     int		m_nGPSStatus;		// CEM120_EC and EC2 mounts are crap without GPS receiving signal
     int		m_nTimeSource;		// CEM120xxx mounts rely heavily on DST being set and time being accurate
-    char    m_sModel[5];		// save a selectable/comparable version of the model of mount
+    const iOptronModel  *m_pModel;      // resolved from :MountInfo# on connect, "Unsupported Mount" until then
 
     bool    m_bParked;
 
     bool    m_bDebugLog;
     char    m_szLogBuffer[IOPTRON_LOG_BUFFER_SIZE];
 
-	bool    m_bIsConnected;                               // Connected to the mount?
+	std::atomic<bool>   m_bIsConnected;                   // Connected to the mount? Set under m_LinkLock, pulseGuide() tests it there
     char    m_szFirmwareVersion[SERIAL_BUFFER_SIZE];
 
     char    m_szHardwareModel[SERIAL_BUFFER_SIZE];
 
-	double  m_dGotoRATarget;						  // Current Target RA;
-	double  m_dGotoDECTarget;                      // Current Goto Target Dec;
+	CCentiArcsec    m_GotoRaTarget;     // Current Target RA;
+	CCentiArcsec    m_GotoDecTarget;    // Current Goto Target Dec;
 	
     MountDriverInterface::MoveDir      m_nOpenLoopDir;
     
-    int     sendCommand(const char *pszCmd, char *pszResult, int nExpectedResultLen);
-    int     readResponse(char *szRespBuffer, int nBytesToRead);
+    int     sendCommand(int nCmdId, char *pszResult);                       // command from the catalog
+    int     sendCommand(int nCmdId, const char *pszCmd, char *pszResult);   // formatted command, reply and flags from the catalog
+    int     sendCommand(const iOptronCommand &command, const char *pszCmd, int nCmdLen, char *pszResult, int nLinkUser = LINK_USER_HOST);
+    int     sendCommandLocked(const iOptronCommand &command, const char *pszCmd, int nCmdLen, char *pszResult, int nLinkUser = LINK_USER_HOST, bool bRetry = true);   // m_LinkLock held
+    int     exchange(const iOptronCommand &command, const char *pszCmd, int nCmdLen, char *szResp, unsigned nEvents, int nLinkUser);
+    int     readMountInfo(char *model, unsigned int strMaxLen, bool bRetry);   // m_LinkLock held
+    int     readResponse(char *szRespBuffer, int nBytesToRead, int nTimeout, unsigned long &ulBytesRead);
+    void    publishTelemetry();
+    void    notifyStatus();
+    int     selectCustomRate();
+    static int sendStreamRate(double dMountMultiplierRa, void *pUserData);
+    void    accountReadTime(int64_t nReadNs, unsigned long ulBytesRead);
+    int     accountParseTime(int nParseErr, int64_t nParseStartNs);    // returns nParseErr
 
     const char m_aszSlewRateNames[IOPTRON_NB_SLEW_SPEEDS][IOPTRON_SLEW_NAME_LENGHT] = { "1x", "2x", "8x", "16x",  "64x", "128x", "256x"};
 
-    CStopWatch      slewToTimer;
-    CStopWatch      cmdTimer;
-    CStopWatch      trackRatesTimer;
-    CStopWatch      getAtParkTimer;
-
-    float       m_dRa;
-    float       m_dDec;
-
-#ifdef IOPTRON_DEBUG
-    std::string m_sLogfilePath;
-	// timestamp for logs
-    char *timestamp;
-	time_t ltime;
-	FILE *Logfile;	  // LogFile
-	char* getTimestamp();
-#endif
+    CMonotonicClock *m_pClock;
+    CClockTimer     slewToTimer;
+    CClockTimer     cmdTimer;
+    CClockTimer     trackRatesTimer;
+    CClockTimer     getAtParkTimer;
+    CClockTimer     statusAgeTimer;     // reset each time :GLS# is read
+
+    std::atomic<unsigned>   m_nStaleCaches;     // CACHE_xxx invalidated by the commands sent since the last refresh
+    mutable CPriorityLock   m_LinkLock;         // one exchange at a time on the port, guide pulses first
+    CGuideStats             m_GuideStats;       // m_LinkLock held
+    CRateStreamer           m_RateStream;
+    iOptronTrafficCounters  m_Traffic[IOPTRON_NB_LINK_USERS];  // m_LinkLock held
+    int64_t                 m_nLastResponseAgeNs;
+    CCommandStats           m_CommandStats;
+    iOptronPhaseTimes       m_PhaseTimes;
+    int                     m_nLinkBaud;        // speed the port was opened at
+    CLinkHealth             m_LinkHealth;
+    bool                    m_bResyncPending;   // last exchange failed, its reply could still arrive
+    CTransportRecorder      m_Recorder;
+    CTelemetryPublisher     m_Telemetry;
+    int64_t                 m_nPositionTimeNs;  // system clock of the last :GEP# / :GLS# reads, for the telemetry
+    int64_t                 m_nStatusTimeNs;
+    CMountEvents            m_Events;
+
+    CCentiArcsec    m_Ra;       // last :GEP# position, exactly as the mount sent it
+    CCentiArcsec    m_Dec;
+
+	CAsyncLog *Logfile;	  // LogFile, owned by X2Mount, never NULL
+    CTraceLog *m_pTrace;  // owned by X2Mount, never NULL
 	
 };
 
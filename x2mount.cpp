@@ -20,7 +20,7 @@ X2Mount::X2Mount(const char* pszDriverSelection,
 	m_pIOMutex						= pIOMutex;
 	m_pTickCount					= pTickCount;
 	
-#ifdef IOPTRON_X2_DEBUG
+    // the log file is only created once a log level is turned on, in the ini or the settings dialog
 #if defined(SB_WIN_BUILD)
     m_sLogfilePath = getenv("HOMEDRIVE");
     m_sLogfilePath += getenv("HOMEPATH");
@@ -32,28 +32,30 @@ X2Mount::X2Mount(const char* pszDriverSelection,
     m_sLogfilePath = getenv("HOME");
     m_sLogfilePath += "/iOptronV3_X2_Logfile.txt";
 #endif
-	LogFile = fopen(m_sLogfilePath.c_str(), "w");
-    if(LogFile) {
-        m_iOptronV3.setLogFile(LogFile);
-        ltime = time(NULL);
-        timestamp = asctime(localtime(&ltime));
-        timestamp[strlen(timestamp) - 1] = 0;
-        fprintf(LogFile, "[%s] iOptronV3 X2 plugin version %3.3f\n", timestamp, DRIVER_VERSION);
-        fflush(LogFile);
-    }
-#endif
-	
+    LogFile = new CAsyncLog();    // formats and writes from its own thread
+    LogFile->setFilePath(m_sLogfilePath);
+    m_iOptronV3.setLogFile(LogFile);
+    m_pTrace = new CTraceLog();
+    m_iOptronV3.setTrace(m_pTrace);
 
 	m_bSynced = false;
 	m_bParked = false;
     m_bLinked = false;
 	m_bSetAutoTimeData = false;
 	m_bHasDoneZeroPosition = false;
-
-    m_iOptronV3.setSerxPointer(m_pSerX);
+    m_bCaptureTranscript = false;
+    m_bNativeSerial = false;
+    m_bDumpLinkStats = false;
+    m_bTraceEvents = false;
+    m_nSlewStartNs = 0;
+
+    // all serial I/O goes through the capture wrapper, it's a plain pass-through unless a capture is started
+    m_pSerialCapture = new CSerialCapture(m_pSerX);
+    m_iOptronV3.setSerxPointer(m_pSerialCapture);
     m_iOptronV3.setTSX(m_pTheSkyXForMounts);
     m_iOptronV3.setSleeper(m_pSleeper);
     m_iOptronV3.setLogger(m_pLogger);
+    m_iOptronV3.events().subscribe(MOUNT_EVENT_STATUS | MOUNT_EVENT_SLEW_DONE | MOUNT_EVENT_PARKED | MOUNT_EVENT_UNPARKED | MOUNT_EVENT_PIER_FLIP, onMountEvent, this);
 
     m_CurrentRateIndex = 0;
 
@@ -61,12 +63,28 @@ X2Mount::X2Mount(const char* pszDriverSelection,
 	if (m_pIniUtil)
 	{
 		m_bSetAutoTimeData = (m_pIniUtil->readInt(PARENT_KEY, AUTO_DATETIME, 0) == 0?false:true);
+        m_bCaptureTranscript = (m_pIniUtil->readInt(PARENT_KEY, CAPTURE_TRANSCRIPT, 0) == 0?false:true);
+        m_bDumpLinkStats = (m_pIniUtil->readInt(PARENT_KEY, DUMP_LINK_STATS, 0) == 0?false:true);
+        m_bTraceEvents = (m_pIniUtil->readInt(PARENT_KEY, TRACE_EVENTS, 0) == 0?false:true);
+        m_iOptronV3.transportRecorder().setCapture(homeFilePath("iOptronV3_slow"), m_pIniUtil->readInt(PARENT_KEY, SLOW_COMMAND_MS, TRANSPORT_DEFAULT_SLOW_MS));
+        if(m_pIniUtil->readInt(PARENT_KEY, PUBLISH_TELEMETRY, 0))
+            m_iOptronV3.setTelemetry(true, m_nPrivateMulitInstanceIndex);
+#if !defined(SB_WIN_BUILD)
+        m_bNativeSerial = (m_pIniUtil->readInt(PARENT_KEY, NATIVE_SERIAL, 0) == 0?false:true);
+        m_NativeSerial.setReadMode(m_pIniUtil->readInt(PARENT_KEY, NATIVE_SERIAL_VMIN, 0), m_pIniUtil->readInt(PARENT_KEY, NATIVE_SERIAL_VTIME, 0));
+        m_NativeSerial.setLowLatency(m_pIniUtil->readInt(PARENT_KEY, NATIVE_SERIAL_LOW_LATENCY, 1) == 0?false:true);
+#endif
 	}
+    readLogLevels();
 
 }
 
 X2Mount::~X2Mount()
 {
+    // the rate stream thread sends through the serial, log and trace objects deleted below
+    m_iOptronV3.stopRateStream();
+    if (m_pSerialCapture)
+        delete m_pSerialCapture;
     if (m_pSerX)
 		delete m_pSerX;
 	if (m_pTheSkyXForMounts)
@@ -81,6 +99,14 @@ X2Mount::~X2Mount()
 		delete m_pIOMutex;
 	if (m_pTickCount)
 		delete m_pTickCount;
+    if (m_pTrace) {
+        m_iOptronV3.setTrace(NULL);
+        delete m_pTrace;
+    }
+    if (LogFile) {
+        m_iOptronV3.setLogFile(NULL);
+        delete LogFile;
+    }
  }
 
 
@@ -125,30 +151,18 @@ int X2Mount::startOpenLoopMove(const MountDriverInterface::MoveDir& Dir, const i
     if(!m_bLinked)
         return ERR_NOLINK;
 
-    X2MutexLocker ml(GetMutex());
+    CHostCallProbe probe(m_HostCallStats, m_iOptronV3, X2_CALL_START_OPEN_LOOP_MOVE, GetMutex());
 
 	m_CurrentRateIndex = nRateIndex;
-#ifdef IOPTRON_X2_DEBUG
-	if (LogFile) {
-		ltime = time(NULL);
-		timestamp = asctime(localtime(&ltime));
-		timestamp[strlen(timestamp) - 1] = 0;
-        fprintf(LogFile, "[%s] startOpenLoopMove called Dir: %d , Rate: %d\n", timestamp, Dir, nRateIndex);
-        fflush(LogFile);
+	if (LogFile->enabled(LOG_SLEW, LOG_DEBUG)) {
+        LogFile->log("startOpenLoopMove called Dir: %d , Rate: %d\n", Dir, nRateIndex);
 	}
-#endif
 
     nErr = m_iOptronV3.startOpenSlew(Dir, nRateIndex);
     if(nErr) {
-#ifdef IOPTRON_X2_DEBUG
-        if (LogFile) {
-            ltime = time(NULL);
-            timestamp = asctime(localtime(&ltime));
-            timestamp[strlen(timestamp) - 1] = 0;
-            fprintf(LogFile, "[%s] startOpenLoopMove ERROR %d\n", timestamp, nErr);
-            fflush(LogFile);
+        if (LogFile->enabled(LOG_SLEW, LOG_ERROR)) {
+            LogFile->log("startOpenLoopMove ERROR %d\n", nErr);
         }
-#endif
         m_pLogger->out("startOpenLoopMove ERROR");
         return ERR_CMDFAILED;
     }
@@ -161,29 +175,17 @@ int X2Mount::endOpenLoopMove(void)
     if(!m_bLinked)
         return ERR_NOLINK;
 
-    X2MutexLocker ml(GetMutex());
+    CHostCallProbe probe(m_HostCallStats, m_iOptronV3, X2_CALL_END_OPEN_LOOP_MOVE, GetMutex());
 
-#ifdef IOPTRON_X2_DEBUG
-	if (LogFile){
-		ltime = time(NULL);
-		timestamp = asctime(localtime(&ltime));
-		timestamp[strlen(timestamp) - 1] = 0;
-		fprintf(LogFile, "[%s] endOpenLoopMove Called\n", timestamp);
-        fflush(LogFile);
+	if (LogFile->enabled(LOG_SLEW, LOG_DEBUG)) {
+		LogFile->log("endOpenLoopMove Called\n");
 	}
-#endif
 
     nErr = m_iOptronV3.stopOpenLoopMove();
     if(nErr) {
-#ifdef IOPTRON_X2_DEBUG
-        if (LogFile) {
-            ltime = time(NULL);
-            timestamp = asctime(localtime(&ltime));
-            timestamp[strlen(timestamp) - 1] = 0;
-            fprintf(LogFile, "[%s] endOpenLoopMove ERROR %d\n", timestamp, nErr);
-            fflush(LogFile);
+        if (LogFile->enabled(LOG_SLEW, LOG_ERROR)) {
+            LogFile->log("endOpenLoopMove ERROR %d\n", nErr);
         }
-#endif
         m_pLogger->out("endOpenLoopMove ERROR");
         return ERR_CMDFAILED;
     }
@@ -194,7 +196,7 @@ int X2Mount::rateCountOpenLoopMove(void) const
 {
     X2Mount* pMe = (X2Mount*)this;
 
-    X2MutexLocker ml(pMe->GetMutex());
+    CHostCallProbe probe(pMe->m_HostCallStats, pMe->m_iOptronV3, X2_CALL_RATE_COUNT_OPEN_LOOP_MOVE, pMe->GetMutex());
 	return pMe->m_iOptronV3.getNbSlewRates();
 }
 
@@ -203,15 +205,9 @@ int X2Mount::rateNameFromIndexOpenLoopMove(const int& nZeroBasedIndex, char* psz
     int nErr = SB_OK;
     nErr = m_iOptronV3.getRateName(nZeroBasedIndex, pszOut, nOutMaxSize);
     if(nErr) {
-#ifdef IOPTRON_X2_DEBUG
-        if (LogFile) {
-            ltime = time(NULL);
-            timestamp = asctime(localtime(&ltime));
-            timestamp[strlen(timestamp) - 1] = 0;
-            fprintf(LogFile, "[%s] rateNameFromIndexOpenLoopMove ERROR %d\n", timestamp, nErr);
-            fflush(LogFile);
+        if (LogFile->enabled(LOG_SLEW, LOG_ERROR)) {
+            LogFile->log("rateNameFromIndexOpenLoopMove ERROR %d\n", nErr);
         }
-#endif
         m_pLogger->out("rateNameFromIndexOpenLoopMove ERROR");
         return ERR_CMDFAILED;
     }
@@ -223,6 +219,64 @@ int X2Mount::rateIndexOpenLoopMove(void)
 	return m_CurrentRateIndex;
 }
 
+#pragma mark - Pulse guiding
+int X2Mount::pulseGuide(const MountDriverInterface::MoveDir& Dir, const int& nDurationMs)
+{
+    int nErr = SB_OK;
+    if(!m_bLinked)
+        return ERR_NOLINK;
+
+    // no CHostCallProbe, it would queue the pulse behind the host call holding the mutex
+    nErr = m_iOptronV3.pulseGuide(Dir, nDurationMs);
+    if(nErr) {
+        if (LogFile->enabled(LOG_TRACKING, LOG_ERROR)) {
+            LogFile->log("pulseGuide ERROR %d, Dir: %d, duration %d ms\n", nErr, Dir, nDurationMs);
+        }
+        return nErr == NOT_CONNECTED ? ERR_NOLINK : ERR_CMDFAILED;
+    }
+    return SB_OK;
+}
+
+int X2Mount::startRateStream(const std::vector<iOptronRatePoint> &profile, int nPeriodMs)
+{
+    int nErr = SB_OK;
+    if(!m_bLinked)
+        return ERR_NOLINK;
+
+    X2MutexLocker ml(GetMutex());
+    nErr = m_iOptronV3.startRateStream(profile, nPeriodMs);
+    if(nErr) {
+        if (LogFile->enabled(LOG_TRACKING, LOG_ERROR)) {
+            LogFile->log("startRateStream ERROR %d, %d points\n", nErr, (int)profile.size());
+        }
+        return nErr == NOT_CONNECTED ? ERR_NOLINK : ERR_CMDFAILED;
+    }
+    return SB_OK;
+}
+
+int X2Mount::startRateStream(RateEphemerisCallback pfEphemeris, void *pUserData, int nPeriodMs)
+{
+    int nErr = SB_OK;
+    if(!m_bLinked)
+        return ERR_NOLINK;
+
+    X2MutexLocker ml(GetMutex());
+    nErr = m_iOptronV3.startRateStream(pfEphemeris, pUserData, nPeriodMs);
+    if(nErr) {
+        if (LogFile->enabled(LOG_TRACKING, LOG_ERROR)) {
+            LogFile->log("startRateStream ERROR %d\n", nErr);
+        }
+        return nErr == NOT_CONNECTED ? ERR_NOLINK : ERR_CMDFAILED;
+    }
+    return SB_OK;
+}
+
+void X2Mount::stopRateStream(void)
+{
+    X2MutexLocker ml(GetMutex());
+    m_iOptronV3.stopRateStream();
+}
+
 #pragma mark - UI binding
 
 int X2Mount::execModalSettingsDialog(void)
@@ -250,12 +304,13 @@ int X2Mount::execModalSettingsDialog(void)
 		return ERR_POINTER;
 	}
 
-    X2MutexLocker ml(GetMutex());
+    CHostCallProbe probe(m_HostCallStats, m_iOptronV3, X2_CALL_SETTINGS_DIALOG, GetMutex());
 
 	// Set values in the userinterface
     iAutoDateTime = m_pIniUtil->readInt(PARENT_KEY, AUTO_DATETIME, 0);
     m_bSetAutoTimeData = iAutoDateTime==1?true:false;
     dx->setChecked("autoDateTime", iAutoDateTime); // set this anyway to indicate our value even if mount isn't connected
+    dx->setCurrentIndex("comboBox_logLevel", m_pIniUtil->readInt(PARENT_KEY, LOG_LEVEL, LOG_OFF));
 
     if(m_bLinked) {
         dx->setEnabled("parkAz", true);
@@ -309,15 +364,9 @@ int X2Mount::execModalSettingsDialog(void)
 
         dx->setEnabled("checkBox_zero_done", true); // allow user to check and uncheck this
         dx->setChecked("checkBox_zero_good", m_bHasDoneZeroPosition?1:0);
-#ifdef IOPTRON_X2_DEBUG
-        if (LogFile) {
-            ltime = time(NULL);
-            timestamp = asctime(localtime(&ltime));
-            timestamp[strlen(timestamp) - 1] = 0;
-            fprintf(LogFile, "[%s] execModalSettingsDialog initializing checkBox_zero_good .  Value of m_bHasDoneZeroPosition: %s\n", timestamp, m_bHasDoneZeroPosition?"true":"false");
-            fflush(LogFile);
+        if (LogFile->enabled(LOG_UI, LOG_DEBUG)) {
+            LogFile->log("execModalSettingsDialog initializing checkBox_zero_good .  Value of m_bHasDoneZeroPosition: %s\n", m_bHasDoneZeroPosition?"true":"false");
         }
-#endif
     }
     else {
         dx->setEnabled("parkAz", false);
@@ -350,6 +399,8 @@ int X2Mount::execModalSettingsDialog(void)
     dx->setEnabled("checkBox_dst_good", false); // checkbox telling you that DST has been set for slewing
     dx->setEnabled("checkBox_zero_good", false); // checkbox confirming you did a seek zero position for slewing
 
+    updateLinkStats(dx);
+
 	//Display the user interface
     m_nCurrentDialog = MAIN;
 	if ((nErr = ui->exec(bPressedOK)))
@@ -357,26 +408,14 @@ int X2Mount::execModalSettingsDialog(void)
 	
 	//Retreive values from the user interface
 	if (bPressedOK) {
-#ifdef IOPTRON_X2_DEBUG
-        if (LogFile) {
-            ltime = time(NULL);
-            timestamp = asctime(localtime(&ltime));
-            timestamp[strlen(timestamp) - 1] = 0;
-            fprintf(LogFile, "[%s] execModalSettingsDialog pressedOK: do the needful and check if stuff changed\n", timestamp);
-            fflush(LogFile);
+        if (LogFile->enabled(LOG_UI, LOG_DEBUG)) {
+            LogFile->log("execModalSettingsDialog pressedOK: do the needful and check if stuff changed\n");
         }
-#endif
         dx->text("lineEdit_utc", szUtcOffsetReadInMins, SERIAL_BUFFER_SIZE);
         if (strcmp(szUtcOffsetReadInMins, szUtcOffsetInMins) != 0) {
-#ifdef IOPTRON_X2_DEBUG
-            if (LogFile) {
-                ltime = time(NULL);
-                timestamp = asctime(localtime(&ltime));
-                timestamp[strlen(timestamp) - 1] = 0;
-                fprintf(LogFile, "[%s] execModalSettingsDialog pressedOK: utc value changed value is %s.  first character %c\n", timestamp, szUtcOffsetReadInMins, szUtcOffsetReadInMins[0]);
-                fflush(LogFile);
+            if (LogFile->enabled(LOG_UI, LOG_DEBUG)) {
+                LogFile->log("execModalSettingsDialog pressedOK: utc value changed value is %s.  first character %c\n", szUtcOffsetReadInMins, szUtcOffsetReadInMins[0]);
             }
-#endif
             // changed utc offset
             if (atoi(szUtcOffsetReadInMins) > 780 || atoi(szUtcOffsetReadInMins) < -720) {
                 // out of range,..
@@ -390,15 +429,9 @@ int X2Mount::execModalSettingsDialog(void)
             }
         }
         if (dx->currentIndex("comboBox_dst") != 0) {
-#ifdef IOPTRON_X2_DEBUG
-            if (LogFile) {
-                ltime = time(NULL);
-                timestamp = asctime(localtime(&ltime));
-                timestamp[strlen(timestamp) - 1] = 0;
-                fprintf(LogFile, "[%s] execModalSettingsDialog pressedOK: dst value set.  Value read is %i\n", timestamp, dx->currentIndex("comboBox_dst"));
-                fflush(LogFile);
+            if (LogFile->enabled(LOG_UI, LOG_DEBUG)) {
+                LogFile->log("execModalSettingsDialog pressedOK: dst value set.  Value read is %i\n", dx->currentIndex("comboBox_dst"));
             }
-#endif
             if (dx->currentIndex("comboBox_dst") == 1 && !bDaylight) {
                 // change to daylight
                 m_iOptronV3.setDST(true);
@@ -408,31 +441,21 @@ int X2Mount::execModalSettingsDialog(void)
             }
         }
 
-#ifdef IOPTRON_X2_DEBUG
-        if (LogFile) {
-            ltime = time(NULL);
-            timestamp = asctime(localtime(&ltime));
-            timestamp[strlen(timestamp) - 1] = 0;
-            fprintf(LogFile, "[%s] execModalSettingsDialog pressedOK: dst value set.  Value read is %i\n", timestamp, dx->currentIndex("comboBox_dst"));
-            fflush(LogFile);
+        if (LogFile->enabled(LOG_UI, LOG_DEBUG)) {
+            LogFile->log("execModalSettingsDialog pressedOK: dst value set.  Value read is %i\n", dx->currentIndex("comboBox_dst"));
         }
-#endif
         m_bSetAutoTimeData = (dx->isChecked("autoDateTime") == 0?false:true);
         if(m_pIniUtil){
             m_pIniUtil->writeInt(PARENT_KEY, AUTO_DATETIME, m_bSetAutoTimeData?1:0);
+            m_pIniUtil->writeInt(PARENT_KEY, LOG_LEVEL, dx->currentIndex("comboBox_logLevel"));
+            readLogLevels();
         }
 
         if (dx->isChecked("checkBox_zero_done")) {
             m_bHasDoneZeroPosition = true;
-#ifdef IOPTRON_X2_DEBUG
-            if (LogFile) {
-                ltime = time(NULL);
-                timestamp = asctime(localtime(&ltime));
-                timestamp[strlen(timestamp) - 1] = 0;
-                fprintf(LogFile, "[%s] execModalSettingsDialog label_promise_zero checked.  Value of m_bHasDoneZeroPosition: %s\n", timestamp, m_bHasDoneZeroPosition?"true":"false");
-                fflush(LogFile);
+            if (LogFile->enabled(LOG_UI, LOG_DEBUG)) {
+                LogFile->log("execModalSettingsDialog label_promise_zero checked.  Value of m_bHasDoneZeroPosition: %s\n", m_bHasDoneZeroPosition?"true":"false");
             }
-#endif
         }
 	}
 	return nErr;
@@ -457,30 +480,18 @@ int X2Mount::doConfirm(bool &bPressedOK, const char *szText)
 
     bPressedOK = false;
 
-#ifdef IOPTRON_X2_DEBUG
-    if (LogFile) {
-        ltime = time(NULL);
-        timestamp = asctime(localtime(&ltime));
-        timestamp[strlen(timestamp) - 1] = 0;
-        fprintf(LogFile, "[%s] doConfirm called: X2GUIInterface is %s.  \n", timestamp, ui==NULL?"NULL":"*good*");
-        fflush(LogFile);
+    if (LogFile->enabled(LOG_UI, LOG_DEBUG)) {
+        LogFile->log("doConfirm called: X2GUIInterface is %s.  \n", ui==NULL?"NULL":"*good*");
     }
-#endif
 
     if (NULL == ui)
         return ERR_POINTER;
     nErr = ui->loadUserInterface("iOptronV3Conf.ui", deviceType(), m_nPrivateMulitInstanceIndex);
 
     if (nErr) {
-#ifdef IOPTRON_X2_DEBUG
-        if (LogFile) {
-            ltime = time(NULL);
-            timestamp = asctime(localtime(&ltime));
-            timestamp[strlen(timestamp) - 1] = 0;
-            fprintf(LogFile, "[%s] doConfirm error when loading user interface: %i.  \n", timestamp, nErr);
-            fflush(LogFile);
+        if (LogFile->enabled(LOG_UI, LOG_ERROR)) {
+            LogFile->log("doConfirm error when loading user interface: %i.  \n", nErr);
         }
-#endif
         return nErr;
     }
 
@@ -494,27 +505,15 @@ int X2Mount::doConfirm(bool &bPressedOK, const char *szText)
     //Display the user interface
     nErr = ui->exec(bPressedOK);
     if (nErr) {
-#ifdef IOPTRON_X2_DEBUG
-        if (LogFile) {
-            ltime = time(NULL);
-            timestamp = asctime(localtime(&ltime));
-            timestamp[strlen(timestamp) - 1] = 0;
-            fprintf(LogFile, "[%s] doConfirm dialog ended.  Error when exec-ing user interface: %i.  \n", timestamp, nErr);
-            fflush(LogFile);
+        if (LogFile->enabled(LOG_UI, LOG_ERROR)) {
+            LogFile->log("doConfirm dialog ended.  Error when exec-ing user interface: %i.  \n", nErr);
         }
-#endif
         return nErr;
     }
 
-#ifdef IOPTRON_X2_DEBUG
-    if (LogFile) {
-        ltime = time(NULL);
-        timestamp = asctime(localtime(&ltime));
-        timestamp[strlen(timestamp) - 1] = 0;
-        fprintf(LogFile, "[%s] doConfirm dialog ended successfully.  value of bPressedOK: %s.  \n", timestamp, bPressedOK?"true":"false");
-        fflush(LogFile);
+    if (LogFile->enabled(LOG_UI, LOG_DEBUG)) {
+        LogFile->log("doConfirm dialog ended successfully.  value of bPressedOK: %s.  \n", bPressedOK?"true":"false");
     }
-#endif
 
     m_nCurrentDialog = MAIN;
 
@@ -549,37 +548,19 @@ int X2Mount::doMainDialogEvents(X2GUIExchangeInterface* uiex, const char* pszEve
     bool bIsGPSFunctioning = false;
     bool bIsGPSReceivingData = false;
 
-#ifdef IOPTRON_X2_DEBUG
-    if (LogFile) {
-        ltime = time(NULL);
-        timestamp = asctime(localtime(&ltime));
-        timestamp[strlen(timestamp) - 1] = 0;
-        fprintf(LogFile, "[%s] X2Mount::uiEvent called.  Value of pszEvent: %s\n", timestamp, pszEvent);
-        fflush(LogFile);
+    if (LogFile->enabled(LOG_UI, LOG_DEBUG)) {
+        LogFile->log("X2Mount::uiEvent called.  Value of pszEvent: %s\n", pszEvent);
     }
-#endif
     if(!m_bLinked)
         return ERR_NOLINK ;
 
-#ifdef IOPTRON_X2_DEBUG
-    if (LogFile) {
-        ltime = time(NULL);
-        timestamp = asctime(localtime(&ltime));
-        timestamp[strlen(timestamp) - 1] = 0;
-        fprintf(LogFile, "[%s] X2Mount::uiEvent called.  We're linked so doing something\n", timestamp);
-        fflush(LogFile);
+    if (LogFile->enabled(LOG_UI, LOG_DEBUG)) {
+        LogFile->log("X2Mount::uiEvent called.  We're linked so doing something\n");
     }
-#endif
 	if (!strcmp(pszEvent, "on_pushButton_7_clicked")) { //Set location from TSX --> mount
-#ifdef IOPTRON_X2_DEBUG
-		if (LogFile) {
-			ltime = time(NULL);
-			timestamp = asctime(localtime(&ltime));
-			timestamp[strlen(timestamp) - 1] = 0;
-			fprintf(LogFile, "[%s] X2Mount::uiEvent on_pushButton_7_clicked (_7 means set location from TSX)\n", timestamp);
-			fflush(LogFile);
+		if (LogFile->enabled(LOG_UI, LOG_DEBUG)) {
+			LogFile->log("X2Mount::uiEvent on_pushButton_7_clicked (_7 means set location from TSX)\n");
 		}
-#endif
         m_iOptronV3.mountHasFunctioningGPSPassive(bIsGPSFunctioning);
 		m_iOptronV3.isGPSReceivingDataPassive(bIsGPSReceivingData);
 		if (bIsGPSFunctioning) {
@@ -594,7 +575,7 @@ int X2Mount::doMainDialogEvents(X2GUIExchangeInterface* uiex, const char* pszEve
 
 		if(bOk) {
 			// TSX longitude is + going west and - going east, so passing the opposite
-			 nErr = m_iOptronV3.setLocation(m_pTheSkyXForMounts->latitude(), - m_pTheSkyXForMounts->longitude());
+			 nErr = m_iOptronV3.setLocation(CCentiArcsec::fromDegrees(m_pTheSkyXForMounts->latitude()), CCentiArcsec::fromDegrees(-m_pTheSkyXForMounts->longitude()));
 			if(nErr) {
 				snprintf(szTmpBuf,SERIAL_BUFFER_SIZE, "Error setting location: %d", nErr);
 				uiex->messageBox("Error",szTmpBuf);
@@ -602,15 +583,9 @@ int X2Mount::doMainDialogEvents(X2GUIExchangeInterface* uiex, const char* pszEve
 		}
 	}
 	else if (!strcmp(pszEvent, "on_pushButton_6_clicked")) { //Set the time, timezone, and date from TSX --> mount
-#ifdef IOPTRON_X2_DEBUG
-		if (LogFile) {
-			ltime = time(NULL);
-			timestamp = asctime(localtime(&ltime));
-			timestamp[strlen(timestamp) - 1] = 0;
-			fprintf(LogFile, "[%s] X2Mount::uiEvent on_pushButton_6_clicked (_6 means set timezone, utc, time and date)\n", timestamp);
-			fflush(LogFile);
+		if (LogFile->enabled(LOG_UI, LOG_DEBUG)) {
+			LogFile->log("X2Mount::uiEvent on_pushButton_6_clicked (_6 means set timezone, utc, time and date)\n");
 		}
-#endif
 		doConfirm(bOk, "Are you sure you want to send the time, timezone, UTC offset, and date from TheSky to the mount ?");
 		if(bOk) {
 
@@ -633,17 +608,11 @@ int X2Mount::doMainDialogEvents(X2GUIExchangeInterface* uiex, const char* pszEve
                     dUTCOffsetInMins = dTimezoneFromTSX * 60;
                     snprintf(szTmpBuf, SERIAL_BUFFER_SIZE, "%+03.0f", dUTCOffsetInMins);
 
-                    #ifdef IOPTRON_X2_DEBUG
-                    if (LogFile) {
-                        ltime = time(NULL);
-                        timestamp = asctime(localtime(&ltime));
-                        timestamp[strlen(timestamp) - 1] = 0;
-                        fprintf(LogFile,
-                                "[%s] X2Mount::doMainDialogEvents::on_pushButton_6_clicked (_6 means set timezone, utc, time and date) calculated UTC offset as %g and the string we're sending to the mount: %s\n",
-                                timestamp, dUTCOffsetInMins, szTmpBuf);
-                        fflush(LogFile);
+                    if (LogFile->enabled(LOG_UI, LOG_DEBUG)) {
+                        LogFile->log(
+                                "X2Mount::doMainDialogEvents::on_pushButton_6_clicked (_6 means set timezone, utc, time and date) calculated UTC offset as %g and the string we're sending to the mount: %s\n",
+                                dUTCOffsetInMins, szTmpBuf);
                     }
-                    #endif
 
                     nErr = m_iOptronV3.setUtcOffset(szTmpBuf);
                     if (nErr) {
@@ -653,17 +622,11 @@ int X2Mount::doMainDialogEvents(X2GUIExchangeInterface* uiex, const char* pszEve
                         //
                         // next, set time/date on mount to TSX's time/date which I assume is NTP time for most people
                         //
-                         #ifdef IOPTRON_X2_DEBUG
-                         if (LogFile) {
-                            ltime = time(NULL);
-                            timestamp = asctime(localtime(&ltime));
-                            timestamp[strlen(timestamp) - 1] = 0;
-                            fprintf(LogFile,
-                                    "[%s] X2Mount::doMainDialogEvents::on_pushButton_6_clicked (_6 means set timezone, utc, time and date) TSX Julian time came back as %g \n",
-                                    timestamp, m_pTheSkyXForMounts->julianDate());
-                            fflush(LogFile);
+                         if (LogFile->enabled(LOG_UI, LOG_DEBUG)) {
+                            LogFile->log(
+                                    "X2Mount::doMainDialogEvents::on_pushButton_6_clicked (_6 means set timezone, utc, time and date) TSX Julian time came back as %g \n",
+                                    m_pTheSkyXForMounts->julianDate());
                          }
-                         #endif
                          nErr = m_iOptronV3.setTimeAndDate(m_pTheSkyXForMounts->julianDate());
                         if (nErr) {
                             snprintf(szTmpBuf, SERIAL_BUFFER_SIZE, "Error setting date/time on mount : %d.  Both UTC offset and DST were indeed successfully set.", nErr);
@@ -676,15 +639,9 @@ int X2Mount::doMainDialogEvents(X2GUIExchangeInterface* uiex, const char* pszEve
 		}
 	}
 	else if (!strcmp(pszEvent, "on_pushButton_2_clicked")) { //Set the park position
-#ifdef IOPTRON_X2_DEBUG
-        if (LogFile) {
-            ltime = time(NULL);
-            timestamp = asctime(localtime(&ltime));
-            timestamp[strlen(timestamp) - 1] = 0;
-            fprintf(LogFile, "[%s] X2Mount::uiEvent on_pushButton_2_clicked (_2 means parked)\n", timestamp);
-            fflush(LogFile);
+        if (LogFile->enabled(LOG_UI, LOG_DEBUG)) {
+            LogFile->log("X2Mount::uiEvent on_pushButton_2_clicked (_2 means parked)\n");
         }
-#endif
         doConfirm(bOk, "Are you sure you want to set the park position ?");
         if(bOk) {
             uiex->propertyDouble("parkAz", "value", dParkAz);
@@ -696,15 +653,9 @@ int X2Mount::doMainDialogEvents(X2GUIExchangeInterface* uiex, const char* pszEve
             }
         }
     } else if (!strcmp(pszEvent, "on_pushButton_3_clicked")) {
-#ifdef IOPTRON_X2_DEBUG
-        if (LogFile) {
-            ltime = time(NULL);
-            timestamp = asctime(localtime(&ltime));
-            timestamp[strlen(timestamp) - 1] = 0;
-            fprintf(LogFile, "[%s] X2Mount::uiEvent on_pushButton_3_clicked (_3 means goto zero position)\n", timestamp);
-            fflush(LogFile);
+        if (LogFile->enabled(LOG_UI, LOG_DEBUG)) {
+            LogFile->log("X2Mount::uiEvent on_pushButton_3_clicked (_3 means goto zero position)\n");
         }
-#endif
         doConfirm(bOk, "Are you sure you want to go to zero position ?");
         if(bOk) {
             nErr = m_iOptronV3.gotoZeroPosition();
@@ -715,15 +666,9 @@ int X2Mount::doMainDialogEvents(X2GUIExchangeInterface* uiex, const char* pszEve
         }
 
     } else if (!strcmp(pszEvent, "on_pushButton_4_clicked")) {
-#ifdef IOPTRON_X2_DEBUG
-        if (LogFile) {
-            ltime = time(NULL);
-            timestamp = asctime(localtime(&ltime));
-            timestamp[strlen(timestamp) - 1] = 0;
-            fprintf(LogFile, "[%s] X2Mount::uiEvent on_pushButton_4_clicked (_4 means find zero)\n", timestamp);
-            fflush(LogFile);
+        if (LogFile->enabled(LOG_UI, LOG_DEBUG)) {
+            LogFile->log("X2Mount::uiEvent on_pushButton_4_clicked (_4 means find zero)\n");
         }
-#endif
         doConfirm(bOk, "Are you sure you want to search for mechanical zero position ?");
         if(bOk) {
             nErr = m_iOptronV3.findZeroPosition();
@@ -735,15 +680,9 @@ int X2Mount::doMainDialogEvents(X2GUIExchangeInterface* uiex, const char* pszEve
             }
         }
     } else if (!strcmp(pszEvent, "on_pushButton_5_clicked")) {
-#ifdef IOPTRON_X2_DEBUG
-        if (LogFile) {
-            ltime = time(NULL);
-            timestamp = asctime(localtime(&ltime));
-            timestamp[strlen(timestamp) - 1] = 0;
-            fprintf(LogFile, "[%s] X2Mount::uiEvent on_pushButton_5_clicked (_5 means goto flats position)\n", timestamp);
-            fflush(LogFile);
+        if (LogFile->enabled(LOG_UI, LOG_DEBUG)) {
+            LogFile->log("X2Mount::uiEvent on_pushButton_5_clicked (_5 means goto flats position)\n");
         }
-#endif
         doConfirm(bOk, "Are you sure you want to move the mount to point straight up and take flats ?");
         if(bOk) {
             nErr = m_iOptronV3.gotoFlatsPosition();
@@ -753,15 +692,9 @@ int X2Mount::doMainDialogEvents(X2GUIExchangeInterface* uiex, const char* pszEve
             }
         }
     } else if (!strcmp(pszEvent, "on_pushButton_8_clicked")) {
-#ifdef IOPTRON_X2_DEBUG
-        if (LogFile) {
-            ltime = time(NULL);
-            timestamp = asctime(localtime(&ltime));
-            timestamp[strlen(timestamp) - 1] = 0;
-            fprintf(LogFile, "[%s] X2Mount::uiEvent on_pushButton_8_clicked (_8 means set altitude limit)\n", timestamp);
-            fflush(LogFile);
+        if (LogFile->enabled(LOG_UI, LOG_DEBUG)) {
+            LogFile->log("X2Mount::uiEvent on_pushButton_8_clicked (_8 means set altitude limit)\n");
         }
-#endif
         doConfirm(bOk, "Are you sure you want to set the altitude limit ?");
         if(bOk) {
             uiex->propertyInt("altLimit", "value", iAltLimit);
@@ -772,15 +705,9 @@ int X2Mount::doMainDialogEvents(X2GUIExchangeInterface* uiex, const char* pszEve
             }
         }
     } else if (!strcmp(pszEvent, "on_pushButton_9_clicked")) {
-#ifdef IOPTRON_X2_DEBUG
-        if (LogFile) {
-            ltime = time(NULL);
-            timestamp = asctime(localtime(&ltime));
-            timestamp[strlen(timestamp) - 1] = 0;
-            fprintf(LogFile, "[%s] X2Mount::uiEvent on_pushButton_9_clicked (_9 means set meridian treatement)\n", timestamp);
-            fflush(LogFile);
+        if (LogFile->enabled(LOG_UI, LOG_DEBUG)) {
+            LogFile->log("X2Mount::uiEvent on_pushButton_9_clicked (_9 means set meridian treatement)\n");
         }
-#endif
         doConfirm(bOk, "Are you sure you want to set both the meridian treatment (flip vs stop) AND set the degrees past meridian ?");
         if(bOk) {
             if (uiex->isChecked("meridianStop")) {
@@ -800,8 +727,19 @@ int X2Mount::doMainDialogEvents(X2GUIExchangeInterface* uiex, const char* pszEve
                 }
             }
         }
+    } else if (!strcmp(pszEvent, "on_pushButton_perfReport_clicked")) {
+        std::string sReportPath;
+        if (writeLatencyReport(sReportPath)) {
+            snprintf(szTmpBuf, SERIAL_BUFFER_SIZE, "Can't create %s", sReportPath.c_str());
+            uiex->messageBox("Error", szTmpBuf);
+        }
+        else {
+            snprintf(szTmpBuf, SERIAL_BUFFER_SIZE, "Latency report written to %s", sReportPath.c_str());
+            uiex->messageBox("Latency Report", szTmpBuf);
+        }
 	} else if (!strcmp(pszEvent, "on_timer")) {
 	    updateDialogRealtime(uiex);
+        updateLinkStats(uiex);
 	}
     return nErr;
 }
@@ -817,12 +755,14 @@ int X2Mount::updateDialogRealtime(X2GUIExchangeInterface* uiex)
     bool bAtParked = false;
     bool bOkToSlew = false;
     bool bGPSOrLatLongGood = false;
-    float fLat, fLong;
+    CCentiArcsec Lat, Long;
 
     memset(szGPSStatus,0,SERIAL_BUFFER_SIZE);
     memset(szTimeSource,0,SERIAL_BUFFER_SIZE);
 
-    m_iOptronV3.getInfoAndSettings();
+    // while the host polls isCompleteSlewTo / isCompletePark the status is already fresh, don't ask twice
+    if(m_iOptronV3.getStatusAgeNs() > DIALOG_STATUS_MAX_AGE_MS * NS_PER_MS)
+        m_iOptronV3.getInfoAndSettings();
     m_iOptronV3.getGPSStatusStringPassive(szGPSStatus, SERIAL_BUFFER_SIZE);
     uiex->setText("label_kv_1", szGPSStatus);
     m_iOptronV3.isGPSOrLatLongGoodPassive(bGPSOrLatLongGood);
@@ -859,8 +799,8 @@ int X2Mount::updateDialogRealtime(X2GUIExchangeInterface* uiex)
     }
 
     // set lat/long in interface
-    m_iOptronV3.getLocationPassive(fLat, fLong);
-    snprintf(szLatLong, SERIAL_BUFFER_SIZE, "%f/%f", fLat, fLong);
+    m_iOptronV3.getLocationPassive(Lat, Long);
+    snprintf(szLatLong, SERIAL_BUFFER_SIZE, "%f/%f", Lat.degrees(), Long.degrees());
     uiex->setText("label_lat_long_4", szLatLong);
     return SB_OK;
 }
@@ -882,11 +822,21 @@ int X2Mount::establishLink(void)
 
     char szPort[DRIVER_MAX_STRING];
 
-	X2MutexLocker ml(GetMutex());
+	CHostCallProbe probe(m_HostCallStats, m_iOptronV3, X2_CALL_ESTABLISH_LINK, GetMutex());
+    m_HostCallStats.reset();  // start accounting for this session
 	// get serial port device name
     portNameOnToCharPtr(szPort,DRIVER_MAX_STRING);
 
-	nErr =  m_iOptronV3.Connect(szPort);
+#if !defined(SB_WIN_BUILD)
+    // pick the transport for this session, the host serial port or our own tty code
+    m_pSerialCapture->setSerX(m_bNativeSerial ? (SerXInterface *)&m_NativeSerial : m_pSerX);
+#endif
+    if(m_bCaptureTranscript)
+        startTranscriptCapture();
+    if(m_bTraceEvents)
+        startTrace();
+
+    nErr = m_iOptronV3.Connect(szPort);
     if(nErr) {
         m_bLinked = false;
     }
@@ -902,17 +852,11 @@ int X2Mount::establishLink(void)
             // set DST on mount
             nErr = m_iOptronV3.setDST(bInDST);
             if (nErr) {
-                #ifdef IOPTRON_X2_DEBUG
-                if (LogFile) {
-                    ltime = time(NULL);
-                    timestamp = asctime(localtime(&ltime));
-                    timestamp[strlen(timestamp) - 1] = 0;
-                    fprintf(LogFile,
-                            "[%s] X2Mount::establishLink Error setting DST on mount. Unlinking mount. Mount boolean sent %u\n",
-                            timestamp, bInDST?1:0);
-                    fflush(LogFile);
+                if (LogFile->enabled(LOG_TRANSPORT, LOG_ERROR)) {
+                    LogFile->log(
+                            "X2Mount::establishLink Error setting DST on mount. Unlinking mount. Mount boolean sent %u\n",
+                            bInDST?1:0);
                 }
-                #endif
             } else {
                 //
                 // next try setting UTC offset
@@ -926,49 +870,31 @@ int X2Mount::establishLink(void)
                 nErr = m_iOptronV3.setUtcOffset(szTmpBuf);
 
                 if (nErr) {
-                    #ifdef IOPTRON_X2_DEBUG
-                    if (LogFile) {
-                        ltime = time(NULL);
-                        timestamp = asctime(localtime(&ltime));
-                        timestamp[strlen(timestamp) - 1] = 0;
-                        fprintf(LogFile,
-                                "[%s] X2Mount::establishLink Error setting UTC offset : %g.  DST was set successfully. Unlinking mount.  UTC offset value sent %s\n",
-                                timestamp, dUTCOffsetInMins, szTmpBuf);
-                        fflush(LogFile);
+                    if (LogFile->enabled(LOG_TRANSPORT, LOG_ERROR)) {
+                        LogFile->log(
+                                "X2Mount::establishLink Error setting UTC offset : %g.  DST was set successfully. Unlinking mount.  UTC offset value sent %s\n",
+                                dUTCOffsetInMins, szTmpBuf);
                     }
-                    #endif
                 } else {
                     //
                     // next, set time/date on mount to TSX's time/date which I assume is NTP time for most people
                     //
                     nErr = m_iOptronV3.setTimeAndDate(m_pTheSkyXForMounts->julianDate());
                     if (nErr) {
-                        #ifdef IOPTRON_X2_DEBUG
-                        if (LogFile) {
-                            ltime = time(NULL);
-                            timestamp = asctime(localtime(&ltime));
-                            timestamp[strlen(timestamp) - 1] = 0;
-                            fprintf(LogFile,
-                                    "[%s] X2Mount::establishLink Error setting date/time on mount : %g.  Both UTC offset and DST were indeed successfully set.\n",
-                                    timestamp, m_pTheSkyXForMounts->julianDate());
-                            fflush(LogFile);
+                        if (LogFile->enabled(LOG_TRANSPORT, LOG_ERROR)) {
+                            LogFile->log(
+                                    "X2Mount::establishLink Error setting date/time on mount : %g.  Both UTC offset and DST were indeed successfully set.\n",
+                                    m_pTheSkyXForMounts->julianDate());
                         }
-                        #endif
                     } else {
                         // TSX longitude is + going west and - going east, so passing the opposite
-                        nErr = m_iOptronV3.setLocation(m_pTheSkyXForMounts->latitude(), - m_pTheSkyXForMounts->longitude());
+                        nErr = m_iOptronV3.setLocation(CCentiArcsec::fromDegrees(m_pTheSkyXForMounts->latitude()), CCentiArcsec::fromDegrees(-m_pTheSkyXForMounts->longitude()));
                         if (nErr) {
-                            #ifdef IOPTRON_X2_DEBUG
-                            if (LogFile) {
-                                ltime = time(NULL);
-                                timestamp = asctime(localtime(&ltime));
-                                timestamp[strlen(timestamp) - 1] = 0;
-                                fprintf(LogFile,
-                                        "[%s] X2Mount::establishLink Error setting lat/long on mount : %g / %g.  UTC offset, DST, and date/time were indeed successfully set.\n",
-                                        timestamp, m_pTheSkyXForMounts->latitude(), -m_pTheSkyXForMounts->longitude());
-                                fflush(LogFile);
+                            if (LogFile->enabled(LOG_TRANSPORT, LOG_ERROR)) {
+                                LogFile->log(
+                                        "X2Mount::establishLink Error setting lat/long on mount : %g / %g.  UTC offset, DST, and date/time were indeed successfully set.\n",
+                                        m_pTheSkyXForMounts->latitude(), -m_pTheSkyXForMounts->longitude());
                             }
-                            #endif
                         }
                     }
                 }
@@ -976,21 +902,20 @@ int X2Mount::establishLink(void)
         }
 
         if (nErr && m_bLinked) {
-            #ifdef IOPTRON_X2_DEBUG
-            if (LogFile) {
-                ltime = time(NULL);
-                timestamp = asctime(localtime(&ltime));
-                timestamp[strlen(timestamp) - 1] = 0;
-                fprintf(LogFile,
-                        "[%s] X2Mount::establishLink Error auto setting time on mount. Unlinking mount. Err was: %i\n",
-                        timestamp, nErr);
-                fflush(LogFile);
+            if (LogFile->enabled(LOG_TRANSPORT, LOG_ERROR)) {
+                LogFile->log(
+                        "X2Mount::establishLink Error auto setting time on mount. Unlinking mount. Err was: %i\n",
+                        nErr);
             }
-            #endif
             m_iOptronV3.Disconnect();
             m_bLinked = false;
         }
 	}
+    if(!m_bLinked) {
+        // terminateLink isn't called for a link that wasn't made
+        m_pSerialCapture->stopCapture();
+        m_pTrace->stop();
+    }
     return nErr;
 }
 
@@ -1008,15 +933,9 @@ int X2Mount::inDaylightTime(bool &bInDST)
         return nErr;
     }
 
-#ifdef IOPTRON_X2_DEBUG
-    if (LogFile) {
-        ltime = time(NULL);
-        timestamp = asctime(localtime(&ltime));
-        timestamp[strlen(timestamp) - 1] = 0;
-        fprintf(LogFile, "[%s] Call to m_pTheSkyXForMounts->localDateTime returned '%i' for DST value. \n", timestamp, iDST);
-        fflush(LogFile);
+    if (LogFile->enabled(LOG_TRANSPORT, LOG_DEBUG)) {
+        LogFile->log("Call to m_pTheSkyXForMounts->localDateTime returned '%i' for DST value. \n", iDST);
     }
-#endif
 
     bInDST = iDST==1?true:false;
     return 0;
@@ -1026,30 +945,29 @@ int X2Mount::terminateLink(void)
 {
     int nErr = SB_OK;
 
-	X2MutexLocker ml(GetMutex());
-
-#ifdef IOPTRON_X2_DEBUG
-    if (LogFile) {
-        ltime = time(NULL);
-        timestamp = asctime(localtime(&ltime));
-        timestamp[strlen(timestamp) - 1] = 0;
-        fprintf(LogFile, "[%s] terminateLink calling Disconnect\n", timestamp);
-        fflush(LogFile);
+	CHostCallProbe probe(m_HostCallStats, m_iOptronV3, X2_CALL_TERMINATE_LINK, GetMutex());
+
+    if (LogFile->enabled(LOG_TRANSPORT, LOG_DEBUG)) {
+        LogFile->log("terminateLink calling Disconnect\n");
+        LogFile->log("serial traffic per host call for this session:\n");
+        LogFile->flush();
+        m_HostCallStats.dump(LogFile->file());
+        dumpLinkTables(LogFile->file());
+        LogFile->log("host calls by total time for this session:\n");
+        LogFile->flush();
+        m_HostCallStats.report(LogFile->file());
     }
-#endif
+    if (m_bDumpLinkStats)
+        dumpLinkStats();
     nErr = m_iOptronV3.Disconnect();
     m_bLinked = false;
     m_bHasDoneZeroPosition = false;
+    m_pSerialCapture->stopCapture();
+    m_pTrace->stop();   // the terminateLink span itself isn't in the trace
 
-#ifdef IOPTRON_X2_DEBUG
-    if (LogFile) {
-        ltime = time(NULL);
-        timestamp = asctime(localtime(&ltime));
-        timestamp[strlen(timestamp) - 1] = 0;
-        fprintf(LogFile, "[%s] Disconnected\n", timestamp);
-        fflush(LogFile);
+    if (LogFile->enabled(LOG_TRANSPORT, LOG_DEBUG)) {
+        LogFile->log("Disconnected\n");
     }
-#endif
     return nErr;
 }
 
@@ -1080,10 +998,8 @@ void X2Mount::deviceInfoNameShort(BasicStringInterface& str) const
 {
     if(m_bLinked) {
         X2Mount* pMe = (X2Mount*)this;
-        X2MutexLocker ml(pMe->GetMutex());
-        char cModel[SERIAL_BUFFER_SIZE];
-        pMe->m_iOptronV3.getMountInfo(cModel, SERIAL_BUFFER_SIZE);
-        str = cModel;
+        CHostCallProbe probe(pMe->m_HostCallStats, pMe->m_iOptronV3, X2_CALL_DEVICE_INFO, pMe->GetMutex());
+        str = pMe->m_iOptronV3.getModel().pszName;
     }
     else
         str = "Not connected1";
@@ -1102,7 +1018,7 @@ void X2Mount::deviceInfoFirmwareVersion(BasicStringInterface& str)
 {
     if(m_bLinked) {
         char cFirmware[SERIAL_BUFFER_SIZE];
-        X2MutexLocker ml(GetMutex());
+        CHostCallProbe probe(m_HostCallStats, m_iOptronV3, X2_CALL_DEVICE_INFO, GetMutex());
         m_iOptronV3.getFirmwareVersion(cFirmware, SERIAL_BUFFER_SIZE);
         str = cFirmware;
     }
@@ -1112,10 +1028,8 @@ void X2Mount::deviceInfoFirmwareVersion(BasicStringInterface& str)
 void X2Mount::deviceInfoModel(BasicStringInterface& str)
 {
     if(m_bLinked) {
-        char cModel[SERIAL_BUFFER_SIZE];
-        X2MutexLocker ml(GetMutex());
-        m_iOptronV3.getMountInfo(cModel, SERIAL_BUFFER_SIZE);
-        str = cModel;
+        CHostCallProbe probe(m_HostCallStats, m_iOptronV3, X2_CALL_DEVICE_INFO, GetMutex());
+        str = m_iOptronV3.getModel().pszName;
     }
     else
         str = "Not connected";
@@ -1129,22 +1043,16 @@ int X2Mount::raDec(double& ra, double& dec, const bool& bCached)
     if(!m_bLinked)
         return ERR_NOLINK;
 
-    X2MutexLocker ml(GetMutex());
+    CHostCallProbe probe(m_HostCallStats, m_iOptronV3, X2_CALL_RADEC, GetMutex());
 
 	// Get the RA and DEC from the mount
 	nErr = m_iOptronV3.getRaAndDec(ra, dec, false);
     if(nErr) {
         nErr = ERR_CMDFAILED;
 
-#ifdef IOPTRON_X2_DEBUG
-        if (LogFile) {
-            ltime = time(NULL);
-            timestamp = asctime(localtime(&ltime));
-            timestamp[strlen(timestamp) - 1] = 0;
-            fprintf(LogFile, "[%s] X2Mount::raDec ERROR nErr = %d \n", timestamp, nErr);
-            fflush(LogFile);
+        if (LogFile->enabled(LOG_CACHE, LOG_ERROR)) {
+            LogFile->log("X2Mount::raDec ERROR nErr = %d \n", nErr);
         }
-#endif
     }
 	return nErr;
 }
@@ -1156,31 +1064,19 @@ int X2Mount::abort()
     if(!m_bLinked)
         return ERR_NOLINK;
 
-    X2MutexLocker ml(GetMutex());
+    CHostCallProbe probe(m_HostCallStats, m_iOptronV3, X2_CALL_ABORT, GetMutex());
 
-#ifdef IOPTRON_X2_DEBUG
-	if (LogFile) {
-		ltime = time(NULL);
-		timestamp = asctime(localtime(&ltime));
-		timestamp[strlen(timestamp) - 1] = 0;
-		fprintf(LogFile, "[%s] abort Called\n", timestamp);
-        fflush(LogFile);
+	if (LogFile->enabled(LOG_SLEW, LOG_DEBUG)) {
+		LogFile->log("abort Called\n");
 	}
-#endif
 
     nErr = m_iOptronV3.Abort();
     if(nErr) {
         nErr = ERR_CMDFAILED;
 
-#ifdef IOPTRON_X2_DEBUG
-        if (LogFile) {
-            ltime = time(NULL);
-            timestamp = asctime(localtime(&ltime));
-            timestamp[strlen(timestamp) - 1] = 0;
-            fprintf(LogFile, "[%s] Abort ERROR nErr = %d \n", timestamp, nErr);
-            fflush(LogFile);
+        if (LogFile->enabled(LOG_SLEW, LOG_ERROR)) {
+            LogFile->log("Abort ERROR nErr = %d \n", nErr);
         }
-#endif
     }
 
     return nErr;
@@ -1193,28 +1089,16 @@ int X2Mount::startSlewTo(const double& dRa, const double& dDec)
     if(!m_bLinked)
         return ERR_NOLINK;
 
-    X2MutexLocker ml(GetMutex());
+    CHostCallProbe probe(m_HostCallStats, m_iOptronV3, X2_CALL_START_SLEW_TO, GetMutex());
 
-#ifdef IOPTRON_X2_DEBUG
-	if (LogFile) {
-		ltime = time(NULL);
-		timestamp = asctime(localtime(&ltime));
-		timestamp[strlen(timestamp) - 1] = 0;
-		fprintf(LogFile, "[%s] startSlewTo Called %f %f\n", timestamp, dRa, dDec);
-        fflush(LogFile);
+	if (LogFile->enabled(LOG_SLEW, LOG_DEBUG)) {
+		LogFile->log("startSlewTo Called %f %f\n", dRa, dDec);
 	}
-#endif
     nErr = m_iOptronV3.startSlewTo(dRa, dDec);
     if(nErr) {
-#ifdef IOPTRON_X2_DEBUG
-        if (LogFile) {
-            ltime = time(NULL);
-            timestamp = asctime(localtime(&ltime));
-            timestamp[strlen(timestamp) - 1] = 0;
-            fprintf(LogFile, "[%s] startSlewTo ERROR nErr = %d \n", timestamp, nErr);
-            fflush(LogFile);
+        if (LogFile->enabled(LOG_SLEW, LOG_ERROR)) {
+            LogFile->log("startSlewTo ERROR nErr = %d \n", nErr);
         }
-#endif
         m_pLogger->out("startSlewTo ERROR");
         return ERR_CMDFAILED;
     }
@@ -1229,20 +1113,14 @@ int X2Mount::isCompleteSlewTo(bool& bComplete) const
         return ERR_NOLINK;
 
     X2Mount* pMe = (X2Mount*)this;
-    X2MutexLocker ml(pMe->GetMutex());
+    CHostCallProbe probe(pMe->m_HostCallStats, pMe->m_iOptronV3, X2_CALL_IS_COMPLETE_SLEW_TO, pMe->GetMutex());
 
     nErr = pMe->m_iOptronV3.isSlewToComplete(bComplete);
     if(nErr) {
         nErr = ERR_CMDFAILED;
-#ifdef IOPTRON_X2_DEBUG
-        if (LogFile) {
-            pMe->ltime = time(NULL);
-            pMe->timestamp = asctime(localtime(&(pMe->ltime)));
-            timestamp[strlen(timestamp) - 1] = 0;
-            fprintf(LogFile, "[%s] isCompleteSlewTo ERROR nErr = %d \n", timestamp, nErr);
-            fflush(LogFile);
+        if (LogFile->enabled(LOG_SLEW, LOG_ERROR)) {
+            LogFile->log("isCompleteSlewTo ERROR nErr = %d \n", nErr);
         }
-#endif
     }
 
 	return nErr;
@@ -1250,19 +1128,13 @@ int X2Mount::isCompleteSlewTo(bool& bComplete) const
 
 int X2Mount::endSlewTo(void)
 {
-#ifdef IOPTRON_X2_DEBUG
-    if (LogFile) {
-        ltime = time(NULL);
-        timestamp = asctime(localtime(&ltime));
-        timestamp[strlen(timestamp) - 1] = 0;
-        fprintf(LogFile, "[%s] endSlewTo Called\n", timestamp);
-        fflush(LogFile);
+    if (LogFile->enabled(LOG_SLEW, LOG_DEBUG)) {
+        LogFile->log("endSlewTo Called\n");
     }
-#endif
     if(!m_bLinked)
         return ERR_NOLINK;
 
-    X2MutexLocker ml(GetMutex());
+    CHostCallProbe probe(m_HostCallStats, m_iOptronV3, X2_CALL_END_SLEW_TO, GetMutex());
 
     return m_iOptronV3.endSlewTo();
 
@@ -1276,31 +1148,19 @@ int X2Mount::syncMount(const double& ra, const double& dec)
     if(!m_bLinked)
         return ERR_NOLINK;
 
-    X2MutexLocker ml(GetMutex());
+    CHostCallProbe probe(m_HostCallStats, m_iOptronV3, X2_CALL_SYNC_MOUNT, GetMutex());
 
-#ifdef IOPTRON_X2_DEBUG
-    if (LogFile) {
-        ltime = time(NULL);
-        timestamp = asctime(localtime(&ltime));
-        timestamp[strlen(timestamp) - 1] = 0;
-        fprintf(LogFile, "[%s] syncMount Called : %f\t%f\n", timestamp, ra, dec);
-        fflush(LogFile);
+    if (LogFile->enabled(LOG_SLEW, LOG_DEBUG)) {
+        LogFile->log("syncMount Called : %f\t%f\n", ra, dec);
     }
-#endif
 
     nErr = m_iOptronV3.syncTo(ra, dec);
     if(nErr) {
         nErr = ERR_CMDFAILED;
 
-#ifdef IOPTRON_X2_DEBUG
-        if (LogFile) {
-            ltime = time(NULL);
-            timestamp = asctime(localtime(&ltime));
-            timestamp[strlen(timestamp) - 1] = 0;
-            fprintf(LogFile, "[%s] syncMount ERROR nErr = %d \n", timestamp, nErr);
-            fflush(LogFile);
+        if (LogFile->enabled(LOG_SLEW, LOG_ERROR)) {
+            LogFile->log("syncMount ERROR nErr = %d \n", nErr);
         }
-#endif
     }
     return nErr;
 }
@@ -1312,21 +1172,16 @@ bool X2Mount::isSynced(void)
     if(!m_bLinked)
         return false;
 
-    X2MutexLocker ml(GetMutex());
+    CHostCallProbe probe(m_HostCallStats, m_iOptronV3, X2_CALL_IS_SYNCED, GetMutex());
 
    nErr = m_iOptronV3.isGPSOrLatLongGood(m_bSynced);
 
-#ifdef IOPTRON_X2_DEBUG
-    if (LogFile) {
-        ltime = time(NULL);
-        timestamp = asctime(localtime(&ltime));
-        timestamp[strlen(timestamp) - 1] = 0;
-        fprintf(LogFile, "[%s] isSynced Called : m_bSynced = %s\n", timestamp, m_bSynced?"true":"false");
-        if (nErr)
-            fprintf(LogFile, "[%s] isSynced ERROR calling isGPSOrLatLongGood nErr = %d \n", timestamp, nErr);
-        fflush(LogFile);
+    if (LogFile->enabled(LOG_SLEW, LOG_DEBUG)) {
+        LogFile->log("isSynced Called : m_bSynced = %s\n", m_bSynced?"true":"false");
+    }
+    if (nErr && LogFile->enabled(LOG_SLEW, LOG_ERROR)) {
+        LogFile->log("isSynced ERROR calling isGPSOrLatLongGood nErr = %d \n", nErr);
     }
-#endif
 
     return m_bSynced;
 }
@@ -1338,21 +1193,15 @@ int X2Mount::setTrackingRates(const bool& bTrackingOn, const bool& bIgnoreRates,
     if(!m_bLinked)
         return ERR_NOLINK;
 
-    X2MutexLocker ml(GetMutex());
+    CHostCallProbe probe(m_HostCallStats, m_iOptronV3, X2_CALL_SET_TRACKING_RATES, GetMutex());
 
 
     nErr = m_iOptronV3.setTrackingRates(bTrackingOn, bIgnoreRates, dRaRateArcSecPerSec, dDecRateArcSecPerSec);
 
     if(nErr) {
-#ifdef IOPTRON_X2_DEBUG
-        if (LogFile) {
-            ltime = time(NULL);
-            timestamp = asctime(localtime(&ltime));
-            timestamp[strlen(timestamp) - 1] = 0;
-            fprintf(LogFile, "[%s] setTrackingRates ERROR nErr = %d \n", timestamp, nErr);
-            fflush(LogFile);
+        if (LogFile->enabled(LOG_TRACKING, LOG_ERROR)) {
+            LogFile->log("setTrackingRates ERROR nErr = %d \n", nErr);
         }
-#endif
         return ERR_CMDFAILED;
     }
 
@@ -1367,31 +1216,19 @@ int X2Mount::trackingRates(bool& bTrackingOn, double& dRaRateArcSecPerSec, doubl
     if(!m_bLinked)
         return ERR_NOLINK;
 
-    X2MutexLocker ml(GetMutex());
+    CHostCallProbe probe(m_HostCallStats, m_iOptronV3, X2_CALL_TRACKING_RATES, GetMutex());
 
     nErr = m_iOptronV3.getTrackRates(bTrackingOn, dRaRateArcSecPerSec, dDecRateArcSecPerSec);
     if(nErr) {
-#ifdef IOPTRON_X2_DEBUG
-        if (LogFile) {
-            ltime = time(NULL);
-            timestamp = asctime(localtime(&ltime));
-            timestamp[strlen(timestamp) - 1] = 0;
-            fprintf(LogFile, "[%s] trackingRates  m_iOptronV3.getTrackRates ERROR nErr = %d \n", timestamp, nErr);
-            fflush(LogFile);
+        if (LogFile->enabled(LOG_TRACKING, LOG_ERROR)) {
+            LogFile->log("trackingRates  m_iOptronV3.getTrackRates ERROR nErr = %d \n", nErr);
         }
-#endif
         return ERR_CMDFAILED;
     }
 
-#ifdef IOPTRON_X2_DEBUG
-    if (LogFile) {
-        ltime = time(NULL);
-        timestamp = asctime(localtime(&ltime));
-        timestamp[strlen(timestamp) - 1] = 0;
-        fprintf(LogFile, "[%s] trackingRates Called. Tracking On: %d , Ra rate : %f , Dec rate: %f\n", timestamp, bTrackingOn, dRaRateArcSecPerSec, dDecRateArcSecPerSec);
-        fflush(LogFile);
+    if (LogFile->enabled(LOG_TRACKING, LOG_DEBUG)) {
+        LogFile->log("trackingRates Called. Tracking On: %d , Ra rate : %f , Dec rate: %f\n", bTrackingOn, dRaRateArcSecPerSec, dDecRateArcSecPerSec);
     }
-#endif
 
 	return nErr;
 }
@@ -1402,42 +1239,24 @@ int X2Mount::siderealTrackingOn()
     if(!m_bLinked)
         return ERR_NOLINK;
 
-    X2MutexLocker ml(GetMutex());
+    CHostCallProbe probe(m_HostCallStats, m_iOptronV3, X2_CALL_SIDEREAL_TRACKING_ON, GetMutex());
 
-#ifdef IOPTRON_X2_DEBUG
-    if (LogFile) {
-        ltime = time(NULL);
-        timestamp = asctime(localtime(&ltime));
-        timestamp[strlen(timestamp) - 1] = 0;
-        fprintf(LogFile, "[%s] siderealTrackingOn Called \n", timestamp);
-        fflush(LogFile);
+    if (LogFile->enabled(LOG_TRACKING, LOG_DEBUG)) {
+        LogFile->log("siderealTrackingOn Called \n");
     }
-#endif
 
     nErr = m_iOptronV3.setSiderealTrackingOn();
 
     if(nErr) {
-#ifdef IOPTRON_X2_DEBUG
-        if (LogFile) {
-            ltime = time(NULL);
-            timestamp = asctime(localtime(&ltime));
-            timestamp[strlen(timestamp) - 1] = 0;
-            fprintf(LogFile, "[%s] siderealTrackingOn ERROR nErr = %d \n", timestamp, nErr);
-            fflush(LogFile);
+        if (LogFile->enabled(LOG_TRACKING, LOG_ERROR)) {
+            LogFile->log("siderealTrackingOn ERROR nErr = %d \n", nErr);
         }
-#endif
         return ERR_CMDFAILED;
     }
 
-#ifdef IOPTRON_X2_DEBUG
-    if (LogFile) {
-        ltime = time(NULL);
-        timestamp = asctime(localtime(&ltime));
-        timestamp[strlen(timestamp) - 1] = 0;
-        fprintf(LogFile, "[%s] siderealTrackingOn complete \n", timestamp);
-        fflush(LogFile);
+    if (LogFile->enabled(LOG_TRACKING, LOG_DEBUG)) {
+        LogFile->log("siderealTrackingOn complete \n");
     }
-#endif
 
     return nErr;
 }
@@ -1448,42 +1267,24 @@ int X2Mount::trackingOff()
     if(!m_bLinked)
         return ERR_NOLINK;
 
-    X2MutexLocker ml(GetMutex());
+    CHostCallProbe probe(m_HostCallStats, m_iOptronV3, X2_CALL_TRACKING_OFF, GetMutex());
 
-#ifdef IOPTRON_X2_DEBUG
-    if (LogFile) {
-        ltime = time(NULL);
-        timestamp = asctime(localtime(&ltime));
-        timestamp[strlen(timestamp) - 1] = 0;
-        fprintf(LogFile, "[%s] trackingOff Called \n", timestamp);
-        fflush(LogFile);
+    if (LogFile->enabled(LOG_TRACKING, LOG_DEBUG)) {
+        LogFile->log("trackingOff Called \n");
     }
-#endif
     nErr = m_iOptronV3.setTrackingOff();
     if(nErr) {
         nErr = ERR_CMDFAILED;
-#ifdef IOPTRON_X2_DEBUG
-        if (LogFile) {
-            ltime = time(NULL);
-            timestamp = asctime(localtime(&ltime));
-            timestamp[strlen(timestamp) - 1] = 0;
-            fprintf(LogFile, "[%s] trackingOff ERROR nErr = %d \n", timestamp, nErr);
-            fflush(LogFile);
+        if (LogFile->enabled(LOG_TRACKING, LOG_ERROR)) {
+            LogFile->log("trackingOff ERROR nErr = %d \n", nErr);
         }
-#endif
         return nErr;
     }
 
 
-#ifdef IOPTRON_X2_DEBUG
-    if (LogFile) {
-        ltime = time(NULL);
-        timestamp = asctime(localtime(&ltime));
-        timestamp[strlen(timestamp) - 1] = 0;
-        fprintf(LogFile, "[%s] trackingOff complete nErr = %d \n", timestamp, nErr);
-        fflush(LogFile);
+    if (LogFile->enabled(LOG_TRACKING, LOG_DEBUG)) {
+        LogFile->log("trackingOff complete nErr = %d \n", nErr);
     }
-#endif
 
     return nErr;
 }
@@ -1497,7 +1298,7 @@ bool X2Mount::needsRefactionAdjustments(void)
     if(!m_bLinked)
         return false;
 
-    X2MutexLocker ml(GetMutex());
+    CHostCallProbe probe(m_HostCallStats, m_iOptronV3, X2_CALL_NEEDS_REFRACTION, GetMutex());
 
     // check if iOptron V3 refraction adjustment is on.
     nErr = m_iOptronV3.getRefractionCorrEnabled(bEnabled);
@@ -1516,19 +1317,13 @@ bool X2Mount::isParked(void)
     if(!m_bLinked)
         return false;
 
-    X2MutexLocker ml(GetMutex());
+    CHostCallProbe probe(m_HostCallStats, m_iOptronV3, X2_CALL_IS_PARKED, GetMutex());
 
     nErr = m_iOptronV3.getAtPark(bIsPArked);
     if(nErr) {
-#ifdef IOPTRON_X2_DEBUG
-        if (LogFile) {
-            ltime = time(NULL);
-            timestamp = asctime(localtime(&ltime));
-            timestamp[strlen(timestamp) - 1] = 0;
-            fprintf(LogFile, "[%s] isParked m_iOptronV3.getAtPark ERROR nErr = %d \n", timestamp, nErr);
-            fflush(LogFile);
+        if (LogFile->enabled(LOG_SLEW, LOG_ERROR)) {
+            LogFile->log("isParked m_iOptronV3.getAtPark ERROR nErr = %d \n", nErr);
         }
-#endif
         return false;
     }
     if(!bIsPArked) // not parked
@@ -1537,15 +1332,9 @@ bool X2Mount::isParked(void)
     // get tracking state.
     nErr = m_iOptronV3.getTrackRates(bTrackingOn, dTrackRaArcSecPerHr, dTrackDecArcSecPerHr);
     if(nErr) {
-#ifdef IOPTRON_X2_DEBUG
-        if (LogFile) {
-            ltime = time(NULL);
-            timestamp = asctime(localtime(&ltime));
-            timestamp[strlen(timestamp) - 1] = 0;
-            fprintf(LogFile, "[%s] isParked m_iOptronV3.getTrackRates ERROR nErr = %d \n", timestamp, nErr);
-            fflush(LogFile);
+        if (LogFile->enabled(LOG_SLEW, LOG_ERROR)) {
+            LogFile->log("isParked m_iOptronV3.getTrackRates ERROR nErr = %d \n", nErr);
         }
-#endif
         return false;
     }
     // if AtPark and tracking is off, then we're parked, if not then we're unparked.
@@ -1563,29 +1352,17 @@ int X2Mount::startPark(const double& dAz, const double& dAlt)
     if(!m_bLinked)
         return ERR_NOLINK;
 	
-	X2MutexLocker ml(GetMutex());
-#ifdef IOPTRON_X2_DEBUG
-	if (LogFile) {
-		ltime = time(NULL);
-		timestamp = asctime(localtime(&ltime));
-		timestamp[strlen(timestamp) - 1] = 0;
-        fprintf(LogFile, "[%s] startPark Called.\n", timestamp);
-        fflush(LogFile);
+	CHostCallProbe probe(m_HostCallStats, m_iOptronV3, X2_CALL_START_PARK, GetMutex());
+	if (LogFile->enabled(LOG_SLEW, LOG_DEBUG)) {
+        LogFile->log("startPark Called.\n");
 	}
-#endif
     // Park mount to pre-define park position (in the mount).
     nErr = m_iOptronV3.parkMount();
     if(nErr) {
         nErr = ERR_CMDFAILED;
-#ifdef IOPTRON_X2_DEBUG
-        if (LogFile) {
-            ltime = time(NULL);
-            timestamp = asctime(localtime(&ltime));
-            timestamp[strlen(timestamp) - 1] = 0;
-            fprintf(LogFile, "[%s] startPark  m_iOptronV3.parkMount ERROR nErr = %d \n", timestamp, nErr);
-            fflush(LogFile);
+        if (LogFile->enabled(LOG_SLEW, LOG_ERROR)) {
+            LogFile->log("startPark  m_iOptronV3.parkMount ERROR nErr = %d \n", nErr);
         }
-#endif
     }
 	return nErr;
 }
@@ -1600,20 +1377,14 @@ int X2Mount::isCompletePark(bool& bComplete) const
 
     X2Mount* pMe = (X2Mount*)this;
 
-    X2MutexLocker ml(pMe->GetMutex());
+    CHostCallProbe probe(pMe->m_HostCallStats, pMe->m_iOptronV3, X2_CALL_IS_COMPLETE_PARK, pMe->GetMutex());
 
     nErr = pMe->m_iOptronV3.getAtPark(bComplete);
     if(nErr) {
         nErr = ERR_CMDFAILED;
-#ifdef IOPTRON_X2_DEBUG
-        if (LogFile) {
-            pMe->ltime = time(NULL);
-            pMe->timestamp = asctime(localtime(&(pMe->ltime)));
-            timestamp[strlen(timestamp) - 1] = 0;
-            fprintf(LogFile, "[%s] isCompletePark  m_iOptronV3.getAtPark ERROR nErr = %d \n", timestamp, nErr);
-            fflush(LogFile);
+        if (LogFile->enabled(LOG_SLEW, LOG_ERROR)) {
+            LogFile->log("isCompletePark  m_iOptronV3.getAtPark ERROR nErr = %d \n", nErr);
         }
-#endif
     }
 	return nErr;
 }
@@ -1630,19 +1401,13 @@ int X2Mount::startUnpark(void)
     if(!m_bLinked)
         return ERR_NOLINK;
 
-    X2MutexLocker ml(GetMutex());
+    CHostCallProbe probe(m_HostCallStats, m_iOptronV3, X2_CALL_START_UNPARK, GetMutex());
 
     nErr = m_iOptronV3.unPark();
     if(nErr) {
-#ifdef IOPTRON_X2_DEBUG
-        if (LogFile) {
-            ltime = time(NULL);
-            timestamp = asctime(localtime(&ltime));
-            timestamp[strlen(timestamp) - 1] = 0;
-            fprintf(LogFile, "[%s] startUnpark : m_iOptronV3.unPark() ERROR nErr= %i !\n", timestamp, nErr);
-            fflush(LogFile);
+        if (LogFile->enabled(LOG_SLEW, LOG_ERROR)) {
+            LogFile->log("startUnpark : m_iOptronV3.unPark() ERROR nErr= %i !\n", nErr);
         }
-#endif
         nErr = ERR_CMDFAILED;
     }
     m_bParked = false;
@@ -1664,21 +1429,15 @@ int X2Mount::isCompleteUnpark(bool& bComplete) const
 
     X2Mount* pMe = (X2Mount*)this;
 
-    X2MutexLocker ml(pMe->GetMutex());
+    CHostCallProbe probe(pMe->m_HostCallStats, pMe->m_iOptronV3, X2_CALL_IS_COMPLETE_UNPARK, pMe->GetMutex());
 
     bComplete = false;
 
     nErr = pMe->m_iOptronV3.getAtPark(bIsParked);
     if(nErr) {
-#ifdef IOPTRON_X2_DEBUG
-        if (LogFile) {
-            pMe->ltime = time(NULL);
-            pMe->timestamp = asctime(localtime(&(pMe->ltime)));
-            pMe->timestamp[strlen(pMe->timestamp) - 1] = 0;
-            fprintf(LogFile, "[%s] isCompleteUnpark  m_iOptronV3.getAtPark ERROR nErr = %d \n", pMe->timestamp, nErr);
-            fflush(LogFile);
+        if (LogFile->enabled(LOG_SLEW, LOG_ERROR)) {
+            LogFile->log("isCompleteUnpark  m_iOptronV3.getAtPark ERROR nErr = %d \n", nErr);
         }
-#endif
         nErr = ERR_CMDFAILED;
     }
     if(!bIsParked) { // no longer parked.
@@ -1692,15 +1451,9 @@ int X2Mount::isCompleteUnpark(bool& bComplete) const
     nErr = pMe->m_iOptronV3.getTrackRates(bTrackingOn, dTrackRaArcSecPerHr, dTrackDecArcSecPerHr);
     if(nErr) {
         nErr = ERR_CMDFAILED;
-#ifdef IOPTRON_X2_DEBUG
-        if (LogFile) {
-            pMe->ltime = time(NULL);
-            pMe->timestamp = asctime(localtime(&(pMe->ltime)));
-            pMe->timestamp[strlen(pMe->timestamp) - 1] = 0;
-            fprintf(LogFile, "[%s] isCompleteUnpark  m_iOptronV3.getTrackRates ERROR nErr = %d \n", pMe->timestamp, nErr);
-            fflush(LogFile);
+        if (LogFile->enabled(LOG_SLEW, LOG_ERROR)) {
+            LogFile->log("isCompleteUnpark  m_iOptronV3.getTrackRates ERROR nErr = %d \n", nErr);
         }
-#endif
     }
 
     if(bTrackingOn) {
@@ -1740,15 +1493,9 @@ double X2Mount::flipHourAngle() {
     double dFlipHourToRet;
 
     dFlipHourToRet = m_iOptronV3.flipHourAngle();
-#ifdef IOPTRON_X2_DEBUG
-	if (LogFile) {
-		ltime = time(NULL);
-		timestamp = asctime(localtime(&ltime));
-		timestamp[strlen(timestamp) - 1] = 0;
-		fprintf(LogFile, "[%s] flipHourAngle called and returning %f\n", timestamp, dFlipHourToRet);
-        fflush(LogFile);
+	if (LogFile->enabled(LOG_SLEW, LOG_DEBUG)) {
+		LogFile->log("flipHourAngle called and returning %f\n", dFlipHourToRet);
 	}
-#endif
 
     return dFlipHourToRet;
 }
@@ -1757,34 +1504,23 @@ double X2Mount::flipHourAngle() {
 int X2Mount::gemLimits(double& dHoursEast, double& dHoursWest)
 {
     int nErr = SB_OK;
-#ifdef IOPTRON_X2_DEBUG
-    if (LogFile) {
-        ltime = time(NULL);
-        timestamp = asctime(localtime(&ltime));
-        timestamp[strlen(timestamp) - 1] = 0;
-        fprintf(LogFile, "[%s] gemLimits called.\n", timestamp);
-        fflush(LogFile);
+    if (LogFile->enabled(LOG_SLEW, LOG_DEBUG)) {
+        LogFile->log("gemLimits called.\n");
     }
-#endif
     if(!m_bLinked)
         return ERR_NOLINK;
 
-    X2MutexLocker ml(GetMutex());
+    CHostCallProbe probe(m_HostCallStats, m_iOptronV3, X2_CALL_GEM_LIMITS, GetMutex());
 
     nErr = m_iOptronV3.getLimits(dHoursEast, dHoursWest);
 
-#ifdef IOPTRON_X2_DEBUG
-    if (LogFile) {
-        ltime = time(NULL);
-        timestamp = asctime(localtime(&ltime));
-        timestamp[strlen(timestamp) - 1] = 0;
-        if (nErr)
-            fprintf(LogFile, "[%s] gemLimits m_iOptronV3.getLimits ERROR nErr = %d\n", timestamp, nErr);
-        fprintf(LogFile, "[%s] gemLimits dHoursEast = %f\n", timestamp, dHoursEast);
-        fprintf(LogFile, "[%s] gemLimits dHoursWest = %f\n", timestamp, dHoursWest);
-        fflush(LogFile);
+    if (nErr && LogFile->enabled(LOG_SLEW, LOG_ERROR)) {
+        LogFile->log("gemLimits m_iOptronV3.getLimits ERROR nErr = %d\n", nErr);
+    }
+    if (LogFile->enabled(LOG_SLEW, LOG_DEBUG)) {
+        LogFile->log("gemLimits dHoursEast = %f\n", dHoursEast);
+        LogFile->log("gemLimits dHoursWest = %f\n", dHoursWest);
     }
-#endif
     // temp debugging.
 	dHoursEast = 0.0;
 	dHoursWest = 0.0;
@@ -1827,3 +1563,212 @@ void X2Mount::portNameOnToCharPtr(char* pszPort, const unsigned int& nMaxSize) c
 
 
 
+void X2Mount::startTranscriptCapture()
+{
+    std::string sCapturePath;
+    char szFileName[SERIAL_BUFFER_SIZE];
+    time_t tNow;
+    int nErr;
+
+    tNow = time(NULL);
+    strftime(szFileName, SERIAL_BUFFER_SIZE, "iOptronV3_capture_%Y%m%d_%H%M%S.bin", localtime(&tNow));
+    sCapturePath = homeFilePath(szFileName);
+
+    nErr = m_pSerialCapture->startCapture(sCapturePath.c_str());
+    if (LogFile->enabled(LOG_TRANSPORT, LOG_DEBUG)) {
+        LogFile->log("startTranscriptCapture capturing serial transcript to %s, nErr = %d\n", sCapturePath.c_str(), nErr);
+    }
+}
+
+void X2Mount::startTrace()
+{
+    std::string sTracePath;
+    char szFileName[SERIAL_BUFFER_SIZE];
+    time_t tNow;
+    int nErr;
+
+    tNow = time(NULL);
+    strftime(szFileName, SERIAL_BUFFER_SIZE, "iOptronV3_trace_%Y%m%d_%H%M%S.json", localtime(&tNow));
+    sTracePath = homeFilePath(szFileName);
+
+    nErr = m_pTrace->start(sTracePath, m_iOptronV3.clock());
+    if (LogFile->enabled(LOG_TRANSPORT, LOG_DEBUG)) {
+        LogFile->log("startTrace tracing to %s, nErr = %d\n", sTracePath.c_str(), nErr);
+    }
+}
+
+void X2Mount::dumpLinkStats()
+{
+    std::string sStatsPath;
+    char szFileName[SERIAL_BUFFER_SIZE];
+    time_t tNow;
+    FILE *pFile;
+
+    tNow = time(NULL);
+    strftime(szFileName, SERIAL_BUFFER_SIZE, "iOptronV3_linkstats_%Y%m%d_%H%M%S.txt", localtime(&tNow));
+    sStatsPath = homeFilePath(szFileName);
+    pFile = fopen(sStatsPath.c_str(), "w");
+    if (!pFile) {
+        if (LogFile->enabled(LOG_TRANSPORT, LOG_ERROR)) {
+            LogFile->log("dumpLinkStats can't create %s\n", sStatsPath.c_str());
+        }
+        return;
+    }
+    fprintf(pFile, "iOptronV3 X2 plugin version %3.3f, mount %s\n\n", DRIVER_VERSION, m_iOptronV3.getModel().pszName);
+    dumpLinkTables(pFile);
+    dumpGuideStats(pFile);
+    dumpRateStream(pFile);
+    m_HostCallStats.dump(pFile);
+    fprintf(pFile, "\n");
+    m_HostCallStats.report(pFile);
+    fclose(pFile);
+}
+
+// On demand from the settings dialog, host calls ranked by time spent in them and where that time went
+int X2Mount::writeLatencyReport(std::string &sReportPath)
+{
+    char szFileName[SERIAL_BUFFER_SIZE];
+    time_t tNow;
+    FILE *pFile;
+
+    tNow = time(NULL);
+    strftime(szFileName, SERIAL_BUFFER_SIZE, "iOptronV3_latency_%Y%m%d_%H%M%S.txt", localtime(&tNow));
+    sReportPath = homeFilePath(szFileName);
+    pFile = fopen(sReportPath.c_str(), "w");
+    if (!pFile) {
+        if (LogFile->enabled(LOG_UI, LOG_ERROR)) {
+            LogFile->log("writeLatencyReport can't create %s\n", sReportPath.c_str());
+        }
+        return ERR_CMDFAILED;
+    }
+    fprintf(pFile, "iOptronV3 X2 plugin version %3.3f, mount %s\n\n", DRIVER_VERSION, m_iOptronV3.getModel().pszName);
+    m_HostCallStats.report(pFile);
+    fprintf(pFile, "\n");
+    dumpLinkTables(pFile);
+    dumpGuideStats(pFile);
+    dumpRateStream(pFile);
+    fclose(pFile);
+    return SB_OK;
+}
+
+void X2Mount::updateLinkStats(X2GUIExchangeInterface* uiex)
+{
+    char szTable[IOPTRON_LINK_STATS_TABLE_SIZE];
+    int nLen;
+    CGuideStats guideStats;
+
+    // health summary first, it's what tells a bad cable apart
+    m_iOptronV3.getLinkHealth(m_LinkHealthCopy);
+    m_iOptronV3.getCommandStats(m_CommandStatsCopy);
+    nLen = m_LinkHealthCopy.format(szTable, IOPTRON_LINK_STATS_TABLE_SIZE);
+    m_iOptronV3.getGuideStats(guideStats);
+    nLen += guideStats.format(szTable + nLen, IOPTRON_LINK_STATS_TABLE_SIZE - nLen);
+    m_CommandStatsCopy.formatTable(szTable + nLen, IOPTRON_LINK_STATS_TABLE_SIZE - nLen);
+    uiex->setPropertyString("linkStats", "plainText", szTable);
+}
+
+// copies taken under the link lock, guide pulses and the rate stream update them from other threads
+void X2Mount::dumpLinkTables(FILE *pFile)
+{
+    m_iOptronV3.getLinkHealth(m_LinkHealthCopy);
+    m_iOptronV3.getCommandStats(m_CommandStatsCopy);
+    m_LinkHealthCopy.dump(pFile);
+    fprintf(pFile, "\n");
+    m_CommandStatsCopy.dump(pFile);
+    fprintf(pFile, "\n");
+}
+
+// only when guide pulses were sent, most sessions don't guide through the mount
+void X2Mount::dumpGuideStats(FILE *pFile)
+{
+    CGuideStats guideStats;
+
+    m_iOptronV3.getGuideStats(guideStats);
+    if(!guideStats.pulses())
+        return;
+    guideStats.dump(pFile);
+    fprintf(pFile, "\n");
+}
+
+// only when a rate stream was started, most sessions track at the host rates
+void X2Mount::dumpRateStream(FILE *pFile)
+{
+    iOptronRateStreamCounters counters;
+
+    m_iOptronV3.rateStream().getCounters(counters);
+    if(!counters.nTicks)
+        return;
+    m_iOptronV3.rateStream().dump(pFile);
+    fprintf(pFile, "\n");
+}
+
+std::string X2Mount::homeFilePath(const char *pszFileName) const
+{
+    std::string sPath;
+
+#if defined(SB_WIN_BUILD)
+    sPath = getenv("HOMEDRIVE");
+    sPath += getenv("HOMEPATH");
+    sPath += "\\";
+#elif defined(SB_LINUX_BUILD)
+    sPath = getenv("HOME");
+    sPath += "/";
+#elif defined(SB_MAC_BUILD)
+    sPath = getenv("HOME");
+    sPath += "/";
+#endif
+    sPath += pszFileName;
+    return sPath;
+}
+
+// LogLevel applies to all categories, LogLevelTransport ... LogLevelUI override it when set (-1 or missing = use LogLevel)
+void X2Mount::readLogLevels()
+{
+    static const char *pszCategoryKeys[LOG_NB_CATEGORIES] = {LOG_LEVEL_TRANSPORT, LOG_LEVEL_CACHE, LOG_LEVEL_SLEW, LOG_LEVEL_TRACKING, LOG_LEVEL_UI};
+    bool bWasEnabled = LogFile->anyEnabled();
+    int nLevel;
+    int nCategoryLevel;
+    int i;
+
+    if (!m_pIniUtil)
+        return;
+
+    nLevel = m_pIniUtil->readInt(PARENT_KEY, LOG_LEVEL, LOG_OFF);
+    for(i = 0; i < LOG_NB_CATEGORIES; i++) {
+        nCategoryLevel = m_pIniUtil->readInt(PARENT_KEY, pszCategoryKeys[i], -1);
+        LogFile->setLevel(i, nCategoryLevel < 0 ? nLevel : nCategoryLevel);
+    }
+
+    if (!bWasEnabled && LogFile->anyEnabled()) {
+        LogFile->log("iOptronV3 X2 plugin version %3.3f\n", DRIVER_VERSION);
+    }
+}
+
+// Called from inside the CiOptron read that saw the change, so the X2 I/O mutex is already held
+void X2Mount::onMountEvent(const iOptronMountEvent &event, void *pUserData)
+{
+    X2Mount *pMe = (X2Mount *)pUserData;
+
+    switch(event.nEvent) {
+        case MOUNT_EVENT_STATUS:
+            if(event.nStatus == SLEWING || event.nStatus == FLIPPING)
+                pMe->m_nSlewStartNs = event.nTimeNs;
+            break;
+        case MOUNT_EVENT_SLEW_DONE:
+            if (pMe->LogFile->enabled(LOG_SLEW, LOG_DEBUG)) {
+                pMe->LogFile->log("[X2Mount::onMountEvent] slew done after %3.1f s, status %d\n", nsToSeconds(event.nTimeNs - pMe->m_nSlewStartNs), event.nStatus);
+            }
+            break;
+        case MOUNT_EVENT_UNPARKED:
+            pMe->m_bParked = false;     // isParked() also wants tracking off, only the way out is certain
+            break;
+        case MOUNT_EVENT_PIER_FLIP:
+            if (pMe->LogFile->enabled(LOG_SLEW, LOG_DEBUG)) {
+                pMe->LogFile->log("[X2Mount::onMountEvent] pier side changed to %s\n", event.nPierSide == PIER_WEST ? "west" : "east");
+            }
+            break;
+    }
+    if(pMe->m_pTrace->enabled())
+        pMe->m_pTrace->instant(CMountEvents::eventName(event.nEvent), "mount", NULL, event.nStatus);
+}
+
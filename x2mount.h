@@ -27,16 +27,34 @@
 
 // Include files for iOptron mount
 #include "iOptronV3.h"
+#include "HostCallStats.h"
+#include "SerialCapture.h"
+#include "TermiosSerial.h"
 
 
 #define PARENT_KEY			"iOptronV3"
 #define CHILD_KEY_PORT_NAME "PortName"
 #define AUTO_DATETIME		"SetDateTimeData"
+#define CAPTURE_TRANSCRIPT	"CaptureTranscript"
+#define NATIVE_SERIAL		"NativeSerial"
+#define NATIVE_SERIAL_VMIN	"NativeSerialVMin"
+#define NATIVE_SERIAL_VTIME	"NativeSerialVTime"
+#define NATIVE_SERIAL_LOW_LATENCY	"NativeSerialLowLatency"
+#define DUMP_LINK_STATS		"DumpLinkStats"		// write the per command link statistics to a file on disconnect
+#define TRACE_EVENTS		"TraceEvents"		// write a Chrome trace of each session (establishLink to terminateLink)
+#define SLOW_COMMAND_MS		"SlowCommandMs"		// save the last transport events when an exchange takes longer, 0 = off
+#define PUBLISH_TELEMETRY	"PublishTelemetry"	// mount state in POSIX shared memory for other processes, see iOptronTelemetry.h
+#define LOG_LEVEL			"LogLevel"			// AsyncLogLevel for every category, also set from the settings dialog
+#define LOG_LEVEL_TRANSPORT	"LogLevelTransport"	// per category overrides, -1 = same as LogLevel
+#define LOG_LEVEL_CACHE		"LogLevelCache"
+#define LOG_LEVEL_SLEW		"LogLevelSlew"
+#define LOG_LEVEL_TRACKING	"LogLevelTracking"
+#define LOG_LEVEL_UI		"LogLevelUI"
 #define MAX_PORT_NAME_SIZE 120
+#define IOPTRON_LINK_STATS_TABLE_SIZE 4096  // one line per catalog command
+#define DIALOG_STATUS_MAX_AGE_MS 1000       // the settings dialog reads :GLS# itself when the cached status is older
 
 
-// #define IOPTRON_X2_DEBUG    // Define this to have log files
-
 #if defined(SB_WIN_BUILD)
 #define DEF_PORT_NAME					"COM1"
 #elif defined(SB_LINUX_BUILD)
@@ -147,6 +165,14 @@ public:
 	virtual int								rateCountOpenLoopMove(void) const;
 	virtual int								rateNameFromIndexOpenLoopMove(const int& nZeroBasedIndex, char* pszOut, const int& nOutMaxSize);
 	virtual int								rateIndexOpenLoopMove(void);
+
+	// timed guide pulse, not an X2 interface : for guiders integrated with the plugin. Doesn't take the
+	// X2 I/O mutex, the pulse only waits for the serial exchange in progress, see PulseGuide.h
+	int										pulseGuide(const MountDriverInterface::MoveDir& Dir, const int& nDurationMs);
+	// custom rate streaming for satellites and comets, not an X2 interface either, see RateStream.h
+	int										startRateStream(const std::vector<iOptronRatePoint> &profile, int nPeriodMs = RATE_STREAM_DEFAULT_PERIOD_MS);
+	int										startRateStream(RateEphemerisCallback pfEphemeris, void *pUserData, int nPeriodMs = RATE_STREAM_DEFAULT_PERIOD_MS);
+	void									stopRateStream(void);
 	
 	//NeedsRefractionInterface
 	virtual bool							needsRefactionAdjustments(void);
@@ -183,6 +209,10 @@ public:
 	virtual int initModalSettingsDialog(void) { return 0; }
 	virtual int execModalSettingsDialog(void);
 	void uiEvent(X2GUIExchangeInterface* uiex, const char* pszEvent); // Process a UI event
+
+    // per host call serial traffic, for replaying TheSkyX polling patterns against a simulated mount
+    const CHostCallStats &hostCallStats() const { return m_HostCallStats; }
+    void setClock(CMonotonicClock *pClock) { m_iOptronV3.setClock(pClock); }  // driver timers and caches, NULL for the system clock
 	
 	
 	// Implementation
@@ -208,6 +238,11 @@ private:
 	
 	// Variables for iOptron object
 	CiOptron m_iOptronV3;
+	CHostCallStats m_HostCallStats;
+    CSerialCapture *m_pSerialCapture;   // sits between m_iOptronV3 and m_pSerX
+#if !defined(SB_WIN_BUILD)
+    CTermiosSerial m_NativeSerial;      // used instead of m_pSerX when NativeSerial is set in the ini
+#endif
 
     bool m_bLinked;
 
@@ -221,8 +256,13 @@ private:
     int m_nCurrentDialog;
 
 	bool	m_bSetAutoTimeData;
+    bool    m_bCaptureTranscript;
+    bool    m_bNativeSerial;
+    bool    m_bDumpLinkStats;
+    bool    m_bTraceEvents;
 
 	bool m_bHasDoneZeroPosition;
+    int64_t m_nSlewStartNs;     // status went to slewing, CiOptron clock
 
 	int inDaylightTime(bool &bInDST);
 
@@ -234,13 +274,26 @@ private:
     int updateDialogRealtime(X2GUIExchangeInterface* uiex);
 
     void portNameOnToCharPtr(char* pszPort, const unsigned int& nMaxSize) const;
+    void startTranscriptCapture();
+    void startTrace();
+    void dumpLinkStats();
+    void dumpLinkTables(FILE *pFile);
+    int  writeLatencyReport(std::string &sReportPath);
+    void updateLinkStats(X2GUIExchangeInterface* uiex);
+    void dumpGuideStats(FILE *pFile);
+    void dumpRateStream(FILE *pFile);
+    std::string homeFilePath(const char *pszFileName) const;
+    void readLogLevels();
+    static void onMountEvent(const iOptronMountEvent &event, void *pUserData);
+
+    // link statistics snapshots for the reports and the dialog, X2 mutex held.
+    // Members because the command stats are too big for the stack of the host threads.
+    CCommandStats m_CommandStatsCopy;
+    CLinkHealth m_LinkHealthCopy;
 
-#ifdef IOPTRON_X2_DEBUG
     std::string m_sLogfilePath;
-    char *timestamp;
-    time_t ltime;
-	FILE *LogFile;	  // LogFile
-#endif
+	CAsyncLog *LogFile;	  // LogFile, never NULL, levels from the ini
+    CTraceLog *m_pTrace;  // only writes when TraceEvents is set
 	
 	
 };